@@ -69,7 +69,7 @@ function showToast(message, type = 'info') {
 document.addEventListener('DOMContentLoaded', () => {
   loadBrandingConfig();
   initializeTheme();
-  fetchStatus();
+  openStatusSocket();
   fetchNetworks();
   fetchCustomParams();
   setupEventListeners();
@@ -243,46 +243,66 @@ function setupEventListeners() {
     goToStep(3);
   });
   if (prev3) prev3.addEventListener('click', () => goToStep(2));
+  const otaBtn = document.getElementById('ota-btn');
+  if (otaBtn) otaBtn.addEventListener('click', uploadFirmware);
+}
+
+// Connection status as last reported; /ws messages only carry changed fields.
+let status = {};
+let statusSocket = null;
+let statusPoll = null;
+let socketRetryMs = 1000;
+const connectListeners = new Set();
+
+// Live status over /ws: the device sends its full state when the socket opens
+// and then only what changed, so an idle tab costs no requests. /status_json
+// polling is the fallback while the socket is down (or the firmware was built
+// without ENABLE_WEBSOCKETS).
+function openStatusSocket() {
+  const scheme = location.protocol === 'https:' ? 'wss' : 'ws';
+  let ws;
+  try {
+    ws = new WebSocket(`${scheme}://${location.host}/ws`);
+  } catch (e) {
+    startStatusPolling();
+    return;
+  }
+  ws.onopen = () => {
+    statusSocket = ws;
+    socketRetryMs = 1000;
+    stopStatusPolling();
+  };
+  ws.onmessage = (event) => {
+    let msg;
+    try { msg = JSON.parse(event.data); } catch (e) { return; }
+    if (msg.type === 'status') applyStatus(msg);
+    else if (msg.type === 'connect') connectListeners.forEach(fn => fn(msg));
+    else if (msg.type === 'ota') renderOta(msg);
+  };
+  ws.onclose = () => {
+    if (statusSocket === ws) statusSocket = null;
+    startStatusPolling();
+    setTimeout(openStatusSocket, socketRetryMs);
+    socketRetryMs = Math.min(socketRetryMs * 2, 30000);
+  };
 }
 
-// Fetch current connection status
+function startStatusPolling() {
+  if (statusPoll) return;
+  fetchStatus();
+  statusPoll = setInterval(fetchStatus, 10000);
+}
+
+function stopStatusPolling() {
+  clearInterval(statusPoll);
+  statusPoll = null;
+}
+
+// Fetch current connection status (polling fallback)
 async function fetchStatus() {
   try {
     const response = await fetch('/status_json');
-    const data = await response.json();
-    
-    connectionStatus.textContent = data.status;
-    connectionStatusDetail.textContent = data.status;
-    ipAddress.textContent = data.ip;
-    if (data.ssid) {
-      const ssidEl = document.getElementById('ssid-current');
-      if (ssidEl) ssidEl.textContent = data.ssid;
-    }
-    
-    // Update UI based on connection status
-    if (data.status === 'Connected') {
-      // Update connection badge
-      connectionBadge.classList.remove('bg-blue-200', 'bg-red-200', 'bg-yellow-200');
-      connectionBadge.classList.add('bg-green-200');
-      connectionStatus.classList.remove('text-blue-800', 'text-red-800', 'text-yellow-800');
-      connectionStatus.classList.add('text-green-800');
-      
-      // Update signal strength if available from status JSON
-      if (typeof data.rssi === 'number') {
-        signalStrength.textContent = data.rssi + ' dBm';
-        signalBars.innerHTML = generateSignalBars(data.rssi);
-      }
-    } else if (data.status === 'Connecting...') {
-      connectionBadge.classList.remove('bg-blue-200', 'bg-red-200', 'bg-green-200');
-      connectionBadge.classList.add('bg-yellow-200');
-      connectionStatus.classList.remove('text-blue-800', 'text-red-800', 'text-green-800');
-      connectionStatus.classList.add('text-yellow-800');
-    } else {
-      connectionBadge.classList.remove('bg-green-200', 'bg-yellow-200', 'bg-red-200');
-      connectionBadge.classList.add('bg-blue-200');
-      connectionStatus.classList.remove('text-green-800', 'text-yellow-800', 'text-red-800');
-      connectionStatus.classList.add('text-blue-800');
-    }
+    applyStatus(await response.json());
   } catch (error) {
     console.error('Error fetching status:', error);
     connectionStatus.textContent = 'Error';
@@ -294,13 +314,111 @@ async function fetchStatus() {
   }
 }
 
+// Merges a full or partial status into the view.
+function applyStatus(update) {
+  Object.assign(status, update);
+  if (Array.isArray(update.params)) updateParamInputs(update.params);
+  renderStatus(status);
+}
+
+function updateParamInputs(params) {
+  params.forEach(({ id, value }) => {
+    const el = document.getElementById(id);
+    // Never overwrite what the user is typing.
+    if (!el || el === document.activeElement) return;
+    if (el.type === 'checkbox') el.checked = value === 'true';
+    else el.value = value;
+  });
+}
+
+function renderStatus(data) {
+  connectionStatus.textContent = data.status;
+  connectionStatusDetail.textContent = data.status;
+  ipAddress.textContent = data.ip;
+  if (data.ssid) {
+    const ssidEl = document.getElementById('ssid-current');
+    if (ssidEl) ssidEl.textContent = data.ssid;
+  }
+  
+  // Update UI based on connection status
+  if (data.status === 'Connected') {
+    // Update connection badge
+    connectionBadge.classList.remove('bg-blue-200', 'bg-red-200', 'bg-yellow-200');
+    connectionBadge.classList.add('bg-green-200');
+    connectionStatus.classList.remove('text-blue-800', 'text-red-800', 'text-yellow-800');
+    connectionStatus.classList.add('text-green-800');
+    
+    // Update signal strength if available from status JSON
+    if (typeof data.rssi === 'number') {
+      signalStrength.textContent = data.rssi + ' dBm';
+      signalBars.innerHTML = generateSignalBars(data.rssi);
+    }
+  } else if (data.status === 'Connecting...') {
+    connectionBadge.classList.remove('bg-blue-200', 'bg-red-200', 'bg-green-200');
+    connectionBadge.classList.add('bg-yellow-200');
+    connectionStatus.classList.remove('text-blue-800', 'text-red-800', 'text-green-800');
+    connectionStatus.classList.add('text-yellow-800');
+  } else {
+    connectionBadge.classList.remove('bg-green-200', 'bg-yellow-200', 'bg-red-200');
+    connectionBadge.classList.add('bg-blue-200');
+    connectionStatus.classList.remove('text-green-800', 'text-yellow-800', 'text-red-800');
+    connectionStatus.classList.add('text-blue-800');
+  }
+}
+
+// Outcome of a background connect: pushed on /ws when the socket is up,
+// otherwise followed through /status_json until it settles. Started before
+// POST /connect, so a result pushed ahead of the 202 is not missed; wait()
+// returns it and cancel() stops listening.
+function watchConnectResult(timeoutMs = 60000) {
+  let settled = null;
+  let resolveSettled = null;
+  const listener = (msg) => {
+    if (msg.state === 'connecting' || settled) return;
+    settled = msg.state;
+    if (resolveSettled) resolveSettled(settled);
+  };
+  const viaSocket = statusSocket !== null;
+  if (viaSocket) connectListeners.add(listener);
+  const cancel = () => connectListeners.delete(listener);
+
+  async function wait() {
+    if (!viaSocket) return pollConnectResult(timeoutMs);
+    let timer;
+    const state = settled || await new Promise(resolve => {
+      resolveSettled = resolve;
+      timer = setTimeout(() => resolve('failed'), timeoutMs);
+    });
+    clearTimeout(timer);
+    cancel();
+    return state;
+  }
+  return { wait, cancel };
+}
+
+async function pollConnectResult(timeoutMs) {
+  let state = 'connecting';
+  for (let i = 0; state === 'connecting' && i < timeoutMs / 1000; i++) {
+    await sleep(1000);
+    const polled = await (await fetch('/status_json')).json();
+    state = polled.connect ? polled.connect.state : 'failed';
+  }
+  return state === 'connecting' ? 'failed' : state;
+}
+
 // Fetch available networks
 async function fetchNetworks() {
   try {
     networkList.innerHTML = '<div class="loading"><i class="fas fa-spinner fa-spin mr-2"></i>Scanning networks...</div>';
     scanBtn.disabled = true;
-    const response = await fetch('/scan');
-    networks = await response.json();
+    // /scan answers from the cache at once; poll while the background scan runs.
+    let data = await (await fetch('/scan?refresh=1')).json();
+    for (let i = 0; data.scanning && i < 15; i++) {
+      if (data.networks.length) displayNetworks(data.networks);
+      await new Promise(resolve => setTimeout(resolve, 1000));
+      data = await (await fetch('/scan')).json();
+    }
+    networks = data.networks;
     displayNetworks(networks);
   } catch (error) {
     console.error('Error scanning networks:', error);
@@ -402,17 +520,25 @@ async function connectToNetwork() {
     connectionStatus.style.color = 'var(--warning-color)';
     
     // Send connection request
-    const response = await fetch('/connect', {
-      method: 'POST',
-      body: formData
-    });
-    
-    const result = await response.json();
-    if (result.result === 'Connected') {
+    const outcome = watchConnectResult();
+    let result = {};
+    let state = 'failed';
+    try {
+      const response = await fetch('/connect', {
+        method: 'POST',
+        body: formData
+      });
+      result = await response.json();
+      // The device answers 202 at once and connects in the background.
+      if (response.status === 202) state = await outcome.wait();
+    } finally {
+      outcome.cancel();
+    }
+    if (state === 'connected') {
       showToast('Connected to ' + ssid, 'success');
-      // poll to reflect new IP and RSSI
-      for (let i=0;i<5;i++){ await sleep(800); await fetchStatus(); }
+      if (!statusSocket) await fetchStatus();
     } else {
+      if (result.error) console.warn(result.error);
       showToast('Failed to connect to ' + ssid, 'error');
       connectionStatus.textContent = 'Connection Failed';
       connectionStatus.style.color = 'var(--danger-color)';
@@ -577,8 +703,54 @@ function getSignalStrengthFromRSSI(rssi) {
   return rssi;
 }
 
-// Periodically update status
-setInterval(fetchStatus, 10000); // Update every 10 seconds
+// Firmware update. The image is streamed into flash as it uploads; progress
+// and throughput come from the device over /ws (XHR upload progress is the
+// fallback without a socket). With a SHA-256 the device refuses to activate
+// an image that does not match.
+function renderOta(msg) {
+  const bar = document.getElementById('ota-bar');
+  const info = document.getElementById('ota-info');
+  if (!bar || !info) return;
+  const total = msg.total || (otaFile ? otaFile.size : 0);
+  if (total) bar.style.width = Math.min(100, Math.round(msg.written * 100 / total)) + '%';
+  const rate = msg.bytes_per_s ? ` · ${(msg.bytes_per_s / 1024).toFixed(0)} KB/s` : '';
+  if (msg.state === 'writing') info.textContent = `${(msg.written / 1024).toFixed(0)} KB written${rate}`;
+  else if (msg.state === 'done') info.textContent = `Done${rate} · SHA-256 ${msg.sha256.slice(0, 12)}…`;
+  else info.textContent = 'Failed: ' + msg.error;
+}
+
+let otaFile = null;
+
+function uploadFirmware() {
+  const input = document.getElementById('ota-file');
+  const digest = document.getElementById('ota-sha256').value.trim();
+  otaFile = input && input.files[0];
+  if (!otaFile) {
+    showToast('Choose a firmware image first', 'error');
+    return;
+  }
+  const form = new FormData();
+  form.append('firmware', otaFile, otaFile.name);
+  const xhr = new XMLHttpRequest();
+  xhr.open('POST', '/ota');
+  if (digest) xhr.setRequestHeader('X-SHA256', digest);
+  xhr.upload.onprogress = (e) => {
+    if (!statusSocket && e.lengthComputable) renderOta({ state: 'writing', written: e.loaded, total: e.total });
+  };
+  xhr.onload = () => {
+    let result = {};
+    try { result = JSON.parse(xhr.responseText); } catch (e) { /* ignore */ }
+    if (xhr.status === 200) {
+      renderOta({ state: 'done', written: result.bytes, bytes_per_s: result.bytes_per_s, sha256: result.sha256 });
+      showToast(result.reboot ? 'Firmware updated, restarting…' : 'Firmware updated', 'success');
+    } else {
+      renderOta({ state: 'error', written: 0, error: result.error || xhr.status });
+      showToast('Firmware update failed', 'error');
+    }
+  };
+  xhr.onerror = () => showToast('Firmware upload interrupted', 'error');
+  xhr.send(form);
+}
 
 // Stepper helpers
 function goToStep(step) {
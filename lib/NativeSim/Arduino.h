@@ -0,0 +1,90 @@
+#ifndef NATIVE_SIM_ARDUINO_H
+#define NATIVE_SIM_ARDUINO_H
+
+// Minimal Arduino-ESP32 core for running sketches as a host process.
+// Only what this project touches is provided; anything else should fail to
+// compile rather than silently behave differently from the device.
+
+#include <ctype.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "WString.h"
+#include "Print.h"
+#include "Stream.h"
+#include "HardwareSerial.h"
+#include "IPAddress.h"
+
+#ifndef NATIVE_SIM
+#define NATIVE_SIM 1
+#endif
+
+#define PROGMEM
+#define PGM_P const char*
+#define F(string_literal) (reinterpret_cast<const __FlashStringHelper*>(string_literal))
+#define pgm_read_byte(addr) (*reinterpret_cast<const uint8_t*>(addr))
+#define pgm_read_word(addr) (*reinterpret_cast<const uint16_t*>(addr))
+#define pgm_read_dword(addr) (*reinterpret_cast<const uint32_t*>(addr))
+#define strlen_P strlen
+#define memcpy_P memcpy
+#define RTC_DATA_ATTR
+#define IRAM_ATTR
+
+#define LOW 0x0
+#define HIGH 0x1
+#define INPUT 0x01
+#define OUTPUT 0x03
+
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+void yield();
+
+inline void pinMode(uint8_t, uint8_t) {}
+inline void digitalWrite(uint8_t, uint8_t) {}
+inline int digitalRead(uint8_t) { return LOW; }
+
+long random(long howbig);
+long random(long howsmall, long howbig);
+void randomSeed(unsigned long seed);
+
+// newlib provides strlcpy/strlcat on the ESP32; older glibc does not.
+#if defined(__GLIBC__) && !__GLIBC_PREREQ(2, 38)
+inline size_t strlcpy(char* dst, const char* src, size_t size) {
+  size_t len = strlen(src);
+  if (size) {
+    size_t n = len < size - 1 ? len : size - 1;
+    memcpy(dst, src, n);
+    dst[n] = 0;
+  }
+  return len;
+}
+#endif
+
+// Subset of the ESP32 "ESP" object.
+class EspClass {
+public:
+  uint32_t getHeapSize();
+  uint32_t getFreeHeap();
+  uint32_t getMinFreeHeap();
+  uint32_t getMaxAllocHeap();
+  const char* getChipModel() { return "ESP32-NATIVE-SIM"; }
+  uint8_t getChipCores() { return 2; }
+  uint32_t getCpuFreqMHz() { return 240; }
+  uint64_t getEfuseMac();
+  uint32_t getSketchSize();
+  uint32_t getFreeSketchSpace();
+  [[noreturn]] void restart();
+};
+
+extern EspClass ESP;
+
+// Sketch entry points, called by the host main().
+void setup();
+void loop();
+
+#endif // NATIVE_SIM_ARDUINO_H
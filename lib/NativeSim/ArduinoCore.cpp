@@ -0,0 +1,105 @@
+#include "Arduino.h"
+#include "NativeSim.h"
+#include "ESPmDNS.h"
+#include <random>
+#include <thread>
+
+// ----- Timing -----
+unsigned long millis() { return static_cast<unsigned long>(NativeSim::nowMicros() / 1000); }
+unsigned long micros() { return static_cast<unsigned long>(NativeSim::nowMicros()); }
+void delay(uint32_t ms) { NativeSim::sleepMicros(static_cast<uint64_t>(ms) * 1000); }
+void delayMicroseconds(uint32_t us) { NativeSim::sleepMicros(us); }
+
+void yield() {
+  if (NativeSim::clockMode() == NativeSim::ClockMode::RealTime) std::this_thread::yield();
+}
+
+// ----- Random -----
+namespace {
+std::mt19937& rng() {
+  static std::mt19937 engine(0x5eed);
+  return engine;
+}
+} // namespace
+
+void randomSeed(unsigned long seed) { rng().seed(static_cast<uint32_t>(seed)); }
+
+long random(long howbig) {
+  if (howbig <= 0) return 0;
+  return static_cast<long>(rng()() % static_cast<unsigned long>(howbig));
+}
+
+long random(long howsmall, long howbig) {
+  if (howsmall >= howbig) return howsmall;
+  return random(howbig - howsmall) + howsmall;
+}
+
+// ----- Serial -----
+HardwareSerial Serial;
+
+size_t HardwareSerial::write(uint8_t c) {
+  return fputc(c, stdout) == EOF ? 0 : 1;
+}
+
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size) {
+  return fwrite(buffer, 1, size, stdout);
+}
+
+void HardwareSerial::flush() { fflush(stdout); }
+
+// ----- IPAddress -----
+const IPAddress INADDR_NONE(0, 0, 0, 0);
+
+bool IPAddress::fromString(const char* address) {
+  unsigned int parts[4];
+  char tail;
+  if (sscanf(address, "%u.%u.%u.%u%c", &parts[0], &parts[1], &parts[2], &parts[3], &tail) != 4) return false;
+  for (int i = 0; i < 4; i++) {
+    if (parts[i] > 255) return false;
+    _address[i] = static_cast<uint8_t>(parts[i]);
+  }
+  return true;
+}
+
+String IPAddress::toString() const {
+  char buf[16];
+  snprintf(buf, sizeof(buf), "%u.%u.%u.%u", _address[0], _address[1], _address[2], _address[3]);
+  return String(buf);
+}
+
+size_t IPAddress::printTo(Print& p) const {
+  return p.print(toString());
+}
+
+// ----- ESP -----
+EspClass ESP;
+
+uint32_t EspClass::getHeapSize() { return static_cast<uint32_t>(NativeSim::heapSize()); }
+
+uint32_t EspClass::getFreeHeap() {
+  size_t live = NativeSim::heapStats().liveBytes;
+  size_t size = NativeSim::heapSize();
+  return live >= size ? 0 : static_cast<uint32_t>(size - live);
+}
+
+uint32_t EspClass::getMinFreeHeap() {
+  size_t peak = NativeSim::heapStats().peakLiveBytes;
+  size_t size = NativeSim::heapSize();
+  return peak >= size ? 0 : static_cast<uint32_t>(size - peak);
+}
+
+// The host allocator does not fragment like the ESP32 TLSF heap, so the
+// largest block is approximated by the free total.
+uint32_t EspClass::getMaxAllocHeap() { return getFreeHeap(); }
+
+uint64_t EspClass::getEfuseMac() { return 0x0000A1B2C3D4E5F6ULL; }
+uint32_t EspClass::getSketchSize() { return 1024 * 1024; }
+uint32_t EspClass::getFreeSketchSpace() { return 3 * 1024 * 1024; }
+
+void EspClass::restart() {
+  fflush(stdout);
+  exit(0);
+}
+
+// ----- mDNS -----
+MDNSResponder MDNS;
@@ -0,0 +1,12 @@
+#include "Arduino.h"
+
+// Host entry point. Kept in its own translation unit so that test runners
+// which bring their own main() never pull it out of the library archive.
+int main() {
+  setvbuf(stdout, nullptr, _IOLBF, 0);
+  setup();
+  for (;;) {
+    loop();
+    yield();
+  }
+}
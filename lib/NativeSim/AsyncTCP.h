@@ -0,0 +1,25 @@
+#ifndef NATIVE_SIM_ASYNC_TCP_H
+#define NATIVE_SIM_ASYNC_TCP_H
+
+#include "Arduino.h"
+#include "IPAddress.h"
+
+// The native server owns the sockets; AsyncClient only describes the peer.
+class AsyncClient {
+public:
+  IPAddress remoteIP() const { return _remoteIP; }
+  uint16_t remotePort() const { return _remotePort; }
+  IPAddress localIP() const { return _localIP; }
+  uint16_t localPort() const { return _localPort; }
+  bool connected() const { return _connected; }
+  size_t space() const { return 5744; }  // CONFIG_LWIP_TCP_SND_BUF_DEFAULT
+  bool canSend() const { return _connected; }
+
+  IPAddress _remoteIP;
+  uint16_t _remotePort = 0;
+  IPAddress _localIP;
+  uint16_t _localPort = 0;
+  bool _connected = true;
+};
+
+#endif // NATIVE_SIM_ASYNC_TCP_H
@@ -0,0 +1,87 @@
+#include "AsyncUDP.h"
+#include "NativeSim.h"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+std::atomic<uint16_t> g_lastBoundUdpPort{0};
+}
+
+namespace NativeSim {
+uint16_t lastBoundUdpPort() { return g_lastBoundUdpPort.load(); }
+}
+
+size_t AsyncUDPPacket::write(const uint8_t* data, size_t len) {
+  sockaddr_in to;
+  memset(&to, 0, sizeof(to));
+  to.sin_family = AF_INET;
+  to.sin_addr.s_addr = _remoteIP;
+  to.sin_port = htons(_remotePort);
+  ssize_t n = sendto(_fd, data, len, 0, reinterpret_cast<sockaddr*>(&to), sizeof(to));
+  return n > 0 ? static_cast<size_t>(n) : 0;
+}
+
+bool AsyncUDP::listen(uint16_t port) {
+  close();
+  if (port == 53) {
+    if (const char* env = getenv("WM_DNS_PORT")) port = static_cast<uint16_t>(atoi(env));
+  }
+  _fd = socket(AF_INET, SOCK_DGRAM, 0);
+  if (_fd < 0) return false;
+  int one = 1;
+  setsockopt(_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  addr.sin_port = htons(port);
+  if (bind(_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || pipe(_wakeFds) != 0) {
+    fprintf(stderr, "[native-sim] udp: cannot bind port %u: %s\n", port, strerror(errno));
+    ::close(_fd);
+    _fd = -1;
+    return false;
+  }
+  socklen_t addrLen = sizeof(addr);
+  getsockname(_fd, reinterpret_cast<sockaddr*>(&addr), &addrLen);
+  g_lastBoundUdpPort.store(ntohs(addr.sin_port));
+  fcntl(_fd, F_SETFL, fcntl(_fd, F_GETFL, 0) | O_NONBLOCK);
+  _running = true;
+  _thread = std::thread([this] { run(); });
+  return true;
+}
+
+void AsyncUDP::close() {
+  if (_fd < 0) return;
+  _running = false;
+  char b = 1;
+  ssize_t ignored = write(_wakeFds[1], &b, 1);
+  (void)ignored;
+  if (_thread.joinable()) _thread.join();
+  ::close(_fd);
+  ::close(_wakeFds[0]);
+  ::close(_wakeFds[1]);
+  _fd = _wakeFds[0] = _wakeFds[1] = -1;
+}
+
+void AsyncUDP::run() {
+  uint8_t buf[1500];
+  while (_running) {
+    pollfd fds[2] = {{_fd, POLLIN, 0}, {_wakeFds[0], POLLIN, 0}};
+    if (poll(fds, 2, -1) < 0 && errno != EINTR) break;
+    // Drain everything that queued up; one callback per datagram.
+    for (;;) {
+      sockaddr_in from;
+      socklen_t fromLen = sizeof(from);
+      ssize_t n = recvfrom(_fd, buf, sizeof(buf), 0, reinterpret_cast<sockaddr*>(&from), &fromLen);
+      if (n < 0) break;
+      if (!_handler) continue;
+      AsyncUDPPacket packet(_fd, buf, static_cast<size_t>(n), from.sin_addr.s_addr, ntohs(from.sin_port));
+      _handler(packet);
+    }
+  }
+}
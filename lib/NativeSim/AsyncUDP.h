@@ -0,0 +1,58 @@
+#ifndef NATIVE_SIM_ASYNC_UDP_H
+#define NATIVE_SIM_ASYNC_UDP_H
+
+#include <atomic>
+#include <functional>
+#include <thread>
+#include "Arduino.h"
+#include "IPAddress.h"
+
+// UDP stand-in for the Arduino-ESP32 AsyncUDP: a listening socket whose
+// packets are handed to the onPacket callback on a thread of its own, like
+// the "async_udp" task on the device. Port 53 can be overridden with
+// WM_DNS_PORT since it usually needs root (0 = ephemeral, see
+// NativeSim::lastBoundUdpPort()).
+
+class AsyncUDPPacket {
+public:
+  AsyncUDPPacket(int fd, uint8_t* data, size_t len, uint32_t remoteIP, uint16_t remotePort)
+    : _fd(fd), _data(data), _len(len), _remoteIP(remoteIP), _remotePort(remotePort) {}
+
+  uint8_t* data() { return _data; }
+  size_t length() { return _len; }
+  IPAddress remoteIP() { return IPAddress(_remoteIP); }
+  uint16_t remotePort() { return _remotePort; }
+  // Replies to the sender.
+  size_t write(const uint8_t* data, size_t len);
+
+private:
+  int _fd;
+  uint8_t* _data;
+  size_t _len;
+  uint32_t _remoteIP;
+  uint16_t _remotePort;  // host order
+};
+
+typedef std::function<void(AsyncUDPPacket& packet)> AuPacketHandlerFunction;
+
+class AsyncUDP {
+public:
+  AsyncUDP() = default;
+  ~AsyncUDP() { close(); }
+
+  void onPacket(AuPacketHandlerFunction cb) { _handler = cb; }
+  bool listen(uint16_t port);
+  void close();
+  bool connected() const { return _fd >= 0; }
+
+private:
+  void run();
+
+  int _fd = -1;
+  int _wakeFds[2] = {-1, -1};
+  std::thread _thread;
+  std::atomic<bool> _running{false};
+  AuPacketHandlerFunction _handler;
+};
+
+#endif // NATIVE_SIM_ASYNC_UDP_H
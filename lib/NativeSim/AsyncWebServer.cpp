@@ -0,0 +1,1295 @@
+#include "ESPAsyncWebServer.h"
+#include "NativeSim.h"
+#include "NativeSimHttp.h"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+std::atomic<uint16_t> g_lastBoundPort{0};
+
+// Listening servers, for serveInProcess().
+std::mutex g_coresMutex;
+std::vector<NativeSimHttp::ServerCore*> g_cores;
+
+// Same segment budget the library uses per write on the device.
+const size_t kSendWindow = 5744;
+const size_t kUploadChunk = 1460;
+const size_t kMaxHeadBytes = 8192;
+
+const char* statusText(int code) {
+  switch (code) {
+    case 100: return "Continue";
+    case 101: return "Switching Protocols";
+    case 200: return "OK";
+    case 201: return "Created";
+    case 202: return "Accepted";
+    case 204: return "No Content";
+    case 206: return "Partial Content";
+    case 301: return "Moved Permanently";
+    case 302: return "Found";
+    case 304: return "Not Modified";
+    case 400: return "Bad Request";
+    case 401: return "Unauthorized";
+    case 403: return "Forbidden";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 409: return "Conflict";
+    case 411: return "Length Required";
+    case 412: return "Precondition Failed";
+    case 413: return "Request Entity Too Large";
+    case 416: return "Requested Range Not Satisfiable";
+    case 429: return "Too Many Requests";
+    case 431: return "Request Header Fields Too Large";
+    case 500: return "Internal Server Error";
+    case 501: return "Not Implemented";
+    case 503: return "Service Unavailable";
+    default: return "";
+  }
+}
+
+bool headerEquals(const String& a, const char* b) { return strcasecmp(a.c_str(), b) == 0; }
+
+void setNonBlocking(int fd) {
+  int flags = fcntl(fd, F_GETFL, 0);
+  fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+void parseQuery(const char* s, size_t len, std::vector<AsyncWebParameter>& out, bool form) {
+  size_t start = 0;
+  while (start < len) {
+    size_t end = start;
+    while (end < len && s[end] != '&') end++;
+    size_t eq = start;
+    while (eq < end && s[eq] != '=') eq++;
+    if (end > start) {
+      String name = NativeSimHttp::urlDecode(s + start, eq - start);
+      String value = eq < end ? NativeSimHttp::urlDecode(s + eq + 1, end - eq - 1) : String();
+      out.push_back(AsyncWebParameter(name, value, form));
+    }
+    start = end + 1;
+  }
+}
+
+// Extracts `key="value"` from a Content-Disposition style header.
+String headerAttribute(const std::string& header, const char* key) {
+  std::string needle = std::string(key) + "=\"";
+  size_t pos = 0;
+  while ((pos = header.find(needle, pos)) != std::string::npos) {
+    if (pos == 0 || header[pos - 1] == ' ' || header[pos - 1] == ';') {
+      size_t start = pos + needle.size();
+      size_t end = header.find('"', start);
+      if (end == std::string::npos) return String();
+      return String(header.c_str() + start, static_cast<unsigned int>(end - start));
+    }
+    pos += needle.size();
+  }
+  return String();
+}
+
+} // namespace
+
+namespace NativeSim {
+uint16_t lastBoundHttpPort() { return g_lastBoundPort.load(); }
+}
+
+namespace NativeSimHttp {
+
+// ----- Helpers -----
+String urlDecode(const char* s, size_t len) {
+  String out;
+  out.reserve(static_cast<unsigned int>(len));
+  for (size_t i = 0; i < len; i++) {
+    char c = s[i];
+    if (c == '+') {
+      out += ' ';
+    } else if (c == '%' && i + 2 < len && isxdigit(static_cast<unsigned char>(s[i + 1])) &&
+               isxdigit(static_cast<unsigned char>(s[i + 2]))) {
+      char hex[3] = {s[i + 1], s[i + 2], 0};
+      out += static_cast<char>(strtol(hex, nullptr, 16));
+      i += 2;
+    } else {
+      out += c;
+    }
+  }
+  return out;
+}
+
+static const char kB64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+std::string base64Encode(const uint8_t* data, size_t len) {
+  std::string out;
+  out.reserve((len + 2) / 3 * 4);
+  for (size_t i = 0; i < len; i += 3) {
+    uint32_t n = static_cast<uint32_t>(data[i]) << 16;
+    if (i + 1 < len) n |= static_cast<uint32_t>(data[i + 1]) << 8;
+    if (i + 2 < len) n |= data[i + 2];
+    out += kB64[(n >> 18) & 63];
+    out += kB64[(n >> 12) & 63];
+    out += i + 1 < len ? kB64[(n >> 6) & 63] : '=';
+    out += i + 2 < len ? kB64[n & 63] : '=';
+  }
+  return out;
+}
+
+std::string base64Decode(const char* data, size_t len) {
+  std::string out;
+  uint32_t buf = 0;
+  int bits = 0;
+  for (size_t i = 0; i < len; i++) {
+    const char* p = strchr(kB64, data[i]);
+    if (data[i] == '=' || !p || !*p) continue;
+    buf = (buf << 6) | static_cast<uint32_t>(p - kB64);
+    bits += 6;
+    if (bits >= 8) {
+      bits -= 8;
+      out += static_cast<char>((buf >> bits) & 0xFF);
+    }
+  }
+  return out;
+}
+
+void sha1(const uint8_t* data, size_t len, uint8_t out[20]) {
+  uint32_t h[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+  std::string msg(reinterpret_cast<const char*>(data), len);
+  msg += static_cast<char>(0x80);
+  while (msg.size() % 64 != 56) msg += static_cast<char>(0);
+  uint64_t bitLen = static_cast<uint64_t>(len) * 8;
+  for (int i = 7; i >= 0; i--) msg += static_cast<char>((bitLen >> (i * 8)) & 0xFF);
+  auto rol = [](uint32_t v, int n) { return (v << n) | (v >> (32 - n)); };
+  for (size_t chunk = 0; chunk < msg.size(); chunk += 64) {
+    uint32_t w[80];
+    for (int i = 0; i < 16; i++) {
+      const uint8_t* p = reinterpret_cast<const uint8_t*>(msg.data() + chunk + i * 4);
+      w[i] = (static_cast<uint32_t>(p[0]) << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+    }
+    for (int i = 16; i < 80; i++) w[i] = rol(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+    uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+    for (int i = 0; i < 80; i++) {
+      uint32_t f, k;
+      if (i < 20) { f = (b & c) | (~b & d); k = 0x5A827999; }
+      else if (i < 40) { f = b ^ c ^ d; k = 0x6ED9EBA1; }
+      else if (i < 60) { f = (b & c) | (b & d) | (c & d); k = 0x8F1BBCDC; }
+      else { f = b ^ c ^ d; k = 0xCA62C1D6; }
+      uint32_t t = rol(a, 5) + f + e + k + w[i];
+      e = d; d = c; c = rol(b, 30); b = a; a = t;
+    }
+    h[0] += a; h[1] += b; h[2] += c; h[3] += d; h[4] += e;
+  }
+  for (int i = 0; i < 5; i++) {
+    out[i * 4] = static_cast<uint8_t>(h[i] >> 24);
+    out[i * 4 + 1] = static_cast<uint8_t>(h[i] >> 16);
+    out[i * 4 + 2] = static_cast<uint8_t>(h[i] >> 8);
+    out[i * 4 + 3] = static_cast<uint8_t>(h[i]);
+  }
+}
+
+std::string encodeWebSocketFrame(uint8_t opcode, const uint8_t* data, size_t len) {
+  std::string frame;
+  frame += static_cast<char>(0x80 | opcode);
+  if (len < 126) {
+    frame += static_cast<char>(len);
+  } else if (len < 65536) {
+    frame += static_cast<char>(126);
+    frame += static_cast<char>(len >> 8);
+    frame += static_cast<char>(len & 0xFF);
+  } else {
+    frame += static_cast<char>(127);
+    for (int i = 7; i >= 0; i--) frame += static_cast<char>((static_cast<uint64_t>(len) >> (i * 8)) & 0xFF);
+  }
+  frame.append(reinterpret_cast<const char*>(data), len);
+  return frame;
+}
+
+const char* contentTypeFor(const String& path) {
+  if (path.endsWith(".html") || path.endsWith(".htm")) return "text/html";
+  if (path.endsWith(".css")) return "text/css";
+  if (path.endsWith(".js")) return "application/javascript";
+  if (path.endsWith(".json")) return "application/json";
+  if (path.endsWith(".png")) return "image/png";
+  if (path.endsWith(".gif")) return "image/gif";
+  if (path.endsWith(".jpg") || path.endsWith(".jpeg")) return "image/jpeg";
+  if (path.endsWith(".ico")) return "image/x-icon";
+  if (path.endsWith(".svg")) return "image/svg+xml";
+  if (path.endsWith(".woff2")) return "font/woff2";
+  if (path.endsWith(".txt")) return "text/plain";
+  if (path.endsWith(".xml")) return "text/xml";
+  if (path.endsWith(".pdf")) return "application/pdf";
+  if (path.endsWith(".zip")) return "application/zip";
+  if (path.endsWith(".gz")) return "application/x-gzip";
+  return "text/plain";
+}
+
+// ----- Connection -----
+bool Connection::queue(const char* data, size_t len, bool isMessage) {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (state == Closed) return false;
+    out.append(data, len);
+    totalQueued += len;
+    if (isMessage) messageEnds.push_back(totalQueued);
+  }
+  wake();
+  return true;
+}
+
+size_t Connection::queuedMessages() {
+  std::lock_guard<std::mutex> lock(mutex);
+  return messageEnds.size();
+}
+
+void Connection::wake() {
+  if (core) core->wake();
+}
+
+// ----- Server core -----
+bool ServerCore::start() {
+  listenFd = socket(AF_INET, SOCK_STREAM, 0);
+  if (listenFd < 0) return false;
+  int one = 1;
+  setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  addr.sin_port = htons(port);
+  if (bind(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || listen(listenFd, 16) != 0) {
+    fprintf(stderr, "[native-sim] http: cannot listen on port %u: %s\n", port, strerror(errno));
+    ::close(listenFd);
+    listenFd = -1;
+    return false;
+  }
+  socklen_t addrLen = sizeof(addr);
+  getsockname(listenFd, reinterpret_cast<sockaddr*>(&addr), &addrLen);
+  port = ntohs(addr.sin_port);
+  g_lastBoundPort.store(port);
+  setNonBlocking(listenFd);
+  if (pipe(wakeFds) != 0) return false;
+  setNonBlocking(wakeFds[0]);
+  setNonBlocking(wakeFds[1]);
+  running = true;
+  thread = std::thread([this] { run(); });
+  std::lock_guard<std::mutex> lock(g_coresMutex);
+  g_cores.push_back(this);
+  return true;
+}
+
+void ServerCore::stop() {
+  if (!running.exchange(false)) return;
+  {
+    std::lock_guard<std::mutex> lock(g_coresMutex);
+    for (auto it = g_cores.begin(); it != g_cores.end(); ++it) {
+      if (*it == this) {
+        g_cores.erase(it);
+        break;
+      }
+    }
+  }
+  wake();
+  if (thread.joinable()) thread.join();
+  while (!conns.empty()) close(conns.front());
+  ::close(listenFd);
+  ::close(wakeFds[0]);
+  ::close(wakeFds[1]);
+  listenFd = wakeFds[0] = wakeFds[1] = -1;
+}
+
+void ServerCore::wake() {
+  if (wakeFds[1] >= 0) {
+    char b = 1;
+    ssize_t ignored = write(wakeFds[1], &b, 1);
+    (void)ignored;
+  }
+}
+
+void ServerCore::run() {
+  // Reused across iterations so the idle loop itself never allocates.
+  std::vector<pollfd> fds;
+  std::vector<ConnectionPtr> snapshot;
+  while (running) {
+    fds.clear();
+    fds.push_back({listenFd, POLLIN, 0});
+    fds.push_back({wakeFds[0], POLLIN, 0});
+    bool pending = false;
+    for (auto& c : conns) {
+      short events = POLLIN;
+      {
+        std::lock_guard<std::mutex> lock(c->mutex);
+        if (c->out.size() > c->outSent) events |= POLLOUT;
+        if (c->state == Connection::Sending && !c->bodyDone && c->out.size() == c->outSent) pending = true;
+      }
+      fds.push_back({c->fd, events, 0});
+    }
+    // A filler that asked to be retried needs polling even without socket events.
+    int timeout = pending ? 5 : 100;
+    if (poll(fds.data(), fds.size(), timeout) < 0 && errno != EINTR) break;
+
+    if (fds[1].revents & POLLIN) {
+      char drain[64];
+      while (read(wakeFds[0], drain, sizeof(drain)) > 0) {}
+    }
+    if (fds[0].revents & POLLIN) accept();
+
+    // Connections accepted above are not in `fds` yet; visit the rest.
+    snapshot.assign(conns.begin(), conns.end());
+    for (size_t i = 0; i < snapshot.size(); i++) {
+      const ConnectionPtr& c = snapshot[i];
+      short revents = i + 2 < fds.size() && fds[i + 2].fd == c->fd ? fds[i + 2].revents : 0;
+      if (revents & (POLLIN | POLLHUP | POLLERR)) readFrom(c);
+      if (c->state == Connection::Closed) continue;
+      pump(c);
+    }
+    snapshot.clear();
+  }
+}
+
+void ServerCore::accept() {
+  for (;;) {
+    sockaddr_in addr;
+    socklen_t len = sizeof(addr);
+    int fd = ::accept(listenFd, reinterpret_cast<sockaddr*>(&addr), &len);
+    if (fd < 0) return;
+    setNonBlocking(fd);
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    auto c = std::make_shared<Connection>();
+    c->fd = fd;
+    c->core = this;
+    c->remoteIP = IPAddress(static_cast<uint32_t>(addr.sin_addr.s_addr));
+    c->remotePort = ntohs(addr.sin_port);
+    sockaddr_in local;
+    socklen_t localLen = sizeof(local);
+    getsockname(fd, reinterpret_cast<sockaddr*>(&local), &localLen);
+    c->localIP = IPAddress(static_cast<uint32_t>(local.sin_addr.s_addr));
+    c->localPort = ntohs(local.sin_port);
+    c->in.reserve(kUploadChunk);
+    c->out.reserve(kSendWindow + 64);
+    conns.push_back(c);
+  }
+}
+
+void ServerCore::readFrom(const ConnectionPtr& c) {
+  char buf[4096];
+  for (;;) {
+    ssize_t n = recv(c->fd, buf, sizeof(buf), 0);
+    if (n > 0) {
+      // Handled segment by segment, as AsyncTCP delivers it, so a large body
+      // never piles up in `in`.
+      c->in.append(buf, static_cast<size_t>(n));
+      process(c);
+      continue;
+    }
+    if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+      // Peer went away; whatever we parsed still gets a chance below.
+      process(c);
+      close(c);
+      return;
+    }
+    break;
+  }
+  process(c);
+}
+
+void ServerCore::process(const ConnectionPtr& c) {
+  for (;;) {
+    Connection::State state;
+    {
+      std::lock_guard<std::mutex> lock(c->mutex);
+      state = c->state;
+    }
+    if (state == Connection::ReadingHead) {
+      if (!parseHead(c)) return;
+    } else if (state == Connection::ReadingBody) {
+      consumeBody(c);
+      std::lock_guard<std::mutex> lock(c->mutex);
+      if (c->state == Connection::ReadingBody) return;
+    } else if (state == Connection::WebSocket) {
+      processWebSocket(c);
+      return;
+    } else {
+      // Pipelined bytes after a request are ignored (Connection: close).
+      c->in.clear();
+      return;
+    }
+  }
+}
+
+bool ServerCore::parseHead(const ConnectionPtr& c) {
+  size_t end = c->in.find("\r\n\r\n");
+  if (end == std::string::npos) {
+    if (c->in.size() > kMaxHeadBytes) {
+      static const char kTooLarge[] = "HTTP/1.1 431 Request Header Fields Too Large\r\nConnection: close\r\n\r\n";
+      c->queue(kTooLarge, sizeof(kTooLarge) - 1);
+      std::lock_guard<std::mutex> lock(c->mutex);
+      c->state = Connection::Sending;
+      c->bodyDone = true;
+      c->headSent = true;
+    }
+    return false;
+  }
+  std::string head = c->in.substr(0, end);
+  c->in.erase(0, end + 4);
+
+  auto* req = new AsyncWebServerRequest(server, c.get());
+  c->request = req;
+  req->_client._remoteIP = c->remoteIP;
+  req->_client._remotePort = c->remotePort;
+  req->_client._localIP = c->localIP;
+  req->_client._localPort = c->localPort;
+
+  size_t lineEnd = head.find("\r\n");
+  std::string requestLine = head.substr(0, lineEnd);
+  size_t sp1 = requestLine.find(' ');
+  size_t sp2 = requestLine.rfind(' ');
+  std::string method = requestLine.substr(0, sp1);
+  std::string target = sp1 != std::string::npos && sp2 > sp1 ? requestLine.substr(sp1 + 1, sp2 - sp1 - 1) : "/";
+  std::string version = sp2 != std::string::npos ? requestLine.substr(sp2 + 1) : "HTTP/1.0";
+  req->_version = version == "HTTP/1.0" ? 0 : 1;
+  if (method == "GET") req->_method = HTTP_GET;
+  else if (method == "POST") req->_method = HTTP_POST;
+  else if (method == "DELETE") req->_method = HTTP_DELETE;
+  else if (method == "PUT") req->_method = HTTP_PUT;
+  else if (method == "PATCH") req->_method = HTTP_PATCH;
+  else if (method == "HEAD") req->_method = HTTP_HEAD;
+  else if (method == "OPTIONS") req->_method = HTTP_OPTIONS;
+
+  size_t q = target.find('?');
+  req->_url = urlDecode(target.c_str(), q == std::string::npos ? target.size() : q);
+  if (q != std::string::npos) parseQuery(target.c_str() + q + 1, target.size() - q - 1, req->_params, false);
+
+  size_t pos = lineEnd == std::string::npos ? head.size() : lineEnd + 2;
+  while (pos < head.size()) {
+    size_t eol = head.find("\r\n", pos);
+    if (eol == std::string::npos) eol = head.size();
+    size_t colon = head.find(':', pos);
+    if (colon != std::string::npos && colon < eol) {
+      size_t vstart = colon + 1;
+      while (vstart < eol && head[vstart] == ' ') vstart++;
+      String name(head.c_str() + pos, static_cast<unsigned int>(colon - pos));
+      String value(head.c_str() + vstart, static_cast<unsigned int>(eol - vstart));
+      if (headerEquals(name, "Host")) req->_host = value;
+      else if (headerEquals(name, "Content-Length")) req->_contentLength = strtoul(value.c_str(), nullptr, 10);
+      else if (headerEquals(name, "Content-Type")) {
+        int semi = value.indexOf(';');
+        req->_contentType = semi >= 0 ? value.substring(0, semi) : value;
+        req->_contentType.trim();
+        if (req->_contentType.equalsIgnoreCase("multipart/form-data")) {
+          int b = value.indexOf("boundary=");
+          if (b >= 0) {
+            req->_boundary = value.substring(b + 9);
+            if (req->_boundary.startsWith("\"")) req->_boundary = req->_boundary.substring(1, req->_boundary.length() - 1);
+            req->_isMultipart = true;
+          }
+        }
+      }
+      req->_headers.push_back(AsyncWebHeader(name, value));
+    }
+    pos = eol + 2;
+  }
+
+  req->_handler = server->_attachHandler(req);
+  if (req->_handler && req->_handler->_upgrade(req, c.get())) {
+    c->request = nullptr;
+    delete req;
+    std::lock_guard<std::mutex> lock(c->mutex);
+    c->state = Connection::WebSocket;
+    return true;
+  }
+
+  c->bodyReceived = 0;
+  c->formBody.clear();
+  c->mpState = Connection::MpPreamble;
+  c->mpBuf.clear();
+  std::lock_guard<std::mutex> lock(c->mutex);
+  c->state = req->_contentLength ? Connection::ReadingBody : Connection::AwaitingResponse;
+  if (c->state == Connection::AwaitingResponse) {
+    c->mutex.unlock();
+    dispatch(c);
+    c->mutex.lock();
+  }
+  return true;
+}
+
+void ServerCore::consumeBody(const ConnectionPtr& c) {
+  AsyncWebServerRequest* req = c->request;
+  size_t remaining = req->_contentLength - c->bodyReceived;
+  size_t take = c->in.size() < remaining ? c->in.size() : remaining;
+  if (take == 0) return;
+  std::string chunk = c->in.substr(0, take);
+  c->in.erase(0, take);
+  size_t index = c->bodyReceived;
+  c->bodyReceived += take;
+
+  bool urlencoded = req->_contentType.equalsIgnoreCase("application/x-www-form-urlencoded");
+  if (req->_isMultipart) {
+    feedMultipart(c, chunk.data(), chunk.size());
+  } else if (urlencoded) {
+    c->formBody += chunk;
+  } else if (req->_handler) {
+    req->_handler->handleBody(req, reinterpret_cast<uint8_t*>(&chunk[0]), chunk.size(), index, req->_contentLength);
+  }
+
+  if (c->bodyReceived < req->_contentLength) return;
+  if (urlencoded) parseQuery(c->formBody.data(), c->formBody.size(), req->_params, true);
+  {
+    std::lock_guard<std::mutex> lock(c->mutex);
+    c->state = Connection::AwaitingResponse;
+  }
+  dispatch(c);
+}
+
+void ServerCore::flushUploadItem(const ConnectionPtr& c, bool final) {
+  AsyncWebServerRequest* req = c->request;
+  if (req->_handler) {
+    req->_handler->handleUpload(req, c->mpFilename, c->mpItemIndex, reinterpret_cast<uint8_t*>(&c->mpItem[0]),
+                                c->mpItem.size(), final);
+  }
+  c->mpItemIndex += c->mpItem.size();
+  c->mpItem.clear();
+}
+
+void ServerCore::feedMultipart(const ConnectionPtr& c, const char* data, size_t len) {
+  AsyncWebServerRequest* req = c->request;
+  c->mpBuf.append(data, len);
+  std::string dash = "--" + std::string(req->_boundary.c_str());
+  std::string delim = "\r\n" + dash;
+  for (;;) {
+    if (c->mpState == Connection::MpPreamble) {
+      size_t p = c->mpBuf.find(dash);
+      if (p == std::string::npos || c->mpBuf.size() < p + dash.size() + 2) return;
+      c->mpBuf.erase(0, p + dash.size() + 2);
+      c->mpState = Connection::MpHeaders;
+    } else if (c->mpState == Connection::MpHeaders) {
+      size_t p = c->mpBuf.find("\r\n\r\n");
+      if (p == std::string::npos) return;
+      std::string headers = c->mpBuf.substr(0, p);
+      c->mpBuf.erase(0, p + 4);
+      c->mpName = headerAttribute(headers, "name");
+      c->mpFilename = headerAttribute(headers, "filename");
+      c->mpIsFile = headers.find("filename=\"") != std::string::npos;
+      c->mpItem.clear();
+      c->mpItemIndex = 0;
+      c->mpItemSize = 0;
+      c->mpState = Connection::MpData;
+    } else if (c->mpState == Connection::MpData) {
+      size_t p = c->mpBuf.find(delim);
+      size_t usable = p != std::string::npos ? p : (c->mpBuf.size() > delim.size() ? c->mpBuf.size() - delim.size() : 0);
+      for (size_t i = 0; i < usable;) {
+        size_t n = usable - i;
+        if (c->mpIsFile) {
+          size_t room = kUploadChunk - c->mpItem.size();
+          if (n > room) n = room;
+          c->mpItem.append(c->mpBuf, i, n);
+          c->mpItemSize += n;
+          if (c->mpItem.size() == kUploadChunk) flushUploadItem(c, false);
+        } else {
+          c->mpItem.append(c->mpBuf, i, n);
+          c->mpItemSize += n;
+        }
+        i += n;
+      }
+      c->mpBuf.erase(0, usable);
+      if (p == std::string::npos) return;
+      c->mpBuf.erase(0, delim.size());
+      if (c->mpIsFile) {
+        flushUploadItem(c, true);
+        req->_params.push_back(AsyncWebParameter(c->mpName, c->mpFilename, true, true, c->mpItemSize));
+      } else {
+        req->_params.push_back(AsyncWebParameter(c->mpName, String(c->mpItem.c_str(), static_cast<unsigned int>(c->mpItem.size())), true));
+        c->mpItem.clear();
+      }
+      c->mpState = Connection::MpBoundaryTail;
+    } else if (c->mpState == Connection::MpBoundaryTail) {
+      if (c->mpBuf.size() < 2) return;
+      if (c->mpBuf.compare(0, 2, "--") == 0) {
+        c->mpState = Connection::MpDone;
+        c->mpBuf.clear();
+        return;
+      }
+      c->mpBuf.erase(0, 2);
+      c->mpState = Connection::MpHeaders;
+    } else {
+      c->mpBuf.clear();
+      return;
+    }
+  }
+}
+
+void ServerCore::dispatch(const ConnectionPtr& c) {
+  AsyncWebServerRequest* req = c->request;
+  if (req->_handler) req->_handler->handleRequest(req);
+  else req->send(501);
+}
+
+void ServerCore::pump(const ConnectionPtr& c) {
+  std::lock_guard<std::mutex> lock(c->mutex);
+  if (c->state == Connection::AwaitingResponse && c->response) c->state = Connection::Sending;
+
+  if (c->state == Connection::Sending && c->response) {
+    AsyncWebServerResponse* r = c->response;
+    bool headOnly = c->request && c->request->method() == HTTP_HEAD;
+    bool chunked = r->_isChunked() && c->request && c->request->version() == 1;
+    if (!c->headSent) {
+      String head = r->_assembleHead(c->request ? c->request->version() : 1);
+      c->out.append(head.c_str(), head.length());
+      c->totalQueued += head.length();
+      c->headSent = true;
+      if (headOnly || !r->_sourceValid()) c->bodyDone = true;
+    }
+    while (!c->bodyDone && c->out.size() - c->outSent < kSendWindow) {
+      uint8_t buf[kSendWindow];
+      size_t room = kSendWindow - (c->out.size() - c->outSent);
+      if (chunked) room = room > 16 ? room - 16 : 0;
+      if (room == 0) break;
+      size_t n = r->_fillBody(buf, room);
+      if (n == RESPONSE_TRY_AGAIN) break;
+      if (n == 0) {
+        if (chunked) c->out += "0\r\n\r\n";
+        c->bodyDone = true;
+        break;
+      }
+      if (chunked) {
+        char hdr[24];
+        snprintf(hdr, sizeof(hdr), "%zx\r\n", n);
+        c->out += hdr;
+        c->out.append(reinterpret_cast<char*>(buf), n);
+        c->out += "\r\n";
+      } else {
+        c->out.append(reinterpret_cast<char*>(buf), n);
+      }
+      c->totalQueued += n;
+    }
+  }
+
+  while (c->out.size() > c->outSent) {
+    ssize_t n = send(c->fd, c->out.data() + c->outSent, c->out.size() - c->outSent, MSG_NOSIGNAL);
+    if (n <= 0) break;
+    c->outSent += static_cast<size_t>(n);
+    c->totalSent += static_cast<size_t>(n);
+  }
+  while (!c->messageEnds.empty() && c->messageEnds.front() <= c->totalSent) c->messageEnds.pop_front();
+  if (c->outSent == c->out.size()) {
+    c->out.clear();
+    c->outSent = 0;
+  } else if (c->outSent > 64 * 1024) {
+    c->out.erase(0, c->outSent);
+    c->outSent = 0;
+  }
+
+  bool done = c->out.empty() &&
+              ((c->state == Connection::Sending && c->bodyDone) || (c->state == Connection::WebSocket && c->closeWhenFlushed));
+  if (done) {
+    c->mutex.unlock();
+    close(c);
+    c->mutex.lock();
+  }
+}
+
+void ServerCore::close(const ConnectionPtr& c) {
+  AsyncWebServerRequest* req;
+  AsyncWebServerResponse* resp;
+  AsyncWebSocket* ws;
+  {
+    std::lock_guard<std::mutex> lock(c->mutex);
+    if (c->state == Connection::Closed && c->fd < 0) return;
+    c->state = Connection::Closed;
+    req = c->request;
+    resp = c->response;
+    ws = c->ws;
+    c->request = nullptr;
+    c->response = nullptr;
+    c->ws = nullptr;
+    if (c->fd >= 0) ::close(c->fd);
+    c->fd = -1;
+  }
+  if (ws) ws->_onClientGone(c.get());
+  if (req) {
+    req->_client._connected = false;
+    if (req->_onDisconnect) req->_onDisconnect();
+    delete req;
+  }
+  delete resp;
+  for (auto it = conns.begin(); it != conns.end(); ++it) {
+    if (it->get() == c.get()) {
+      conns.erase(it);
+      break;
+    }
+  }
+}
+
+int ServerCore::serveLocal(const char* method, const char* target, std::string* body) {
+  // A connection that is never accepted: no fd, not in `conns`, so this may
+  // run on any thread.
+  auto c = std::make_shared<Connection>();
+  c->remoteIP = c->localIP = IPAddress(127, 0, 0, 1);
+  c->localPort = port;
+  c->in = std::string(method) + " " + target + " HTTP/1.1\r\nHost: localhost\r\n\r\n";
+  parseHead(c);
+
+  AsyncWebServerRequest* req;
+  AsyncWebServerResponse* resp;
+  {
+    std::lock_guard<std::mutex> lock(c->mutex);
+    req = c->request;
+    resp = c->response;
+    c->request = nullptr;
+    c->response = nullptr;
+    c->state = Connection::Closed;
+  }
+  int code = resp ? resp->code() : 0;
+  if (body) body->clear();
+  if (resp && resp->_sourceValid()) {
+    uint8_t buf[kSendWindow];
+    for (;;) {
+      size_t n = resp->_fillBody(buf, sizeof(buf));
+      if (n == 0 || n == RESPONSE_TRY_AGAIN) break;
+      if (body) body->append(reinterpret_cast<char*>(buf), n);
+    }
+  }
+  if (req) {
+    req->_client._connected = false;
+    if (req->_onDisconnect) req->_onDisconnect();
+    delete req;
+  }
+  delete resp;
+  return code;
+}
+
+} // namespace NativeSimHttp
+
+int NativeSim::serveInProcess(uint16_t port, const char* method, const char* target, std::string* body) {
+  NativeSimHttp::ServerCore* core = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(g_coresMutex);
+    for (auto* candidate : g_cores) {
+      if (candidate->port == port) core = candidate;
+    }
+  }
+  return core ? core->serveLocal(method, target, body) : -1;
+}
+
+// ----- AsyncWebServerResponse -----
+bool AsyncWebServerResponse::addHeader(const String& name, const String& value, bool replaceExisting) {
+  for (auto& h : _headers) {
+    if (h.name().equalsIgnoreCase(name)) {
+      if (!replaceExisting) return false;
+      h = AsyncWebHeader(name, value);
+      return true;
+    }
+  }
+  _headers.push_back(AsyncWebHeader(name, value));
+  return true;
+}
+
+bool AsyncWebServerResponse::removeHeader(const char* name) {
+  for (auto it = _headers.begin(); it != _headers.end(); ++it) {
+    if (headerEquals(it->name(), name)) {
+      _headers.erase(it);
+      return true;
+    }
+  }
+  return false;
+}
+
+const AsyncWebHeader* AsyncWebServerResponse::getHeader(const char* name) const {
+  for (auto& h : _headers) {
+    if (headerEquals(h.name(), name)) return &h;
+  }
+  return nullptr;
+}
+
+String AsyncWebServerResponse::_assembleHead(uint8_t version) {
+  if (version == 0) _chunked = false;
+  String out;
+  char line[64];
+  snprintf(line, sizeof(line), "HTTP/1.%d %d %s\r\n", version, _code, statusText(_code));
+  out += line;
+  out += "Connection: close\r\n";
+  if (_chunked) out += "Transfer-Encoding: chunked\r\n";
+  else if (_sendContentLength) out += "Content-Length: " + String(static_cast<unsigned long>(_contentLength)) + "\r\n";
+  if (_contentType.length()) out += "Content-Type: " + _contentType + "\r\n";
+  for (auto& h : _headers) out += h.toString();
+  out += "\r\n";
+  return out;
+}
+
+AsyncBasicResponse::AsyncBasicResponse(int code, const String& contentType, const String& content)
+    : _content(content) {
+  _code = code;
+  _contentType = contentType;
+  _contentLength = _content.length();
+  if (_contentLength && !_contentType.length()) _contentType = "text/plain";
+}
+
+size_t AsyncBasicResponse::_fillBody(uint8_t* buf, size_t maxLen) {
+  size_t left = _contentLength - _sentBody;
+  size_t n = left < maxLen ? left : maxLen;
+  memcpy(buf, _content.c_str() + _sentBody, n);
+  _sentBody += n;
+  return n;
+}
+
+AsyncProgmemResponse::AsyncProgmemResponse(int code, const String& contentType, const uint8_t* content, size_t len)
+    : _content(content) {
+  _code = code;
+  _contentType = contentType;
+  _contentLength = len;
+}
+
+size_t AsyncProgmemResponse::_fillBody(uint8_t* buf, size_t maxLen) {
+  size_t left = _contentLength - _sentBody;
+  size_t n = left < maxLen ? left : maxLen;
+  memcpy(buf, _content + _sentBody, n);
+  _sentBody += n;
+  return n;
+}
+
+AsyncFileResponse::AsyncFileResponse(FS& fs, const String& path, const String& contentType, bool download) {
+  String actual = path;
+  if (!download && !fs.exists(path) && fs.exists(path + ".gz")) actual = path + ".gz";
+  _content = fs.open(actual, FILE_READ);
+  if (actual != path) addHeader("Content-Encoding", "gzip");
+  setup(path, contentType, download);
+}
+
+AsyncFileResponse::AsyncFileResponse(File content, const String& path, const String& contentType, bool download)
+    : _content(content) {
+  String name = _content ? String(_content.name()) : String();
+  if (name.endsWith(".gz") && !path.endsWith(".gz")) addHeader("Content-Encoding", "gzip");
+  setup(path, contentType, download);
+}
+
+void AsyncFileResponse::setup(const String& path, const String& contentType, bool download) {
+  _code = _content ? 200 : 404;
+  _contentLength = _content ? _content.size() : 0;
+  _contentType = contentType.length() ? contentType : String(download ? "application/octet-stream" : NativeSimHttp::contentTypeFor(path));
+  int slash = path.lastIndexOf('/');
+  String filename = path.substring(slash + 1);
+  addHeader("Content-Disposition", (download ? "attachment; filename=\"" : "inline; filename=\"") + filename + "\"");
+}
+
+size_t AsyncFileResponse::_fillBody(uint8_t* buf, size_t maxLen) {
+  if (!_content) return 0;
+  size_t left = _contentLength - _sentBody;
+  size_t n = _content.read(buf, left < maxLen ? left : maxLen);
+  _sentBody += n;
+  return n;
+}
+
+AsyncCallbackResponse::AsyncCallbackResponse(const String& contentType, size_t len, AwsResponseFiller callback)
+    : _callback(callback) {
+  _contentType = contentType;
+  _contentLength = len;
+  if (len == 0) _sendContentLength = false;
+}
+
+size_t AsyncCallbackResponse::_fillBody(uint8_t* buf, size_t maxLen) {
+  if (_sendContentLength) {
+    size_t left = _contentLength - _filled;
+    if (left == 0) return 0;
+    if (maxLen > left) maxLen = left;
+  }
+  size_t n = _callback(buf, maxLen, _filled);
+  if (n == RESPONSE_TRY_AGAIN) return n;
+  if (n > maxLen) n = maxLen;
+  _filled += n;
+  return n;
+}
+
+AsyncChunkedResponse::AsyncChunkedResponse(const String& contentType, AwsResponseFiller callback)
+    : AsyncCallbackResponse(contentType, 0, callback) {
+  _chunked = true;
+}
+
+AsyncResponseStream::AsyncResponseStream(const String& contentType, size_t bufferSize) {
+  _contentType = contentType;
+  _buffer.reserve(bufferSize);
+}
+
+size_t AsyncResponseStream::write(uint8_t data) { return write(&data, 1); }
+
+size_t AsyncResponseStream::write(const uint8_t* data, size_t len) {
+  _buffer.insert(_buffer.end(), data, data + len);
+  _contentLength = _buffer.size();
+  return len;
+}
+
+size_t AsyncResponseStream::_fillBody(uint8_t* buf, size_t maxLen) {
+  size_t left = _buffer.size() - _readPos;
+  size_t n = left < maxLen ? left : maxLen;
+  memcpy(buf, _buffer.data() + _readPos, n);
+  _readPos += n;
+  return n;
+}
+
+// ----- AsyncWebServerRequest -----
+AsyncWebServerRequest::AsyncWebServerRequest(AsyncWebServer* server, NativeSimHttp::Connection* conn)
+    : _server(server), _conn(conn) {}
+
+AsyncWebServerRequest::~AsyncWebServerRequest() {
+  if (_tempObject) free(_tempObject);
+}
+
+const char* AsyncWebServerRequest::methodToString() const {
+  switch (_method) {
+    case HTTP_GET: return "GET";
+    case HTTP_POST: return "POST";
+    case HTTP_DELETE: return "DELETE";
+    case HTTP_PUT: return "PUT";
+    case HTTP_PATCH: return "PATCH";
+    case HTTP_HEAD: return "HEAD";
+    case HTTP_OPTIONS: return "OPTIONS";
+    default: return "UNKNOWN";
+  }
+}
+
+void AsyncWebServerRequest::send(AsyncWebServerResponse* response) {
+  if (!response) return;
+  {
+    std::lock_guard<std::mutex> lock(_conn->mutex);
+    if (_conn->response || _conn->state == NativeSimHttp::Connection::Closed) {
+      delete response;
+      return;
+    }
+    _conn->response = response;
+  }
+  _conn->wake();
+}
+
+AsyncWebServerResponse* AsyncWebServerRequest::getResponse() const {
+  std::lock_guard<std::mutex> lock(_conn->mutex);
+  return _conn->response;
+}
+
+void AsyncWebServerRequest::send(int code, const String& contentType, const String& content) {
+  send(beginResponse(code, contentType, content));
+}
+
+void AsyncWebServerRequest::send(FS& fs, const String& path, const String& contentType, bool download,
+                                 AwsTemplateProcessor callback) {
+  send(beginResponse(fs, path, contentType, download, callback));
+}
+
+void AsyncWebServerRequest::send(File content, const String& path, const String& contentType, bool download,
+                                 AwsTemplateProcessor callback) {
+  send(beginResponse(content, path, contentType, download, callback));
+}
+
+void AsyncWebServerRequest::send(const String& contentType, size_t len, AwsResponseFiller callback) {
+  send(beginResponse(contentType, len, callback));
+}
+
+void AsyncWebServerRequest::sendChunked(const String& contentType, AwsResponseFiller callback) {
+  send(beginChunkedResponse(contentType, callback));
+}
+
+void AsyncWebServerRequest::send_P(int code, const String& contentType, const uint8_t* content, size_t len) {
+  send(beginResponse_P(code, contentType, content, len));
+}
+
+void AsyncWebServerRequest::send_P(int code, const String& contentType, PGM_P content) {
+  send(beginResponse_P(code, contentType, content));
+}
+
+void AsyncWebServerRequest::redirect(const String& url) {
+  AsyncWebServerResponse* response = beginResponse(302);
+  response->addHeader("Location", url);
+  send(response);
+}
+
+AsyncWebServerResponse* AsyncWebServerRequest::beginResponse(int code, const String& contentType, const String& content) {
+  return new AsyncBasicResponse(code, contentType, content);
+}
+
+AsyncWebServerResponse* AsyncWebServerRequest::beginResponse(FS& fs, const String& path, const String& contentType,
+                                                             bool download, AwsTemplateProcessor callback) {
+  (void)callback;
+  if (fs.exists(path) || (!download && fs.exists(path + ".gz"))) return new AsyncFileResponse(fs, path, contentType, download);
+  return nullptr;
+}
+
+AsyncWebServerResponse* AsyncWebServerRequest::beginResponse(File content, const String& path, const String& contentType,
+                                                             bool download, AwsTemplateProcessor callback) {
+  (void)callback;
+  if (content) return new AsyncFileResponse(content, path, contentType, download);
+  return nullptr;
+}
+
+AsyncWebServerResponse* AsyncWebServerRequest::beginResponse(const String& contentType, size_t len, AwsResponseFiller callback) {
+  return new AsyncCallbackResponse(contentType, len, callback);
+}
+
+AsyncWebServerResponse* AsyncWebServerRequest::beginChunkedResponse(const String& contentType, AwsResponseFiller callback) {
+  return new AsyncChunkedResponse(contentType, callback);
+}
+
+AsyncResponseStream* AsyncWebServerRequest::beginResponseStream(const String& contentType, size_t bufferSize) {
+  return new AsyncResponseStream(contentType, bufferSize);
+}
+
+AsyncWebServerResponse* AsyncWebServerRequest::beginResponse_P(int code, const String& contentType, const uint8_t* content, size_t len) {
+  return new AsyncProgmemResponse(code, contentType, content, len);
+}
+
+AsyncWebServerResponse* AsyncWebServerRequest::beginResponse_P(int code, const String& contentType, PGM_P content) {
+  return beginResponse_P(code, contentType, reinterpret_cast<const uint8_t*>(content), strlen(content));
+}
+
+bool AsyncWebServerRequest::authenticate(const char* username, const char* password, const char* realm, bool passwordIsHash) {
+  (void)realm;
+  (void)passwordIsHash;
+  const AsyncWebHeader* h = getHeader("Authorization");
+  if (!h || !h->value().startsWith("Basic ")) return false;
+  String encoded = h->value().substring(6);
+  encoded.trim();
+  std::string decoded = NativeSimHttp::base64Decode(encoded.c_str(), encoded.length());
+  std::string expected = std::string(username ? username : "") + ":" + (password ? password : "");
+  return decoded == expected;
+}
+
+void AsyncWebServerRequest::requestAuthentication(const char* realm, bool isDigest) {
+  (void)isDigest;
+  AsyncWebServerResponse* r = beginResponse(401);
+  r->addHeader("WWW-Authenticate", String("Basic realm=\"") + (realm ? realm : "Login Required") + "\"");
+  send(r);
+}
+
+bool AsyncWebServerRequest::hasHeader(const String& name) const { return getHeader(name) != nullptr; }
+
+const AsyncWebHeader* AsyncWebServerRequest::getHeader(const String& name) const {
+  for (auto& h : _headers) {
+    if (h.name().equalsIgnoreCase(name)) return &h;
+  }
+  return nullptr;
+}
+
+const AsyncWebHeader* AsyncWebServerRequest::getHeader(size_t num) const {
+  return num < _headers.size() ? &_headers[num] : nullptr;
+}
+
+const String& AsyncWebServerRequest::header(const char* name) const {
+  static const String empty;
+  const AsyncWebHeader* h = getHeader(name);
+  return h ? h->value() : empty;
+}
+
+bool AsyncWebServerRequest::hasParam(const String& name, bool post, bool file) const {
+  return getParam(name, post, file) != nullptr;
+}
+
+const AsyncWebParameter* AsyncWebServerRequest::getParam(const String& name, bool post, bool file) const {
+  for (auto& p : _params) {
+    if (p.name() == name && p.isPost() == post && p.isFile() == file) return &p;
+  }
+  return nullptr;
+}
+
+const AsyncWebParameter* AsyncWebServerRequest::getParam(size_t num) const {
+  return num < _params.size() ? &_params[num] : nullptr;
+}
+
+bool AsyncWebServerRequest::hasArg(const char* name) const {
+  for (auto& p : _params) {
+    if (p.name() == name) return true;
+  }
+  return false;
+}
+
+const String& AsyncWebServerRequest::arg(const String& name) const {
+  static const String empty;
+  for (auto& p : _params) {
+    if (p.name() == name) return p.value();
+  }
+  return empty;
+}
+
+const String& AsyncWebServerRequest::arg(size_t i) const {
+  static const String empty;
+  return i < _params.size() ? _params[i].value() : empty;
+}
+
+const String& AsyncWebServerRequest::argName(size_t i) const {
+  static const String empty;
+  return i < _params.size() ? _params[i].name() : empty;
+}
+
+// ----- Handlers -----
+bool AsyncCallbackWebHandler::canHandle(AsyncWebServerRequest* request) {
+  if (!_onRequest) return false;
+  if (!(_method & request->method())) return false;
+  if (_uri.length() && _uri.startsWith("/*.")) {
+    String ext = _uri.substring(_uri.lastIndexOf('.'));
+    return request->url().endsWith(ext);
+  }
+  if (_uri.length() && _uri.endsWith("*")) {
+    return request->url().startsWith(_uri.substring(0, _uri.length() - 1));
+  }
+  if (_uri.length() && _uri != request->url() && !request->url().startsWith(_uri + "/")) return false;
+  return true;
+}
+
+void AsyncCallbackWebHandler::handleRequest(AsyncWebServerRequest* request) {
+  if (_username.length() && _password.length() && !request->authenticate(_username.c_str(), _password.c_str())) {
+    request->requestAuthentication();
+    return;
+  }
+  if (_onRequest) _onRequest(request);
+  else request->send(500);
+}
+
+void AsyncCallbackWebHandler::handleUpload(AsyncWebServerRequest* request, const String& filename, size_t index,
+                                           uint8_t* data, size_t len, bool final) {
+  if (_onUpload) _onUpload(request, filename, index, data, len, final);
+}
+
+void AsyncCallbackWebHandler::handleBody(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index,
+                                         size_t total) {
+  if (_onBody) _onBody(request, data, len, index, total);
+}
+
+AsyncStaticWebHandler::AsyncStaticWebHandler(const char* uri, FS& fs, const char* path, const char* cache_control)
+    : _fs(fs), _uri(uri), _path(path), _cache_control(cache_control ? cache_control : "") {
+  if (_uri.length() == 0 || _uri[0] != '/') _uri = "/" + _uri;
+  if (_path.length() == 0 || _path[0] != '/') _path = "/" + _path;
+  _isDir = _path[_path.length() - 1] == '/';
+  if (_uri[_uri.length() - 1] == '/') _uri = _uri.substring(0, _uri.length() - 1);
+  if (_path[_path.length() - 1] == '/') _path = _path.substring(0, _path.length() - 1);
+}
+
+bool AsyncStaticWebHandler::getFile(AsyncWebServerRequest* request, String& resolved, bool& gzipped) {
+  String path = request->url().substring(_uri.length());
+  bool canSkipFileCheck = (_isDir && path.length() == 0) || path.endsWith("/");
+  path = _path + path;
+  auto exists = [&](const String& p) {
+    if (_fs.exists(p + ".gz")) { resolved = p; gzipped = true; return true; }
+    if (_fs.exists(p)) {
+      File f = _fs.open(p, FILE_READ);
+      if (f && !f.isDirectory()) { resolved = p; gzipped = false; return true; }
+    }
+    return false;
+  };
+  if (!canSkipFileCheck && exists(path)) return true;
+  if (_defaultFile.length() == 0) return false;
+  if (!path.endsWith("/")) path += "/";
+  path += _defaultFile;
+  return exists(path);
+}
+
+bool AsyncStaticWebHandler::canHandle(AsyncWebServerRequest* request) {
+  if (request->method() != HTTP_GET && request->method() != HTTP_HEAD) return false;
+  if (!request->url().startsWith(_uri)) return false;
+  String resolved;
+  bool gzipped;
+  return getFile(request, resolved, gzipped);
+}
+
+void AsyncStaticWebHandler::handleRequest(AsyncWebServerRequest* request) {
+  String resolved;
+  bool gzipped = false;
+  if (!getFile(request, resolved, gzipped)) {
+    request->send(404);
+    return;
+  }
+  if (_last_modified.length() && _last_modified == request->header("If-Modified-Since")) {
+    request->send(304);
+    return;
+  }
+  File file = _fs.open(gzipped ? resolved + ".gz" : resolved, FILE_READ);
+  AsyncWebServerResponse* response = new AsyncFileResponse(file, resolved);
+  if (_last_modified.length()) response->addHeader("Last-Modified", _last_modified);
+  if (_cache_control.length()) response->addHeader("Cache-Control", _cache_control);
+  request->send(response);
+}
+
+// ----- AsyncWebServer -----
+AsyncWebServer::AsyncWebServer(uint16_t port)
+    : _port(port), _catchAllHandler(new AsyncCallbackWebHandler()), _serverCore(new NativeSimHttp::ServerCore()) {
+  _serverCore->server = this;
+  _serverCore->port = port;
+  _catchAllHandler->onRequest([](AsyncWebServerRequest* request) { request->send(404); });
+}
+
+AsyncWebServer::~AsyncWebServer() {
+  end();
+  reset();
+  delete _catchAllHandler;
+  delete _serverCore;
+}
+
+void AsyncWebServer::begin() {
+  if (!_serverCore->running) _serverCore->start();
+}
+
+void AsyncWebServer::end() { _serverCore->stop(); }
+
+void AsyncWebServer::reset() {
+  for (auto h : _handlers) {
+    // The library owns handlers created by on()/serveStatic(); WebSocket
+    // handlers added with addHandler() stay owned by the caller.
+    if (!dynamic_cast<AsyncWebSocket*>(h)) delete h;
+  }
+  _handlers.clear();
+}
+
+AsyncWebHandler& AsyncWebServer::addHandler(AsyncWebHandler* handler) {
+  _handlers.push_back(handler);
+  return *handler;
+}
+
+bool AsyncWebServer::removeHandler(AsyncWebHandler* handler) {
+  for (auto it = _handlers.begin(); it != _handlers.end(); ++it) {
+    if (*it == handler) {
+      _handlers.erase(it);
+      return true;
+    }
+  }
+  return false;
+}
+
+AsyncCallbackWebHandler& AsyncWebServer::on(const char* uri, ArRequestHandlerFunction onRequest) {
+  return on(uri, HTTP_ANY, onRequest);
+}
+
+AsyncCallbackWebHandler& AsyncWebServer::on(const char* uri, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest) {
+  return on(uri, method, onRequest, nullptr, nullptr);
+}
+
+AsyncCallbackWebHandler& AsyncWebServer::on(const char* uri, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest,
+                                            ArUploadHandlerFunction onUpload) {
+  return on(uri, method, onRequest, onUpload, nullptr);
+}
+
+AsyncCallbackWebHandler& AsyncWebServer::on(const char* uri, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest,
+                                            ArUploadHandlerFunction onUpload, ArBodyHandlerFunction onBody) {
+  auto* handler = new AsyncCallbackWebHandler();
+  handler->setUri(uri);
+  handler->setMethod(method);
+  handler->onRequest(onRequest);
+  handler->onUpload(onUpload);
+  handler->onBody(onBody);
+  addHandler(handler);
+  return *handler;
+}
+
+AsyncStaticWebHandler& AsyncWebServer::serveStatic(const char* uri, fs::FS& fs, const char* path, const char* cache_control) {
+  auto* handler = new AsyncStaticWebHandler(uri, fs, path, cache_control);
+  addHandler(handler);
+  return *handler;
+}
+
+void AsyncWebServer::onNotFound(ArRequestHandlerFunction fn) { _catchAllHandler->onRequest(fn); }
+void AsyncWebServer::onFileUpload(ArUploadHandlerFunction fn) { _catchAllHandler->onUpload(fn); }
+void AsyncWebServer::onRequestBody(ArBodyHandlerFunction fn) { _catchAllHandler->onBody(fn); }
+
+AsyncWebHandler* AsyncWebServer::_attachHandler(AsyncWebServerRequest* request) {
+  for (auto h : _handlers) {
+    if (h->filter(request) && h->canHandle(request)) return h;
+  }
+  return _catchAllHandler;
+}
@@ -0,0 +1,303 @@
+#include "AsyncWebSocket.h"
+#include "NativeSimHttp.h"
+
+using NativeSimHttp::Connection;
+
+namespace {
+const char kWsGuid[] = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+}
+
+// ----- AsyncWebSocketClient -----
+AsyncWebSocketClient::AsyncWebSocketClient(AsyncWebSocket* server, std::shared_ptr<Connection> conn, uint32_t id)
+    : _conn(conn), _server(server), _clientId(id) {
+  _client._remoteIP = conn->remoteIP;
+  _client._remotePort = conn->remotePort;
+  _client._localIP = conn->localIP;
+  _client._localPort = conn->localPort;
+}
+
+AsyncWebSocketClient::~AsyncWebSocketClient() {
+  if (_tempObject) free(_tempObject);
+}
+
+AwsClientStatus AsyncWebSocketClient::status() const {
+  std::lock_guard<std::mutex> lock(_conn->mutex);
+  if (_conn->state == Connection::Closed) return WS_DISCONNECTED;
+  return _conn->closeWhenFlushed ? WS_DISCONNECTING : WS_CONNECTED;
+}
+
+bool AsyncWebSocketClient::queueIsFull() const { return queueLen() >= WS_MAX_QUEUED_MESSAGES; }
+
+size_t AsyncWebSocketClient::queueLen() const { return _conn->queuedMessages(); }
+
+void AsyncWebSocketClient::close(uint16_t code, const char* message) {
+  std::string payload;
+  if (code) {
+    payload += static_cast<char>(code >> 8);
+    payload += static_cast<char>(code & 0xFF);
+    if (message) payload += message;
+  }
+  std::string frame = NativeSimHttp::encodeWebSocketFrame(WS_DISCONNECT, reinterpret_cast<const uint8_t*>(payload.data()),
+                                                          payload.size());
+  _conn->queue(frame.data(), frame.size());
+  {
+    std::lock_guard<std::mutex> lock(_conn->mutex);
+    _conn->closeWhenFlushed = true;
+  }
+  _conn->wake();
+}
+
+void AsyncWebSocketClient::ping(const uint8_t* data, size_t len) {
+  std::string frame = NativeSimHttp::encodeWebSocketFrame(WS_PING, data, len);
+  _conn->queue(frame.data(), frame.size());
+}
+
+bool AsyncWebSocketClient::text(const char* message, size_t len) {
+  // Like the library, a full queue drops the message instead of blocking.
+  if (queueIsFull() || status() != WS_CONNECTED) return false;
+  std::string frame = NativeSimHttp::encodeWebSocketFrame(WS_TEXT, reinterpret_cast<const uint8_t*>(message), len);
+  return _conn->queue(frame.data(), frame.size(), true);
+}
+
+bool AsyncWebSocketClient::text(const char* message) { return text(message, strlen(message)); }
+
+bool AsyncWebSocketClient::binary(const uint8_t* message, size_t len) {
+  if (queueIsFull() || status() != WS_CONNECTED) return false;
+  std::string frame = NativeSimHttp::encodeWebSocketFrame(WS_BINARY, message, len);
+  return _conn->queue(frame.data(), frame.size(), true);
+}
+
+// ----- AsyncWebSocket -----
+AsyncWebSocket::AsyncWebSocket(const String& url) : _url(url) {}
+
+AsyncWebSocket::~AsyncWebSocket() { closeAll(); }
+
+bool AsyncWebSocket::canHandle(AsyncWebServerRequest* request) {
+  return _enabled && request->method() == HTTP_GET && request->url() == _url && request->hasHeader("Upgrade") &&
+         request->header("Upgrade").equalsIgnoreCase("websocket");
+}
+
+void AsyncWebSocket::handleRequest(AsyncWebServerRequest* request) {
+  // Only reached when the upgrade could not be performed.
+  request->send(400);
+}
+
+bool AsyncWebSocket::_upgrade(AsyncWebServerRequest* request, Connection* conn) {
+  if (!request->hasHeader("Sec-WebSocket-Key")) return false;
+  if (_username.length() && _password.length() && !request->authenticate(_username.c_str(), _password.c_str())) {
+    return false;
+  }
+  std::string key = std::string(request->header("Sec-WebSocket-Key").c_str()) + kWsGuid;
+  uint8_t digest[20];
+  NativeSimHttp::sha1(reinterpret_cast<const uint8_t*>(key.data()), key.size(), digest);
+  std::string accept = NativeSimHttp::base64Encode(digest, sizeof(digest));
+  std::string head = "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                     "Sec-WebSocket-Accept: " + accept + "\r\n\r\n";
+
+  AsyncWebSocketClient* client;
+  {
+    std::lock_guard<std::recursive_mutex> lock(_lock);
+    _clients.emplace_back(new AsyncWebSocketClient(this, conn->shared_from_this(), _cNextId++));
+    client = _clients.back().get();
+  }
+  conn->queue(head.data(), head.size());
+  {
+    std::lock_guard<std::mutex> lock(conn->mutex);
+    conn->ws = this;
+  }
+  _handleEvent(client, WS_EVT_CONNECT, request, nullptr, 0);
+  return true;
+}
+
+void AsyncWebSocket::_handleEvent(AsyncWebSocketClient* client, AwsEventType type, void* arg, uint8_t* data, size_t len) {
+  if (_eventHandler) _eventHandler(this, client, type, arg, data, len);
+}
+
+AsyncWebSocketClient* AsyncWebSocket::_clientFor(Connection* conn) {
+  std::lock_guard<std::recursive_mutex> lock(_lock);
+  for (auto& c : _clients) {
+    if (c->_conn.get() == conn) return c.get();
+  }
+  return nullptr;
+}
+
+void AsyncWebSocket::_onClientGone(Connection* conn) {
+  std::unique_ptr<AsyncWebSocketClient> gone;
+  {
+    std::lock_guard<std::recursive_mutex> lock(_lock);
+    for (auto it = _clients.begin(); it != _clients.end(); ++it) {
+      if ((*it)->_conn.get() == conn) {
+        gone = std::move(*it);
+        _clients.erase(it);
+        break;
+      }
+    }
+  }
+  if (gone) _handleEvent(gone.get(), WS_EVT_DISCONNECT, nullptr, nullptr, 0);
+}
+
+size_t AsyncWebSocket::count() const {
+  std::lock_guard<std::recursive_mutex> lock(_lock);
+  size_t n = 0;
+  for (auto& c : _clients) {
+    if (c->status() == WS_CONNECTED) n++;
+  }
+  return n;
+}
+
+AsyncWebSocketClient* AsyncWebSocket::client(uint32_t id) {
+  std::lock_guard<std::recursive_mutex> lock(_lock);
+  for (auto& c : _clients) {
+    if (c->id() == id && c->status() == WS_CONNECTED) return c.get();
+  }
+  return nullptr;
+}
+
+bool AsyncWebSocket::availableForWriteAll() {
+  std::lock_guard<std::recursive_mutex> lock(_lock);
+  for (auto& c : _clients) {
+    if (c->queueIsFull()) return false;
+  }
+  return true;
+}
+
+bool AsyncWebSocket::availableForWrite(uint32_t id) {
+  AsyncWebSocketClient* c = client(id);
+  return c && !c->queueIsFull();
+}
+
+void AsyncWebSocket::close(uint32_t id, uint16_t code, const char* message) {
+  AsyncWebSocketClient* c = client(id);
+  if (c) c->close(code, message);
+}
+
+void AsyncWebSocket::closeAll(uint16_t code, const char* message) {
+  std::lock_guard<std::recursive_mutex> lock(_lock);
+  for (auto& c : _clients) {
+    if (c->status() == WS_CONNECTED) c->close(code, message);
+  }
+}
+
+void AsyncWebSocket::cleanupClients(uint16_t maxClients) {
+  std::lock_guard<std::recursive_mutex> lock(_lock);
+  if (count() > maxClients) _clients.front()->close();
+}
+
+void AsyncWebSocket::ping(uint32_t id, const uint8_t* data, size_t len) {
+  AsyncWebSocketClient* c = client(id);
+  if (c) c->ping(data, len);
+}
+
+void AsyncWebSocket::pingAll(const uint8_t* data, size_t len) {
+  std::lock_guard<std::recursive_mutex> lock(_lock);
+  for (auto& c : _clients) {
+    if (c->status() == WS_CONNECTED) c->ping(data, len);
+  }
+}
+
+bool AsyncWebSocket::text(uint32_t id, const char* message, size_t len) {
+  AsyncWebSocketClient* c = client(id);
+  return c && c->text(message, len);
+}
+
+bool AsyncWebSocket::text(uint32_t id, const char* message) { return text(id, message, strlen(message)); }
+
+void AsyncWebSocket::textAll(const char* message, size_t len) {
+  std::lock_guard<std::recursive_mutex> lock(_lock);
+  for (auto& c : _clients) {
+    if (c->status() == WS_CONNECTED) c->text(message, len);
+  }
+}
+
+void AsyncWebSocket::textAll(const char* message) { textAll(message, strlen(message)); }
+
+void AsyncWebSocket::binaryAll(const uint8_t* message, size_t len) {
+  std::lock_guard<std::recursive_mutex> lock(_lock);
+  for (auto& c : _clients) {
+    if (c->status() == WS_CONNECTED) c->binary(message, len);
+  }
+}
+
+// ----- Frame parsing (server thread) -----
+namespace NativeSimHttp {
+
+void ServerCore::processWebSocket(const ConnectionPtr& c) {
+  AsyncWebSocket* ws;
+  {
+    std::lock_guard<std::mutex> lock(c->mutex);
+    ws = c->ws;
+  }
+  if (!ws) {
+    c->in.clear();
+    return;
+  }
+  AsyncWebSocketClient* client = ws->_clientFor(c.get());
+  for (;;) {
+    if (c->in.size() < 2) return;
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(c->in.data());
+    AwsFrameInfo info;
+    memset(&info, 0, sizeof(info));
+    info.final = (p[0] & 0x80) != 0;
+    info.opcode = p[0] & 0x0F;
+    info.masked = (p[1] & 0x80) != 0;
+    uint64_t len = p[1] & 0x7F;
+    size_t pos = 2;
+    if (len == 126) {
+      if (c->in.size() < 4) return;
+      len = (static_cast<uint64_t>(p[2]) << 8) | p[3];
+      pos = 4;
+    } else if (len == 127) {
+      if (c->in.size() < 10) return;
+      len = 0;
+      for (int i = 0; i < 8; i++) len = (len << 8) | p[2 + i];
+      pos = 10;
+    }
+    if (info.masked) {
+      if (c->in.size() < pos + 4) return;
+      memcpy(info.mask, p + pos, 4);
+      pos += 4;
+    }
+    if (c->in.size() < pos + len) return;
+    std::string payload = c->in.substr(pos, static_cast<size_t>(len));
+    c->in.erase(0, pos + static_cast<size_t>(len));
+    if (info.masked) {
+      for (size_t i = 0; i < payload.size(); i++) payload[i] ^= static_cast<char>(info.mask[i % 4]);
+    }
+    info.len = len;
+    uint8_t* data = reinterpret_cast<uint8_t*>(&payload[0]);
+
+    if (info.opcode == WS_DISCONNECT) {
+      bool alreadyClosing;
+      {
+        std::lock_guard<std::mutex> lock(c->mutex);
+        alreadyClosing = c->closeWhenFlushed;
+      }
+      if (!alreadyClosing && client) client->close();
+      std::lock_guard<std::mutex> lock(c->mutex);
+      c->closeWhenFlushed = true;
+      return;
+    }
+    if (info.opcode == WS_PING) {
+      std::string pong = encodeWebSocketFrame(WS_PONG, data, payload.size());
+      c->queue(pong.data(), pong.size());
+      if (client) ws->_handleEvent(client, WS_EVT_PING, nullptr, data, payload.size());
+      continue;
+    }
+    if (info.opcode == WS_PONG) {
+      if (client) ws->_handleEvent(client, WS_EVT_PONG, nullptr, data, payload.size());
+      continue;
+    }
+    if (info.opcode == WS_TEXT || info.opcode == WS_BINARY) {
+      c->wsMessageOpcode = info.opcode;
+      c->wsMessageIndex = 0;
+    }
+    info.message_opcode = c->wsMessageOpcode;
+    info.index = c->wsMessageIndex;
+    c->wsMessageIndex += len;
+    // The library NUL-terminates text payloads in place; std::string already
+    // keeps a terminator past size().
+    if (client) ws->_handleEvent(client, WS_EVT_DATA, &info, data, payload.size());
+  }
+}
+
+} // namespace NativeSimHttp
@@ -0,0 +1,133 @@
+#ifndef NATIVE_SIM_ASYNC_WEB_SOCKET_H
+#define NATIVE_SIM_ASYNC_WEB_SOCKET_H
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include "ESPAsyncWebServer.h"
+
+#ifndef WS_MAX_QUEUED_MESSAGES
+#define WS_MAX_QUEUED_MESSAGES 32
+#endif
+#ifndef DEFAULT_MAX_WS_CLIENTS
+#define DEFAULT_MAX_WS_CLIENTS 8
+#endif
+
+class AsyncWebSocket;
+class AsyncWebSocketClient;
+
+#define WS_CONTINUATION 0x00
+#define WS_TEXT 0x01
+#define WS_BINARY 0x02
+#define WS_DISCONNECT 0x08
+#define WS_PING 0x09
+#define WS_PONG 0x0a
+
+typedef enum { WS_DISCONNECTED, WS_CONNECTED, WS_DISCONNECTING } AwsClientStatus;
+typedef enum { WS_EVT_CONNECT, WS_EVT_DISCONNECT, WS_EVT_PING, WS_EVT_PONG, WS_EVT_ERROR, WS_EVT_DATA } AwsEventType;
+
+typedef struct {
+  uint8_t message_opcode;
+  uint32_t num;
+  uint8_t final;
+  uint8_t masked;
+  uint8_t opcode;
+  uint64_t len;
+  uint8_t mask[4];
+  uint64_t index;
+} AwsFrameInfo;
+
+typedef std::function<void(AsyncWebSocket* server, AsyncWebSocketClient* client, AwsEventType type, void* arg,
+                           uint8_t* data, size_t len)> AwsEventHandler;
+
+class AsyncWebSocketClient {
+public:
+  AsyncWebSocketClient(AsyncWebSocket* server, std::shared_ptr<NativeSimHttp::Connection> conn, uint32_t id);
+  ~AsyncWebSocketClient();
+
+  uint32_t id() const { return _clientId; }
+  AwsClientStatus status() const;
+  AsyncClient* client() { return &_client; }
+  AsyncWebSocket* server() { return _server; }
+  IPAddress remoteIP() const { return _client.remoteIP(); }
+  uint16_t remotePort() const { return _client.remotePort(); }
+
+  void close(uint16_t code = 0, const char* message = nullptr);
+  void ping(const uint8_t* data = nullptr, size_t len = 0);
+  void keepAlivePeriod(uint16_t seconds) { _keepAlivePeriod = seconds; }
+  uint16_t keepAlivePeriod() const { return _keepAlivePeriod; }
+
+  bool queueIsFull() const;
+  size_t queueLen() const;
+  bool canSend() const { return !queueIsFull(); }
+
+  bool text(const char* message, size_t len);
+  bool text(const char* message);
+  bool text(const String& message) { return text(message.c_str(), message.length()); }
+  bool binary(const uint8_t* message, size_t len);
+  bool binary(const char* message, size_t len) { return binary(reinterpret_cast<const uint8_t*>(message), len); }
+
+  void* _tempObject = nullptr;
+
+  // ----- Native sim internals -----
+  std::shared_ptr<NativeSimHttp::Connection> _conn;
+
+private:
+  AsyncWebSocket* _server;
+  uint32_t _clientId;
+  AsyncClient _client;
+  uint16_t _keepAlivePeriod = 0;
+};
+
+class AsyncWebSocket : public AsyncWebHandler {
+public:
+  explicit AsyncWebSocket(const String& url);
+  ~AsyncWebSocket();
+
+  const char* url() const { return _url.c_str(); }
+  void enable(bool e) { _enabled = e; }
+  bool enabled() const { return _enabled; }
+  bool availableForWriteAll();
+  bool availableForWrite(uint32_t id);
+
+  size_t count() const;
+  AsyncWebSocketClient* client(uint32_t id);
+  bool hasClient(uint32_t id) { return client(id) != nullptr; }
+
+  void close(uint32_t id, uint16_t code = 0, const char* message = nullptr);
+  void closeAll(uint16_t code = 0, const char* message = nullptr);
+  void cleanupClients(uint16_t maxClients = DEFAULT_MAX_WS_CLIENTS);
+
+  void ping(uint32_t id, const uint8_t* data = nullptr, size_t len = 0);
+  void pingAll(const uint8_t* data = nullptr, size_t len = 0);
+
+  bool text(uint32_t id, const char* message, size_t len);
+  bool text(uint32_t id, const char* message);
+  bool text(uint32_t id, const String& message) { return text(id, message.c_str(), message.length()); }
+  void textAll(const char* message, size_t len);
+  void textAll(const char* message);
+  void textAll(const String& message) { textAll(message.c_str(), message.length()); }
+  void binaryAll(const uint8_t* message, size_t len);
+  void binaryAll(const char* message, size_t len) { binaryAll(reinterpret_cast<const uint8_t*>(message), len); }
+
+  void onEvent(AwsEventHandler handler) { _eventHandler = handler; }
+
+  bool canHandle(AsyncWebServerRequest* request) override;
+  void handleRequest(AsyncWebServerRequest* request) override;
+
+  // ----- Native sim internals -----
+  bool _upgrade(AsyncWebServerRequest* request, NativeSimHttp::Connection* conn) override;
+  void _handleEvent(AsyncWebSocketClient* client, AwsEventType type, void* arg, uint8_t* data, size_t len);
+  void _onClientGone(NativeSimHttp::Connection* conn);
+  AsyncWebSocketClient* _clientFor(NativeSimHttp::Connection* conn);
+
+private:
+  String _url;
+  bool _enabled = true;
+  uint32_t _cNextId = 1;
+  mutable std::recursive_mutex _lock;
+  std::list<std::unique_ptr<AsyncWebSocketClient>> _clients;
+  AwsEventHandler _eventHandler;
+};
+
+#endif // NATIVE_SIM_ASYNC_WEB_SOCKET_H
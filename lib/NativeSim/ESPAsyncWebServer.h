@@ -0,0 +1,391 @@
+#ifndef NATIVE_SIM_ESP_ASYNC_WEB_SERVER_H
+#define NATIVE_SIM_ESP_ASYNC_WEB_SERVER_H
+
+// Real-socket stand-in for ESPAsyncWebServer. One server thread plays the
+// part of the AsyncTCP task: it accepts connections, parses requests, runs
+// handlers and streams responses with non-blocking sockets. Handlers may
+// complete a request later from any thread, as on the device.
+
+#include <functional>
+#include <list>
+#include <memory>
+#include <vector>
+#include "Arduino.h"
+#include "FS.h"
+#include "AsyncTCP.h"
+
+class AsyncWebServer;
+class AsyncWebServerRequest;
+class AsyncWebServerResponse;
+class AsyncWebHandler;
+class AsyncStaticWebHandler;
+class AsyncCallbackWebHandler;
+class AsyncResponseStream;
+
+namespace NativeSimHttp {
+struct Connection;
+struct ServerCore;
+}
+
+typedef enum {
+  HTTP_GET = 0b00000001,
+  HTTP_POST = 0b00000010,
+  HTTP_DELETE = 0b00000100,
+  HTTP_PUT = 0b00001000,
+  HTTP_PATCH = 0b00010000,
+  HTTP_HEAD = 0b00100000,
+  HTTP_OPTIONS = 0b01000000,
+  HTTP_ANY = 0b01111111,
+} WebRequestMethod;
+typedef uint8_t WebRequestMethodComposite;
+
+// Filler return value meaning "no data yet, call me again".
+#define RESPONSE_TRY_AGAIN 0xFFFFFFFF
+
+typedef std::function<void(AsyncWebServerRequest* request)> ArRequestHandlerFunction;
+typedef std::function<void(AsyncWebServerRequest* request, const String& filename, size_t index, uint8_t* data,
+                           size_t len, bool final)> ArUploadHandlerFunction;
+typedef std::function<void(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total)>
+    ArBodyHandlerFunction;
+typedef std::function<bool(AsyncWebServerRequest* request)> ArRequestFilterFunction;
+typedef std::function<void(void)> ArDisconnectHandler;
+typedef std::function<size_t(uint8_t* buffer, size_t maxLen, size_t index)> AwsResponseFiller;
+typedef std::function<String(const String&)> AwsTemplateProcessor;
+
+class AsyncWebParameter {
+public:
+  AsyncWebParameter(const String& name, const String& value, bool form = false, bool file = false, size_t size = 0)
+      : _name(name), _value(value), _size(size), _isForm(form), _isFile(file) {}
+  const String& name() const { return _name; }
+  const String& value() const { return _value; }
+  size_t size() const { return _size; }
+  bool isPost() const { return _isForm; }
+  bool isFile() const { return _isFile; }
+
+private:
+  String _name;
+  String _value;
+  size_t _size;
+  bool _isForm;
+  bool _isFile;
+};
+
+class AsyncWebHeader {
+public:
+  AsyncWebHeader(const String& name, const String& value) : _name(name), _value(value) {}
+  const String& name() const { return _name; }
+  const String& value() const { return _value; }
+  String toString() const { return _name + ": " + _value + "\r\n"; }
+
+private:
+  String _name;
+  String _value;
+};
+
+// ----- Responses -----
+class AsyncWebServerResponse {
+public:
+  AsyncWebServerResponse() = default;
+  virtual ~AsyncWebServerResponse() = default;
+  void setCode(int code) { _code = code; }
+  int code() const { return _code; }
+  void setContentLength(size_t len) { _contentLength = len; }
+  void setContentType(const String& type) { _contentType = type; }
+  bool addHeader(const String& name, const String& value, bool replaceExisting = true);
+  bool removeHeader(const char* name);
+  const AsyncWebHeader* getHeader(const char* name) const;
+
+  // ----- Native sim internals -----
+  // Serialized status line + headers.
+  String _assembleHead(uint8_t httpVersionMinor);
+  // Produces up to maxLen body bytes; 0 = done, RESPONSE_TRY_AGAIN = later.
+  virtual size_t _fillBody(uint8_t* buf, size_t maxLen) = 0;
+  virtual bool _sourceValid() const { return true; }
+  bool _isChunked() const { return _chunked; }
+  size_t _bodyLength() const { return _contentLength; }
+
+protected:
+  int _code = 200;
+  String _contentType;
+  size_t _contentLength = 0;
+  bool _chunked = false;
+  bool _sendContentLength = true;
+  std::list<AsyncWebHeader> _headers;
+  size_t _sentBody = 0;
+};
+
+class AsyncBasicResponse : public AsyncWebServerResponse {
+public:
+  AsyncBasicResponse(int code, const String& contentType = String(), const String& content = String());
+  size_t _fillBody(uint8_t* buf, size_t maxLen) override;
+
+private:
+  String _content;
+};
+
+class AsyncProgmemResponse : public AsyncWebServerResponse {
+public:
+  AsyncProgmemResponse(int code, const String& contentType, const uint8_t* content, size_t len);
+  size_t _fillBody(uint8_t* buf, size_t maxLen) override;
+
+private:
+  const uint8_t* _content;
+};
+
+class AsyncFileResponse : public AsyncWebServerResponse {
+public:
+  AsyncFileResponse(FS& fs, const String& path, const String& contentType = String(), bool download = false);
+  AsyncFileResponse(File content, const String& path, const String& contentType = String(), bool download = false);
+  size_t _fillBody(uint8_t* buf, size_t maxLen) override;
+  bool _sourceValid() const override { return static_cast<bool>(_content); }
+
+private:
+  File _content;
+  void setup(const String& path, const String& contentType, bool download);
+};
+
+class AsyncCallbackResponse : public AsyncWebServerResponse {
+public:
+  AsyncCallbackResponse(const String& contentType, size_t len, AwsResponseFiller callback);
+  size_t _fillBody(uint8_t* buf, size_t maxLen) override;
+
+protected:
+  AwsResponseFiller _callback;
+  size_t _filled = 0;
+};
+
+class AsyncChunkedResponse : public AsyncCallbackResponse {
+public:
+  AsyncChunkedResponse(const String& contentType, AwsResponseFiller callback);
+};
+
+class AsyncResponseStream : public AsyncWebServerResponse, public Print {
+public:
+  AsyncResponseStream(const String& contentType, size_t bufferSize);
+  size_t write(uint8_t data) override;
+  size_t write(const uint8_t* data, size_t len) override;
+  using Print::write;
+  size_t _fillBody(uint8_t* buf, size_t maxLen) override;
+  size_t available() const { return _buffer.size() - _readPos; }
+
+private:
+  std::vector<uint8_t> _buffer;
+  size_t _readPos = 0;
+};
+
+// ----- Request -----
+class AsyncWebServerRequest {
+  friend struct NativeSimHttp::Connection;
+  friend struct NativeSimHttp::ServerCore;
+
+public:
+  AsyncWebServerRequest(AsyncWebServer* server, NativeSimHttp::Connection* conn);
+  ~AsyncWebServerRequest();
+
+  AsyncClient* client() { return &_client; }
+  WebRequestMethodComposite method() const { return _method; }
+  const char* methodToString() const;
+  uint8_t version() const { return _version; }
+  const String& url() const { return _url; }
+  const String& host() const { return _host; }
+  const String& contentType() const { return _contentType; }
+  size_t contentLength() const { return _contentLength; }
+  bool multipart() const { return _isMultipart; }
+
+  // Responses.
+  void send(AsyncWebServerResponse* response);
+  void send(int code, const String& contentType = String(), const String& content = String());
+  void send(FS& fs, const String& path, const String& contentType = String(), bool download = false,
+            AwsTemplateProcessor callback = nullptr);
+  void send(File content, const String& path, const String& contentType = String(), bool download = false,
+            AwsTemplateProcessor callback = nullptr);
+  void send(const String& contentType, size_t len, AwsResponseFiller callback);
+  void sendChunked(const String& contentType, AwsResponseFiller callback);
+  void send_P(int code, const String& contentType, const uint8_t* content, size_t len);
+  void send_P(int code, const String& contentType, PGM_P content);
+  void redirect(const String& url);
+  // The response handed to send() and not yet sent out (nullptr before send()).
+  AsyncWebServerResponse* getResponse() const;
+
+  AsyncWebServerResponse* beginResponse(int code, const String& contentType = String(), const String& content = String());
+  AsyncWebServerResponse* beginResponse(FS& fs, const String& path, const String& contentType = String(),
+                                        bool download = false, AwsTemplateProcessor callback = nullptr);
+  AsyncWebServerResponse* beginResponse(File content, const String& path, const String& contentType = String(),
+                                        bool download = false, AwsTemplateProcessor callback = nullptr);
+  AsyncWebServerResponse* beginResponse(const String& contentType, size_t len, AwsResponseFiller callback);
+  AsyncWebServerResponse* beginChunkedResponse(const String& contentType, AwsResponseFiller callback);
+  AsyncResponseStream* beginResponseStream(const String& contentType, size_t bufferSize = 1460);
+  AsyncWebServerResponse* beginResponse_P(int code, const String& contentType, const uint8_t* content, size_t len);
+  AsyncWebServerResponse* beginResponse_P(int code, const String& contentType, PGM_P content);
+
+  // Authentication.
+  bool authenticate(const char* username, const char* password, const char* realm = nullptr,
+                    bool passwordIsHash = false);
+  void requestAuthentication(const char* realm = nullptr, bool isDigest = true);
+
+  void onDisconnect(ArDisconnectHandler fn) { _onDisconnect = fn; }
+
+  // Headers.
+  size_t headers() const { return _headers.size(); }
+  bool hasHeader(const String& name) const;
+  const AsyncWebHeader* getHeader(const String& name) const;
+  const AsyncWebHeader* getHeader(size_t num) const;
+  const String& header(const char* name) const;
+
+  // Parameters.
+  size_t params() const { return _params.size(); }
+  bool hasParam(const String& name, bool post = false, bool file = false) const;
+  const AsyncWebParameter* getParam(const String& name, bool post = false, bool file = false) const;
+  const AsyncWebParameter* getParam(size_t num) const;
+  const std::vector<AsyncWebParameter>& getParams() const { return _params; }  // std::list in the library
+  size_t args() const { return _params.size(); }
+  bool hasArg(const char* name) const;
+  const String& arg(const String& name) const;
+  const String& arg(size_t i) const;
+  const String& argName(size_t i) const;
+
+  // Mirrors the library: freed with free() when the request is destroyed.
+  void* _tempObject = nullptr;
+
+private:
+  AsyncWebServer* _server;
+  NativeSimHttp::Connection* _conn;
+  AsyncClient _client;
+  WebRequestMethodComposite _method = HTTP_GET;
+  uint8_t _version = 1;
+  String _url;
+  String _host;
+  String _contentType;
+  String _boundary;
+  size_t _contentLength = 0;
+  bool _isMultipart = false;
+  std::vector<AsyncWebHeader> _headers;
+  std::vector<AsyncWebParameter> _params;
+  ArDisconnectHandler _onDisconnect;
+  AsyncWebHandler* _handler = nullptr;
+};
+
+// ----- Handlers -----
+class AsyncWebHandler {
+public:
+  virtual ~AsyncWebHandler() {}
+  AsyncWebHandler& setFilter(ArRequestFilterFunction fn) {
+    _filter = fn;
+    return *this;
+  }
+  AsyncWebHandler& setAuthentication(const char* username, const char* password) {
+    _username = username;
+    _password = password;
+    return *this;
+  }
+  bool filter(AsyncWebServerRequest* request) { return _filter == nullptr || _filter(request); }
+  virtual bool canHandle(AsyncWebServerRequest* request) { (void)request; return false; }
+  virtual void handleRequest(AsyncWebServerRequest* request) { (void)request; }
+  virtual void handleUpload(AsyncWebServerRequest* request, const String& filename, size_t index, uint8_t* data,
+                            size_t len, bool final) {
+    (void)request; (void)filename; (void)index; (void)data; (void)len; (void)final;
+  }
+  virtual void handleBody(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total) {
+    (void)request; (void)data; (void)len; (void)index; (void)total;
+  }
+  virtual bool isRequestHandlerTrivial() { return true; }
+
+  // ----- Native sim internals -----
+  // WebSocket handlers take over the connection after the upgrade.
+  virtual bool _upgrade(AsyncWebServerRequest* request, NativeSimHttp::Connection* conn) {
+    (void)request; (void)conn;
+    return false;
+  }
+
+protected:
+  ArRequestFilterFunction _filter = nullptr;
+  String _username;
+  String _password;
+};
+
+class AsyncCallbackWebHandler : public AsyncWebHandler {
+public:
+  void setUri(const String& uri) { _uri = uri; _isRegex = false; }
+  void setMethod(WebRequestMethodComposite method) { _method = method; }
+  void onRequest(ArRequestHandlerFunction fn) { _onRequest = fn; }
+  void onUpload(ArUploadHandlerFunction fn) { _onUpload = fn; }
+  void onBody(ArBodyHandlerFunction fn) { _onBody = fn; }
+
+  bool canHandle(AsyncWebServerRequest* request) override;
+  void handleRequest(AsyncWebServerRequest* request) override;
+  void handleUpload(AsyncWebServerRequest* request, const String& filename, size_t index, uint8_t* data,
+                    size_t len, bool final) override;
+  void handleBody(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total) override;
+  bool isRequestHandlerTrivial() override { return !_onRequest; }
+
+private:
+  String _uri;
+  WebRequestMethodComposite _method = HTTP_ANY;
+  bool _isRegex = false;
+  ArRequestHandlerFunction _onRequest;
+  ArUploadHandlerFunction _onUpload;
+  ArBodyHandlerFunction _onBody;
+};
+
+class AsyncStaticWebHandler : public AsyncWebHandler {
+public:
+  AsyncStaticWebHandler(const char* uri, FS& fs, const char* path, const char* cache_control);
+  bool canHandle(AsyncWebServerRequest* request) override;
+  void handleRequest(AsyncWebServerRequest* request) override;
+  AsyncStaticWebHandler& setIsDir(bool isDir) { _isDir = isDir; return *this; }
+  AsyncStaticWebHandler& setDefaultFile(const char* filename) { _defaultFile = filename; return *this; }
+  AsyncStaticWebHandler& setCacheControl(const char* cache_control) { _cache_control = cache_control; return *this; }
+  AsyncStaticWebHandler& setLastModified(const char* last_modified) { _last_modified = last_modified; return *this; }
+  AsyncStaticWebHandler& setTemplateProcessor(AwsTemplateProcessor newCallback) { (void)newCallback; return *this; }
+
+private:
+  FS& _fs;
+  String _uri;
+  String _path;
+  String _defaultFile = "index.htm";
+  String _cache_control;
+  String _last_modified;
+  bool _isDir = true;
+  bool getFile(AsyncWebServerRequest* request, String& resolved, bool& gzipped);
+};
+
+// ----- Server -----
+class AsyncWebServer {
+public:
+  AsyncWebServer(uint16_t port);
+  ~AsyncWebServer();
+
+  void begin();
+  void end();
+  void reset();
+
+  AsyncWebHandler& addHandler(AsyncWebHandler* handler);
+  bool removeHandler(AsyncWebHandler* handler);
+
+  AsyncCallbackWebHandler& on(const char* uri, ArRequestHandlerFunction onRequest);
+  AsyncCallbackWebHandler& on(const char* uri, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest);
+  AsyncCallbackWebHandler& on(const char* uri, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest,
+                              ArUploadHandlerFunction onUpload);
+  AsyncCallbackWebHandler& on(const char* uri, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest,
+                              ArUploadHandlerFunction onUpload, ArBodyHandlerFunction onBody);
+
+  AsyncStaticWebHandler& serveStatic(const char* uri, fs::FS& fs, const char* path, const char* cache_control = nullptr);
+
+  void onNotFound(ArRequestHandlerFunction fn);
+  void onFileUpload(ArUploadHandlerFunction fn);
+  void onRequestBody(ArBodyHandlerFunction fn);
+
+  // ----- Native sim internals -----
+  AsyncWebHandler* _attachHandler(AsyncWebServerRequest* request);
+  NativeSimHttp::ServerCore* _core() { return _serverCore; }
+
+private:
+  uint16_t _port;
+  std::list<AsyncWebHandler*> _handlers;
+  AsyncCallbackWebHandler* _catchAllHandler;
+  NativeSimHttp::ServerCore* _serverCore;
+};
+
+#include "AsyncWebSocket.h"
+
+#endif // NATIVE_SIM_ESP_ASYNC_WEB_SERVER_H
@@ -0,0 +1,29 @@
+#ifndef NATIVE_SIM_ESPMDNS_H
+#define NATIVE_SIM_ESPMDNS_H
+
+#include "Arduino.h"
+
+// mDNS has no host equivalent worth simulating; calls succeed and are logged.
+class MDNSResponder {
+public:
+  bool begin(const String& hostName) {
+    printf("[native-sim] mdns: %s.local\n", hostName.c_str());
+    return true;
+  }
+  void end() {}
+  bool addService(const char* service, const char* proto, uint16_t port) {
+    (void)service; (void)proto; (void)port;
+    return true;
+  }
+  bool addService(const String& service, const String& proto, uint16_t port) {
+    return addService(service.c_str(), proto.c_str(), port);
+  }
+  bool addServiceTxt(const char* name, const char* proto, const char* key, const char* value) {
+    (void)name; (void)proto; (void)key; (void)value;
+    return true;
+  }
+};
+
+extern MDNSResponder MDNS;
+
+#endif // NATIVE_SIM_ESPMDNS_H
@@ -0,0 +1,365 @@
+#include "FS.h"
+#include "SPIFFS.h"
+#include "NativeSim.h"
+#include <dirent.h>
+#include <errno.h>
+#include <mutex>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+fs::SPIFFSFS SPIFFS;
+
+namespace {
+
+std::mutex g_rootMutex;
+std::string g_root;
+NativeSim::FlashTiming g_flashTiming;
+NativeSim::FlashStats g_flashStats;
+
+NativeSim::FlashTiming timing() {
+  std::lock_guard<std::mutex> lock(g_rootMutex);
+  return g_flashTiming;
+}
+
+void chargeOpen(size_t appendFrom) {
+  NativeSim::FlashTiming t = timing();
+  {
+    std::lock_guard<std::mutex> lock(g_rootMutex);
+    g_flashStats.opens++;
+  }
+  NativeSim::sleepMicros(t.openUs + static_cast<uint64_t>(t.appendSeekUsPerKB) * appendFrom / 1024);
+}
+
+std::string root() {
+  std::lock_guard<std::mutex> lock(g_rootMutex);
+  if (g_root.empty()) {
+    const char* env = getenv("WM_FS_ROOT");
+    g_root = env && *env ? env : "data";
+  }
+  return g_root;
+}
+
+// Maps an SPIFFS path ("/foo.txt") onto the host directory, rejecting
+// anything that would escape it.
+bool hostPath(const char* path, std::string& out) {
+  if (!path || path[0] != '/') return false;
+  std::string p(path);
+  if (p.find("/../") != std::string::npos || (p.size() >= 3 && p.compare(p.size() - 3, 3, "/..") == 0)) return false;
+  out = root() + p;
+  while (out.size() > 1 && out.back() == '/') out.pop_back();
+  return true;
+}
+
+void makeParents(const std::string& host) {
+  size_t pos = root().size() + 1;
+  while ((pos = host.find('/', pos)) != std::string::npos) {
+    ::mkdir(host.substr(0, pos).c_str(), 0755);
+    pos++;
+  }
+}
+
+bool isDir(const std::string& host) {
+  struct stat st;
+  return stat(host.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+bool isFile(const std::string& host) {
+  struct stat st;
+  return stat(host.c_str(), &st) == 0 && S_ISREG(st.st_mode);
+}
+
+} // namespace
+
+namespace fs {
+
+class FileImpl {
+public:
+  FILE* fp = nullptr;
+  bool directory = false;
+  std::string path;                  // SPIFFS path
+  std::string host;                  // host path
+  std::vector<std::string> entries;  // directory listing snapshot
+  size_t nextEntry = 0;
+  bool writable = false;
+
+  ~FileImpl() { close(); }
+  void close() {
+    if (fp) {
+      fclose(fp);
+      if (writable) {
+        {
+          std::lock_guard<std::mutex> lock(g_rootMutex);
+          g_flashStats.closes++;
+        }
+        NativeSim::sleepMicros(timing().closeUs);
+      }
+    }
+    fp = nullptr;
+    directory = false;
+  }
+};
+
+// ----- File -----
+size_t File::write(uint8_t c) { return write(&c, 1); }
+
+size_t File::write(const uint8_t* buf, size_t size) {
+  if (!_p || !_p->fp) return 0;
+  size_t n = fwrite(buf, 1, size, _p->fp);
+  NativeSim::FlashTiming t = timing();
+  {
+    std::lock_guard<std::mutex> lock(g_rootMutex);
+    g_flashStats.writes++;
+    g_flashStats.bytesWritten += n;
+  }
+  NativeSim::sleepMicros(t.writeUs + static_cast<uint64_t>(t.programUsPerKB) * n / 1024);
+  return n;
+}
+
+int File::available() {
+  if (!_p || !_p->fp) return 0;
+  return static_cast<int>(size() - position());
+}
+
+int File::read() {
+  if (!_p || !_p->fp) return -1;
+  return fgetc(_p->fp);
+}
+
+int File::peek() {
+  if (!_p || !_p->fp) return -1;
+  int c = fgetc(_p->fp);
+  if (c != EOF) ungetc(c, _p->fp);
+  return c;
+}
+
+void File::flush() {
+  if (_p && _p->fp) fflush(_p->fp);
+}
+
+size_t File::read(uint8_t* buf, size_t size) {
+  if (!_p || !_p->fp) return 0;
+  size_t n = fread(buf, 1, size, _p->fp);
+  std::lock_guard<std::mutex> lock(g_rootMutex);
+  g_flashStats.bytesRead += n;
+  return n;
+}
+
+String File::readString() {
+  String ret;
+  if (!_p || !_p->fp) return ret;
+  ret.reserve(static_cast<unsigned int>(available()));
+  char buf[256];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), _p->fp)) > 0) ret.concat(buf, static_cast<unsigned int>(n));
+  return ret;
+}
+
+bool File::seek(uint32_t pos, SeekMode mode) {
+  if (!_p || !_p->fp) return false;
+  int whence = mode == SeekSet ? SEEK_SET : mode == SeekCur ? SEEK_CUR : SEEK_END;
+  return fseek(_p->fp, static_cast<long>(pos), whence) == 0;
+}
+
+size_t File::position() const {
+  if (!_p || !_p->fp) return 0;
+  long pos = ftell(_p->fp);
+  return pos < 0 ? 0 : static_cast<size_t>(pos);
+}
+
+size_t File::size() const {
+  if (!_p || !_p->fp) return 0;
+  fflush(_p->fp);
+  struct stat st;
+  if (fstat(fileno(_p->fp), &st) != 0) return 0;
+  return static_cast<size_t>(st.st_size);
+}
+
+bool File::setBufferSize(size_t size) {
+  if (!_p || !_p->fp) return false;
+  return setvbuf(_p->fp, nullptr, _IOFBF, size) == 0;
+}
+
+void File::close() {
+  if (_p) _p->close();
+  _p.reset();
+}
+
+File::operator bool() const { return _p && (_p->fp || _p->directory); }
+
+time_t File::getLastWrite() {
+  if (!_p) return 0;
+  struct stat st;
+  if (stat(_p->host.c_str(), &st) != 0) return 0;
+  return st.st_mtime;
+}
+
+const char* File::path() const { return _p ? _p->path.c_str() : nullptr; }
+
+const char* File::name() const {
+  if (!_p) return nullptr;
+  size_t slash = _p->path.rfind('/');
+  return _p->path.c_str() + (slash == std::string::npos ? 0 : slash + 1);
+}
+
+bool File::isDirectory() { return _p && _p->directory; }
+
+File File::openNextFile(const char* mode) {
+  if (!_p || !_p->directory) return File();
+  while (_p->nextEntry < _p->entries.size()) {
+    const std::string& entry = _p->entries[_p->nextEntry++];
+    std::string child = _p->path == "/" ? "/" + entry : _p->path + "/" + entry;
+    File f = SPIFFS.open(child.c_str(), mode);
+    if (f) return f;
+  }
+  return File();
+}
+
+void File::rewindDirectory() {
+  if (_p) _p->nextEntry = 0;
+}
+
+// ----- FS -----
+File FS::open(const char* path, const char* mode, const bool create) {
+  (void)create;
+  std::string host;
+  if (!_mounted || !hostPath(path, host)) return File();
+  auto impl = std::make_shared<FileImpl>();
+  impl->path = path;
+  impl->host = host;
+  if (isDir(host)) {
+    if (strcmp(mode, FILE_READ) != 0) return File();
+    impl->directory = true;
+    DIR* dir = opendir(host.c_str());
+    if (!dir) return File();
+    while (struct dirent* e = readdir(dir)) {
+      if (e->d_name[0] == '.') continue;
+      impl->entries.push_back(e->d_name);
+    }
+    closedir(dir);
+    return File(impl);
+  }
+  std::string m(mode);
+  if (m[0] == 'r' && !isFile(host)) return File();
+  if (m[0] == 'w' || m[0] == 'a') makeParents(host);
+  if (m.find('b') == std::string::npos) m += 'b';
+  struct stat st;
+  chargeOpen(m[0] == 'a' && stat(host.c_str(), &st) == 0 ? static_cast<size_t>(st.st_size) : 0);
+  impl->fp = fopen(host.c_str(), m.c_str());
+  if (!impl->fp) return File();
+  impl->writable = m[0] != 'r' || m.find('+') != std::string::npos;
+  return File(impl);
+}
+
+bool FS::exists(const char* path) {
+  std::string host;
+  if (!_mounted || !hostPath(path, host)) return false;
+  return isFile(host) || isDir(host);
+}
+
+bool FS::remove(const char* path) {
+  std::string host;
+  if (!_mounted || !hostPath(path, host)) return false;
+  return ::unlink(host.c_str()) == 0;
+}
+
+bool FS::rename(const char* pathFrom, const char* pathTo) {
+  std::string from, to;
+  if (!_mounted || !hostPath(pathFrom, from) || !hostPath(pathTo, to)) return false;
+  makeParents(to);
+  chargeOpen(0);
+  return ::rename(from.c_str(), to.c_str()) == 0;
+}
+
+bool FS::mkdir(const char* path) {
+  std::string host;
+  if (!_mounted || !hostPath(path, host)) return false;
+  return ::mkdir(host.c_str(), 0755) == 0 || errno == EEXIST;
+}
+
+bool FS::rmdir(const char* path) {
+  std::string host;
+  if (!_mounted || !hostPath(path, host)) return false;
+  return ::rmdir(host.c_str()) == 0;
+}
+
+// ----- SPIFFS -----
+bool SPIFFSFS::begin(bool formatOnFail, const char* basePath, uint8_t maxOpenFiles, const char* partitionLabel) {
+  (void)basePath;
+  (void)maxOpenFiles;
+  (void)partitionLabel;
+  std::string dir = root();
+  NativeSim::FlashTiming timing = NativeSim::flashTiming();
+  NativeSim::sleepMicros(timing.mountMs * 1000ULL);
+  if (!isDir(dir)) {
+    if (!formatOnFail || !format()) return false;
+    NativeSim::sleepMicros(timing.mountMs * 1000ULL);
+  }
+  _mounted = true;
+  return true;
+}
+
+bool SPIFFSFS::format() {
+  NativeSim::sleepMicros(NativeSim::flashTiming().formatMs * 1000ULL);
+  std::string dir = root();
+  if (!isDir(dir)) return ::mkdir(dir.c_str(), 0755) == 0;
+  DIR* d = opendir(dir.c_str());
+  if (!d) return false;
+  while (struct dirent* e = readdir(d)) {
+    if (e->d_name[0] == '.') continue;
+    ::unlink((dir + "/" + e->d_name).c_str());
+  }
+  closedir(d);
+  return true;
+}
+
+size_t SPIFFSFS::totalBytes() { return 0xE0000; }
+
+size_t SPIFFSFS::usedBytes() {
+  size_t used = 0;
+  DIR* d = opendir(root().c_str());
+  if (!d) return 0;
+  while (struct dirent* e = readdir(d)) {
+    struct stat st;
+    if (stat((root() + "/" + e->d_name).c_str(), &st) == 0 && S_ISREG(st.st_mode)) used += st.st_size;
+  }
+  closedir(d);
+  return used;
+}
+
+void SPIFFSFS::end() { _mounted = false; }
+
+} // namespace fs
+
+namespace NativeSim {
+
+void setFilesystemRoot(const char* path) {
+  std::lock_guard<std::mutex> lock(g_rootMutex);
+  g_root = path ? path : "";
+}
+
+FlashStats flashStats() {
+  std::lock_guard<std::mutex> lock(g_rootMutex);
+  return g_flashStats;
+}
+
+void resetFlashStats() {
+  std::lock_guard<std::mutex> lock(g_rootMutex);
+  g_flashStats = FlashStats();
+}
+
+void setFlashTiming(const FlashTiming& timing) {
+  std::lock_guard<std::mutex> lock(g_rootMutex);
+  g_flashTiming = timing;
+}
+
+FlashTiming flashTiming() { return timing(); }
+
+const char* filesystemRoot() {
+  static std::string current;
+  current = root();
+  return current.c_str();
+}
+
+} // namespace NativeSim
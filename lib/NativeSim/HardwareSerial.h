@@ -0,0 +1,30 @@
+#ifndef NATIVE_SIM_HARDWARE_SERIAL_H
+#define NATIVE_SIM_HARDWARE_SERIAL_H
+
+#include "Stream.h"
+
+// UART0 maps onto the host process' stdout; there is no input side.
+class HardwareSerial : public Stream {
+public:
+  void begin(unsigned long baud) { _baud = baud; }
+  void end() {}
+  unsigned long baudRate() const { return _baud; }
+  operator bool() const { return true; }
+
+  int available() override { return 0; }
+  int read() override { return -1; }
+  int peek() override { return -1; }
+  int availableForWrite() override { return 4096; }
+  void flush() override;
+
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t* buffer, size_t size) override;
+  using Print::write;
+
+private:
+  unsigned long _baud = 115200;
+};
+
+extern HardwareSerial Serial;
+
+#endif // NATIVE_SIM_HARDWARE_SERIAL_H
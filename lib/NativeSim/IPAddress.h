@@ -0,0 +1,43 @@
+#ifndef NATIVE_SIM_IPADDRESS_H
+#define NATIVE_SIM_IPADDRESS_H
+
+#include <stdint.h>
+#include <string.h>
+#include "Printable.h"
+#include "WString.h"
+
+// IPv4 address as used by the Arduino-ESP32 WiFi API.
+class IPAddress : public Printable {
+public:
+  IPAddress() : _address{0, 0, 0, 0} {}
+  IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : _address{a, b, c, d} {}
+  IPAddress(uint32_t address) { *this = address; }
+  explicit IPAddress(const uint8_t* address) : _address{address[0], address[1], address[2], address[3]} {}
+
+  // Network byte order, like lwIP's ip4_addr_t.addr.
+  operator uint32_t() const {
+    uint32_t v;
+    memcpy(&v, _address, 4);
+    return v;
+  }
+  IPAddress& operator=(uint32_t address) {
+    memcpy(_address, &address, 4);
+    return *this;
+  }
+  bool operator==(const IPAddress& other) const { return memcmp(_address, other._address, 4) == 0; }
+  bool operator!=(const IPAddress& other) const { return !(*this == other); }
+  uint8_t operator[](int index) const { return _address[index]; }
+  uint8_t& operator[](int index) { return _address[index]; }
+
+  bool fromString(const char* address);
+  bool fromString(const String& address) { return fromString(address.c_str()); }
+  String toString() const;
+  size_t printTo(Print& p) const override;
+
+private:
+  uint8_t _address[4];
+};
+
+extern const IPAddress INADDR_NONE;
+
+#endif // NATIVE_SIM_IPADDRESS_H
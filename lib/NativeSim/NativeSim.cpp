@@ -0,0 +1,211 @@
+#include "NativeSim.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <new>
+#include <stdlib.h>
+#include <thread>
+
+namespace NativeSim {
+
+// ----- Heap accounting -----
+namespace {
+
+// Each block carries its size in a header so frees and reallocs can be
+// accounted without a side table. 16 bytes keeps max_align_t alignment.
+const size_t kHeader = 16;
+
+std::atomic<uint64_t> g_allocations{0};
+std::atomic<uint64_t> g_frees{0};
+std::atomic<uint64_t> g_bytesAllocated{0};
+std::atomic<size_t> g_liveBytes{0};
+std::atomic<size_t> g_peakLiveBytes{0};
+std::atomic<size_t> g_heapSize{320 * 1024};
+
+void notePeak(size_t live) {
+  size_t peak = g_peakLiveBytes.load(std::memory_order_relaxed);
+  while (live > peak && !g_peakLiveBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {}
+}
+
+void* attach(void* base, size_t size) {
+  *static_cast<size_t*>(base) = size;
+  return static_cast<uint8_t*>(base) + kHeader;
+}
+
+} // namespace
+
+void* heapAlloc(size_t size) {
+  void* base = malloc(size + kHeader);
+  if (!base) return nullptr;
+  g_allocations.fetch_add(1, std::memory_order_relaxed);
+  g_bytesAllocated.fetch_add(size, std::memory_order_relaxed);
+  notePeak(g_liveBytes.fetch_add(size, std::memory_order_relaxed) + size);
+  return attach(base, size);
+}
+
+void* heapRealloc(void* ptr, size_t size) {
+  if (!ptr) return heapAlloc(size);
+  void* base = static_cast<uint8_t*>(ptr) - kHeader;
+  size_t oldSize = *static_cast<size_t*>(base);
+  void* grown = realloc(base, size + kHeader);
+  if (!grown) return nullptr;
+  g_allocations.fetch_add(1, std::memory_order_relaxed);
+  g_frees.fetch_add(1, std::memory_order_relaxed);
+  g_bytesAllocated.fetch_add(size, std::memory_order_relaxed);
+  if (size >= oldSize) notePeak(g_liveBytes.fetch_add(size - oldSize, std::memory_order_relaxed) + size - oldSize);
+  else g_liveBytes.fetch_sub(oldSize - size, std::memory_order_relaxed);
+  return attach(grown, size);
+}
+
+void heapFree(void* ptr) {
+  if (!ptr) return;
+  void* base = static_cast<uint8_t*>(ptr) - kHeader;
+  g_frees.fetch_add(1, std::memory_order_relaxed);
+  g_liveBytes.fetch_sub(*static_cast<size_t*>(base), std::memory_order_relaxed);
+  free(base);
+}
+
+HeapStats heapStats() {
+  HeapStats s;
+  s.allocations = g_allocations.load();
+  s.frees = g_frees.load();
+  s.bytesAllocated = g_bytesAllocated.load();
+  s.liveBytes = g_liveBytes.load();
+  s.peakLiveBytes = g_peakLiveBytes.load();
+  return s;
+}
+
+void resetHeapPeak() { g_peakLiveBytes.store(g_liveBytes.load()); }
+void setHeapSize(size_t bytes) { g_heapSize.store(bytes); }
+size_t heapSize() { return g_heapSize.load(); }
+
+// ----- Clock & scheduler -----
+namespace {
+
+struct Scheduler {
+  std::mutex mutex;
+  std::condition_variable wake;
+  std::multimap<uint64_t, std::pair<uint32_t, std::function<void()>>> events;
+  uint32_t nextId = 1;
+  bool threadStarted = false;
+  std::atomic<ClockMode> mode{ClockMode::RealTime};
+  std::atomic<uint64_t> virtualUs{0};
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+  uint64_t realUs() const {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+  }
+
+  // Background "event task" for RealTime mode.
+  void run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+      if (mode.load() != ClockMode::RealTime || events.empty()) {
+        wake.wait(lock);
+        continue;
+      }
+      auto first = events.begin();
+      uint64_t now = realUs();
+      if (first->first > now) {
+        wake.wait_for(lock, std::chrono::microseconds(first->first - now));
+        continue;
+      }
+      auto fn = std::move(first->second.second);
+      events.erase(first);
+      lock.unlock();
+      fn();
+      lock.lock();
+    }
+  }
+};
+
+// Leaked on purpose: the event thread may outlive static destruction.
+Scheduler& scheduler() {
+  static Scheduler* s = new Scheduler();
+  return *s;
+}
+
+} // namespace
+
+void setClockMode(ClockMode mode) {
+  Scheduler& s = scheduler();
+  std::lock_guard<std::mutex> lock(s.mutex);
+  if (mode == s.mode.load()) return;
+  if (mode == ClockMode::Virtual) s.virtualUs.store(s.realUs());
+  s.mode.store(mode);
+  s.wake.notify_all();
+}
+
+ClockMode clockMode() { return scheduler().mode.load(); }
+
+uint64_t nowMicros() {
+  Scheduler& s = scheduler();
+  return s.mode.load() == ClockMode::Virtual ? s.virtualUs.load() : s.realUs();
+}
+
+void sleepMicros(uint64_t us) {
+  if (clockMode() == ClockMode::Virtual) {
+    Scheduler& s = scheduler();
+    uint64_t target = s.virtualUs.load() + us;
+    for (;;) {
+      std::unique_lock<std::mutex> lock(s.mutex);
+      auto first = s.events.begin();
+      if (first == s.events.end() || first->first > target) break;
+      if (first->first > s.virtualUs.load()) s.virtualUs.store(first->first);
+      auto fn = std::move(first->second.second);
+      s.events.erase(first);
+      lock.unlock();
+      fn();
+    }
+    if (target > s.virtualUs.load()) s.virtualUs.store(target);
+    return;
+  }
+  std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+void advanceMillis(uint32_t ms) {
+  if (clockMode() == ClockMode::Virtual) sleepMicros(static_cast<uint64_t>(ms) * 1000);
+}
+
+uint32_t schedule(uint32_t delayMs, std::function<void()> fn) {
+  Scheduler& s = scheduler();
+  std::lock_guard<std::mutex> lock(s.mutex);
+  if (!s.threadStarted) {
+    std::thread([&s] { s.run(); }).detach();
+    s.threadStarted = true;
+  }
+  uint32_t id = s.nextId++;
+  uint64_t now = s.mode.load() == ClockMode::Virtual ? s.virtualUs.load() : s.realUs();
+  s.events.emplace(now + static_cast<uint64_t>(delayMs) * 1000, std::make_pair(id, std::move(fn)));
+  s.wake.notify_all();
+  return id;
+}
+
+void cancel(uint32_t id) {
+  Scheduler& s = scheduler();
+  std::lock_guard<std::mutex> lock(s.mutex);
+  for (auto it = s.events.begin(); it != s.events.end(); ++it) {
+    if (it->second.first == id) {
+      s.events.erase(it);
+      return;
+    }
+  }
+}
+
+} // namespace NativeSim
+
+// ----- Global allocation hooks -----
+void* operator new(size_t size) {
+  void* p = NativeSim::heapAlloc(size ? size : 1);
+  if (!p) throw std::bad_alloc();
+  return p;
+}
+void* operator new[](size_t size) { return operator new(size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return NativeSim::heapAlloc(size ? size : 1); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return NativeSim::heapAlloc(size ? size : 1); }
+void operator delete(void* p) noexcept { NativeSim::heapFree(p); }
+void operator delete[](void* p) noexcept { NativeSim::heapFree(p); }
+void operator delete(void* p, size_t) noexcept { NativeSim::heapFree(p); }
+void operator delete[](void* p, size_t) noexcept { NativeSim::heapFree(p); }
@@ -0,0 +1,153 @@
+#ifndef NATIVE_SIM_H
+#define NATIVE_SIM_H
+
+// Host-side control surface for the native simulation of the Arduino-ESP32
+// core. Sketches never need this header; tests, benchmarks and the native
+// host program use it to drive the simulated clock, radio and filesystem.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <functional>
+#include <string>
+#include "WString.h"
+#include "WiFiType.h"
+
+namespace NativeSim {
+
+// ----- Clock -----
+// RealTime: millis()/delay() follow the host steady clock and timed events run
+// on a background "event task" thread, like the ESP32 system event loop.
+// Virtual: time only moves when delay()/advance() is called, and due events run
+// on the calling thread. Virtual mode is what deterministic tests use.
+enum class ClockMode { RealTime, Virtual };
+
+void setClockMode(ClockMode mode);
+ClockMode clockMode();
+uint64_t nowMicros();
+void sleepMicros(uint64_t us);
+void advanceMillis(uint32_t ms);  // Virtual mode only.
+
+// Runs fn once the clock has moved delayMs forward. Returns an id for cancel().
+uint32_t schedule(uint32_t delayMs, std::function<void()> fn);
+void cancel(uint32_t id);
+
+// ----- Heap accounting -----
+// Every String buffer and every global operator new is tracked so handlers can
+// be compared by allocations per request.
+struct HeapStats {
+  uint64_t allocations;     // malloc/new/realloc calls that produced a block
+  uint64_t frees;
+  uint64_t bytesAllocated;  // cumulative
+  size_t liveBytes;
+  size_t peakLiveBytes;
+};
+
+HeapStats heapStats();
+void resetHeapPeak();
+void setHeapSize(size_t bytes);   // Simulated DRAM size reported by ESP.getHeapSize().
+size_t heapSize();
+
+void* heapAlloc(size_t size);
+void* heapRealloc(void* ptr, size_t size);
+void heapFree(void* ptr);
+
+// ----- Radio -----
+struct AccessPoint {
+  String ssid;
+  String password;       // empty for open networks
+  uint8_t bssid[6];
+  int32_t channel;
+  int32_t rssi;
+  wifi_auth_mode_t auth;
+};
+
+struct RadioTiming {
+  uint32_t channelDwellMs = 120;  // active probe time per channel
+  uint8_t channels = 13;
+  uint32_t associateMs = 250;     // auth + association
+  uint32_t authFailMs = 1500;     // time until a wrong password is reported
+  uint32_t dhcpMs = 900;          // DHCP DISCOVER..ACK
+};
+
+void addAccessPoint(const AccessPoint& ap);
+void addAccessPoint(const char* ssid, const char* password, int32_t channel, int32_t rssi);
+bool setAccessPointRssi(const char* ssid, int32_t rssi);
+void clearAccessPoints();
+void setRadioTiming(const RadioTiming& timing);
+RadioTiming radioTiming();
+// Credentials the station would have found in NVS at boot.
+void setStoredCredentials(const char* ssid, const char* password);
+// Number of stations associated to the SoftAP.
+void setSoftAPStations(uint8_t count);
+
+// ----- NVS -----
+// Preferences live in process memory; a WiFiManager constructed later in the
+// same process sees what an earlier one stored, like after a reboot.
+void eraseNvs();
+uint32_t nvsWriteCount();  // committed put*/remove/clear calls (flash wear)
+
+// ----- Filesystem -----
+// SPIFFS is mapped onto a host directory. Defaults to $WM_FS_ROOT or ./data.
+void setFilesystemRoot(const char* path);
+const char* filesystemRoot();
+
+// Flash cost of SPIFFS operations, charged on the clock. A mount checks every
+// page of the partition; a format erases every sector. A missing root
+// directory is a blank partition: begin(true) pays a failed mount, a format
+// and a second mount, like the ESP32 driver. Opening a file scans the object
+// lookup pages for its name (an append also walks the index to the end of the
+// file), every write() that reaches flash programs a partial page and updates
+// the object index, and closing a written file flushes the index header.
+struct FlashTiming {
+  uint32_t mountMs = 250;
+  uint32_t formatMs = 9000;
+  uint32_t openUs = 1200;
+  uint32_t appendSeekUsPerKB = 40;
+  uint32_t writeUs = 350;
+  uint32_t programUsPerKB = 1000;
+  uint32_t closeUs = 600;
+};
+
+void setFlashTiming(const FlashTiming& timing);
+FlashTiming flashTiming();
+
+// File operations that reached the simulated flash since the last reset.
+struct FlashStats {
+  uint32_t opens;   // files, including renames (same name lookup)
+  uint32_t writes;  // File::write() calls
+  uint32_t closes;  // closes of files opened for writing
+  uint64_t bytesWritten;
+  uint64_t bytesRead;
+};
+
+FlashStats flashStats();
+void resetFlashStats();
+
+// ----- OTA -----
+// Size of the inactive app slot that Update writes to, and the host file that
+// receives the image of the last successful Update.end() (the next boot
+// image). The path defaults to /tmp/nativesim-ota-<pid>.bin.
+void setOtaPartitionSize(size_t bytes);
+size_t otaPartitionSize();
+void setOtaImagePath(const char* path);
+const char* otaImagePath();
+
+// ----- HTTP -----
+// Port actually bound by the most recent AsyncWebServer::begin(); useful when
+// the configured port is 0 (ephemeral).
+uint16_t lastBoundHttpPort();
+// Runs one bodiless request (e.g. "GET", "/scan?refresh=1") through the
+// handlers of the server bound to `port` on the calling thread, without a
+// socket, and drains the response body into `body`. Returns the status code,
+// 0 if the handler sent nothing, -1 if no server listens on `port`. For
+// micro-benchmarks: no socket or scheduler time in the measurement.
+int serveInProcess(uint16_t port, const char* method, const char* target, std::string* body = nullptr);
+
+// ----- UDP -----
+// Port actually bound by the most recent AsyncUDP::listen(), e.g. the captive
+// DNS responder started with WM_DNS_PORT=0.
+uint16_t lastBoundUdpPort();
+
+} // namespace NativeSim
+
+#endif // NATIVE_SIM_H
@@ -0,0 +1,187 @@
+#ifndef NATIVE_SIM_CLIENT_H
+#define NATIVE_SIM_CLIENT_H
+
+// Loopback HTTP and WebSocket clients for the native tests and benchmarks.
+// Header-only and host-only: it talks to the simulated AsyncWebServer over
+// real sockets, the way a browser on the SoftAP would.
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+
+namespace NativeSim {
+
+// ----- HTTP -----
+// A connection to 127.0.0.1:`port`, or -1. `from` binds the client end to
+// another address in 127/8 (one per simulated client); `rcvbuf` shrinks the
+// receive buffer, e.g. for a client that reads slowly or not at all.
+inline int openSocket(uint16_t port, const char* from = nullptr, int rcvbuf = 0) {
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (rcvbuf) setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+  sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  if (from) {
+    inet_pton(AF_INET, from, &addr.sin_addr);
+    bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+  }
+  addr.sin_port = htons(port);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+// Reads until the server closes, then closes `fd`. With `maxBody` the client
+// hangs up once that much of the body has arrived, like a link that drops
+// mid-transfer.
+inline std::string receiveAll(int fd, size_t maxBody = std::string::npos) {
+  std::string raw;
+  char buf[4096];
+  ssize_t n;
+  while ((n = recv(fd, buf, sizeof(buf), 0)) > 0) {
+    raw.append(buf, n);
+    size_t split = raw.find("\r\n\r\n");
+    if (split != std::string::npos && raw.size() - split - 4 >= maxBody) break;
+  }
+  close(fd);
+  return raw;
+}
+
+// Sends `request` as is on a new connection; the raw reply (see receiveAll()).
+inline std::string exchange(uint16_t port, const std::string& request, size_t maxBody = std::string::npos) {
+  int fd = openSocket(port);
+  if (fd < 0) return std::string();
+  send(fd, request.data(), request.size(), 0);
+  return receiveAll(fd, maxBody);
+}
+
+struct HttpReply {
+  int status = -1;   // -1: no complete head arrived
+  std::string head;  // status line and headers, each ending in CRLF
+  std::string body;  // chunked transfer coding removed
+
+  // Value of header `name`, "" if absent.
+  std::string header(const std::string& name) const {
+    size_t pos = head.find("\r\n" + name + ": ");
+    if (pos == std::string::npos) return "";
+    pos += name.size() + 4;
+    return head.substr(pos, head.find("\r\n", pos) - pos);
+  }
+};
+
+// Splits a raw reply into status, head and body, joining chunk payloads.
+inline HttpReply parseReply(const std::string& raw) {
+  HttpReply reply;
+  size_t split = raw.find("\r\n\r\n");
+  if (split == std::string::npos) return reply;
+  reply.status = atoi(raw.c_str() + 9);
+  reply.head = raw.substr(0, split + 2);
+  size_t pos = split + 4;
+  if (reply.header("Transfer-Encoding") != "chunked") {
+    reply.body = raw.substr(pos);
+    return reply;
+  }
+  for (;;) {
+    size_t eol = raw.find("\r\n", pos);
+    if (eol == std::string::npos) break;
+    size_t len = strtoul(raw.c_str() + pos, nullptr, 16);
+    if (len == 0) break;
+    reply.body.append(raw, eol + 2, len);
+    pos = eol + 2 + len + 2;
+  }
+  return reply;
+}
+
+inline HttpReply httpRequest(uint16_t port, const std::string& request) {
+  return parseReply(exchange(port, request));
+}
+
+// `headers`: extra header lines, each ending in CRLF.
+inline HttpReply httpGet(uint16_t port, const std::string& target, const std::string& headers = "") {
+  return httpRequest(port, "GET " + target + " HTTP/1.1\r\nHost: localhost\r\n" + headers + "\r\n");
+}
+
+// A GET that keeps nothing but the status code and, in `bytes`, how much
+// arrived (head included). Stack buffers only, so heap counters taken around
+// it see the server alone. -1 if the connection failed.
+inline int httpGetDiscard(uint16_t port, const char* target, size_t* bytes = nullptr) {
+  int fd = openSocket(port);
+  if (fd < 0) return -1;
+  char req[256];
+  int len = snprintf(req, sizeof(req), "GET %s HTTP/1.1\r\nHost: localhost\r\n\r\n", target);
+  send(fd, req, len, 0);
+  char buf[4096];
+  char status[16] = {0};
+  size_t total = 0;
+  ssize_t n;
+  while ((n = recv(fd, buf, sizeof(buf), 0)) > 0) {
+    if (total < sizeof(status) - 1) {
+      size_t take = sizeof(status) - 1 - total;
+      memcpy(status + total, buf, static_cast<size_t>(n) < take ? n : take);
+    }
+    total += n;
+  }
+  close(fd);
+  if (bytes) *bytes = total;
+  return atoi(status + 9);
+}
+
+// ----- WebSocket -----
+// Upgrades a new connection on `path`; the socket once the 101 has been
+// read, or -1. Receives time out after 2 s.
+inline int openWebSocket(uint16_t port, const char* path, int rcvbuf = 0) {
+  int fd = openSocket(port, nullptr, rcvbuf);
+  if (fd < 0) return -1;
+  timeval tv{2, 0};
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+  std::string req = std::string("GET ") + path +
+                    " HTTP/1.1\r\nHost: localhost\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                    "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\nSec-WebSocket-Version: 13\r\n\r\n";
+  send(fd, req.data(), req.size(), 0);
+  std::string head;
+  char c;
+  while (head.find("\r\n\r\n") == std::string::npos && recv(fd, &c, 1, 0) == 1) head += c;
+  if (head.compare(0, 12, "HTTP/1.1 101") != 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+// Moves the complete frames at the front of `raw` out of it and appends the
+// payloads of the text frames to `messages`; returns how many there were.
+// Server frames are unmasked, and the server never sends 64 KB or more.
+inline size_t takeTextFrames(std::string& raw, std::vector<std::string>& messages) {
+  size_t taken = 0;
+  while (raw.size() >= 2) {
+    size_t len = raw[1] & 0x7F;
+    size_t hdr = 2;
+    if (len == 126) {
+      if (raw.size() < 4) break;
+      len = (static_cast<uint8_t>(raw[2]) << 8) | static_cast<uint8_t>(raw[3]);
+      hdr = 4;
+    }
+    if (raw.size() < hdr + len) break;
+    if ((raw[0] & 0x0F) == 0x1) {
+      messages.push_back(raw.substr(hdr, len));
+      taken++;
+    }
+    raw.erase(0, hdr + len);
+  }
+  return taken;
+}
+
+} // namespace NativeSim
+
+#endif // NATIVE_SIM_CLIENT_H
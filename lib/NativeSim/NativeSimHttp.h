@@ -0,0 +1,112 @@
+#ifndef NATIVE_SIM_HTTP_H
+#define NATIVE_SIM_HTTP_H
+
+// Internal plumbing shared by the native AsyncWebServer and AsyncWebSocket.
+// Not part of the ESPAsyncWebServer API surface.
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ESPAsyncWebServer.h"
+
+namespace NativeSimHttp {
+
+struct ServerCore;
+
+// One accepted TCP connection. Only the server thread reads the socket and
+// advances parsing; other threads may queue output or hand over a response
+// under `mutex`, then wake the server thread.
+struct Connection : std::enable_shared_from_this<Connection> {
+  enum State { ReadingHead, ReadingBody, AwaitingResponse, Sending, WebSocket, Closed };
+
+  int fd = -1;
+  ServerCore* core = nullptr;
+  IPAddress remoteIP;
+  uint16_t remotePort = 0;
+  IPAddress localIP;
+  uint16_t localPort = 0;
+
+  std::mutex mutex;
+  State state = ReadingHead;
+  std::string in;
+  std::string out;
+  size_t outSent = 0;                 // bytes of `out` already written to the socket
+  uint64_t totalQueued = 0;           // lifetime bytes queued, for WebSocket queue tracking
+  uint64_t totalSent = 0;
+  std::deque<uint64_t> messageEnds;   // WebSocket frames still queued (by end offset)
+  bool closeWhenFlushed = false;
+
+  AsyncWebServerRequest* request = nullptr;
+  AsyncWebServerResponse* response = nullptr;
+  bool headSent = false;
+  bool bodyDone = false;
+
+  // Request body parsing.
+  size_t bodyReceived = 0;
+  std::string formBody;
+  enum MultipartState { MpPreamble, MpHeaders, MpData, MpBoundaryTail, MpDone } mpState = MpPreamble;
+  std::string mpBuf;
+  String mpName;
+  String mpFilename;
+  bool mpIsFile = false;
+  std::string mpItem;                 // 1460-byte upload chunk being assembled
+  size_t mpItemIndex = 0;
+  size_t mpItemSize = 0;
+
+  // WebSocket.
+  AsyncWebSocket* ws = nullptr;
+  uint8_t wsMessageOpcode = 0;
+  uint64_t wsMessageIndex = 0;
+
+  // Queues raw bytes for the socket (any thread). Returns false once closed.
+  bool queue(const char* data, size_t len, bool isMessage = false);
+  size_t queuedMessages();
+  void wake();
+};
+
+typedef std::shared_ptr<Connection> ConnectionPtr;
+
+struct ServerCore {
+  AsyncWebServer* server = nullptr;
+  uint16_t port = 0;
+  int listenFd = -1;
+  int wakeFds[2] = {-1, -1};
+  std::thread thread;
+  std::atomic<bool> running{false};
+  std::vector<ConnectionPtr> conns;   // server thread only
+
+  bool start();
+  void stop();
+  void wake();
+  void run();
+
+  void accept();
+  void readFrom(const ConnectionPtr& c);
+  void process(const ConnectionPtr& c);
+  bool parseHead(const ConnectionPtr& c);
+  void consumeBody(const ConnectionPtr& c);
+  void feedMultipart(const ConnectionPtr& c, const char* data, size_t len);
+  void flushUploadItem(const ConnectionPtr& c, bool final);
+  void dispatch(const ConnectionPtr& c);
+  void pump(const ConnectionPtr& c);
+  void processWebSocket(const ConnectionPtr& c);
+  void close(const ConnectionPtr& c);
+  // NativeSim::serveInProcess().
+  int serveLocal(const char* method, const char* target, std::string* body);
+};
+
+// Helpers.
+String urlDecode(const char* s, size_t len);
+std::string base64Encode(const uint8_t* data, size_t len);
+std::string base64Decode(const char* data, size_t len);
+void sha1(const uint8_t* data, size_t len, uint8_t out[20]);
+std::string encodeWebSocketFrame(uint8_t opcode, const uint8_t* data, size_t len);
+const char* contentTypeFor(const String& path);
+
+} // namespace NativeSimHttp
+
+#endif // NATIVE_SIM_HTTP_H
@@ -0,0 +1,165 @@
+#include "Preferences.h"
+#include "NativeSim.h"
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace {
+
+struct Nvs {
+  std::mutex mutex;
+  std::map<std::string, std::map<std::string, std::string>> namespaces;
+  uint32_t writes = 0;
+};
+
+Nvs& nvs() {
+  static Nvs* store = new Nvs();
+  return *store;
+}
+
+bool validName(const char* name) { return name && *name && strlen(name) <= 15; }
+
+} // namespace
+
+Preferences::Preferences() : _started(false), _readOnly(false) { _name[0] = '\0'; }
+
+Preferences::~Preferences() { end(); }
+
+bool Preferences::begin(const char* name, bool readOnly, const char* partitionLabel) {
+  if (_started || !validName(name)) return false;
+  strlcpy(_name, name, sizeof(_name));
+  _readOnly = readOnly;
+  _started = true;
+  return true;
+}
+
+void Preferences::end() { _started = false; }
+
+bool Preferences::writable(const char* key) const { return _started && !_readOnly && validName(key); }
+
+bool Preferences::clear() {
+  if (!_started || _readOnly) return false;
+  Nvs& s = nvs();
+  std::lock_guard<std::mutex> lock(s.mutex);
+  s.namespaces.erase(_name);
+  s.writes++;
+  return true;
+}
+
+bool Preferences::remove(const char* key) {
+  if (!writable(key)) return false;
+  Nvs& s = nvs();
+  std::lock_guard<std::mutex> lock(s.mutex);
+  if (s.namespaces[_name].erase(key) == 0) return false;
+  s.writes++;
+  return true;
+}
+
+bool Preferences::isKey(const char* key) {
+  if (!_started || !validName(key)) return false;
+  Nvs& s = nvs();
+  std::lock_guard<std::mutex> lock(s.mutex);
+  auto ns = s.namespaces.find(_name);
+  return ns != s.namespaces.end() && ns->second.count(key) != 0;
+}
+
+// ----- Writes -----
+size_t Preferences::put(const char* key, const void* value, size_t len) {
+  if (!writable(key)) return 0;
+  Nvs& s = nvs();
+  std::lock_guard<std::mutex> lock(s.mutex);
+  s.namespaces[_name][key].assign(static_cast<const char*>(value), len);
+  s.writes++;
+  return len;
+}
+
+size_t Preferences::putBool(const char* key, bool value) {
+  uint8_t v = value ? 1 : 0;
+  return put(key, &v, sizeof(v));
+}
+
+size_t Preferences::putUInt(const char* key, uint32_t value) { return put(key, &value, sizeof(value)); }
+
+size_t Preferences::putString(const char* key, const char* value) {
+  if (!value) return 0;
+  return put(key, value, strlen(value)) ? strlen(value) : 0;
+}
+
+size_t Preferences::putString(const char* key, const String& value) { return putString(key, value.c_str()); }
+
+size_t Preferences::putBytes(const char* key, const void* value, size_t len) {
+  if (!value || !len) return 0;
+  return put(key, value, len);
+}
+
+// ----- Reads -----
+bool Preferences::get(const char* key, void* out, size_t len) {
+  if (!_started || !validName(key)) return false;
+  Nvs& s = nvs();
+  std::lock_guard<std::mutex> lock(s.mutex);
+  auto ns = s.namespaces.find(_name);
+  if (ns == s.namespaces.end()) return false;
+  auto it = ns->second.find(key);
+  if (it == ns->second.end() || it->second.size() != len) return false;
+  memcpy(out, it->second.data(), len);
+  return true;
+}
+
+bool Preferences::getBool(const char* key, bool defaultValue) {
+  uint8_t v;
+  return get(key, &v, sizeof(v)) ? v != 0 : defaultValue;
+}
+
+uint32_t Preferences::getUInt(const char* key, uint32_t defaultValue) {
+  uint32_t v;
+  return get(key, &v, sizeof(v)) ? v : defaultValue;
+}
+
+String Preferences::getString(const char* key, const String& defaultValue) {
+  if (!_started || !validName(key)) return defaultValue;
+  Nvs& s = nvs();
+  std::lock_guard<std::mutex> lock(s.mutex);
+  auto ns = s.namespaces.find(_name);
+  if (ns == s.namespaces.end()) return defaultValue;
+  auto it = ns->second.find(key);
+  return it == ns->second.end() ? defaultValue : String(it->second.c_str());
+}
+
+size_t Preferences::getBytesLength(const char* key) {
+  if (!_started || !validName(key)) return 0;
+  Nvs& s = nvs();
+  std::lock_guard<std::mutex> lock(s.mutex);
+  auto ns = s.namespaces.find(_name);
+  if (ns == s.namespaces.end()) return 0;
+  auto it = ns->second.find(key);
+  return it == ns->second.end() ? 0 : it->second.size();
+}
+
+size_t Preferences::getBytes(const char* key, void* buf, size_t maxLen) {
+  if (!_started || !validName(key) || !buf) return 0;
+  Nvs& s = nvs();
+  std::lock_guard<std::mutex> lock(s.mutex);
+  auto ns = s.namespaces.find(_name);
+  if (ns == s.namespaces.end()) return 0;
+  auto it = ns->second.find(key);
+  if (it == ns->second.end() || it->second.size() > maxLen) return 0;
+  memcpy(buf, it->second.data(), it->second.size());
+  return it->second.size();
+}
+
+// ----- NativeSim NVS controls -----
+namespace NativeSim {
+
+void eraseNvs() {
+  Nvs& s = nvs();
+  std::lock_guard<std::mutex> lock(s.mutex);
+  s.namespaces.clear();
+}
+
+uint32_t nvsWriteCount() {
+  Nvs& s = nvs();
+  std::lock_guard<std::mutex> lock(s.mutex);
+  return s.writes;
+}
+
+} // namespace NativeSim
@@ -0,0 +1,43 @@
+#ifndef NATIVE_SIM_PREFERENCES_H
+#define NATIVE_SIM_PREFERENCES_H
+
+#include "Arduino.h"
+
+// NVS key/value store (arduino-esp32 Preferences). Namespaces and keys follow
+// the NVS limit of 15 characters. Contents live in process memory, so a new
+// WiFiManager in the same process sees what the previous "boot" wrote.
+class Preferences {
+public:
+  Preferences();
+  ~Preferences();
+
+  bool begin(const char* name, bool readOnly = false, const char* partitionLabel = nullptr);
+  void end();
+
+  bool clear();
+  bool remove(const char* key);
+  bool isKey(const char* key);
+
+  size_t putBool(const char* key, bool value);
+  size_t putUInt(const char* key, uint32_t value);
+  size_t putString(const char* key, const char* value);
+  size_t putString(const char* key, const String& value);
+  size_t putBytes(const char* key, const void* value, size_t len);
+
+  bool getBool(const char* key, bool defaultValue = false);
+  uint32_t getUInt(const char* key, uint32_t defaultValue = 0);
+  String getString(const char* key, const String& defaultValue = String());
+  size_t getBytesLength(const char* key);
+  size_t getBytes(const char* key, void* buf, size_t maxLen);
+
+private:
+  bool writable(const char* key) const;
+  size_t put(const char* key, const void* value, size_t len);
+  bool get(const char* key, void* out, size_t len);
+
+  char _name[16];
+  bool _started;
+  bool _readOnly;
+};
+
+#endif // NATIVE_SIM_PREFERENCES_H
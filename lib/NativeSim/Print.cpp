@@ -0,0 +1,48 @@
+#include "Print.h"
+#include "NativeSim.h"
+#include <stdarg.h>
+#include <stdio.h>
+
+size_t Print::write(const uint8_t* buffer, size_t size) {
+  size_t n = 0;
+  while (size--) {
+    if (!write(*buffer++)) break;
+    n++;
+  }
+  return n;
+}
+
+size_t Print::printf(const char* format, ...) {
+  char loc[64];
+  va_list arg;
+  va_start(arg, format);
+  int len = vsnprintf(loc, sizeof(loc), format, arg);
+  va_end(arg);
+  if (len < 0) return 0;
+  if (static_cast<size_t>(len) < sizeof(loc)) return write(loc, len);
+  char* temp = static_cast<char*>(NativeSim::heapAlloc(len + 1));
+  if (!temp) return 0;
+  va_start(arg, format);
+  vsnprintf(temp, len + 1, format, arg);
+  va_end(arg);
+  size_t n = write(temp, len);
+  NativeSim::heapFree(temp);
+  return n;
+}
+
+size_t Print::printNumber(unsigned long long n, int base) {
+  String s(n, static_cast<unsigned char>(base));
+  if (base == HEX) s.toUpperCase();
+  return print(s);
+}
+
+size_t Print::printSigned(long long n, int base) {
+  if (base == DEC) return print(String(n));
+  return printNumber(static_cast<unsigned long long>(n), base);
+}
+
+size_t Print::print(double n, int digits) {
+  char buf[64];
+  int len = snprintf(buf, sizeof(buf), "%.*f", digits, n);
+  return write(buf, len);
+}
@@ -0,0 +1,23 @@
+#ifndef NATIVE_SIM_SPIFFS_H
+#define NATIVE_SIM_SPIFFS_H
+
+#include "FS.h"
+
+namespace fs {
+
+// SPIFFS mounted on a host directory (see NativeSim::setFilesystemRoot).
+class SPIFFSFS : public FS {
+public:
+  bool begin(bool formatOnFail = false, const char* basePath = "/spiffs", uint8_t maxOpenFiles = 10,
+             const char* partitionLabel = nullptr);
+  bool format();
+  size_t totalBytes();
+  size_t usedBytes();
+  void end();
+};
+
+} // namespace fs
+
+extern fs::SPIFFSFS SPIFFS;
+
+#endif // NATIVE_SIM_SPIFFS_H
@@ -0,0 +1,38 @@
+#ifndef NATIVE_SIM_STREAM_H
+#define NATIVE_SIM_STREAM_H
+
+#include "Print.h"
+
+class Stream : public Print {
+public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+
+  void setTimeout(unsigned long timeout) { _timeout = timeout; }
+  unsigned long getTimeout() const { return _timeout; }
+
+  virtual size_t readBytes(uint8_t* buffer, size_t length) {
+    size_t count = 0;
+    while (count < length) {
+      int c = read();
+      if (c < 0) break;
+      *buffer++ = static_cast<uint8_t>(c);
+      count++;
+    }
+    return count;
+  }
+  size_t readBytes(char* buffer, size_t length) { return readBytes(reinterpret_cast<uint8_t*>(buffer), length); }
+
+  virtual String readString() {
+    String ret;
+    int c;
+    while ((c = read()) >= 0) ret += static_cast<char>(c);
+    return ret;
+  }
+
+protected:
+  unsigned long _timeout = 1000;
+};
+
+#endif // NATIVE_SIM_STREAM_H
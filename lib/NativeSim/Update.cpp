@@ -0,0 +1,174 @@
+#include "Update.h"
+#include "NativeSim.h"
+#include <mutex>
+#include <string>
+#include <unistd.h>
+
+UpdateClass Update;
+
+namespace {
+
+const size_t kSectorSize = 4096;
+
+const char* const kErrorTexts[] = {
+  "No Error", "Flash Write Failed", "Flash Erase Failed", "Flash Read Failed", "Not Enough Space",
+  "Bad Size Given", "Stream Read Timeout", "MD5 Check Failed", "Wrong Magic Byte",
+  "Could Not Activate The Firmware", "Partition Could Not be Found", "Bad Argument", "Aborted",
+};
+
+std::mutex g_otaMutex;
+size_t g_partitionSize = 0x140000;  // app slot of the default 4 MB table
+std::string g_imagePath;
+
+std::string imagePath() {
+  std::lock_guard<std::mutex> lock(g_otaMutex);
+  if (g_imagePath.empty()) g_imagePath = "/tmp/nativesim-ota-" + std::to_string(getpid()) + ".bin";
+  return g_imagePath;
+}
+
+} // namespace
+
+UpdateClass::UpdateClass()
+  : _error(UPDATE_ERROR_OK), _size(0), _progress(0), _buffer(nullptr), _bufferLen(0), _file(nullptr) {}
+
+UpdateClass::~UpdateClass() { reset(); }
+
+void UpdateClass::reset() {
+  delete[] _buffer;
+  _buffer = nullptr;
+  _bufferLen = 0;
+  if (_file) fclose(_file);
+  _file = nullptr;
+  _size = 0;
+  _progress = 0;
+}
+
+bool UpdateClass::begin(size_t size, int command, int ledPin, uint8_t ledOn, const char* label) {
+  (void)ledPin;
+  (void)ledOn;
+  (void)label;
+  if (_size > 0) return false;  // already running
+  _error = UPDATE_ERROR_OK;
+  if (size == 0 || command != U_FLASH) {
+    _error = UPDATE_ERROR_BAD_ARGUMENT;
+    return false;
+  }
+  size_t partition = NativeSim::otaPartitionSize();
+  if (size == UPDATE_SIZE_UNKNOWN) size = partition;
+  if (size > partition) {
+    _error = UPDATE_ERROR_SIZE;
+    return false;
+  }
+  _file = fopen((imagePath() + ".part").c_str(), "wb");
+  if (!_file) {
+    _error = UPDATE_ERROR_NO_PARTITION;
+    return false;
+  }
+  _buffer = new uint8_t[kSectorSize];
+  _size = size;
+  return true;
+}
+
+bool UpdateClass::flushSector() {
+  if (_progress == 0 && _buffer[0] != ESP_IMAGE_HEADER_MAGIC) {
+    _error = UPDATE_ERROR_MAGIC_BYTE;
+    return false;
+  }
+  if (fwrite(_buffer, 1, _bufferLen, _file) != _bufferLen) {
+    _error = UPDATE_ERROR_WRITE;
+    return false;
+  }
+  _progress += _bufferLen;
+  _bufferLen = 0;
+  return true;
+}
+
+size_t UpdateClass::write(uint8_t* data, size_t len) {
+  if (hasError() || !isRunning()) return 0;
+  if (len > remaining() - _bufferLen) {
+    abort();
+    _error = UPDATE_ERROR_SPACE;
+    return 0;
+  }
+  size_t done = 0;
+  while (done < len) {
+    size_t n = kSectorSize - _bufferLen;
+    if (n > len - done) n = len - done;
+    memcpy(_buffer + _bufferLen, data + done, n);
+    _bufferLen += n;
+    done += n;
+    if ((_bufferLen == kSectorSize || _progress + _bufferLen == _size) && !flushSector()) {
+      uint8_t error = _error;
+      abort();
+      _error = error;
+      return 0;
+    }
+  }
+  return len;
+}
+
+bool UpdateClass::end(bool evenIfRemaining) {
+  if (hasError() || !isRunning()) return false;
+  if (_bufferLen && !flushSector()) {
+    uint8_t error = _error;
+    abort();
+    _error = error;
+    return false;
+  }
+  if (!isFinished()) {
+    if (!evenIfRemaining || _progress == 0) {
+      abort();
+      _error = UPDATE_ERROR_SIZE;
+      return false;
+    }
+    _size = _progress;
+  }
+  std::string path = imagePath();
+  fclose(_file);
+  _file = nullptr;
+  bool ok = rename((path + ".part").c_str(), path.c_str()) == 0;
+  reset();
+  if (!ok) _error = UPDATE_ERROR_ACTIVATE;
+  return ok;
+}
+
+void UpdateClass::abort() {
+  if (_file) {
+    fclose(_file);
+    _file = nullptr;
+    unlink((imagePath() + ".part").c_str());
+  }
+  reset();
+  _error = UPDATE_ERROR_ABORT;
+}
+
+const char* UpdateClass::errorString() {
+  return _error < sizeof(kErrorTexts) / sizeof(kErrorTexts[0]) ? kErrorTexts[_error] : "UNKNOWN";
+}
+
+void UpdateClass::printError(Print& out) { out.println(errorString()); }
+
+namespace NativeSim {
+
+void setOtaPartitionSize(size_t bytes) {
+  std::lock_guard<std::mutex> lock(g_otaMutex);
+  g_partitionSize = bytes;
+}
+
+size_t otaPartitionSize() {
+  std::lock_guard<std::mutex> lock(g_otaMutex);
+  return g_partitionSize;
+}
+
+void setOtaImagePath(const char* path) {
+  std::lock_guard<std::mutex> lock(g_otaMutex);
+  g_imagePath = path ? path : "";
+}
+
+const char* otaImagePath() {
+  static std::string current;
+  current = imagePath();
+  return current.c_str();
+}
+
+} // namespace NativeSim
@@ -0,0 +1,67 @@
+#ifndef NATIVE_SIM_UPDATE_H
+#define NATIVE_SIM_UPDATE_H
+
+#include "Arduino.h"
+
+// Firmware update sink (arduino-esp32 Update). Data is staged through a
+// 4 KB sector buffer, as on the device, into a host file standing in for the
+// inactive app partition; end() makes it the boot image (see
+// NativeSim::otaImagePath()).
+
+#define UPDATE_ERROR_OK (0)
+#define UPDATE_ERROR_WRITE (1)
+#define UPDATE_ERROR_ERASE (2)
+#define UPDATE_ERROR_READ (3)
+#define UPDATE_ERROR_SPACE (4)
+#define UPDATE_ERROR_SIZE (5)
+#define UPDATE_ERROR_STREAM (6)
+#define UPDATE_ERROR_MD5 (7)
+#define UPDATE_ERROR_MAGIC_BYTE (8)
+#define UPDATE_ERROR_ACTIVATE (9)
+#define UPDATE_ERROR_NO_PARTITION (10)
+#define UPDATE_ERROR_BAD_ARGUMENT (11)
+#define UPDATE_ERROR_ABORT (12)
+
+#define UPDATE_SIZE_UNKNOWN 0xFFFFFFFF
+
+#define U_FLASH 0
+#define U_SPIFFS 100
+
+#define ESP_IMAGE_HEADER_MAGIC 0xE9
+
+class UpdateClass {
+public:
+  UpdateClass();
+  ~UpdateClass();
+
+  bool begin(size_t size = UPDATE_SIZE_UNKNOWN, int command = U_FLASH, int ledPin = -1, uint8_t ledOn = LOW,
+             const char* label = nullptr);
+  size_t write(uint8_t* data, size_t len);
+  bool end(bool evenIfRemaining = false);
+  void abort();
+
+  void printError(Print& out);
+  const char* errorString();
+  uint8_t getError() { return _error; }
+  bool hasError() { return _error != UPDATE_ERROR_OK; }
+  bool isRunning() { return _size > 0; }
+  bool isFinished() { return _progress == _size; }
+  size_t size() { return _size; }
+  size_t progress() { return _progress; }
+  size_t remaining() { return _size - _progress; }
+
+private:
+  bool flushSector();
+  void reset();
+
+  uint8_t _error;
+  size_t _size;
+  size_t _progress;
+  uint8_t* _buffer;
+  size_t _bufferLen;
+  FILE* _file;
+};
+
+extern UpdateClass Update;
+
+#endif // NATIVE_SIM_UPDATE_H
@@ -0,0 +1,407 @@
+#include "WString.h"
+#include "NativeSim.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace {
+
+// Formats an integer in the given base into buf (which must hold 66 bytes).
+void formatUnsigned(unsigned long long value, unsigned char base, char* buf) {
+  if (base < 2 || base > 36) base = 10;
+  char tmp[66];
+  int i = 0;
+  do {
+    unsigned digit = static_cast<unsigned>(value % base);
+    tmp[i++] = static_cast<char>(digit < 10 ? '0' + digit : 'a' + digit - 10);
+    value /= base;
+  } while (value);
+  int j = 0;
+  while (i) buf[j++] = tmp[--i];
+  buf[j] = '\0';
+}
+
+void formatSigned(long long value, unsigned char base, char* buf) {
+  if (value < 0 && base == 10) {
+    buf[0] = '-';
+    formatUnsigned(static_cast<unsigned long long>(-(value + 1)) + 1, base, buf + 1);
+  } else {
+    formatUnsigned(static_cast<unsigned long long>(value), base, buf);
+  }
+}
+
+} // namespace
+
+// ----- Construction -----
+String::String(const char* cstr) {
+  init();
+  if (cstr) copy(cstr, strlen(cstr));
+}
+
+String::String(const char* cstr, unsigned int length) {
+  init();
+  if (cstr) copy(cstr, length);
+}
+
+String::String(const String& value) {
+  init();
+  *this = value;
+}
+
+String::String(String&& rval) noexcept {
+  init();
+  move(rval);
+}
+
+String::String(char c) {
+  init();
+  char buf[2] = {c, 0};
+  *this = buf;
+}
+
+String::String(unsigned char value, unsigned char base) : String(static_cast<unsigned long long>(value), base) {}
+String::String(int value, unsigned char base) : String(static_cast<long long>(value), base) {}
+String::String(unsigned int value, unsigned char base) : String(static_cast<unsigned long long>(value), base) {}
+String::String(long value, unsigned char base) : String(static_cast<long long>(value), base) {}
+String::String(unsigned long value, unsigned char base) : String(static_cast<unsigned long long>(value), base) {}
+
+String::String(long long value, unsigned char base) {
+  init();
+  char buf[67];
+  formatSigned(value, base, buf);
+  *this = buf;
+}
+
+String::String(unsigned long long value, unsigned char base) {
+  init();
+  char buf[66];
+  formatUnsigned(value, base, buf);
+  *this = buf;
+}
+
+String::String(float value, unsigned int decimalPlaces) : String(static_cast<double>(value), decimalPlaces) {}
+
+String::String(double value, unsigned int decimalPlaces) {
+  init();
+  char buf[64];
+  snprintf(buf, sizeof(buf), "%.*f", static_cast<int>(decimalPlaces), value);
+  *this = buf;
+}
+
+String::~String() {
+  releaseBuffer();
+}
+
+// ----- Memory management -----
+void String::init() {
+  _buffer = nullptr;
+  _capacity = 0;
+  _len = 0;
+}
+
+void String::releaseBuffer() {
+  if (_buffer && !isSSO()) NativeSim::heapFree(_buffer);
+}
+
+void String::invalidate() {
+  releaseBuffer();
+  init();
+}
+
+bool String::reserve(unsigned int size) {
+  if (_buffer && _capacity >= size) return true;
+  if (changeBuffer(size)) {
+    if (_len == 0) _buffer[0] = '\0';
+    return true;
+  }
+  return false;
+}
+
+bool String::changeBuffer(unsigned int maxStrLen) {
+  if (maxStrLen < SSO_SIZE) {
+    if (_buffer && !isSSO()) {
+      memcpy(_sso, _buffer, _len + 1);
+      NativeSim::heapFree(_buffer);
+    }
+    _buffer = _sso;
+    _capacity = SSO_SIZE - 1;
+    return true;
+  }
+  char* newbuffer;
+  if (isSSO()) {
+    newbuffer = static_cast<char*>(NativeSim::heapAlloc(maxStrLen + 1));
+    if (newbuffer) memcpy(newbuffer, _sso, _len + 1);
+  } else {
+    newbuffer = static_cast<char*>(NativeSim::heapRealloc(_buffer, maxStrLen + 1));
+  }
+  if (!newbuffer) return false;
+  _buffer = newbuffer;
+  _capacity = maxStrLen;
+  return true;
+}
+
+String& String::copy(const char* cstr, unsigned int length) {
+  if (!reserve(length)) {
+    invalidate();
+    return *this;
+  }
+  _len = length;
+  memmove(_buffer, cstr, length);
+  _buffer[length] = '\0';
+  return *this;
+}
+
+void String::move(String& rhs) {
+  if (this == &rhs) return;
+  if (rhs.isSSO()) {
+    copy(rhs._sso, rhs._len);
+    rhs._len = 0;
+    rhs._sso[0] = '\0';
+    return;
+  }
+  releaseBuffer();
+  _buffer = rhs._buffer;
+  _capacity = rhs._capacity;
+  _len = rhs._len;
+  rhs.init();
+}
+
+String& String::operator=(const String& rhs) {
+  if (this == &rhs) return *this;
+  if (rhs._buffer) copy(rhs._buffer, rhs._len);
+  else invalidate();
+  return *this;
+}
+
+String& String::operator=(String&& rval) noexcept {
+  move(rval);
+  return *this;
+}
+
+String& String::operator=(const char* cstr) {
+  if (cstr) copy(cstr, strlen(cstr));
+  else invalidate();
+  return *this;
+}
+
+// ----- Concatenation -----
+bool String::concat(const char* cstr, unsigned int length) {
+  if (!cstr) return false;
+  if (length == 0) return true;
+  unsigned int newlen = _len + length;
+  // Appending a slice of ourselves must survive the reallocation.
+  if (_buffer && cstr >= _buffer && cstr < _buffer + _len) {
+    size_t offset = static_cast<size_t>(cstr - _buffer);
+    if (!reserve(newlen)) return false;
+    cstr = _buffer + offset;
+  } else if (!reserve(newlen)) {
+    return false;
+  }
+  memmove(_buffer + _len, cstr, length);
+  _len = newlen;
+  _buffer[_len] = '\0';
+  return true;
+}
+
+bool String::concat(const String& s) { return concat(s.c_str(), s._len); }
+bool String::concat(const char* cstr) { return cstr ? concat(cstr, strlen(cstr)) : false; }
+bool String::concat(char c) { return concat(&c, 1); }
+
+bool String::concat(unsigned char num) { return concat(static_cast<unsigned long long>(num)); }
+bool String::concat(int num) { return concat(static_cast<long long>(num)); }
+bool String::concat(unsigned int num) { return concat(static_cast<unsigned long long>(num)); }
+bool String::concat(long num) { return concat(static_cast<long long>(num)); }
+bool String::concat(unsigned long num) { return concat(static_cast<unsigned long long>(num)); }
+
+bool String::concat(long long num) {
+  char buf[67];
+  formatSigned(num, 10, buf);
+  return concat(buf, strlen(buf));
+}
+
+bool String::concat(unsigned long long num) {
+  char buf[66];
+  formatUnsigned(num, 10, buf);
+  return concat(buf, strlen(buf));
+}
+
+bool String::concat(float num) { return concat(static_cast<double>(num)); }
+
+bool String::concat(double num) {
+  char buf[64];
+  int n = snprintf(buf, sizeof(buf), "%.2f", num);
+  return concat(buf, static_cast<unsigned int>(n));
+}
+
+String operator+(const String& lhs, const String& rhs) { String s(lhs); s.concat(rhs); return s; }
+String operator+(const String& lhs, const char* rhs) { String s(lhs); s.concat(rhs); return s; }
+String operator+(const char* lhs, const String& rhs) { String s(lhs); s.concat(rhs); return s; }
+String operator+(const String& lhs, char rhs) { String s(lhs); s.concat(rhs); return s; }
+String operator+(const String& lhs, int rhs) { String s(lhs); s.concat(rhs); return s; }
+String operator+(const String& lhs, unsigned int rhs) { String s(lhs); s.concat(rhs); return s; }
+String operator+(const String& lhs, long rhs) { String s(lhs); s.concat(rhs); return s; }
+String operator+(const String& lhs, unsigned long rhs) { String s(lhs); s.concat(rhs); return s; }
+String operator+(const String& lhs, long long rhs) { String s(lhs); s.concat(rhs); return s; }
+String operator+(const String& lhs, unsigned long long rhs) { String s(lhs); s.concat(rhs); return s; }
+String operator+(const String& lhs, float rhs) { String s(lhs); s.concat(rhs); return s; }
+String operator+(const String& lhs, double rhs) { String s(lhs); s.concat(rhs); return s; }
+
+// ----- Comparison -----
+int String::compareTo(const String& s) const {
+  return strcmp(c_str(), s.c_str());
+}
+
+bool String::equals(const String& s) const {
+  return _len == s._len && compareTo(s) == 0;
+}
+
+bool String::equals(const char* cstr) const {
+  return strcmp(c_str(), cstr ? cstr : "") == 0;
+}
+
+bool String::equalsIgnoreCase(const String& s) const {
+  if (_len != s._len) return false;
+  return strcasecmp(c_str(), s.c_str()) == 0;
+}
+
+bool String::startsWith(const String& prefix) const {
+  if (_len < prefix._len) return false;
+  return startsWith(prefix, 0);
+}
+
+bool String::startsWith(const String& prefix, unsigned int offset) const {
+  if (offset > _len || _len - offset < prefix._len) return false;
+  return strncmp(c_str() + offset, prefix.c_str(), prefix._len) == 0;
+}
+
+bool String::endsWith(const String& suffix) const {
+  if (_len < suffix._len) return false;
+  return strcmp(c_str() + _len - suffix._len, suffix.c_str()) == 0;
+}
+
+// ----- Character access -----
+char String::charAt(unsigned int index) const { return operator[](index); }
+
+void String::setCharAt(unsigned int index, char c) {
+  if (index < _len) _buffer[index] = c;
+}
+
+char String::operator[](unsigned int index) const {
+  if (index >= _len || !_buffer) return 0;
+  return _buffer[index];
+}
+
+char& String::operator[](unsigned int index) {
+  static char dummy;
+  if (index >= _len || !_buffer) {
+    dummy = 0;
+    return dummy;
+  }
+  return _buffer[index];
+}
+
+void String::getBytes(unsigned char* buf, unsigned int bufsize, unsigned int index) const {
+  if (!bufsize || !buf) return;
+  if (index >= _len) {
+    buf[0] = 0;
+    return;
+  }
+  unsigned int n = bufsize - 1;
+  if (n > _len - index) n = _len - index;
+  memcpy(buf, c_str() + index, n);
+  buf[n] = 0;
+}
+
+// ----- Search -----
+int String::indexOf(char ch, unsigned int fromIndex) const {
+  if (fromIndex >= _len) return -1;
+  const char* p = strchr(c_str() + fromIndex, ch);
+  return p ? static_cast<int>(p - c_str()) : -1;
+}
+
+int String::indexOf(const String& str, unsigned int fromIndex) const {
+  if (fromIndex >= _len) return -1;
+  const char* p = strstr(c_str() + fromIndex, str.c_str());
+  return p ? static_cast<int>(p - c_str()) : -1;
+}
+
+int String::lastIndexOf(char ch) const {
+  const char* p = strrchr(c_str(), ch);
+  return p ? static_cast<int>(p - c_str()) : -1;
+}
+
+int String::lastIndexOf(const String& str) const {
+  if (str._len == 0 || str._len > _len) return -1;
+  for (int i = static_cast<int>(_len - str._len); i >= 0; i--) {
+    if (strncmp(c_str() + i, str.c_str(), str._len) == 0) return i;
+  }
+  return -1;
+}
+
+String String::substring(unsigned int left, unsigned int right) const {
+  if (left > right) {
+    unsigned int tmp = left;
+    left = right;
+    right = tmp;
+  }
+  if (left >= _len) return String();
+  if (right > _len) right = _len;
+  return String(c_str() + left, right - left);
+}
+
+// ----- Modification -----
+void String::replace(char find, char replace) {
+  for (unsigned int i = 0; i < _len; i++) {
+    if (_buffer[i] == find) _buffer[i] = replace;
+  }
+}
+
+void String::replace(const String& find, const String& replace) {
+  if (_len == 0 || find._len == 0) return;
+  String result;
+  unsigned int pos = 0;
+  int hit;
+  while ((hit = indexOf(find, pos)) >= 0) {
+    result.concat(c_str() + pos, static_cast<unsigned int>(hit) - pos);
+    result.concat(replace);
+    pos = static_cast<unsigned int>(hit) + find._len;
+  }
+  if (pos == 0) return;
+  result.concat(c_str() + pos, _len - pos);
+  move(result);
+}
+
+void String::remove(unsigned int index) { remove(index, static_cast<unsigned int>(-1)); }
+
+void String::remove(unsigned int index, unsigned int count) {
+  if (index >= _len) return;
+  if (count > _len - index) count = _len - index;
+  memmove(_buffer + index, _buffer + index + count, _len - index - count);
+  _len -= count;
+  _buffer[_len] = '\0';
+}
+
+void String::toLowerCase() {
+  for (unsigned int i = 0; i < _len; i++) _buffer[i] = static_cast<char>(tolower(static_cast<unsigned char>(_buffer[i])));
+}
+
+void String::toUpperCase() {
+  for (unsigned int i = 0; i < _len; i++) _buffer[i] = static_cast<char>(toupper(static_cast<unsigned char>(_buffer[i])));
+}
+
+void String::trim() {
+  if (_len == 0) return;
+  unsigned int begin = 0;
+  while (begin < _len && isspace(static_cast<unsigned char>(_buffer[begin]))) begin++;
+  unsigned int end = _len;
+  while (end > begin && isspace(static_cast<unsigned char>(_buffer[end - 1]))) end--;
+  _len = end - begin;
+  if (begin) memmove(_buffer, _buffer + begin, _len);
+  _buffer[_len] = '\0';
+}
+
+// ----- Parsing -----
+long String::toInt() const { return atol(c_str()); }
+float String::toFloat() const { return static_cast<float>(atof(c_str())); }
+double String::toDouble() const { return atof(c_str()); }
@@ -0,0 +1,136 @@
+#ifndef NATIVE_SIM_WSTRING_H
+#define NATIVE_SIM_WSTRING_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Host implementation of the Arduino String class. Like the ESP32 core it keeps
+// short strings inline (SSO); longer buffers come from the simulated heap so
+// every reallocation shows up in NativeSim::heapStats(), which is the point:
+// String churn is what we want to measure off-device.
+
+class __FlashStringHelper;
+
+class String {
+public:
+  String(const char* cstr = "");
+  String(const char* cstr, unsigned int length);
+  String(const String& str);
+  String(String&& rval) noexcept;
+  String(const __FlashStringHelper* str) : String(reinterpret_cast<const char*>(str)) {}
+  explicit String(char c);
+  explicit String(unsigned char value, unsigned char base = 10);
+  explicit String(int value, unsigned char base = 10);
+  explicit String(unsigned int value, unsigned char base = 10);
+  explicit String(long value, unsigned char base = 10);
+  explicit String(unsigned long value, unsigned char base = 10);
+  explicit String(long long value, unsigned char base = 10);
+  explicit String(unsigned long long value, unsigned char base = 10);
+  explicit String(float value, unsigned int decimalPlaces = 2);
+  explicit String(double value, unsigned int decimalPlaces = 2);
+  ~String();
+
+  String& operator=(const String& rhs);
+  String& operator=(String&& rval) noexcept;
+  String& operator=(const char* cstr);
+
+  bool reserve(unsigned int size);
+  unsigned int length() const { return _len; }
+  bool isEmpty() const { return _len == 0; }
+  const char* c_str() const { return _buffer ? _buffer : ""; }
+  char* begin() { return _buffer; }
+  char* end() { return _buffer ? _buffer + _len : nullptr; }
+  const char* begin() const { return c_str(); }
+  const char* end() const { return c_str() + _len; }
+
+  bool concat(const String& str);
+  bool concat(const char* cstr);
+  bool concat(const char* cstr, unsigned int length);
+  bool concat(char c);
+  bool concat(unsigned char num);
+  bool concat(int num);
+  bool concat(unsigned int num);
+  bool concat(long num);
+  bool concat(unsigned long num);
+  bool concat(long long num);
+  bool concat(unsigned long long num);
+  bool concat(float num);
+  bool concat(double num);
+
+  template <typename T> String& operator+=(const T& rhs) { concat(rhs); return *this; }
+  String& operator+=(const char* cstr) { concat(cstr); return *this; }
+
+  int compareTo(const String& s) const;
+  bool equals(const String& s) const;
+  bool equals(const char* cstr) const;
+  bool equalsIgnoreCase(const String& s) const;
+  bool operator==(const String& rhs) const { return equals(rhs); }
+  bool operator==(const char* cstr) const { return equals(cstr); }
+  bool operator!=(const String& rhs) const { return !equals(rhs); }
+  bool operator!=(const char* cstr) const { return !equals(cstr); }
+  bool operator<(const String& rhs) const { return compareTo(rhs) < 0; }
+  bool operator>(const String& rhs) const { return compareTo(rhs) > 0; }
+  bool startsWith(const String& prefix) const;
+  bool startsWith(const String& prefix, unsigned int offset) const;
+  bool endsWith(const String& suffix) const;
+
+  char charAt(unsigned int index) const;
+  void setCharAt(unsigned int index, char c);
+  char operator[](unsigned int index) const;
+  char& operator[](unsigned int index);
+  void getBytes(unsigned char* buf, unsigned int bufsize, unsigned int index = 0) const;
+  void toCharArray(char* buf, unsigned int bufsize, unsigned int index = 0) const {
+    getBytes(reinterpret_cast<unsigned char*>(buf), bufsize, index);
+  }
+
+  int indexOf(char ch, unsigned int fromIndex = 0) const;
+  int indexOf(const String& str, unsigned int fromIndex = 0) const;
+  int lastIndexOf(char ch) const;
+  int lastIndexOf(const String& str) const;
+  String substring(unsigned int beginIndex) const { return substring(beginIndex, _len); }
+  String substring(unsigned int beginIndex, unsigned int endIndex) const;
+
+  void replace(char find, char replace);
+  void replace(const String& find, const String& replace);
+  void remove(unsigned int index);
+  void remove(unsigned int index, unsigned int count);
+  void toLowerCase();
+  void toUpperCase();
+  void trim();
+
+  long toInt() const;
+  float toFloat() const;
+  double toDouble() const;
+
+private:
+  static const unsigned int SSO_SIZE = 12;  // matches the 32-bit ESP32 core
+  char _sso[SSO_SIZE];
+  char* _buffer;
+  unsigned int _capacity;
+  unsigned int _len;
+
+  void init();
+  void invalidate();
+  bool isSSO() const { return _buffer == _sso; }
+  void releaseBuffer();
+  bool changeBuffer(unsigned int maxStrLen);
+  String& copy(const char* cstr, unsigned int length);
+  void move(String& rhs);
+};
+
+String operator+(const String& lhs, const String& rhs);
+String operator+(const String& lhs, const char* rhs);
+String operator+(const char* lhs, const String& rhs);
+String operator+(const String& lhs, char rhs);
+String operator+(const String& lhs, int rhs);
+String operator+(const String& lhs, unsigned int rhs);
+String operator+(const String& lhs, long rhs);
+String operator+(const String& lhs, unsigned long rhs);
+String operator+(const String& lhs, long long rhs);
+String operator+(const String& lhs, unsigned long long rhs);
+String operator+(const String& lhs, float rhs);
+String operator+(const String& lhs, double rhs);
+inline bool operator==(const char* lhs, const String& rhs) { return rhs.equals(lhs); }
+inline bool operator!=(const char* lhs, const String& rhs) { return !rhs.equals(lhs); }
+
+#endif // NATIVE_SIM_WSTRING_H
@@ -0,0 +1,666 @@
+#include "WiFi.h"
+#include "NativeSim.h"
+#include "esp_wifi.h"
+#include <algorithm>
+#include <mutex>
+#include <vector>
+
+WiFiClass WiFi;
+
+namespace {
+
+struct EventHandler {
+  wifi_event_id_t id;
+  WiFiEventFuncCb cb;
+  arduino_event_id_t filter;
+};
+
+struct Radio {
+  std::recursive_mutex mutex;
+  std::vector<NativeSim::AccessPoint> aps;
+  NativeSim::RadioTiming timing;
+
+  wifi_mode_t mode = WIFI_OFF;
+  wl_status_t status = WL_IDLE_STATUS;
+  String staSsid;
+  String staPass;
+  bool autoReconnect = true;
+  String hostname = "esp32-native";
+  uint32_t attempt = 0;           // bumps on every begin()/disconnect() to drop stale timers
+  int connected = -1;             // index into aps
+  bool useStaticIp = false;
+  IPAddress staticIp, staticGateway, staticSubnet, staticDns1, staticDns2;
+  IPAddress ip, gateway, subnet, dns1, dns2;
+
+  bool scanRunning = false;
+  bool scanHasResults = false;
+  std::vector<NativeSim::AccessPoint> scanResults;
+
+  bool apActive = false;
+  String apSsid;
+  IPAddress apIp{192, 168, 4, 1};
+  IPAddress apGateway{192, 168, 4, 1};
+  IPAddress apSubnet{255, 255, 255, 0};
+  uint8_t apStations = 0;
+
+  std::vector<EventHandler> handlers;
+  wifi_event_id_t nextHandlerId = 1;
+};
+
+Radio& radio() {
+  static Radio* r = new Radio();
+  return *r;
+}
+
+void emit(arduino_event_id_t event, const arduino_event_info_t& info) {
+  std::vector<EventHandler> handlers;
+  {
+    std::lock_guard<std::recursive_mutex> lock(radio().mutex);
+    handlers = radio().handlers;
+  }
+  for (auto& h : handlers) {
+    if (h.filter == ARDUINO_EVENT_MAX || h.filter == event) h.cb(event, info);
+  }
+}
+
+void emit(arduino_event_id_t event) {
+  arduino_event_info_t info;
+  memset(&info, 0, sizeof(info));
+  emit(event, info);
+}
+
+uint32_t scanDurationMs() {
+  const NativeSim::RadioTiming& t = radio().timing;
+  return static_cast<uint32_t>(t.channels) * t.channelDwellMs;
+}
+
+void fillSsid(uint8_t* dst, uint8_t& len, const String& ssid) {
+  len = static_cast<uint8_t>(ssid.length() > 32 ? 32 : ssid.length());
+  memcpy(dst, ssid.c_str(), len);
+  dst[len] = 0;
+}
+
+void failAttempt(uint32_t attempt, wl_status_t result, uint8_t reason) {
+  Radio& r = radio();
+  arduino_event_info_t info;
+  memset(&info, 0, sizeof(info));
+  {
+    std::lock_guard<std::recursive_mutex> lock(r.mutex);
+    if (attempt != r.attempt) return;
+    r.status = result;
+    r.connected = -1;
+    fillSsid(info.wifi_sta_disconnected.ssid, info.wifi_sta_disconnected.ssid_len, r.staSsid);
+    info.wifi_sta_disconnected.reason = reason;
+  }
+  emit(ARDUINO_EVENT_WIFI_STA_DISCONNECTED, info);
+}
+
+void completeDhcp(uint32_t attempt) {
+  Radio& r = radio();
+  arduino_event_info_t info;
+  memset(&info, 0, sizeof(info));
+  {
+    std::lock_guard<std::recursive_mutex> lock(r.mutex);
+    if (attempt != r.attempt || r.connected < 0) return;
+    r.ip = IPAddress(192, 168, 1, static_cast<uint8_t>(100 + r.connected));
+    r.gateway = IPAddress(192, 168, 1, 1);
+    r.subnet = IPAddress(255, 255, 255, 0);
+    r.dns1 = IPAddress(192, 168, 1, 1);
+    r.dns2 = IPAddress(0, 0, 0, 0);
+    r.status = WL_CONNECTED;
+    info.got_ip.ip_info.ip.addr = r.ip;
+    info.got_ip.ip_info.netmask.addr = r.subnet;
+    info.got_ip.ip_info.gw.addr = r.gateway;
+  }
+  emit(ARDUINO_EVENT_WIFI_STA_GOT_IP, info);
+}
+
+void completeAssociation(uint32_t attempt, int apIndex) {
+  Radio& r = radio();
+  arduino_event_info_t info;
+  memset(&info, 0, sizeof(info));
+  bool staticIp;
+  uint32_t dhcpMs;
+  {
+    std::lock_guard<std::recursive_mutex> lock(r.mutex);
+    if (attempt != r.attempt) return;
+    const NativeSim::AccessPoint& ap = r.aps[apIndex];
+    r.connected = apIndex;
+    fillSsid(info.wifi_sta_connected.ssid, info.wifi_sta_connected.ssid_len, ap.ssid);
+    memcpy(info.wifi_sta_connected.bssid, ap.bssid, 6);
+    info.wifi_sta_connected.channel = static_cast<uint8_t>(ap.channel);
+    info.wifi_sta_connected.authmode = ap.auth;
+    staticIp = r.useStaticIp;
+    dhcpMs = r.timing.dhcpMs;
+    if (staticIp) {
+      r.ip = r.staticIp;
+      r.gateway = r.staticGateway;
+      r.subnet = r.staticSubnet;
+      r.dns1 = r.staticDns1;
+      r.dns2 = r.staticDns2;
+      r.status = WL_CONNECTED;
+    }
+  }
+  emit(ARDUINO_EVENT_WIFI_STA_CONNECTED, info);
+  if (!staticIp) {
+    NativeSim::schedule(dhcpMs, [attempt] { completeDhcp(attempt); });
+    return;
+  }
+  // esp-netif reports GOT_IP for a static address as well, right after association.
+  arduino_event_info_t ipInfo;
+  memset(&ipInfo, 0, sizeof(ipInfo));
+  {
+    std::lock_guard<std::recursive_mutex> lock(r.mutex);
+    if (attempt != r.attempt) return;
+    ipInfo.got_ip.ip_info.ip.addr = r.ip;
+    ipInfo.got_ip.ip_info.netmask.addr = r.subnet;
+    ipInfo.got_ip.ip_info.gw.addr = r.gateway;
+  }
+  emit(ARDUINO_EVENT_WIFI_STA_GOT_IP, ipInfo);
+}
+
+// Kicks off an association attempt against the stored station config.
+void startAttempt(int32_t channel, const uint8_t* bssid) {
+  Radio& r = radio();
+  std::lock_guard<std::recursive_mutex> lock(r.mutex);
+  uint32_t attempt = ++r.attempt;
+  r.status = WL_IDLE_STATUS;
+  r.connected = -1;
+  const NativeSim::RadioTiming& t = r.timing;
+
+  // Pick the strongest matching BSS, honouring channel/BSSID pinning.
+  int best = -1;
+  for (size_t i = 0; i < r.aps.size(); i++) {
+    const NativeSim::AccessPoint& ap = r.aps[i];
+    if (ap.ssid != r.staSsid) continue;
+    if (channel > 0 && ap.channel != channel) continue;
+    if (bssid && memcmp(ap.bssid, bssid, 6) != 0) continue;
+    if (best < 0 || ap.rssi > r.aps[best].rssi) best = static_cast<int>(i);
+  }
+
+  // A pinned channel is probed once; otherwise the fast scan walks the band
+  // from channel 1 until the target shows up.
+  uint32_t probeMs;
+  if (channel > 0) probeMs = t.channelDwellMs;
+  else if (best >= 0) probeMs = static_cast<uint32_t>(r.aps[best].channel) * t.channelDwellMs;
+  else probeMs = scanDurationMs();
+
+  if (best < 0) {
+    NativeSim::schedule(probeMs, [attempt] { failAttempt(attempt, WL_NO_SSID_AVAIL, WIFI_REASON_NO_AP_FOUND); });
+    return;
+  }
+  const NativeSim::AccessPoint& ap = r.aps[best];
+  if (ap.password.length() > 0 && ap.password != r.staPass) {
+    NativeSim::schedule(probeMs + t.authFailMs, [attempt] { failAttempt(attempt, WL_CONNECT_FAILED, WIFI_REASON_AUTH_FAIL); });
+    return;
+  }
+  NativeSim::schedule(probeMs + t.associateMs, [attempt, best] { completeAssociation(attempt, best); });
+}
+
+} // namespace
+
+// ----- NativeSim radio controls -----
+namespace NativeSim {
+
+void addAccessPoint(const AccessPoint& ap) {
+  std::lock_guard<std::recursive_mutex> lock(radio().mutex);
+  radio().aps.push_back(ap);
+}
+
+void addAccessPoint(const char* ssid, const char* password, int32_t channel, int32_t rssi) {
+  AccessPoint ap;
+  ap.ssid = ssid;
+  ap.password = password ? password : "";
+  uint32_t n;
+  {
+    std::lock_guard<std::recursive_mutex> lock(radio().mutex);
+    n = static_cast<uint32_t>(radio().aps.size()) + 1;
+  }
+  const uint8_t bssid[6] = {0x02, 0x00, 0x5e, static_cast<uint8_t>(n >> 16), static_cast<uint8_t>(n >> 8), static_cast<uint8_t>(n)};
+  memcpy(ap.bssid, bssid, 6);
+  ap.channel = channel;
+  ap.rssi = rssi;
+  ap.auth = ap.password.length() ? WIFI_AUTH_WPA2_PSK : WIFI_AUTH_OPEN;
+  addAccessPoint(ap);
+}
+
+bool setAccessPointRssi(const char* ssid, int32_t rssi) {
+  std::lock_guard<std::recursive_mutex> lock(radio().mutex);
+  bool found = false;
+  for (auto& ap : radio().aps) {
+    if (ap.ssid == ssid) {
+      ap.rssi = rssi;
+      found = true;
+    }
+  }
+  return found;
+}
+
+void clearAccessPoints() {
+  std::lock_guard<std::recursive_mutex> lock(radio().mutex);
+  Radio& r = radio();
+  r.aps.clear();
+  r.scanResults.clear();
+  r.scanHasResults = false;
+  r.connected = -1;
+  r.attempt++;
+  if (r.status == WL_CONNECTED) r.status = WL_CONNECTION_LOST;
+}
+
+void setRadioTiming(const RadioTiming& timing) {
+  std::lock_guard<std::recursive_mutex> lock(radio().mutex);
+  radio().timing = timing;
+}
+
+RadioTiming radioTiming() {
+  std::lock_guard<std::recursive_mutex> lock(radio().mutex);
+  return radio().timing;
+}
+
+void setStoredCredentials(const char* ssid, const char* password) {
+  std::lock_guard<std::recursive_mutex> lock(radio().mutex);
+  radio().staSsid = ssid ? ssid : "";
+  radio().staPass = password ? password : "";
+}
+
+void setSoftAPStations(uint8_t count) {
+  std::lock_guard<std::recursive_mutex> lock(radio().mutex);
+  radio().apStations = count;
+}
+
+} // namespace NativeSim
+
+// ----- Mode -----
+bool WiFiClass::mode(wifi_mode_t m) {
+  wifi_mode_t previous;
+  {
+    std::lock_guard<std::recursive_mutex> lock(radio().mutex);
+    previous = radio().mode;
+    radio().mode = m;
+    if (!(m & WIFI_STA)) {
+      radio().attempt++;
+      radio().connected = -1;
+      radio().status = WL_IDLE_STATUS;
+    } else if (!(previous & WIFI_STA)) {
+      radio().status = WL_DISCONNECTED;
+    }
+    if (!(m & WIFI_AP)) radio().apActive = false;
+  }
+  if ((m & WIFI_STA) && !(previous & WIFI_STA)) emit(ARDUINO_EVENT_WIFI_STA_START);
+  if (!(m & WIFI_STA) && (previous & WIFI_STA)) emit(ARDUINO_EVENT_WIFI_STA_STOP);
+  return true;
+}
+
+wifi_mode_t WiFiClass::getMode() {
+  std::lock_guard<std::recursive_mutex> lock(radio().mutex);
+  return radio().mode;
+}
+
+bool WiFiClass::enableSTA(bool enable) {
+  wifi_mode_t m = getMode();
+  return mode(static_cast<wifi_mode_t>(enable ? (m | WIFI_STA) : (m & ~WIFI_STA)));
+}
+
+bool WiFiClass::enableAP(bool enable) {
+  wifi_mode_t m = getMode();
+  return mode(static_cast<wifi_mode_t>(enable ? (m | WIFI_AP) : (m & ~WIFI_AP)));
+}
+
+// ----- Station -----
+wl_status_t WiFiClass::begin(const char* ssid, const char* passphrase, int32_t channel, const uint8_t* bssid, bool connect) {
+  if (!ssid || !*ssid || strlen(ssid) > 32) return WL_CONNECT_FAILED;
+  if (passphrase && strlen(passphrase) > 64) return WL_CONNECT_FAILED;
+  enableSTA(true);
+  {
+    std::lock_guard<std::recursive_mutex> lock(radio().mutex);
+    radio().staSsid = ssid;
+    radio().staPass = passphrase ? passphrase : "";
+  }
+  if (connect) startAttempt(channel, bssid);
+  return status();
+}
+
+wl_status_t WiFiClass::begin() {
+  enableSTA(true);
+  {
+    std::lock_guard<std::recursive_mutex> lock(radio().mutex);
+    if (radio().staSsid.length() == 0) return WL_CONNECT_FAILED;
+  }
+  startAttempt(0, nullptr);
+  return status();
+}
+
+// Clearing the static address on a live link starts the DHCP client, which
+// keeps the address in use until its answer arrives (a renewal).
+bool WiFiClass::config(IPAddress local_ip, IPAddress gateway, IPAddress subnet, IPAddress dns1, IPAddress dns2) {
+  uint32_t attempt;
+  uint32_t dhcpMs;
+  bool restartDhcp;
+  {
+    std::lock_guard<std::recursive_mutex> lock(radio().mutex);
+    Radio& r = radio();
+    restartDhcp = r.useStaticIp && static_cast<uint32_t>(local_ip) == 0 && r.connected >= 0;
+    r.useStaticIp = static_cast<uint32_t>(local_ip) != 0;
+    r.staticIp = local_ip;
+    r.staticGateway = gateway;
+    r.staticSubnet = subnet;
+    r.staticDns1 = dns1;
+    r.staticDns2 = dns2;
+    attempt = r.attempt;
+    dhcpMs = r.timing.dhcpMs;
+  }
+  if (restartDhcp) NativeSim::schedule(dhcpMs, [attempt] { completeDhcp(attempt); });
+  return true;
+}
+
+bool WiFiClass::reconnect() {
+  {
+    std::lock_guard<std::recursive_mutex> lock(radio().mutex);
+    if (!(radio().mode & WIFI_STA) || radio().staSsid.length() == 0) return false;
+  }
+  startAttempt(0, nullptr);
+  return true;
+}
+
+bool WiFiClass::disconnect(bool wifioff, bool eraseap) {
+  bool wasConnected;
+  arduino_event_info_t info;
+  memset(&info, 0, sizeof(info));
+  {
+    std::lock_guard<std::recursive_mutex> lock(radio().mutex);
+    Radio& r = radio();
+    wasConnected = r.connected >= 0;
+    fillSsid(info.wifi_sta_disconnected.ssid, info.wifi_sta_disconnected.ssid_len, r.staSsid);
+    info.wifi_sta_disconnected.reason = WIFI_REASON_ASSOC_LEAVE;
+    r.attempt++;
+    r.connected = -1;
+    r.status = WL_DISCONNECTED;
+    r.ip = r.gateway = r.subnet = r.dns1 = r.dns2 = IPAddress();
+    if (eraseap) {
+      r.staSsid = "";
+      r.staPass = "";
+    }
+  }
+  if (wasConnected) emit(ARDUINO_EVENT_WIFI_STA_DISCONNECTED, info);
+  if (wifioff) enableSTA(false);
+  return true;
+}
+
+bool WiFiClass::isConnected() { return status() == WL_CONNECTED; }
+
+bool WiFiClass::setAutoReconnect(bool autoReconnect) {
+  std::lock_guard<std::recursive_mutex> lock(radio().mutex);
+  radio().autoReconnect = autoReconnect;
+  return true;
+}
+
+bool WiFiClass::getAutoReconnect() {
+  std::lock_guard<std::recursive_mutex> lock(radio().mutex);
+  return radio().autoReconnect;
+}
+
+bool WiFiClass::setHostname(const char* hostname) {
+  std::lock_guard<std::recursive_mutex> lock(radio().mutex);
+  radio().hostname = hostname;
+  return true;
+}
+
+const char* WiFiClass::getHostname() {
+  std::lock_guard<std::recursive_mutex> lock(radio().mutex);
+  return radio().hostname.c_str();
+}
+
+wl_status_t WiFiClass::status() {
+  std::lock_guard<std::recursive_mutex> lock(radio().mutex);
+  return radio().status;
+}
+
+// Like the core, the SSID of the current association ("" until associated);
+// psk() reads the saved configuration.
+String WiFiClass::SSID() const {
+  std::lock_guard<std::recursive_mutex> lock(radio().mutex);
+  return radio().connected >= 0 ? radio().staSsid : String();
+}
+
+String WiFiClass::psk() const {
+  std::lock_guard<std::recursive_mutex> lock(radio().mutex);
+  return radio().staPass;
+}
+
+uint8_t* WiFiClass::BSSID(uint8_t* bssid) {
+  static uint8_t current[6];
+  std::lock_guard<std::recursive_mutex> lock(radio().mutex);
+  if (radio().connected < 0) return nullptr;
+  uint8_t* out = bssid ? bssid : current;
+  memcpy(out, radio().aps[radio().connected].bssid, 6);
+  return out;
+}
+
+static String formatBssid(const uint8_t* b) {
+  char buf[18];
+  snprintf(buf, sizeof(buf), "%02X:%02X:%02X:%02X:%02X:%02X", b[0], b[1], b[2], b[3], b[4], b[5]);
+  return String(buf);
+}
+
+String WiFiClass::BSSIDstr() {
+  uint8_t b[6];
+  return BSSID(b) ? formatBssid(b) : String();
+}
+
+int8_t WiFiClass::RSSI() {
+  std::lock_guard<std::recursive_mutex> lock(radio().mutex);
+  if (radio().connected < 0) return 0;
+  return static_cast<int8_t>(radio().aps[radio().connected].rssi);
+}
+
+int32_t WiFiClass::channel() {
+  std::lock_guard<std::recursive_mutex> lock(radio().mutex);
+  if (radio().connected < 0) return 0;
+  return radio().aps[radio().connected].channel;
+}
+
+IPAddress WiFiClass::localIP() {
+  std::lock_guard<std::recursive_mutex> lock(radio().mutex);
+  return radio().status == WL_CONNECTED ? radio().ip : IPAddress();
+}
+
+IPAddress WiFiClass::subnetMask() {
+  std::lock_guard<std::recursive_mutex> lock(radio().mutex);
+  return radio().subnet;
+}
+
+IPAddress WiFiClass::gatewayIP() {
+  std::lock_guard<std::recursive_mutex> lock(radio().mutex);
+  return radio().gateway;
+}
+
+IPAddress WiFiClass::dnsIP(uint8_t dns_no) {
+  std::lock_guard<std::recursive_mutex> lock(radio().mutex);
+  return dns_no == 0 ? radio().dns1 : radio().dns2;
+}
+
+uint8_t* WiFiClass::macAddress(uint8_t* mac) {
+  const uint8_t fixed[6] = {0x24, 0x0A, 0xC4, 0x12, 0x34, 0x56};
+  memcpy(mac, fixed, 6);
+  return mac;
+}
+
+String WiFiClass::macAddress() {
+  uint8_t mac[6];
+  return formatBssid(macAddress(mac));
+}
+
+// ----- Scanning -----
+int16_t WiFiClass::scanNetworks(bool async, bool show_hidden, bool passive, uint32_t max_ms_per_chan,
+                                uint8_t channel, const char* ssid, const uint8_t* bssid) {
+  (void)passive;
+  (void)max_ms_per_chan;
+  (void)bssid;
+  Radio& r = radio();
+  uint32_t durationMs;
+  {
+    std::lock_guard<std::recursive_mutex> lock(r.mutex);
+    if (r.scanRunning) return WIFI_SCAN_RUNNING;
+    r.scanRunning = true;
+    r.scanHasResults = false;
+    r.scanResults.clear();
+    durationMs = channel ? r.timing.channelDwellMs : scanDurationMs();
+  }
+  auto finish = [show_hidden, channel, ssid = String(ssid ? ssid : "")]() -> int16_t {
+    Radio& r = radio();
+    std::lock_guard<std::recursive_mutex> lock(r.mutex);
+    r.scanResults.clear();
+    // Results come back in channel order, as the driver reports them.
+    for (int32_t ch = 1; ch <= 14; ch++) {
+      for (auto& ap : r.aps) {
+        if (ap.channel != ch) continue;
+        if (channel && ap.channel != channel) continue;
+        if (!show_hidden && ap.ssid.length() == 0) continue;
+        if (ssid.length() && ap.ssid != ssid) continue;
+        r.scanResults.push_back(ap);
+      }
+    }
+    r.scanRunning = false;
+    r.scanHasResults = true;
+    return static_cast<int16_t>(r.scanResults.size());
+  };
+  if (async) {
+    NativeSim::schedule(durationMs, [finish] {
+      arduino_event_info_t info;
+      memset(&info, 0, sizeof(info));
+      info.wifi_scan_done.number = static_cast<uint8_t>(finish());
+      emit(ARDUINO_EVENT_WIFI_SCAN_DONE, info);
+    });
+    return WIFI_SCAN_RUNNING;
+  }
+  delay(durationMs);
+  return finish();
+}
+
+int16_t WiFiClass::scanComplete() {
+  std::lock_guard<std::recursive_mutex> lock(radio().mutex);
+  if (radio().scanRunning) return WIFI_SCAN_RUNNING;
+  if (radio().scanHasResults) return static_cast<int16_t>(radio().scanResults.size());
+  return WIFI_SCAN_FAILED;
+}
+
+void WiFiClass::scanDelete() {
+  std::lock_guard<std::recursive_mutex> lock(radio().mutex);
+  radio().scanResults.clear();
+  radio().scanResults.shrink_to_fit();
+  radio().scanHasResults = false;
+}
+
+String WiFiClass::SSID(uint8_t i) {
+  std::lock_guard<std::recursive_mutex> lock(radio().mutex);
+  return i < radio().scanResults.size() ? radio().scanResults[i].ssid : String();
+}
+
+wifi_auth_mode_t WiFiClass::encryptionType(uint8_t i) {
+  std::lock_guard<std::recursive_mutex> lock(radio().mutex);
+  return i < radio().scanResults.size() ? radio().scanResults[i].auth : WIFI_AUTH_OPEN;
+}
+
+int32_t WiFiClass::RSSI(uint8_t i) {
+  std::lock_guard<std::recursive_mutex> lock(radio().mutex);
+  return i < radio().scanResults.size() ? radio().scanResults[i].rssi : 0;
+}
+
+uint8_t* WiFiClass::BSSID(uint8_t i) {
+  std::lock_guard<std::recursive_mutex> lock(radio().mutex);
+  return i < radio().scanResults.size() ? radio().scanResults[i].bssid : nullptr;
+}
+
+String WiFiClass::BSSIDstr(uint8_t i) {
+  uint8_t* b = BSSID(i);
+  return b ? formatBssid(b) : String();
+}
+
+int32_t WiFiClass::channel(uint8_t i) {
+  std::lock_guard<std::recursive_mutex> lock(radio().mutex);
+  return i < radio().scanResults.size() ? radio().scanResults[i].channel : 0;
+}
+
+// ----- SoftAP -----
+bool WiFiClass::softAP(const char* ssid, const char* passphrase, int channel, int ssid_hidden, int max_connection) {
+  (void)channel;
+  (void)ssid_hidden;
+  (void)max_connection;
+  if (!ssid || !*ssid) return false;
+  if (passphrase && *passphrase && strlen(passphrase) < 8) return false;
+  enableAP(true);
+  {
+    std::lock_guard<std::recursive_mutex> lock(radio().mutex);
+    radio().apActive = true;
+    radio().apSsid = ssid;
+  }
+  emit(ARDUINO_EVENT_WIFI_AP_START);
+  return true;
+}
+
+bool WiFiClass::softAPConfig(IPAddress local_ip, IPAddress gateway, IPAddress subnet) {
+  std::lock_guard<std::recursive_mutex> lock(radio().mutex);
+  radio().apIp = local_ip;
+  radio().apGateway = gateway;
+  radio().apSubnet = subnet;
+  return true;
+}
+
+bool WiFiClass::softAPdisconnect(bool wifioff) {
+  {
+    std::lock_guard<std::recursive_mutex> lock(radio().mutex);
+    radio().apActive = false;
+    radio().apStations = 0;
+  }
+  emit(ARDUINO_EVENT_WIFI_AP_STOP);
+  if (wifioff) enableAP(false);
+  return true;
+}
+
+uint8_t WiFiClass::softAPgetStationNum() {
+  std::lock_guard<std::recursive_mutex> lock(radio().mutex);
+  return radio().apActive ? radio().apStations : 0;
+}
+
+IPAddress WiFiClass::softAPIP() {
+  std::lock_guard<std::recursive_mutex> lock(radio().mutex);
+  return radio().apActive ? radio().apIp : IPAddress();
+}
+
+String WiFiClass::softAPSSID() const {
+  std::lock_guard<std::recursive_mutex> lock(radio().mutex);
+  return radio().apSsid;
+}
+
+// ----- Events -----
+wifi_event_id_t WiFiClass::onEvent(WiFiEventFuncCb cbEvent, arduino_event_id_t event) {
+  std::lock_guard<std::recursive_mutex> lock(radio().mutex);
+  EventHandler h;
+  h.id = radio().nextHandlerId++;
+  h.cb = cbEvent;
+  h.filter = event;
+  radio().handlers.push_back(h);
+  return h.id;
+}
+
+void WiFiClass::removeEvent(wifi_event_id_t id) {
+  std::lock_guard<std::recursive_mutex> lock(radio().mutex);
+  auto& hs = radio().handlers;
+  for (auto it = hs.begin(); it != hs.end(); ++it) {
+    if (it->id == id) {
+      hs.erase(it);
+      return;
+    }
+  }
+}
+
+// ----- ESP-IDF -----
+esp_err_t esp_wifi_get_config(wifi_interface_t interface, wifi_config_t* conf) {
+  if (interface != WIFI_IF_STA || !conf) return ESP_FAIL;
+  std::lock_guard<std::recursive_mutex> lock(radio().mutex);
+  memset(conf, 0, sizeof(*conf));
+  memcpy(conf->sta.ssid, radio().staSsid.c_str(), std::min<size_t>(radio().staSsid.length(), sizeof(conf->sta.ssid)));
+  memcpy(conf->sta.password, radio().staPass.c_str(),
+         std::min<size_t>(radio().staPass.length(), sizeof(conf->sta.password)));
+  return ESP_OK;
+}
@@ -0,0 +1,80 @@
+#ifndef NATIVE_SIM_WIFI_H
+#define NATIVE_SIM_WIFI_H
+
+#include <functional>
+#include "Arduino.h"
+#include "IPAddress.h"
+#include "WiFiType.h"
+
+typedef std::function<void(arduino_event_id_t event, arduino_event_info_t info)> WiFiEventFuncCb;
+typedef size_t wifi_event_id_t;
+
+// Simulated radio with the same surface as the Arduino-ESP32 WiFiClass.
+// Access points, timings and stored credentials are configured through
+// NativeSim.h; all state transitions are driven by the simulated clock.
+class WiFiClass {
+public:
+  // Mode.
+  bool mode(wifi_mode_t m);
+  wifi_mode_t getMode();
+  bool enableSTA(bool enable);
+  bool enableAP(bool enable);
+
+  // Station.
+  wl_status_t begin(const char* ssid, const char* passphrase = nullptr, int32_t channel = 0,
+                    const uint8_t* bssid = nullptr, bool connect = true);
+  wl_status_t begin();
+  bool config(IPAddress local_ip, IPAddress gateway, IPAddress subnet,
+              IPAddress dns1 = (uint32_t)0x00000000, IPAddress dns2 = (uint32_t)0x00000000);
+  bool reconnect();
+  bool disconnect(bool wifioff = false, bool eraseap = false);
+  bool isConnected();
+  bool setAutoReconnect(bool autoReconnect);
+  bool getAutoReconnect();
+  bool setHostname(const char* hostname);
+  const char* getHostname();
+  wl_status_t status();
+
+  String SSID() const;
+  String psk() const;
+  uint8_t* BSSID(uint8_t* bssid = nullptr);
+  String BSSIDstr();
+  int8_t RSSI();
+  int32_t channel();
+  IPAddress localIP();
+  IPAddress subnetMask();
+  IPAddress gatewayIP();
+  IPAddress dnsIP(uint8_t dns_no = 0);
+  uint8_t* macAddress(uint8_t* mac);
+  String macAddress();
+
+  // Scanning.
+  int16_t scanNetworks(bool async = false, bool show_hidden = false, bool passive = false,
+                       uint32_t max_ms_per_chan = 300, uint8_t channel = 0,
+                       const char* ssid = nullptr, const uint8_t* bssid = nullptr);
+  int16_t scanComplete();
+  void scanDelete();
+  String SSID(uint8_t networkItem);
+  wifi_auth_mode_t encryptionType(uint8_t networkItem);
+  int32_t RSSI(uint8_t networkItem);
+  uint8_t* BSSID(uint8_t networkItem);
+  String BSSIDstr(uint8_t networkItem);
+  int32_t channel(uint8_t networkItem);
+
+  // SoftAP.
+  bool softAP(const char* ssid, const char* passphrase = nullptr, int channel = 1,
+              int ssid_hidden = 0, int max_connection = 4);
+  bool softAPConfig(IPAddress local_ip, IPAddress gateway, IPAddress subnet);
+  bool softAPdisconnect(bool wifioff = false);
+  uint8_t softAPgetStationNum();
+  IPAddress softAPIP();
+  String softAPSSID() const;
+
+  // Events.
+  wifi_event_id_t onEvent(WiFiEventFuncCb cbEvent, arduino_event_id_t event = ARDUINO_EVENT_MAX);
+  void removeEvent(wifi_event_id_t id);
+};
+
+extern WiFiClass WiFi;
+
+#endif // NATIVE_SIM_WIFI_H
@@ -0,0 +1,96 @@
+#ifndef NATIVE_SIM_WIFI_TYPE_H
+#define NATIVE_SIM_WIFI_TYPE_H
+
+#include <stdint.h>
+
+// Mirrors the enums of the Arduino-ESP32 core / ESP-IDF that sketches use.
+
+typedef enum {
+  WIFI_OFF = 0,
+  WIFI_STA = 1,
+  WIFI_AP = 2,
+  WIFI_AP_STA = 3
+} wifi_mode_t;
+
+typedef enum {
+  WL_NO_SHIELD = 255,
+  WL_IDLE_STATUS = 0,
+  WL_NO_SSID_AVAIL = 1,
+  WL_SCAN_COMPLETED = 2,
+  WL_CONNECTED = 3,
+  WL_CONNECT_FAILED = 4,
+  WL_CONNECTION_LOST = 5,
+  WL_DISCONNECTED = 6
+} wl_status_t;
+
+typedef enum {
+  WIFI_AUTH_OPEN = 0,
+  WIFI_AUTH_WEP,
+  WIFI_AUTH_WPA_PSK,
+  WIFI_AUTH_WPA2_PSK,
+  WIFI_AUTH_WPA_WPA2_PSK,
+  WIFI_AUTH_WPA2_ENTERPRISE,
+  WIFI_AUTH_WPA3_PSK,
+  WIFI_AUTH_WPA2_WPA3_PSK,
+  WIFI_AUTH_MAX
+} wifi_auth_mode_t;
+
+#define WIFI_SCAN_RUNNING (-1)
+#define WIFI_SCAN_FAILED (-2)
+
+typedef enum {
+  ARDUINO_EVENT_WIFI_READY = 0,
+  ARDUINO_EVENT_WIFI_SCAN_DONE,
+  ARDUINO_EVENT_WIFI_STA_START,
+  ARDUINO_EVENT_WIFI_STA_STOP,
+  ARDUINO_EVENT_WIFI_STA_CONNECTED,
+  ARDUINO_EVENT_WIFI_STA_DISCONNECTED,
+  ARDUINO_EVENT_WIFI_STA_AUTHMODE_CHANGE,
+  ARDUINO_EVENT_WIFI_STA_GOT_IP,
+  ARDUINO_EVENT_WIFI_STA_LOST_IP,
+  ARDUINO_EVENT_WIFI_AP_START,
+  ARDUINO_EVENT_WIFI_AP_STOP,
+  ARDUINO_EVENT_WIFI_AP_STACONNECTED,
+  ARDUINO_EVENT_WIFI_AP_STADISCONNECTED,
+  ARDUINO_EVENT_MAX
+} arduino_event_id_t;
+
+typedef arduino_event_id_t WiFiEvent_t;
+
+// Disconnect reasons (subset of wifi_err_reason_t).
+#define WIFI_REASON_AUTH_FAIL 202
+#define WIFI_REASON_NO_AP_FOUND 201
+#define WIFI_REASON_ASSOC_LEAVE 8
+#define WIFI_REASON_4WAY_HANDSHAKE_TIMEOUT 15
+#define WIFI_REASON_HANDSHAKE_TIMEOUT 204
+
+typedef union {
+  struct {
+    uint8_t ssid[33];
+    uint8_t ssid_len;
+    uint8_t bssid[6];
+    uint8_t channel;
+    wifi_auth_mode_t authmode;
+  } wifi_sta_connected;
+  struct {
+    uint8_t ssid[33];
+    uint8_t ssid_len;
+    uint8_t bssid[6];
+    uint8_t reason;
+  } wifi_sta_disconnected;
+  struct {
+    uint32_t status;
+    uint8_t number;
+  } wifi_scan_done;
+  struct {
+    struct {
+      struct { uint32_t addr; } ip;
+      struct { uint32_t addr; } netmask;
+      struct { uint32_t addr; } gw;
+    } ip_info;
+  } got_ip;
+} arduino_event_info_t;
+
+typedef arduino_event_info_t WiFiEventInfo_t;
+
+#endif // NATIVE_SIM_WIFI_TYPE_H
@@ -0,0 +1,39 @@
+#ifndef NATIVE_SIM_ESP_WIFI_H
+#define NATIVE_SIM_ESP_WIFI_H
+
+#include <stdint.h>
+
+// The part of ESP-IDF's esp_wifi.h that reads the driver's saved station
+// configuration. Unlike WiFi.SSID(), it does not need an association.
+
+typedef int esp_err_t;
+#ifndef ESP_OK
+#define ESP_OK 0
+#define ESP_FAIL -1
+#endif
+
+typedef enum { WIFI_IF_STA = 0, WIFI_IF_AP = 1 } wifi_interface_t;
+
+typedef struct {
+  uint8_t ssid[32];      // not terminated when all 32 bytes are used
+  uint8_t password[64];
+  uint8_t bssid_set;
+  uint8_t bssid[6];
+  uint8_t channel;
+} wifi_sta_config_t;
+
+typedef struct {
+  uint8_t ssid[32];
+  uint8_t password[64];
+  uint8_t ssid_len;
+  uint8_t channel;
+} wifi_ap_config_t;
+
+typedef union {
+  wifi_ap_config_t ap;
+  wifi_sta_config_t sta;
+} wifi_config_t;
+
+esp_err_t esp_wifi_get_config(wifi_interface_t interface, wifi_config_t* conf);
+
+#endif // NATIVE_SIM_ESP_WIFI_H
@@ -1,7 +1,11 @@
 #include "WiFiManager.h"
 #include "WiFiManagerParameter.h"
+#include "WiFiManagerJson.h"
+#include "WiFiManagerAssets.h"
 #include <Arduino.h>
+#include <esp_wifi.h>
 #include <cstring>
+#include <algorithm>
 
 #ifdef ENABLE_HTTPS
   #include <AsyncWebServerSecure.h>
@@ -13,9 +17,9 @@
 
 // ----- Constructor & Destructor -----
 WiFiManager::WiFiManager(const WiFiManagerConfig& config)
-  : _config(config), _server(nullptr), _debug(true), _debugPort(&Serial),
+  : _config(config), _server(nullptr), _portalUrl{"/"}, _debug(true), _debugPort(&Serial),
 #ifdef ENABLE_HTML_INTERFACE
-    _customHeadElement(""), _customBodyFooter(""),
+    _customHeadElement(""), _customBodyFooter(""), _rootPageVersion(0),
 #endif
 #ifdef ENABLE_MDNS
     _useMDNS(false), _mdnsHostname("esp32"),
@@ -28,31 +32,67 @@ WiFiManager::WiFiManager(const WiFiManagerConfig& config)
     , _useAuth(config.useAuth), _portalUsername(config.portalUsername), _portalPassword(config.portalPassword)
 #endif
 #ifdef ENABLE_SERIAL_MONITOR
-    , _enableSerialMonitor(config.enableSerialMonitor), _serialMonitorBuffer(""),
-      _serialMonitorBufferSize(config.serialMonitorBufferSize), _lastSerialUpdate(0)
+    , _enableSerialMonitor(config.enableSerialMonitor),
+      _serialMonitorBufferSize(config.serialMonitorBufferSize), _lastSerialUpdate(0), _serialRoutesAdded(false)
+#ifdef ENABLE_WEBSOCKETS
+    , _serialWs(nullptr)
+#endif
 #endif
 #ifdef ENABLE_LOCALIZATION
     , _language("en")
 #endif
 #ifdef ENABLE_WEBSOCKETS
-    , _ws(nullptr)
+    , _ws(nullptr), _published{nullptr, 0, 0, "", 0}, _lastStatusSample(0)
+#endif
+    , _wifiEventId(0),
+#ifdef ENABLE_OTA
+      _otaRequest(nullptr), _otaLastProgress(0), _otaRebootAt(0),
 #endif
+#ifdef ENABLE_BACKUP_RESTORE
+      _restoreRequest(nullptr),
+#endif
+#ifdef ENABLE_FS_EXPLORER
+      _fsIndex(SPIFFS),
+#endif
+      _fsMounted(false),
+#ifdef ENABLE_EMBEDDED_ASSETS
+      _embeddedAssets(kPortalAssets), _embeddedAssetCount(kPortalAssetCount),
+#else
+      _embeddedAssets(nullptr), _embeddedAssetCount(0),
+#endif
+      _heapHistory{}, _heapHistoryPos(0), _heapSamples(0), _minLargestBlock(UINT32_MAX), _heapSampledAt(0),
+      _scanInProgress(false), _scanStartedAt(0)
+    , _connectIndex(0), _pendingConnectState(0), _connectState(ConnectState::IDLE), _connectGotIP(false),
+      _connectFailReason(0), _connectStartedAt(0), _attemptStartedAt(0), _connectDuration(0),
+      _staStaticIP(false), _leaseApplied(false), _leaseRenewing(false), _connectPath(ConnectPath::NONE), _timeToConnected{0, 0, 0}
 {}
 
 WiFiManager::~WiFiManager() {
+#if defined(USING_ESP32) || defined(USING_NATIVE_SIM)
+  if (_wifiEventId) WiFi.removeEvent(_wifiEventId);
+#endif
   if (_server) {
     delete _server;
   }
   for (auto p : _params) {
-    delete p;
+    if (!p->isSchemaBacked()) delete p;
   }
 #ifdef ENABLE_WEBSOCKETS
   if (_ws) { delete _ws; }
 #endif
+#if defined(ENABLE_SERIAL_MONITOR) && defined(ENABLE_WEBSOCKETS)
+  if (_serialWs) { delete _serialWs; }
+#endif
 }
 
 // ----- Debugging -----
 void WiFiManager::debug(String msg) {
+#ifdef ENABLE_SERIAL_MONITOR
+  if (_debug && _enableSerialMonitor && _serialTee) {
+    _serialTee->println("*wm: " + msg);
+    return;
+  }
+#endif
   if (_debug && _debugPort) {
     _debugPort->println("*wm: " + msg);
   }
@@ -60,6 +100,7 @@ void WiFiManager::debug(String msg) {
 
 // ----- Initialization -----
 void WiFiManager::begin() {
+  WM_TRACE_BEGIN(kTraceBeginServer);
 #if defined(ENABLE_HTTPS) && defined(HAS_ASYNC_WEBSERVER_SECURE)
   if (_useHTTPS) {
     _server = new AsyncWebServerSecure(_config.httpPort);
@@ -72,35 +113,55 @@ void WiFiManager::begin() {
 #else
   _server = new AsyncWebServer(_config.httpPort);
 #endif
+  // Before the routes and caches, so the pool sits at the bottom of the heap.
+  _arenas.begin(_config.requestArenas, _config.requestArenaSize);
+  _scheduler.setTotalLimit(_config.maxHeavyRequests);
+  _scheduler.setQueueTimeout(_config.heavyQueueTimeout);
+  WM_TRACE_END(kTraceBeginServer);
 
-  // Filesystem initialization (ESP32 only).
-  bool fsInitialized = SPIFFS.begin(true);
-  if (!fsInitialized) {
-    debug("Error mounting SPIFFS, attempting to format.");
-    if (SPIFFS.format() && SPIFFS.begin(true)) {
-      fsInitialized = true;
-      debug("SPIFFS formatted and mounted successfully");
+  // Filesystem initialization (ESP32 only). A mount scans the whole
+  // partition and a blank one is formatted first, so builds that embed the
+  // portal can leave it out.
+  WM_TRACE_BEGIN(kTraceBeginFilesystem);
+  if (!_config.mountFilesystem) {
+    debug("SPIFFS mount skipped; serving " + String(_embeddedAssetCount) + " embedded assets");
+  } else {
+    _fsMounted = SPIFFS.begin(true);
+    if (!_fsMounted) {
+      debug("Error mounting SPIFFS, attempting to format.");
+      if (SPIFFS.format() && SPIFFS.begin(true)) {
+        _fsMounted = true;
+        debug("SPIFFS formatted and mounted successfully");
+      } else {
+        debug("SPIFFS format failed. Web interface may not work properly.");
+      }
     } else {
-      debug("SPIFFS format failed. Web interface may not work properly.");
+      debug("SPIFFS mounted successfully");
     }
-  } else {
-    debug("SPIFFS mounted successfully");
   }
 
+  WM_TRACE_END(kTraceBeginFilesystem);
+
   // DNS server is started only when AP is started for the portal.
+  WM_TRACE_BEGIN(kTraceBeginRoutes);
 
-#ifdef USING_ESP32
+#if defined(USING_ESP32) || defined(USING_NATIVE_SIM)
   // Attach WiFi event handler to improve stability and state tracking
-  WiFi.onEvent([this](WiFiEvent_t event, WiFiEventInfo_t info){
+  // Event IDs are enumerators, not macros, so they cannot be feature-tested
+  // with #ifdef; arduino-esp32 >= 2.0 names them ARDUINO_EVENT_*.
+  _wifiEventId = WiFi.onEvent([this](WiFiEvent_t event, WiFiEventInfo_t info){
     switch(event){
-      #ifdef SYSTEM_EVENT_STA_CONNECTED
-      case SYSTEM_EVENT_STA_CONNECTED: _lastConxResult = WL_CONNECTED; break;
-      case SYSTEM_EVENT_STA_DISCONNECTED: _lastConxResult = WL_DISCONNECTED; break;
-      #endif
-      #ifdef ARDUINO_EVENT_WIFI_STA_CONNECTED
       case ARDUINO_EVENT_WIFI_STA_CONNECTED: _lastConxResult = WL_CONNECTED; break;
-      case ARDUINO_EVENT_WIFI_STA_DISCONNECTED: _lastConxResult = WL_DISCONNECTED; break;
-      #endif
+      case ARDUINO_EVENT_WIFI_STA_GOT_IP: _connectGotIP = true; break;
+      case ARDUINO_EVENT_WIFI_STA_DISCONNECTED:
+        _lastConxResult = WL_DISCONNECTED;
+        // Our own WiFi.begin()/disconnect() leaves with ASSOC_LEAVE; any other
+        // reason is the driver giving up on the current attempt.
+        if (info.wifi_sta_disconnected.reason != WIFI_REASON_ASSOC_LEAVE) {
+          _connectFailReason = info.wifi_sta_disconnected.reason;
+        }
+        break;
+      case ARDUINO_EVENT_WIFI_SCAN_DONE: onScanDone(); break;
       default: break;
     }
   });
@@ -108,65 +169,128 @@ void WiFiManager::begin() {
 
   // ----- HTTP Endpoints -----
 #ifdef ENABLE_HTML_INTERFACE
-  _server->on("/", HTTP_GET, [this](AsyncWebServerRequest *request) { handleRoot(request); });
+  route("/", HTTP_GET, [this](AsyncWebServerRequest *request) { handleRoot(request); });
 #else
-  _server->on("/", HTTP_GET, [this](AsyncWebServerRequest *request) { handleStatusJSON(request); });
-#endif
-  _server->on("/scan", HTTP_GET, [this](AsyncWebServerRequest *request) { handleScan(request); });
-  _server->on("/connect", HTTP_POST, [this](AsyncWebServerRequest *request) { handleConnect(request); });
-  _server->on("/reset", HTTP_GET, [this](AsyncWebServerRequest *request) { handleReset(request); });
-  _server->on("/status_json", HTTP_GET, [this](AsyncWebServerRequest *request) { handleStatusJSON(request); });
-  _server->on("/params_json", HTTP_GET, [this](AsyncWebServerRequest *request) { handleParamsJSON(request); });
-  _server->on("/update_params", HTTP_POST, [this](AsyncWebServerRequest *request) { handleUpdateParams(request); });
+  route("/", HTTP_GET, [this](AsyncWebServerRequest *request) { handleStatusJSON(request); });
+#endif
+  route("/scan", HTTP_GET, [this](AsyncWebServerRequest *request) { handleScan(request); });
+  route("/connect", HTTP_POST, [this](AsyncWebServerRequest *request) { handleConnect(request); });
+  route("/reset", HTTP_GET, [this](AsyncWebServerRequest *request) { handleReset(request); });
+  route("/status_json", HTTP_GET, [this](AsyncWebServerRequest *request) { handleStatusJSON(request); });
+  route("/params_json", HTTP_GET, [this](AsyncWebServerRequest *request) { handleParamsJSON(request); });
+  route("/update_params", HTTP_POST, [this](AsyncWebServerRequest *request) { handleUpdateParams(request); });
 #ifdef ENABLE_OTA
-  _server->on("/ota", HTTP_POST, [this](AsyncWebServerRequest *request) { handleOTA(request); });
+  route("/ota", HTTP_POST, [this](AsyncWebServerRequest *request) { handleOTA(request); },
+    [this](AsyncWebServerRequest *request, const String& filename, size_t index, uint8_t *data, size_t len, bool final) {
+      handleOTAChunk(request, index, data, len, final, UPDATE_SIZE_UNKNOWN);
+    },
+    [this](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+      handleOTAChunk(request, index, data, len, index + len == total, total);
+    });
 #endif
 #ifdef ENABLE_FS_EXPLORER
-  _server->on("/fs/list", HTTP_GET, [this](AsyncWebServerRequest *request) { handleFSList(request); });
-  _server->on("/fs/delete", HTTP_DELETE, [this](AsyncWebServerRequest *request) { handleFSDelete(request); });
-  _server->on("/fs/upload", HTTP_POST, [](AsyncWebServerRequest *request) {},
+  route("/fs/list", HTTP_GET, [this](AsyncWebServerRequest *request) { handleFSList(request); });
+  route("/fs/delete", HTTP_DELETE, [this](AsyncWebServerRequest *request) { handleFSDelete(request); });
+  route("/fs/download", HTTP_GET, [this](AsyncWebServerRequest *request) { handleFSDownload(request); });
+  route("/fs/upload", HTTP_POST, [this](AsyncWebServerRequest *request) { handleFSUpload(request); },
     [this](AsyncWebServerRequest *request, const String& filename, size_t index, uint8_t *data, size_t len, bool final) {
-      if(!index){
-        debug("Upload Start: " + filename);
-        SPIFFS.remove("/" + filename);
-      }
-      File file = SPIFFS.open("/" + filename, FILE_APPEND);
-      if(file){ file.write(data, len); file.close(); }
-      if(final){ debug("Upload Complete: " + filename); }
-    }
-  );
+      handleFSUploadChunk(request, filename, index, data, len, final);
+    });
 #endif
 #ifdef ENABLE_BACKUP_RESTORE
-  _server->on("/backup", HTTP_GET, [this](AsyncWebServerRequest *request) { handleBackup(request); });
-  _server->on("/restore", HTTP_POST, [this](AsyncWebServerRequest *request) { handleRestore(request); });
+  route("/backup", HTTP_GET, [this](AsyncWebServerRequest *request) { handleBackup(request); });
+  route("/restore", HTTP_POST, [this](AsyncWebServerRequest *request) { handleRestore(request); },
+    [this](AsyncWebServerRequest *request, const String& filename, size_t index, uint8_t *data, size_t len, bool final) {
+      handleRestoreChunk(request, index, data, len);
+    },
+    [this](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+      handleRestoreChunk(request, index, data, len);
+    });
+#endif
+  route("/device_info", HTTP_GET, [this](AsyncWebServerRequest *request) { handleDeviceInfo(request); });
+#ifdef ENABLE_METRICS
+  route("/metrics", HTTP_GET, [this](AsyncWebServerRequest *request) { handleMetrics(request); });
+#endif
+#ifdef ENABLE_TRACE
+  route("/trace", HTTP_GET, [this](AsyncWebServerRequest *request) { handleTrace(request); });
 #endif
-  _server->on("/device_info", HTTP_GET, [this](AsyncWebServerRequest *request) { handleDeviceInfo(request); });
 #ifdef ENABLE_TERMINAL
-  _server->on("/terminal", HTTP_GET, [this](AsyncWebServerRequest *request) { handleTerminal(request); });
+  route("/terminal", HTTP_GET, [this](AsyncWebServerRequest *request) { handleTerminal(request); });
 #endif
 
-  // Serve static files.
-  _server->serveStatic("/", SPIFFS, "/");
-  _server->onNotFound([this](AsyncWebServerRequest *request) { handleNotFound(request); });
+  // OS connectivity probes. Anything but the answer the OS expects opens its
+  // captive-portal sheet, so each gets a redirect to the portal; they are
+  // answered without auth and share one metrics route.
+  static const char* const kCaptiveProbes[] = {
+    "/generate_204", "/gen_204",                          // Android, ChromeOS
+    "/hotspot-detect.html", "/library/test/success.html", // Apple
+    "/connecttest.txt", "/ncsi.txt", "/redirect",         // Windows
+    "/canonical.html", "/success.txt",                    // Firefox
+  };
+  ArRequestHandlerFunction probe = [this](AsyncWebServerRequest *request) { handleCaptiveProbe(request); };
+#ifdef ENABLE_TRACE
+  probe = traced(WmTrace::addTag("probe"), probe);
+#endif
+#ifdef ENABLE_METRICS
+  probe = timed(_metrics.addRoute("probe"), probe);
+#endif
+  for (const char* uri : kCaptiveProbes) _server->on(uri, HTTP_GET | HTTP_HEAD, probe);
+
+  // Static files are served from handleNotFound() so they get gzip, ETag and
+  // cache headers (see WiFiManagerAssets.h).
+  ArRequestHandlerFunction notFound = [this](AsyncWebServerRequest *request) { handleNotFound(request); };
+#ifdef ENABLE_TRACE
+  notFound = traced(WmTrace::addTag("other"), notFound);
+#endif
+#ifdef ENABLE_METRICS
+  notFound = timed(_metrics.addRoute("other"), notFound);
+#endif
+  if (_config.admissionControl) {
+    ArRequestHandlerFunction light = notFound;
+    notFound = [this, light](AsyncWebServerRequest *request) {
+      if (_scheduler.hasQueued()) expireQueued();
+      light(request);
+    };
+  }
+  _server->onNotFound(notFound);
   
 #ifdef ENABLE_WEBSOCKETS
   _ws = new AsyncWebSocket("/ws");
-  _ws->onEvent([](AsyncWebSocket *server, AsyncWebSocketClient *client, AwsEventType type,
+  _ws->onEvent([this](AsyncWebSocket *server, AsyncWebSocketClient *client, AwsEventType type,
                   void *arg, uint8_t *data, size_t len) {
     if(type == WS_EVT_CONNECT){
+#ifdef ENABLE_AUTH
+      // arg is the upgrade request, already answered with 101, so a client
+      // without credentials is dropped rather than challenged. /ws carries the
+      // same data as /status_json.
+      AsyncWebServerRequest* upgrade = static_cast<AsyncWebServerRequest*>(arg);
+      if (_useAuth && !upgrade->authenticate(_portalUsername.c_str(), _portalPassword.c_str())) {
+        client->close();
+        return;
+      }
+#endif
       Serial.println("WebSocket client connected");
+      sendStatusSnapshot(client);
     } else if(type == WS_EVT_DISCONNECT){
       Serial.println("WebSocket client disconnected");
     }
   });
   _server->addHandler(_ws);
 #endif
+#ifdef ENABLE_SERIAL_MONITOR
+  if (_enableSerialMonitor) enableSerialMonitor(true, _serialMonitorBufferSize);
+#endif
 
+  WM_TRACE_END(kTraceBeginRoutes);
+
+  WM_TRACE_BEGIN(kTraceBeginListen);
   _server->begin();
+  WM_TRACE_END(kTraceBeginListen);
   debug("HTTP server started on port " + String(_config.httpPort));
 
 #ifdef ENABLE_MDNS
   if (_useMDNS) {
+    WM_TRACE_SCOPE(kTraceBeginMDNS);
     if (MDNS.begin(_mdnsHostname.c_str())) {
       debug("mDNS responder started as " + _mdnsHostname);
       MDNS.addService("http", "tcp", _config.httpPort);
@@ -176,9 +300,26 @@ void WiFiManager::begin() {
 }
 
 void WiFiManager::loop() {
-  _dnsServer.processNextRequest();
+  processConnect();
+  // A scan that never reports back (radio busy connecting, driver error)
+  // must not block future scans.
+  if (_scanInProgress && millis() - _scanStartedAt > 15000) {
+    debug("Background scan timed out.");
+    _scanInProgress = false;
+  }
 #ifdef ENABLE_WEBSOCKETS
   if(_ws) _ws->cleanupClients();
+  publishStatusDelta();
+#endif
+#ifdef ENABLE_SERIAL_MONITOR
+  flushSerialMonitor();
+#endif
+  sampleHeap();
+#ifdef ENABLE_OTA
+  if (_otaRebootAt && static_cast<long>(millis() - _otaRebootAt) >= 0) {
+    debug("Rebooting into the new firmware.");
+    ESP.restart();
+  }
 #endif
   if (_configPortalStart && (millis() - _configPortalStart > _config.configPortalTimeout)) {
     debug("Config portal timeout reached.");
@@ -188,33 +329,56 @@ void WiFiManager::loop() {
 }
 
 // ----- Connection Management -----
+// The station network the WiFi driver saved. WiFi.SSID() names the current
+// association and is empty before one, so read the driver's configuration.
+static bool savedStation(String& ssid, String& password) {
+  wifi_config_t conf;
+  if (esp_wifi_get_config(WIFI_IF_STA, &conf) != ESP_OK) return false;
+  const char* name = reinterpret_cast<const char*>(conf.sta.ssid);
+  const char* pass = reinterpret_cast<const char*>(conf.sta.password);
+  ssid = String(name, strnlen(name, sizeof(conf.sta.ssid)));
+  password = String(pass, strnlen(pass, sizeof(conf.sta.password)));
+  return ssid.length() > 0;
+}
+
 bool WiFiManager::autoConnect(const char* apName, const char* apPassword) {
+  unsigned long start = millis();
   WiFi.mode(WIFI_STA);
-  if (WiFi.SSID() != "") {
-    debug("Attempting connection to saved AP: " + WiFi.SSID());
-    unsigned long startTime = millis();
-    while (WiFi.status() != WL_CONNECTED && (millis() - startTime) < _config.connectTimeout) {
-      delay(500);
-    }
-    _lastConxResult = WiFi.status();
-    if (WiFi.status() == WL_CONNECTED) {
-      debug("Connected to saved AP.");
-      return true;
-    }
+  if (WiFi.status() == WL_CONNECTED) {
+    _lastConxResult = WL_CONNECTED;
+    debug("Already connected to saved AP.");
+    return true;
+  }
+  if (_config.fastReconnect && tryFastReconnect()) {
+    _connectPath = ConnectPath::FAST;
+    _timeToConnected[static_cast<uint8_t>(ConnectPath::FAST)] = millis() - start;
+    debug("Fast reconnect succeeded in " + String(millis() - start) + " ms.");
+    return true;
+  }
+  std::vector<ConnectCandidate> candidates;
+  String savedSsid, savedPassword;
+  if (savedStation(savedSsid, savedPassword)) {
+    debug("Attempting connection to saved AP: " + savedSsid);
+    candidates.push_back(ConnectCandidate(savedSsid, savedPassword));
   }
 #ifdef ENABLE_MULTI_CRED
   for (auto& cred : _wifiCredentials) {
-    debug("Attempting connection to credential: " + cred.ssid);
-    WiFi.begin(cred.ssid.c_str(), cred.password.c_str());
-    unsigned long startTime = millis();
-    while (WiFi.status() != WL_CONNECTED && (millis() - startTime) < _config.connectTimeout) { delay(500); }
-    _lastConxResult = WiFi.status();
-    if (WiFi.status() == WL_CONNECTED) {
-      debug("Connected using multi-credential: " + cred.ssid);
+    bool known = false;
+    for (auto& c : candidates) known = known || c.ssid == cred.ssid;
+    if (!known) candidates.push_back(ConnectCandidate(cred.ssid, cred.password, cred.priority));
+  }
+#endif
+  if (!candidates.empty()) {
+    // With several networks to choose from, one scan up front is cheaper than
+    // an all-channel probe per credential; a single one uses the cache if fresh.
+    rankCandidates(candidates, getFreshScan(candidates.size() > 1).get());
+    startConnect(std::move(candidates));
+    if (waitForConnect()) {
+      _connectPath = ConnectPath::NORMAL;
+      _timeToConnected[static_cast<uint8_t>(ConnectPath::NORMAL)] = millis() - start;
       return true;
     }
   }
-#endif
   debug("No saved credentials or connection failed. Starting config portal.");
   return startConfigPortal(apName ? apName : "ESP_Config", apPassword);
 }
@@ -227,6 +391,7 @@ bool WiFiManager::startConfigPortal(const char* apName, const char* apPassword)
   }
   startDNS();
   _configPortalStart = millis();
+  startScan();  // warm the cache before the first visitor asks for it
   if (_apCallback) { _apCallback(this); }
   debug("Config portal running...");
   while (WiFi.status() != WL_CONNECTED && (millis() - _configPortalStart < _config.configPortalTimeout)) {
@@ -242,21 +407,402 @@ bool WiFiManager::startConfigPortal(const char* apName, const char* apPassword)
 }
 
 void WiFiManager::stopConfigPortal() {
-  _dnsServer.stop();
+  _dns.end();
   _configPortalStart = 0;
   debug("Config portal stopped.");
 }
 
+// Blocking convenience wrapper; the web UI goes through beginConnect().
 bool WiFiManager::connectToNetwork(const char* ssid, const char* password) {
-  WiFi.begin(ssid, password);
-  unsigned long startTime = millis();
-  while (WiFi.status() != WL_CONNECTED && (millis() - startTime) < _config.connectTimeout) {
-    delay(500);
+  if (!beginConnect(ssid, password)) return false;
+  return waitForConnect();
+}
+
+bool WiFiManager::beginConnect(const char* ssid, const char* password) {
+  if (!ssid || !*ssid) return false;
+  // One hand-over slot: a second request before loop() picked up the first is refused.
+  uint8_t expected = 0;
+  if (!_pendingConnectState.compare_exchange_strong(expected, 1)) return false;
+  _pendingConnect.ssid = ssid;
+  _pendingConnect.password = password ? password : "";
+  _pendingConnectState = 2;
+  return true;
+}
+
+ConnectState WiFiManager::getConnectState() const {
+  return _pendingConnectState ? ConnectState::CONNECTING : _connectState.load();
+}
+
+// Time spent on the current attempt sequence, or on the last one once it ended.
+unsigned long WiFiManager::getConnectDuration() const {
+  if (_pendingConnectState) return 0;
+  if (_connectState == ConnectState::CONNECTING) return millis() - _connectStartedAt;
+  return _connectDuration;
+}
+
+// Pins every candidate heard in `scan` to its strongest BSSID and orders the
+// list by priority, then signal. Candidates that were not heard (hidden or out
+// of range) keep the unpinned all-channel probe and go last.
+void WiFiManager::rankCandidates(std::vector<ConnectCandidate>& candidates, const ScanSnapshot* scan) {
+  if (!scan) return;
+  for (auto& candidate : candidates) {
+    const WiFiNetwork* best = nullptr;
+    for (const auto& net : scan->networks) {
+      if (net.ssid == candidate.ssid && (!best || net.rssi > best->rssi)) best = &net;
+    }
+    if (!best) continue;
+    candidate.rssi = best->rssi;
+    candidate.channel = best->channel;
+    memcpy(candidate.bssid, best->bssid, sizeof(candidate.bssid));
+  }
+  std::stable_sort(candidates.begin(), candidates.end(), [](const ConnectCandidate& a, const ConnectCandidate& b) {
+    if ((a.channel != 0) != (b.channel != 0)) return a.channel != 0;
+    if (a.priority != b.priority) return a.priority > b.priority;
+    return a.rssi > b.rssi;
+  });
+}
+
+void WiFiManager::startConnect(std::vector<ConnectCandidate> candidates) {
+  if (candidates.empty()) return;
+  _connectQueue = std::move(candidates);
+  _connectIndex = 0;
+  _connectStartedAt = millis();
+  _connectState = ConnectState::CONNECTING;
+  startConnectAttempt();
+}
+
+void WiFiManager::startConnectAttempt() {
+  const ConnectCandidate& candidate = _connectQueue[_connectIndex];
+  _connectGotIP = false;
+  _connectFailReason = 0;
+  _attemptStartedAt = millis();
+  if (candidate.channel) {
+    debug("Connecting to AP: " + candidate.ssid + " (channel " + String(candidate.channel) + ", " +
+          String(candidate.rssi) + " dBm)");
+    WiFi.begin(candidate.ssid.c_str(), candidate.password.c_str(), candidate.channel, candidate.bssid);
+  } else {
+    debug("Connecting to AP: " + candidate.ssid);
+    WiFi.begin(candidate.ssid.c_str(), candidate.password.c_str());
+  }
+  notifyConnectState();
+}
+
+// Advances the state machine; called from loop() and never waits on the radio.
+void WiFiManager::processConnect() {
+  if (_pendingConnectState == 2) {
+    std::vector<ConnectCandidate> candidates;
+    candidates.push_back(std::move(_pendingConnect));
+    _pendingConnectState = 0;
+    releaseLease();
+    rankCandidates(candidates, getFreshScan(false).get());
+    startConnect(std::move(candidates));
   }
+  if (_leaseRenewing && _connectGotIP && WiFi.status() == WL_CONNECTED) {
+    _leaseRenewing = false;
+    saveFastReconnect();
+  }
+  if (_connectState != ConnectState::CONNECTING) return;
+  if (_connectGotIP && WiFi.status() == WL_CONNECTED) {
+    WM_TRACE_SPAN(kTraceConnectAttempt, _attemptStartedAt * 1000UL);
+    debug("Connected to " + _connectQueue[_connectIndex].ssid + " in " + String(millis() - _connectStartedAt) + " ms.");
+    finishConnect(ConnectState::CONNECTED);
+    return;
+  }
+  uint8_t reason = _connectFailReason;
+  bool rejected = reason == WIFI_REASON_NO_AP_FOUND || reason == WIFI_REASON_AUTH_FAIL ||
+                  reason == WIFI_REASON_4WAY_HANDSHAKE_TIMEOUT || reason == WIFI_REASON_HANDSHAKE_TIMEOUT;
+  if (!rejected && millis() - _attemptStartedAt < _config.connectTimeout) return;
+  WM_TRACE_SPAN(kTraceConnectAttempt, _attemptStartedAt * 1000UL);
+  ConnectCandidate& candidate = _connectQueue[_connectIndex];
+  if (reason == WIFI_REASON_NO_AP_FOUND && candidate.channel) {
+    // The scan was stale (AP restarted on another channel); probe once more unpinned.
+    debug("No AP on channel " + String(candidate.channel) + ", retrying " + candidate.ssid + " on all channels.");
+    candidate.channel = 0;
+    startConnectAttempt();
+    return;
+  }
+  if (rejected) debug("Connection to " + candidate.ssid + " rejected, reason " + String(reason));
+  else debug("Connection to " + candidate.ssid + " timed out.");
   _lastConxResult = WiFi.status();
-  return (WiFi.status() == WL_CONNECTED);
+  if (++_connectIndex < _connectQueue.size()) {
+    startConnectAttempt();
+    return;
+  }
+  _connectIndex = _connectQueue.size() - 1;
+  finishConnect(ConnectState::FAILED);
+}
+
+void WiFiManager::finishConnect(ConnectState state) {
+  _connectDuration = millis() - _connectStartedAt;
+  _lastConxResult = WiFi.status();
+  if (state == ConnectState::CONNECTED && _leaseApplied) {
+    // The cached lease only got the link up; DHCP takes over from here and
+    // renews it, and the record is saved once its answer is in.
+    releaseLease();
+    _connectGotIP = false;
+    _leaseRenewing = true;
+  } else if (state == ConnectState::CONNECTED && _config.fastReconnect) {
+    saveFastReconnect();
+  }
+  _connectState = state;
+  notifyConnectState();
+}
+
+bool WiFiManager::waitForConnect() {
+  while (getConnectState() == ConnectState::CONNECTING) {
+    loop();
+    delay(10);
+  }
+  return _connectState == ConnectState::CONNECTED;
+}
+
+ConnectPath WiFiManager::getLastConnectPath() const {
+  return _connectPath;
+}
+
+unsigned long WiFiManager::getTimeToConnected(ConnectPath path) const {
+  return _timeToConnected[static_cast<uint8_t>(path)];
+}
+
+// ----- Fast Reconnect -----
+static const char* kFastReconnectNamespace = "wm_fast";
+static const uint32_t kFastReconnectVersion = 2;  // 1 kept a copy of the passphrase
+
+// Rejoins the last network on its known BSSID and channel with the previous
+// DHCP lease applied as a static address: one channel dwell plus association,
+// no probe sweep and no DHCP exchange before the link is up. DHCP is restarted
+// right after (see finishConnect()), so the address is renewed rather than
+// held past its lease.
+bool WiFiManager::tryFastReconnect() {
+  FastReconnectRecord record;
+  if (!loadFastReconnect(record)) return false;
+  String password;
+  if (!storedPassword(record.ssid, password)) return false;
+  debug("Fast reconnect to " + String(record.ssid) + " on channel " + String(record.channel));
+  if (!_staStaticIP && record.ip) {
+    WiFi.config(IPAddress(record.ip), IPAddress(record.gateway), IPAddress(record.subnet), IPAddress(record.dns));
+    _leaseApplied = true;
+  }
+  ConnectCandidate candidate(record.ssid, password);
+  candidate.channel = record.channel;
+  memcpy(candidate.bssid, record.bssid, sizeof(candidate.bssid));
+  std::vector<ConnectCandidate> candidates;
+  candidates.push_back(candidate);
+  startConnect(std::move(candidates));
+  if (waitForConnect()) return true;
+  debug("Fast reconnect failed; falling back to scan and DHCP.");
+  releaseLease();
+  return false;
+}
+
+// The passphrase for `ssid` from the credentials already on the device.
+bool WiFiManager::storedPassword(const char* ssid, String& password) const {
+  String saved;
+  if (savedStation(saved, password) && saved == ssid) return true;
+#ifdef ENABLE_MULTI_CRED
+  for (const auto& cred : _wifiCredentials) {
+    if (cred.ssid == ssid) {
+      password = cred.password;
+      return true;
+    }
+  }
+#endif
+  return false;
+}
+
+// Hands address assignment back to DHCP.
+void WiFiManager::releaseLease() {
+  if (!_leaseApplied) return;
+  WiFi.config(IPAddress((uint32_t)0), IPAddress((uint32_t)0), IPAddress((uint32_t)0));
+  _leaseApplied = false;
+}
+
+bool WiFiManager::loadFastReconnect(FastReconnectRecord& record) {
+  Preferences prefs;
+  if (!prefs.begin(kFastReconnectNamespace, true)) return false;
+  size_t stored = prefs.getBytesLength("last");
+  bool ok = stored == sizeof(record) && prefs.getBytes("last", &record, sizeof(record)) == sizeof(record) &&
+            record.version == kFastReconnectVersion && record.channel > 0 && record.ssid[0];
+  prefs.end();
+  // Older layouts carried the passphrase; do not leave it behind.
+  if (!ok && stored) clearFastReconnect();
+  return ok;
+}
+
+void WiFiManager::saveFastReconnect() {
+  FastReconnectRecord record;
+  memset(&record, 0, sizeof(record));
+  record.version = kFastReconnectVersion;
+  strlcpy(record.ssid, WiFi.SSID().c_str(), sizeof(record.ssid));
+  memcpy(record.bssid, WiFi.BSSID(), sizeof(record.bssid));
+  record.channel = WiFi.channel();
+  record.ip = static_cast<uint32_t>(WiFi.localIP());
+  record.gateway = static_cast<uint32_t>(WiFi.gatewayIP());
+  record.subnet = static_cast<uint32_t>(WiFi.subnetMask());
+  record.dns = static_cast<uint32_t>(WiFi.dnsIP());
+  // Periodic wake-ups land on the same AP and lease; skip the flash write then.
+  FastReconnectRecord stored;
+  if (loadFastReconnect(stored) && memcmp(&stored, &record, sizeof(record)) == 0) return;
+  Preferences prefs;
+  if (!prefs.begin(kFastReconnectNamespace, false)) return;
+  prefs.putBytes("last", &record, sizeof(record));
+  prefs.end();
+  debug("Fast reconnect cache updated.");
+}
+
+void WiFiManager::clearFastReconnect() {
+  Preferences prefs;
+  if (!prefs.begin(kFastReconnectNamespace, false)) return;
+  prefs.clear();
+  prefs.end();
+}
+
+static const char* connectStateName(ConnectState state) {
+  switch (state) {
+    case ConnectState::CONNECTING: return "connecting";
+    case ConnectState::CONNECTED: return "connected";
+    case ConnectState::FAILED: return "failed";
+    default: return "idle";
+  }
+}
+
+// Pushes every transition to WebSocket clients so the UI does not have to poll.
+void WiFiManager::notifyConnectState() {
+#ifdef ENABLE_WEBSOCKETS
+  if (!_ws || _ws->count() == 0) return;
+  const ConnectCandidate& candidate = _connectQueue[_connectIndex];
+  sendWsJson(nullptr, [this, &candidate](JsonStreamWriter& json) {
+    json.beginObject();
+    json.field("type", "connect");
+    json.field("state", connectStateName(_connectState));
+    json.field("ssid", candidate.ssid);
+    json.field("attempt", _connectIndex + 1);
+    json.field("candidates", _connectQueue.size());
+    json.field("elapsed_ms", getConnectDuration());
+    json.field("reason", _connectFailReason.load());
+    json.endObject();
+  });
+#endif
+}
+
+#ifdef ENABLE_WEBSOCKETS
+// How often loop() samples the radio for /ws, and the RSSI change worth a
+// message (readings jitter by a dB or two from one sample to the next).
+static const unsigned long kStatusSampleMs = 1000;
+static const int32_t kRssiStepDb = 3;
+
+// Sends `render` to one client, or to all of them when client is null. The
+// renderer must produce the same document every time it is called: messages
+// are built on the stack and only one that does not fit (many parameters) is
+// rendered again into an exact-size heap buffer.
+void WiFiManager::sendWsJson(AsyncWebSocketClient* client, const JsonRenderer& render) {
+  char stackBuf[256];
+  JsonStreamWriter json(reinterpret_cast<uint8_t*>(stackBuf), sizeof(stackBuf));
+  render(json);
+  const size_t len = json.produced();
+  const char* msg = stackBuf;
+  std::unique_ptr<char[]> heapBuf;
+  if (len != json.written()) {
+    heapBuf.reset(new char[len]);
+    JsonStreamWriter full(reinterpret_cast<uint8_t*>(heapBuf.get()), len);
+    render(full);
+    msg = heapBuf.get();
+  }
+  if (client) client->text(msg, len);
+  else _ws->textAll(msg, len);
 }
 
+// Full state for a client that just connected; later updates are deltas.
+void WiFiManager::sendStatusSnapshot(AsyncWebSocketClient* client) {
+  const char* status = getConnectionStatusText();
+  IPAddress ip = WiFi.localIP();
+  int32_t rssi = WiFi.status() == WL_CONNECTED ? WiFi.RSSI() : 0;
+  char ssid[33];
+  strlcpy(ssid, WiFi.SSID().c_str(), sizeof(ssid));
+  ConnectState connect = getConnectState();
+  sendWsJson(client, [&](JsonStreamWriter& json) {
+    json.beginObject();
+    json.field("type", "status");
+    json.field("status", status);
+    json.key("ip");
+    json.valueIP(ip);
+    json.field("ssid", ssid);
+    json.field("rssi", rssi);
+    json.key("connect");
+    json.beginObject();
+    json.field("state", connectStateName(connect));
+    json.endObject();
+    json.key("params");
+    json.beginArray();
+    for (auto* param : _params) {
+      json.beginObject();
+      json.field("id", param->getID());
+      json.field("value", param->getValue());
+      json.endObject();
+    }
+    json.endArray();
+    json.endObject();
+  });
+}
+
+// Runs from loop(): samples status, RSSI, IP and parameter values and
+// broadcasts only what changed since the last message, so an idle portal
+// costs one comparison per second and no traffic.
+void WiFiManager::publishStatusDelta() {
+  if (!_ws || millis() - _lastStatusSample < kStatusSampleMs) return;
+  _lastStatusSample = millis();
+
+  PublishedStatus now;
+  now.status = getConnectionStatusText();
+  now.ip = static_cast<uint32_t>(WiFi.localIP());
+  now.rssi = WiFi.status() == WL_CONNECTED ? WiFi.RSSI() : 0;
+  strlcpy(now.ssid, WiFi.SSID().c_str(), sizeof(now.ssid));
+  now.paramRevision = WiFiManagerParameter::revision();
+
+  const PublishedStatus was = _published;
+  const bool statusChanged = !was.status || strcmp(now.status, was.status) != 0;
+  const bool ipChanged = now.ip != was.ip;
+  const bool ssidChanged = strcmp(now.ssid, was.ssid) != 0;
+  const int32_t drift = now.rssi - was.rssi;
+  const bool rssiChanged = (now.rssi == 0) != (was.rssi == 0) || drift >= kRssiStepDb || drift <= -kRssiStepDb;
+  // The revision also moves on attribute changes; only values are pushed.
+  bool paramsChanged = false;
+  if (now.paramRevision != was.paramRevision) {
+    for (auto* param : _params) paramsChanged |= param->valueRevision() > was.paramRevision;
+  }
+  // Small drifts are measured from the last value sent so they still add up.
+  if (!rssiChanged) now.rssi = was.rssi;
+  _published = now;
+
+  if (!(statusChanged || ipChanged || ssidChanged || rssiChanged || paramsChanged)) return;
+  if (_ws->count() == 0) return;
+  sendWsJson(nullptr, [&](JsonStreamWriter& json) {
+    json.beginObject();
+    json.field("type", "status");
+    if (statusChanged) json.field("status", now.status);
+    if (ipChanged) {
+      json.key("ip");
+      json.valueIP(IPAddress(now.ip));
+    }
+    if (ssidChanged) json.field("ssid", now.ssid);
+    if (rssiChanged) json.field("rssi", now.rssi);
+    if (paramsChanged) {
+      json.key("params");
+      json.beginArray();
+      for (auto* param : _params) {
+        if (param->valueRevision() <= was.paramRevision) continue;
+        json.beginObject();
+        json.field("id", param->getID());
+        json.field("value", param->getValue());
+        json.endObject();
+      }
+      json.endArray();
+    }
+    json.endObject();
+  });
+}
+#endif
+
 bool WiFiManager::disconnectFromNetwork() {
   WiFi.disconnect();
   return (WiFi.status() != WL_CONNECTED);
@@ -264,6 +810,7 @@ bool WiFiManager::disconnectFromNetwork() {
 
 void WiFiManager::resetSettings() {
   debug("Resetting settings.");
+  clearFastReconnect();
   WiFi.disconnect(true);
 }
 
@@ -275,24 +822,39 @@ void WiFiManager::setAPStaticIPConfig(IPAddress ip, IPAddress gateway, IPAddress
 
 void WiFiManager::setSTAStaticIPConfig(IPAddress ip, IPAddress gateway, IPAddress subnet, IPAddress dns) {
   WiFi.config(ip, gateway, subnet, dns);
+  _staStaticIP = static_cast<uint32_t>(ip) != 0;
+  _leaseApplied = false;
   debug("STA static IP config set.");
 }
 
 // ----- Parameter Handling -----
 bool WiFiManager::addParameter(WiFiManagerParameter* param) {
-  _params.push_back(param);
+  if (!_params.add(param)) {
+    debug("Parameter rejected: " + String(param ? param->getID() : "(null)"));
+    return false;
+  }
+#ifdef ENABLE_HTML_INTERFACE
+  _rootPageVersion++;
+#endif
   debug("Parameter added: " + String(param->getID()));
   return true;
 }
 
 std::vector<WiFiManagerParameter*> WiFiManager::getParameters() const {
-  return _params;
+  return _params.list();
+}
+
+WiFiManagerParameter* WiFiManager::getParameter(const char* id) const {
+  return _params.find(id, strlen(id));
 }
 
 // ----- Debug & Callback Setters -----
 void WiFiManager::setDebugOutput(bool debug, Print& debugPort) {
   _debug = debug;
   _debugPort = &debugPort;
+#ifdef ENABLE_SERIAL_MONITOR
+  if (_serialTee) _serialTee->setOutput(_debugPort);
+#endif
 }
 
 void WiFiManager::setAPCallback(std::function<void(WiFiManager*)> callback) {
@@ -310,12 +872,23 @@ void WiFiManager::setConfigPortalTimeoutCallback(std::function<void()> callback)
 #ifdef ENABLE_HTML_INTERFACE
 void WiFiManager::setCustomHeadElement(const char* html) {
   _customHeadElement = html;
+  _rootPageVersion++;
 }
 void WiFiManager::setCustomBodyFooter(const char* html) {
   _customBodyFooter = html;
+  _rootPageVersion++;
 }
 #endif
 
+void WiFiManager::setEmbeddedAssets(const EmbeddedAsset* table, size_t count) {
+  _embeddedAssets = table;
+  _embeddedAssetCount = table ? count : 0;
+}
+
+bool WiFiManager::isFilesystemMounted() const {
+  return _fsMounted;
+}
+
 #ifdef ENABLE_MDNS
 void WiFiManager::setMDNSHostname(const char* hostname) {
   _mdnsHostname = hostname;
@@ -355,27 +928,111 @@ bool WiFiManager::checkAuthentication(AsyncWebServerRequest *request) {
 #endif
 
 #ifdef ENABLE_SERIAL_MONITOR
+// Largest /serial_ws frame, and how long a partial one may wait for more.
+static const size_t kSerialFrameBytes = 1024;
+static const unsigned long kSerialFlushMs = 50;
+
+// Length of the longest prefix of s[0, n) that does not end inside a UTF-8
+// sequence, so text frames stay valid.
+static size_t utf8Prefix(const uint8_t* s, size_t n) {
+  size_t i = n;
+  while (i > 0 && n - i < 3 && (s[i - 1] & 0xC0) == 0x80) i--;
+  if (i == 0) return n;
+  uint8_t lead = s[i - 1];
+  size_t need = lead >= 0xF0 ? 4 : lead >= 0xE0 ? 3 : lead >= 0xC0 ? 2 : 1;
+  return n - (i - 1) >= need ? n : i - 1;
+}
+
 void WiFiManager::enableSerialMonitor(bool enable, unsigned int bufferSize) {
   _enableSerialMonitor = enable;
-  _serialMonitorBufferSize = bufferSize;
-  _serialMonitorBuffer.reserve(bufferSize);
+  if (!enable) return;
+  if (!_serialRing) {
+    _serialMonitorBufferSize = bufferSize;
+    _serialRing.reset(new SerialRing(bufferSize));
+    _serialTee.reset(new SerialTee(*_serialRing, _debugPort));
+  }
   _lastSerialUpdate = millis();
-  if (enable && _server) {
-    _server->on("/serial", HTTP_GET, [this](AsyncWebServerRequest *request) { /* Serial monitor page code */ });
-    _server->on("/serial_data", HTTP_GET, [this](AsyncWebServerRequest *request) { /* Serial data endpoint */ });
-    debug("Serial monitor enabled");
+  setupSerialMonitor();
+}
+
+void WiFiManager::setupSerialMonitor() {
+  if (_serialRoutesAdded || !_server) return;
+  _serialRoutesAdded = true;
+  _server->on("/serial", HTTP_GET, [this](AsyncWebServerRequest *request) {
+    #ifdef ENABLE_AUTH
+    if (!checkAuthentication(request)) return;
+    #endif
+    if (!servePortalAsset(request, "/serial-monitor.html")) {
+      respond(request, 404, "application/json", "{\"error\":\"Not found\"}");
+    }
+  });
+  // Polling fallback for clients without WebSocket support.
+  _server->on("/serial_data", HTTP_GET, [this](AsyncWebServerRequest *request) {
+    #ifdef ENABLE_AUTH
+    if (!checkAuthentication(request)) return;
+    #endif
+    respond(request, 200, "text/plain", getSerialMonitorBuffer());
+  });
+#ifdef ENABLE_WEBSOCKETS
+  // Output only; baud rate and commands from the page are handled client-side.
+  _serialWs = new AsyncWebSocket("/serial_ws");
+  _server->addHandler(_serialWs);
+#endif
+  debug("Serial monitor enabled");
+}
+
+// Runs from loop(), the ring's only consumer.
+void WiFiManager::flushSerialMonitor() {
+  if (!_enableSerialMonitor || !_serialRing) return;
+  size_t pending = _serialRing->size();
+  if (pending == 0) return;
+#ifdef ENABLE_WEBSOCKETS
+  if (_serialWs && _serialWs->count() > 0) {
+    if (pending < kSerialFrameBytes && millis() - _lastSerialUpdate < kSerialFlushMs) return;
+    uint8_t frame[kSerialFrameBytes];
+    for (int i = 0; i < 4 && _serialRing->size() > 0; i++) {
+      // A client with a full queue holds the stream back; the ring absorbs
+      // the backlog and drops the excess, the loggers never wait.
+      if (!_serialWs->availableForWriteAll()) break;
+      size_t n = utf8Prefix(frame, _serialRing->peek(frame, sizeof(frame)));
+      if (n == 0) break;
+      _serialWs->textAll(reinterpret_cast<const char*>(frame), n);
+      _serialRing->skip(n);
+    }
+    _lastSerialUpdate = millis();
+    return;
   }
+#endif
+  // Nobody is listening: keep the newest half as backlog for the next client.
+  size_t keep = _serialRing->capacity() / 2;
+  if (pending > keep) _serialRing->skip(pending - keep);
 }
+
 bool WiFiManager::isSerialMonitorEnabled() const {
   return _enableSerialMonitor;
 }
 String WiFiManager::getSerialMonitorBuffer() const {
-  return _serialMonitorBuffer;
+  String out;
+  if (!_serialRing) return out;
+  std::unique_ptr<uint8_t[]> buf(new uint8_t[_serialRing->capacity()]);
+  size_t n = _serialRing->snapshot(buf.get(), _serialRing->capacity());
+  out.concat(reinterpret_cast<const char*>(buf.get()), n);
+  return out;
+}
+Print& WiFiManager::getSerialMonitorOutput() {
+  if (!_serialTee) return *_debugPort;
+  return *_serialTee;
+}
+uint32_t WiFiManager::getSerialMonitorDropped() const {
+  return _serialRing ? _serialRing->dropped() : 0;
 }
 #endif
 
 // ----- Status & Network Scanning -----
 String WiFiManager::getConnectionStatus() {
+  return getConnectionStatusText();
+}
+const char* WiFiManager::getConnectionStatusText() {
   switch(WiFi.status()){
     case WL_CONNECTED: return "Connected";
     case WL_DISCONNECTED: return "Disconnected";
@@ -389,22 +1046,80 @@ uint8_t WiFiManager::getLastConxResult() {
   return _lastConxResult;
 }
 std::vector<WiFiNetwork> WiFiManager::scanNetworks(bool forceScan) {
-  std::vector<WiFiNetwork> networks;
-  int n = WiFi.scanNetworks(forceScan);
+  auto snapshot = getScanSnapshot();
+  if (forceScan || !snapshot || millis() - snapshot->timestamp > _config.scanCacheTTL) {
+    startScan();
+  }
+  return snapshot ? snapshot->networks : std::vector<WiFiNetwork>();
+}
+bool WiFiManager::startScan() {
+  // Concurrent callers coalesce into the scan already on air.
+  bool expected = false;
+  if (!_scanInProgress.compare_exchange_strong(expected, true)) return true;
+  _scanStartedAt = millis();
+  if (WiFi.scanNetworks(true) == WIFI_SCAN_FAILED) {
+    debug("Failed to start background scan.");
+    _scanInProgress = false;
+    return false;
+  }
+  debug("Background scan started.");
+  return true;
+}
+bool WiFiManager::isScanInProgress() const {
+  return _scanInProgress;
+}
+unsigned long WiFiManager::getLastScanTime() const {
+  auto snapshot = getScanSnapshot();
+  return snapshot ? snapshot->timestamp : 0;
+}
+std::shared_ptr<const WiFiManager::ScanSnapshot> WiFiManager::getScanSnapshot() const {
+  return std::atomic_load(&_scanSnapshot);
+}
+// Cached results if younger than the TTL; otherwise either nothing or, with
+// scanIfStale, the result of a new scan (servicing loop() while it runs).
+std::shared_ptr<const WiFiManager::ScanSnapshot> WiFiManager::getFreshScan(bool scanIfStale) {
+  auto snapshot = getScanSnapshot();
+  if (snapshot && millis() - snapshot->timestamp <= _config.scanCacheTTL) return snapshot;
+  if (!scanIfStale || !startScan()) return nullptr;
+  while (_scanInProgress) {
+    loop();
+    delay(10);
+  }
+  return getScanSnapshot();
+}
+// Runs on the WiFi event task when the radio reports ARDUINO_EVENT_WIFI_SCAN_DONE.
+void WiFiManager::onScanDone() {
+  WM_TRACE_SPAN(kTraceScan, _scanStartedAt * 1000UL);
+  WM_TRACE_SCOPE(kTraceScanResults);
+  int n = WiFi.scanComplete();
+  if (n < 0) {
+    _scanInProgress = false;
+    return;
+  }
+  auto snapshot = std::make_shared<ScanSnapshot>();
+  snapshot->networks.reserve(n);
   for (int i = 0; i < n; i++) {
     WiFiNetwork net;
     net.ssid = WiFi.SSID(i);
     net.rssi = WiFi.RSSI(i);
     net.encryptionType = WiFi.encryptionType(i);
-    networks.push_back(net);
+    net.channel = WiFi.channel(i);
+    memcpy(net.bssid, WiFi.BSSID(i), sizeof(net.bssid));
+    snapshot->networks.push_back(net);
   }
-#if defined(USING_ESP32)
+#if defined(USING_ESP32) || defined(USING_NATIVE_SIM)
   WiFi.scanDelete();
 #endif
+  snapshot->timestamp = millis();
+  snapshot->duration = snapshot->timestamp - _scanStartedAt;
+  std::atomic_store(&_scanSnapshot, std::shared_ptr<const ScanSnapshot>(snapshot));
+  _scanInProgress = false;
   debug(String(n) + " networks found.");
-  return networks;
 }
 String WiFiManager::getInputTypeString(ParameterType type) {
+  return getInputTypeName(type);
+}
+const char* WiFiManager::getInputTypeName(ParameterType type) {
   switch(type) {
     case ParameterType::TEXT: return "text";
     case ParameterType::PASSWORD: return "password";
@@ -428,67 +1143,103 @@ void WiFiManager::handleRoot(AsyncWebServerRequest *request) {
   if (!checkAuthentication(request)) return;
   #endif
   // Prefer serving rich static UI if available
-  if (SPIFFS.exists("/index.html")) {
-    request->send(SPIFFS, "/index.html", String(), false);
-    return;
-  }
-  String page = "<html><head>";
-#ifdef ENABLE_HTML_INTERFACE
-  if (_customHeadElement.length() > 0) page += _customHeadElement;
-#endif
-  page += "<meta charset='utf-8'><meta name='viewport' content='width=device-width, initial-scale=1.0'>";
-  page += "<title>WiFi Manager</title>";
-  page += "<style>body{font-family:Arial,sans-serif;padding:20px;color:#333} .container{max-width:800px;margin:auto;padding:20px;background:#f9f9f9;border-radius:5px} .btn{padding:8px 16px;background:#0066cc;color:white;border:none;border-radius:4px;cursor:pointer} input,select,textarea{width:100%;padding:8px;margin:5px 0;border:1px solid #ddd;border-radius:4px;}</style>";
-  page += "</head><body><div class='container'>";
-  page += "<h1>WiFi Manager</h1>";
-  page += "<p>Status: " + getConnectionStatus() + "</p>";
-  page += "<h2>Available Networks</h2>";
-  page += "<button class='btn' onclick='scanNetworks()'>Scan Networks</button>";
-  page += "<div id='networks'></div>";
-  page += "<h2>Connect to Network</h2>";
-  page += "<form id='wifi-form'><label for='ssid'>SSID:</label><input type='text' id='ssid' name='ssid' required>";
-  page += "<label for='password'>Password:</label><input type='password' id='password' name='password'>";
-  page += "<button type='submit' class='btn'>Connect</button></form>";
+  if (servePortalAsset(request, "/index.html")) return;
+  // Only the status line changes between renders; the rest comes from the
+  // cached page and is streamed without being joined into one String.
+  std::shared_ptr<const RootPage> page = getRootPage();
+  const char* status = getConnectionStatusText();
+  size_t total = page->head.length() + strlen(status) + page->tail.length();
+  charge(total);
+  request->send(request->beginResponse("text/html", total,
+    [page, status](uint8_t* buffer, size_t maxLen, size_t index) -> size_t {
+      const char* parts[] = {page->head.c_str(), status, page->tail.c_str()};
+      size_t lengths[] = {page->head.length(), strlen(status), page->tail.length()};
+      size_t written = 0;
+      size_t start = 0;
+      for (int i = 0; i < 3; i++) {
+        size_t at = index + written;
+        if (written < maxLen && at < start + lengths[i]) {
+          size_t n = std::min(maxLen - written, start + lengths[i] - at);
+          memcpy(buffer + written, parts[i] + (at - start), n);
+          written += n;
+        }
+        start += lengths[i];
+      }
+      return written;
+    }));
+}
+
+std::shared_ptr<const WiFiManager::RootPage> WiFiManager::getRootPage() {
+  uint32_t version = _rootPageVersion.load();
+  uint32_t paramRevision = WiFiManagerParameter::revision();
+  std::shared_ptr<const RootPage> cached = std::atomic_load(&_rootPage);
+  if (cached && cached->version == version && cached->paramRevision == paramRevision) return cached;
+
+  auto page = std::make_shared<RootPage>();
+  page->version = version;
+  page->paramRevision = paramRevision;
+  String& head = page->head;
+  head.reserve(1024 + _customHeadElement.length());
+  head += "<html><head>";
+  if (_customHeadElement.length() > 0) head += _customHeadElement;
+  head += "<meta charset='utf-8'><meta name='viewport' content='width=device-width, initial-scale=1.0'>";
+  head += "<title>WiFi Manager</title>";
+  head += "<style>body{font-family:Arial,sans-serif;padding:20px;color:#333} .container{max-width:800px;margin:auto;padding:20px;background:#f9f9f9;border-radius:5px} .btn{padding:8px 16px;background:#0066cc;color:white;border:none;border-radius:4px;cursor:pointer} input,select,textarea{width:100%;padding:8px;margin:5px 0;border:1px solid #ddd;border-radius:4px;}</style>";
+  head += "</head><body><div class='container'>";
+  head += "<h1>WiFi Manager</h1>";
+  head += "<p>Status: ";
+
+  String& tail = page->tail;
+  tail.reserve(3072 + _params.size() * 160 + _customBodyFooter.length());
+  tail += "</p>";
+  tail += "<h2>Available Networks</h2>";
+  tail += "<button class='btn' onclick='scanNetworks()'>Scan Networks</button>";
+  tail += "<div id='networks'></div>";
+  tail += "<h2>Connect to Network</h2>";
+  tail += "<form id='wifi-form'><label for='ssid'>SSID:</label><input type='text' id='ssid' name='ssid' required>";
+  tail += "<label for='password'>Password:</label><input type='password' id='password' name='password'>";
+  tail += "<button type='submit' class='btn'>Connect</button></form>";
   if (_params.size() > 0) {
-    page += "<h2>Custom Fields</h2>";
-    page += "<form id='custom-form'>";
+    tail += "<h2>Custom Fields</h2>";
+    tail += "<form id='custom-form'>";
     for (auto param : _params) {
-      page += "<label for='" + String(param->getID()) + "'>" + String(param->getLabel());
-#ifdef ENABLE_LOCALIZATION
-      if (strlen(param->getGroup()) > 0) { page += " (" + String(param->getGroup()) + ")"; }
-#else
-      if (strlen(param->getGroup()) > 0) { page += " (" + String(param->getGroup()) + ")"; }
-#endif
-      page += ":</label>";
-      page += "<input type='" + getInputTypeString(param->getType()) + "' id='" + String(param->getID()) +
-              "' name='" + String(param->getID()) + "' value='" + String(param->getValue()) + "' " +
-              String(param->getCustomAttributes()) + ">";
+      tail += "<label for='"; tail += param->getID(); tail += "'>"; tail += param->getLabel();
+      if (strlen(param->getGroup()) > 0) { tail += " ("; tail += param->getGroup(); tail += ")"; }
+      tail += ":</label>";
+      tail += "<input type='"; tail += getInputTypeName(param->getType());
+      tail += "' id='"; tail += param->getID();
+      tail += "' name='"; tail += param->getID();
+      tail += "' value='"; tail += param->getValue(); tail += "' ";
+      tail += param->getCustomAttributes(); tail += ">";
     }
-    page += "<button type='submit' class='btn'>Save Custom Fields</button>";
-    page += "</form>";
+    tail += "<button type='submit' class='btn'>Save Custom Fields</button>";
+    tail += "</form>";
   }
-  page += "<hr><h2>Advanced Tools</h2>";
-  page += "<a href='/ota'>OTA Update</a> | ";
+  tail += "<hr><h2>Advanced Tools</h2>";
+  tail += "<a href='/ota'>OTA Update</a> | ";
 #ifdef ENABLE_FS_EXPLORER
-  page += "<a href='/fs/list'>File Explorer</a> | ";
+  tail += "<a href='/fs/list'>File Explorer</a> | ";
 #endif
 #ifdef ENABLE_BACKUP_RESTORE
-  page += "<a href='/backup'>Backup Config</a> | ";
+  tail += "<a href='/backup'>Backup Config</a> | ";
 #endif
-  page += "<a href='/device_info'>Device Info</a>";
+  tail += "<a href='/device_info'>Device Info</a>";
 #ifdef ENABLE_TERMINAL
-  page += " | <a href='/terminal'>Terminal</a>";
-#endif
-  page += "</div>";
-  page += "<script>";
-  page += "function scanNetworks(){ document.getElementById('networks').innerHTML='Scanning...';";
-  page += "fetch('/scan').then(r=>r.json()).then(data=>{ let html='<ul>'; data.forEach(n=>{ html+='<li><a href=\"#\" onclick=\"document.getElementById(\\'ssid\\').value=\\''+n.ssid+'\\'\">'+n.ssid+' ('+n.rssi+'dBm)</a></li>'; }); html+='</ul>'; document.getElementById('networks').innerHTML=html; }); }";
-  page += "document.getElementById('wifi-form').onsubmit=function(e){ e.preventDefault(); let formData=new FormData(e.target);";
-  page += "fetch('/connect',{method:'POST',body:formData}).then(r=>r.json()).then(data=>{ alert(data.result || 'Connected!'); }).catch(err=>{ alert('Connection failed'); }); };";
-  page += "if(document.getElementById('custom-form')){ document.getElementById('custom-form').onsubmit=function(e){ e.preventDefault();";
-  page += "let formData=new FormData(e.target); fetch('/update_params',{method:'POST',body:formData}).then(r=>r.json()).then(data=>{ alert(data.result || 'Updated'); }).catch(err=>{ alert('Update failed'); }); }; }";
-  page += "</script></body></html>";
-  request->send(200, "text/html", page);
+  tail += " | <a href='/terminal'>Terminal</a>";
+#endif
+  tail += "</div>";
+  if (_customBodyFooter.length() > 0) tail += _customBodyFooter;
+  tail += "<script>";
+  tail += "function scanNetworks(retry){ document.getElementById('networks').innerHTML='Scanning...';";
+  tail += "fetch(retry?'/scan':'/scan?refresh=1').then(r=>r.json()).then(data=>{ if(data.scanning&&(retry||0)<15){ setTimeout(()=>scanNetworks((retry||0)+1),1000); return; } let html='<ul>'; data.networks.forEach(n=>{ html+='<li><a href=\"#\" onclick=\"document.getElementById(\\'ssid\\').value=\\''+n.ssid+'\\'\">'+n.ssid+' ('+n.rssi+'dBm)</a></li>'; }); html+='</ul>'; document.getElementById('networks').innerHTML=html; }); }";
+  tail += "document.getElementById('wifi-form').onsubmit=function(e){ e.preventDefault(); let formData=new FormData(e.target);";
+  tail += "fetch('/connect',{method:'POST',body:formData}).then(r=>r.json()).then(data=>{ if(data.error){ alert(data.error); return; } waitConnect(0); }).catch(err=>{ alert('Connection failed'); }); };";
+  tail += "function waitConnect(n){ fetch('/status_json').then(r=>r.json()).then(s=>{ if(s.connect.state=='connecting'&&n<60){ setTimeout(()=>waitConnect(n+1),1000); return; } alert(s.connect.state=='connected'?'Connected!':'Connection failed'); }); }";
+  tail += "if(document.getElementById('custom-form')){ document.getElementById('custom-form').onsubmit=function(e){ e.preventDefault();";
+  tail += "let formData=new FormData(e.target); fetch('/update_params',{method:'POST',body:formData}).then(r=>r.json()).then(data=>{ alert(data.result || 'Updated'); }).catch(err=>{ alert('Update failed'); }); }; }";
+  tail += "</script></body></html>";
+  std::atomic_store(&_rootPage, std::shared_ptr<const RootPage>(page));
+  return page;
 }
 #else
 void WiFiManager::handleRoot(AsyncWebServerRequest *request) {
@@ -496,22 +1247,312 @@ void WiFiManager::handleRoot(AsyncWebServerRequest *request) {
 }
 #endif
 
+// ----- Request Arenas & Heap Telemetry -----
+RequestArena* WiFiManager::leaseArena(AsyncWebServerRequest *request) {
+  RequestArena* arena = _arenas.acquire();
+  if (arena) onRequestEnd(request, [this, arena]() { _arenas.release(arena); });
+  return arena;
+}
+
+template <typename Render>
+AsyncWebServerResponse* WiFiManager::beginArenaJson(AsyncWebServerRequest *request, int code, Render&& render) {
+  return beginArenaJson(request, leaseArena(request), code, std::forward<Render>(render));
+}
+
+template <typename Render>
+AsyncWebServerResponse* WiFiManager::beginArenaJson(AsyncWebServerRequest *request, RequestArena* arena, int code,
+                                                    Render&& render) {
+  typedef typename std::decay<Render>::type Renderer;
+  // The renderer, how far the response got, and where to charge the bytes.
+  struct Job {
+    Job(Renderer r, WiFiManager* owner) : render(std::move(r)), owner(owner)
+#ifdef ENABLE_METRICS
+      , route(owner->_metrics.current())
+#endif
+    {}
+    size_t fill(uint8_t* buffer, size_t maxLen, size_t index) {
+      size_t written = cursor.fill(buffer, maxLen, index, render);
+#ifdef ENABLE_METRICS
+      owner->_metrics.addBytes(route, written);
+#endif
+      return written;
+    }
+    Renderer render;
+    JsonCursor cursor;
+    WiFiManager* owner;
+#ifdef ENABLE_METRICS
+    uint8_t route;
+#endif
+  };
+  Job* job = arena ? arena->make<Job>(std::forward<Render>(render), this) : nullptr;
+  if (!job) {
+    static const char kOutOfMemory[] = "{\"error\":\"Out of memory\"}";
+    charge(sizeof(kOutOfMemory) - 1);
+    return request->beginResponse(503, "application/json", kOutOfMemory);
+  }
+  // Captures one pointer, so the filler itself is not heap-allocated either.
+  AsyncWebServerResponse* response = request->beginChunkedResponse("application/json",
+    [job](uint8_t* buffer, size_t maxLen, size_t index) -> size_t { return job->fill(buffer, maxLen, index); });
+  response->setCode(code);
+  return response;
+}
+
+const char* const* WiFiManager::snapshotParams(RequestArena* arena) {
+  if (!arena) return nullptr;
+  return arena->copyStrings<kParamColumns>(_params.size(), [this](size_t i, const char** cells) {
+    const WiFiManagerParameter* param = _params[i];
+    cells[kParamId] = param->getID();
+    cells[kParamLabel] = param->getLabel();
+    cells[kParamValue] = param->getValue();
+    cells[kParamType] = getInputTypeName(param->getType());
+    cells[kParamAttributes] = param->getCustomAttributes();
+    cells[kParamGroup] = param->getGroup();
+  });
+}
+
+void WiFiManager::sampleHeap() {
+#if defined(USING_ESP32) || defined(USING_NATIVE_SIM)
+  if (_heapSamples && millis() - _heapSampledAt < _config.heapSampleInterval) return;
+  _heapSampledAt = millis();
+  uint32_t largest = ESP.getMaxAllocHeap();
+  if (largest < _minLargestBlock) _minLargestBlock = largest;
+  _heapHistory[_heapHistoryPos] = largest;
+  _heapHistoryPos = (_heapHistoryPos + 1) % HeapTelemetry::kHistory;
+  if (_heapSamples < HeapTelemetry::kHistory) _heapSamples++;
+#endif
+}
+
+ArenaStats WiFiManager::getArenaStats() const {
+  return _arenas.stats();
+}
+
+HeapTelemetry WiFiManager::getHeapTelemetry() const {
+  HeapTelemetry t;
+  memset(&t, 0, sizeof(t));
+#if defined(USING_ESP32) || defined(USING_NATIVE_SIM)
+  t.freeHeap = ESP.getFreeHeap();
+  t.largestBlock = ESP.getMaxAllocHeap();
+  t.minFreeHeap = ESP.getMinFreeHeap();
+  t.minLargestBlock = t.largestBlock < _minLargestBlock ? t.largestBlock : _minLargestBlock;
+  t.samples = _heapSamples;
+  uint8_t first = (_heapHistoryPos + HeapTelemetry::kHistory - _heapSamples) % HeapTelemetry::kHistory;
+  for (uint8_t i = 0; i < _heapSamples; i++) t.history[i] = _heapHistory[(first + i) % HeapTelemetry::kHistory];
+#endif
+  return t;
+}
+
+// ----- Route Registration & Instrumentation -----
+#ifdef ENABLE_METRICS
+ArRequestHandlerFunction WiFiManager::timed(uint8_t route, ArRequestHandlerFunction onRequest) {
+  return [this, route, onRequest](AsyncWebServerRequest *request) {
+    // Admitted requests count from admission: the body upload or the wait.
+    uint32_t startedAt;
+    if (!_scheduler.arrivedAt(request, &startedAt)) startedAt = micros();
+    uint8_t outer = _metrics.enter(route);
+    onRequest(request);
+    _metrics.leave(outer);
+    AsyncWebServerResponse* response = request->getResponse();
+    _metrics.record(route, micros() - startedAt, response ? response->code() : 0, 0);
+  };
+}
+#endif
+
+#ifdef ENABLE_TRACE
+ArRequestHandlerFunction WiFiManager::traced(uint16_t tag, ArRequestHandlerFunction onRequest) {
+  return [tag, onRequest](AsyncWebServerRequest *request) {
+    WM_TRACE_SCOPE(tag);
+    onRequest(request);
+  };
+}
+#endif
+
+void WiFiManager::route(const char* uri, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest,
+                        ArUploadHandlerFunction onUpload, ArBodyHandlerFunction onBody) {
+#ifdef ENABLE_TRACE
+  // Upload and body chunks are spans of their own: that is where flash writes happen.
+  uint16_t tag = WmTrace::addTag(uri);
+  onRequest = traced(tag, onRequest);
+  if (onUpload) {
+    ArUploadHandlerFunction upload = onUpload;
+    onUpload = [tag, upload](AsyncWebServerRequest *request, const String& filename, size_t index, uint8_t *data,
+                             size_t len, bool final) {
+      WM_TRACE_SCOPE(tag);
+      upload(request, filename, index, data, len, final);
+    };
+  }
+  if (onBody) {
+    ArBodyHandlerFunction body = onBody;
+    onBody = [tag, body](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+      WM_TRACE_SCOPE(tag);
+      body(request, data, len, index, total);
+    };
+  }
+#endif
+#ifdef ENABLE_METRICS
+  uint8_t id = _metrics.addRoute(uri);
+  if (id != HttpMetrics::kNoRoute) {
+    onRequest = timed(id, onRequest);
+  }
+#endif
+  if (_config.admissionControl) {
+#ifndef ENABLE_METRICS
+    uint8_t id = 0;
+#endif
+    RequestClass cls = RequestScheduler::classify(uri);
+    if (cls == RequestClass::LIGHT) {
+      // Light requests never wait; they only time out queued heavy ones.
+      ArRequestHandlerFunction light = onRequest;
+      onRequest = [this, light](AsyncWebServerRequest *request) {
+        if (_scheduler.hasQueued()) expireQueued();
+        light(request);
+      };
+    } else {
+      // Requests with a body are admitted on their first chunk and cannot
+      // wait; a refusal is sent right away and the rest of the body ignored.
+      bool hasBody = onUpload || onBody;
+      std::shared_ptr<ArRequestHandlerFunction> heavy = std::make_shared<ArRequestHandlerFunction>(onRequest);
+      onRequest = [this, cls, id, hasBody, heavy](AsyncWebServerRequest *request) {
+        if (request->getResponse()) return;  // refused on its first chunk
+        if (_scheduler.isRunning(request) || admit(request, cls, id, hasBody ? nullptr : heavy.get())) {
+          (*heavy)(request);
+        }
+      };
+      if (onUpload) {
+        ArUploadHandlerFunction upload = onUpload;
+        onUpload = [this, cls, id, upload](AsyncWebServerRequest *request, const String& filename, size_t index,
+                                           uint8_t *data, size_t len, bool final) {
+          if (index == 0 && !request->getResponse() && !_scheduler.isRunning(request)) admit(request, cls, id, nullptr);
+          if (_scheduler.isRunning(request)) upload(request, filename, index, data, len, final);
+        };
+      }
+      if (onBody) {
+        ArBodyHandlerFunction body = onBody;
+        onBody = [this, cls, id, body](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index,
+                                       size_t total) {
+          if (index == 0 && !request->getResponse() && !_scheduler.isRunning(request)) admit(request, cls, id, nullptr);
+          if (_scheduler.isRunning(request)) body(request, data, len, index, total);
+        };
+      }
+    }
+  }
+  _server->on(uri, method, onRequest, onUpload, onBody);
+}
+
+// ----- Admission Control -----
+// Admission runs in handlers and release in onDisconnect, on the server task,
+// and so does expiry: a queued request is answered from the task that owns
+// it, never from loop(). Overdue requests are refused when the next request
+// arrives or a running one finishes.
+bool WiFiManager::admit(AsyncWebServerRequest *request, RequestClass cls, uint8_t route,
+                        const ArRequestHandlerFunction* deferred) {
+  uint32_t startedAt = micros();
+  if (_scheduler.hasQueued()) expireQueued();
+  switch (_scheduler.admit(request, cls, route, deferred, millis())) {
+    case RequestScheduler::RUN:
+      request->onDisconnect([this, request]() { releaseHeavy(request); });
+      return true;
+    case RequestScheduler::QUEUED:
+      request->onDisconnect([this, request]() { releaseHeavy(request); });
+      return false;
+    case RequestScheduler::THROTTLED:
+      refuse(request, cls, route, 429, startedAt);
+      return false;
+    default:
+      refuse(request, cls, route, 503, startedAt);
+      return false;
+  }
+}
+
+void WiFiManager::releaseHeavy(AsyncWebServerRequest *request) {
+  _scheduler.release(request, millis());
+  // Places came free: start the requests that waited longest and now fit.
+  const ArRequestHandlerFunction* handler;
+  while (AsyncWebServerRequest* next = _scheduler.next(&handler, millis())) (*handler)(next);
+  if (_scheduler.hasQueued()) expireQueued();
+}
+
+// Refusals never reach the timed handler; they are counted here.
+void WiFiManager::refuse(AsyncWebServerRequest *request, RequestClass cls, uint8_t route, int code,
+                         uint32_t startedAt) {
+  const char* body = code == 429 ? "{\"error\":\"Too many requests\"}" : "{\"error\":\"Busy\"}";
+  AsyncWebServerResponse* response = request->beginResponse(code, "application/json", body);
+  response->addHeader("Retry-After", String(_scheduler.retryAfter(cls)));
+  request->send(response);
+#ifdef ENABLE_METRICS
+  _metrics.record(route, micros() - startedAt, code, strlen(body));
+#endif
+}
+
+void WiFiManager::expireQueued() {
+  // Held while each request is answered, so its teardown (releaseHeavy) waits.
+  std::lock_guard<RequestScheduler> hold(_scheduler);
+  RequestClass cls;
+  uint8_t route;
+  uint32_t arrived;
+  while (AsyncWebServerRequest* request = _scheduler.expired(&cls, &route, &arrived, millis())) {
+    refuse(request, cls, route, 503, arrived);
+  }
+}
+
+void WiFiManager::onRequestEnd(AsyncWebServerRequest *request, const ArDisconnectHandler& fn) {
+  if (!_scheduler.chain(request, fn)) request->onDisconnect(fn);
+}
+
+void WiFiManager::setRequestClassLimits(RequestClass cls, uint8_t running, uint8_t queued) {
+  _scheduler.setLimits(cls, running, queued);
+}
+
+SchedulerStats WiFiManager::getSchedulerStats() const {
+  return _scheduler.stats();
+}
+
+CaptiveDNSStats WiFiManager::getDNSStats() const {
+  return _dns.stats();
+}
+
 void WiFiManager::handleScan(AsyncWebServerRequest *request) {
   #ifdef ENABLE_AUTH
   if (!checkAuthentication(request)) return;
   #endif
-  auto networks = scanNetworks(true);
-  String json = "[";
-  for (size_t i = 0; i < networks.size(); i++) {
-    json += "{";
-    json += "\"ssid\":\"" + networks[i].ssid + "\",";
-    json += "\"rssi\":" + String(networks[i].rssi) + ",";
-    json += "\"encryptionType\":" + String(networks[i].encryptionType);
-    json += "}";
-    if (i < networks.size()-1) json += ",";
+  // Never scans inline: answer from the cache and refresh it in the background
+  // when asked to (?refresh) or when it has gone stale.
+  auto snapshot = getScanSnapshot();
+  unsigned long now = millis();
+  if (request->hasParam("refresh") || !snapshot || now - snapshot->timestamp > _config.scanCacheTTL) {
+    startScan();
   }
-  json += "]";
-  request->send(200, "application/json", json);
+  bool scanning = _scanInProgress;
+  size_t count = snapshot ? snapshot->networks.size() : 0;
+  request->send(beginArenaJson(request, 200, [snapshot, scanning, now, count](JsonStreamWriter& json, size_t piece) {
+    if (piece == 0) {
+      json.beginObject();
+      if (snapshot) {
+        json.field("timestamp", snapshot->timestamp);
+        json.field("age_ms", now - snapshot->timestamp);
+      } else {
+        json.key("timestamp");
+        json.valueNull();
+        json.key("age_ms");
+        json.valueNull();
+      }
+      json.field("scanning", scanning);
+      json.key("networks");
+      json.beginArray();
+    } else if (piece <= count) {
+      const auto& net = snapshot->networks[piece - 1];
+      json.beginObject();
+      json.field("ssid", net.ssid);
+      json.field("rssi", net.rssi);
+      json.field("encryptionType", net.encryptionType);
+      json.endObject();
+    } else if (piece == count + 1) {
+      json.endArray();
+      json.endObject();
+    } else {
+      return false;
+    }
+    return true;
+  }));
 }
 
 void WiFiManager::handleConnect(AsyncWebServerRequest *request) {
@@ -522,17 +1563,17 @@ void WiFiManager::handleConnect(AsyncWebServerRequest *request) {
     if (request->hasParam("ssid", true) && request->hasParam("password", true)) {
       String ssid = request->getParam("ssid", true)->value();
       String password = request->getParam("password", true)->value();
-      debug("Connecting to AP: " + ssid);
-      bool connected = connectToNetwork(ssid.c_str(), password.c_str());
-      if (connected)
-        request->send(200, "application/json", "{\"result\":\"Connected\"}");
+      // The attempt runs from loop(); progress is reported by /status_json
+      // ("connect" object) and, with WebSockets, pushed as it changes.
+      if (beginConnect(ssid.c_str(), password.c_str()))
+        respond(request, 202, "application/json", "{\"result\":\"Connecting\"}");
       else
-        request->send(500, "application/json", "{\"result\":\"Connection Failed\"}");
+        respond(request, 409, "application/json", "{\"error\":\"Connection attempt already pending\"}");
     } else {
-      request->send(400, "application/json", "{\"error\":\"Missing parameters\"}");
+      respond(request, 400, "application/json", "{\"error\":\"Missing parameters\"}");
     }
   } else {
-    request->send(405, "application/json", "{\"error\":\"Method Not Allowed\"}");
+    respond(request, 405, "application/json", "{\"error\":\"Method Not Allowed\"}");
   }
 }
 
@@ -541,60 +1582,127 @@ void WiFiManager::handleReset(AsyncWebServerRequest *request) {
   if (!checkAuthentication(request)) return;
   #endif
   resetSettings();
-  request->send(200, "application/json", "{\"result\":\"Settings reset\"}");
+  respond(request, 200, "application/json", "{\"result\":\"Settings reset\"}");
 }
 
 void WiFiManager::handleNotFound(AsyncWebServerRequest *request) {
-  request->send(404, "application/json", "{\"error\":\"Not found\"}");
+  if (request->method() == HTTP_GET || request->method() == HTTP_HEAD) {
+    String path = request->url();
+    if (path.endsWith("/")) path += "index.html";
+    if (servePortalAsset(request, path)) return;
+  }
+  respond(request, 404, "application/json", "{\"error\":\"Not found\"}");
+}
+
+void WiFiManager::handleCaptiveProbe(AsyncWebServerRequest *request) {
+  AsyncWebServerResponse* response = request->beginResponse(302, "text/plain", "");
+  response->addHeader("Location", _portalUrl);
+  response->addHeader("Cache-Control", "no-store");
+  request->send(response);
 }
 
 void WiFiManager::handleStatusJSON(AsyncWebServerRequest *request) {
   #ifdef ENABLE_AUTH
   if (!checkAuthentication(request)) return;
   #endif
-  String json = "{";
-  json += "\"status\":\"" + getConnectionStatus() + "\",";
-  json += "\"ip\":\"" + WiFi.localIP().toString() + "\",";
-  json += "\"lastResult\":" + String(getLastConxResult()) + ",";
-  json += "\"ssid\":\"" + (WiFi.SSID().length() ? WiFi.SSID() : String("")) + "\",";
-  json += "\"rssi\":" + String(WiFi.status() == WL_CONNECTED ? WiFi.RSSI() : 0) + ",";
-  json += "\"params\":[";
-  for (size_t i = 0; i < _params.size(); i++) {
-    json += "{";
-    json += "\"id\":\"" + String(_params[i]->getID()) + "\",";
-    json += "\"label\":\"" + String(_params[i]->getLabel()) + "\",";
-    json += "\"value\":\"" + String(_params[i]->getValue()) + "\"";
+  // Radio state and parameters are sampled once so every chunk renders the
+  // same document.
+  struct Snapshot {
+    const char* status;
+    IPAddress ip;
+    uint8_t lastResult;
+    int32_t rssi;
+    char ssid[33];
+    ConnectState connect;
+    unsigned long connectMs;
+    uint8_t connectReason;
+    ConnectPath path;
+    unsigned long fastMs;
+    unsigned long normalMs;
+  } snap;
+  snap.status = getConnectionStatusText();
+  snap.ip = WiFi.localIP();
+  snap.lastResult = getLastConxResult();
+  snap.rssi = WiFi.status() == WL_CONNECTED ? WiFi.RSSI() : 0;
+  strlcpy(snap.ssid, WiFi.SSID().c_str(), sizeof(snap.ssid));
+  snap.connect = getConnectState();
+  snap.connectMs = getConnectDuration();
+  snap.connectReason = _connectFailReason;
+  snap.path = _connectPath;
+  snap.fastMs = getTimeToConnected(ConnectPath::FAST);
+  snap.normalMs = getTimeToConnected(ConnectPath::NORMAL);
+  RequestArena* arena = leaseArena(request);
+  const char* const* rows = snapshotParams(arena);
+  size_t count = rows ? _params.size() : 0;
+  request->send(beginArenaJson(request, arena, 200, [snap, rows, count](JsonStreamWriter& json, size_t piece) {
+    if (piece == 0) {
+      json.beginObject();
+      json.field("status", snap.status);
+      json.key("ip");
+      json.valueIP(snap.ip);
+      json.field("lastResult", snap.lastResult);
+      json.field("ssid", snap.ssid);
+      json.field("rssi", snap.rssi);
+      json.key("connect");
+      json.beginObject();
+      json.field("state", connectStateName(snap.connect));
+      json.field("elapsed_ms", snap.connectMs);
+      json.field("reason", snap.connectReason);
+      json.field("path", snap.path == ConnectPath::FAST ? "fast" : snap.path == ConnectPath::NORMAL ? "normal" : "none");
+      json.field("fast_ms", snap.fastMs);
+      json.field("normal_ms", snap.normalMs);
+      json.endObject();
+      json.key("params");
+      json.beginArray();
+    } else if (piece <= count) {
+      const char* const* row = rows + (piece - 1) * kParamColumns;
+      json.beginObject();
+      json.field("id", row[kParamId]);
+      json.field("label", row[kParamLabel]);
+      json.field("value", row[kParamValue]);
 #ifdef ENABLE_LOCALIZATION
-    json += ",\"group\":\"" + String(_params[i]->getGroup()) + "\"";
+      json.field("group", row[kParamGroup]);
 #endif
-    json += "}";
-    if (i < _params.size()-1) json += ",";
-  }
-  json += "]";
-  json += "}";
-  request->send(200, "application/json", json);
+      json.endObject();
+    } else if (piece == count + 1) {
+      json.endArray();
+      json.endObject();
+    } else {
+      return false;
+    }
+    return true;
+  }));
 }
 
 void WiFiManager::handleParamsJSON(AsyncWebServerRequest *request) {
   #ifdef ENABLE_AUTH
   if (!checkAuthentication(request)) return;
   #endif
-  String json = "[";
-  for (size_t i = 0; i < _params.size(); i++) {
-    json += "{";
-    json += "\"id\":\"" + String(_params[i]->getID()) + "\",";
-    json += "\"label\":\"" + String(_params[i]->getLabel()) + "\",";
-    json += "\"value\":\"" + String(_params[i]->getValue()) + "\",";
-    json += "\"type\":\"" + getInputTypeString(_params[i]->getType()) + "\",";
-    json += "\"attributes\":\"" + String(_params[i]->getCustomAttributes()) + "\"";
+  RequestArena* arena = leaseArena(request);
+  const char* const* rows = snapshotParams(arena);
+  size_t count = rows ? _params.size() : 0;
+  request->send(beginArenaJson(request, arena, 200, [rows, count](JsonStreamWriter& json, size_t piece) {
+    if (piece == 0) {
+      json.beginArray();
+    } else if (piece <= count) {
+      const char* const* row = rows + (piece - 1) * kParamColumns;
+      json.beginObject();
+      json.field("id", row[kParamId]);
+      json.field("label", row[kParamLabel]);
+      json.field("value", row[kParamValue]);
+      json.field("type", row[kParamType]);
+      json.field("attributes", row[kParamAttributes]);
 #ifdef ENABLE_LOCALIZATION
-    json += ",\"group\":\"" + String(_params[i]->getGroup()) + "\"";
+      json.field("group", row[kParamGroup]);
 #endif
-    json += "}";
-    if (i < _params.size()-1) json += ",";
-  }
-  json += "]";
-  request->send(200, "application/json", json);
+      json.endObject();
+    } else if (piece == count + 1) {
+      json.endArray();
+    } else {
+      return false;
+    }
+    return true;
+  }));
 }
 
 void WiFiManager::handleUpdateParams(AsyncWebServerRequest *request) {
@@ -602,73 +1710,327 @@ void WiFiManager::handleUpdateParams(AsyncWebServerRequest *request) {
   if (!checkAuthentication(request)) return;
   #endif
   if (request->method() == HTTP_POST) {
+    // One pass over the submitted fields, each dispatched through the id
+    // table; fields that are not parameters are ignored.
+    // getParam(i) walks the list from the head, so iterate it directly.
     bool updated = false;
-    for (size_t i = 0; i < _params.size(); i++) {
-      if (request->hasParam(_params[i]->getID(), true)) {
-        String newValue = request->getParam(_params[i]->getID(), true)->value();
-        _params[i]->setValue(newValue.c_str());
-        updated = true;
-        debug("Updated param: " + String(_params[i]->getID()) + " to " + newValue);
-      }
+    for (const AsyncWebParameter& field : request->getParams()) {
+      if (!field.isPost() || field.isFile()) continue;
+      WiFiManagerParameter* param = _params.find(field.name());
+      if (!param) continue;
+      param->setValue(field.value().c_str());
+      updated = true;
+      // Values may be secrets; only the id is logged.
+      if (_debug) debug("Updated param: " + field.name());
     }
     if (updated)
-      request->send(200, "application/json", "{\"result\":\"Custom fields updated\"}");
+      respond(request, 200, "application/json", "{\"result\":\"Custom fields updated\"}");
     else
-      request->send(400, "application/json", "{\"error\":\"No parameters updated\"}");
+      respond(request, 400, "application/json", "{\"error\":\"No parameters updated\"}");
   } else {
-    request->send(405, "application/json", "{\"error\":\"Method Not Allowed\"}");
+    respond(request, 405, "application/json", "{\"error\":\"Method Not Allowed\"}");
   }
 }
 
 #ifdef ENABLE_OTA
+// Progress messages on /ws are at most this frequent; start and end always go.
+static const unsigned long kOtaProgressMs = 250;
+
+// Upload/body callback: every chunk goes straight through the hash into
+// Update.write(). Runs on the web server task, in order, for one request.
+void WiFiManager::handleOTAChunk(AsyncWebServerRequest *request, size_t index, uint8_t *data, size_t len,
+                                 bool final, size_t total) {
+  if (index == 0) {
+#ifdef ENABLE_AUTH
+    // handleOTA() sends the challenge once the body has been read.
+    if (_useAuth && !request->authenticate(_portalUsername.c_str(), _portalPassword.c_str())) return;
+#endif
+    if (_otaRequest) return;  // handleOTA() answers 409
+    if (!_ota) _ota.reset(new OtaUpdate());
+    _otaRequest = request;
+    // Dropped mid-upload: release the updater so the next attempt can start.
+    onRequestEnd(request, [this, request]() {
+      if (_otaRequest != request) return;
+      _ota->abort();
+      _otaRequest = nullptr;
+      debug("OTA upload aborted by client.");
+      notifyOtaProgress();
+    });
+    const char* digest = "";
+    if (const AsyncWebHeader* h = request->getHeader("X-SHA256")) digest = h->value().c_str();
+    else if (const AsyncWebParameter* p = request->getParam("sha256")) digest = p->value().c_str();
+    else if (const AsyncWebParameter* p = request->getParam("sha256", true)) digest = p->value().c_str();
+    if (_ota->begin(total, digest)) debug("OTA update started.");
+    _otaLastProgress = millis();
+    notifyOtaProgress();
+  }
+  if (_otaRequest != request || !_ota->running()) return;
+  if (len) _ota->write(data, len);
+  if (final && _ota->running()) _ota->end();
+  if (!_ota->running() || millis() - _otaLastProgress >= kOtaProgressMs) {
+    _otaLastProgress = millis();
+    notifyOtaProgress();
+  }
+}
+
+void WiFiManager::notifyOtaProgress() {
+#ifdef ENABLE_WEBSOCKETS
+  if (!_ws || _ws->count() == 0) return;
+  const OtaUpdate& ota = *_ota;
+  sendWsJson(nullptr, [&ota](JsonStreamWriter& json) {
+    json.beginObject();
+    json.field("type", "ota");
+    json.field("state", ota.running() ? "writing" : ota.failed() ? "error" : "done");
+    json.field("written", ota.written());
+    json.key("total");
+    if (ota.size()) json.value(ota.size());
+    else json.valueNull();
+    json.field("elapsed_ms", ota.elapsedMs());
+    json.field("bytes_per_s", ota.bytesPerSecond());
+    if (ota.failed()) json.field("error", ota.error());
+    else if (!ota.running()) json.field("sha256", ota.digest());
+    json.endObject();
+  });
+#endif
+}
+
 void WiFiManager::handleOTA(AsyncWebServerRequest *request) {
   #ifdef ENABLE_AUTH
   if (!checkAuthentication(request)) return;
   #endif
-  debug("OTA update initiated (stub).");
-  request->send(200, "application/json", "{\"result\":\"OTA update initiated (stub)\"}");
+  if (!_otaRequest || _otaRequest != request) {
+    if (_otaRequest) respond(request, 409, "application/json", "{\"error\":\"Another update is in progress\"}");
+    else respond(request, 400, "application/json", "{\"error\":\"No firmware image\"}");
+    return;
+  }
+  _otaRequest = nullptr;
+  const OtaUpdate& ota = *_ota;
+  if (ota.running()) {
+    // Body ended without a final chunk (truncated multipart).
+    _ota->abort();
+  }
+  int code = !ota.failed() ? 200 : ota.digestRejected() ? 400 : 500;
+  if (ota.failed()) debug(String("OTA update failed: ") + ota.error());
+  else debug("OTA update written: " + String(ota.written()) + " bytes in " + String(ota.elapsedMs()) + " ms");
+  char buf[256];
+  JsonStreamWriter json(reinterpret_cast<uint8_t*>(buf), sizeof(buf));
+  json.beginObject();
+  if (ota.failed()) json.field("error", ota.error());
+  else json.field("result", "ok");
+  json.field("bytes", ota.written());
+  json.field("elapsed_ms", ota.elapsedMs());
+  json.field("bytes_per_s", ota.bytesPerSecond());
+  if (ota.digest()[0]) json.field("sha256", ota.digest());
+  json.field("reboot", !ota.failed() && _config.rebootAfterOTA);
+  json.endObject();
+  respond(request, code, "application/json", String(buf, json.written()));
+  if (!ota.failed() && _config.rebootAfterOTA) _otaRebootAt = (millis() + 1000) | 1;
 }
 #endif
 
 #ifdef ENABLE_FS_EXPLORER
+// Page size of /fs/list when no limit is given, and the largest one served.
+static const size_t kFsListDefaultLimit = 50;
+static const size_t kFsListMaxLimit = 200;
+
 void WiFiManager::handleFSList(AsyncWebServerRequest *request) {
   #ifdef ENABLE_AUTH
   if (!checkAuthentication(request)) return;
   #endif
-  String fileList = "[";
-  bool first = true;
-  File root = SPIFFS.open("/");
-  if (!root || !root.isDirectory()) {
-    request->send(500, "application/json", "{\"error\":\"Failed to open FS root\"}");
+  if (!_fsMounted) {
+    respond(request, 503, "application/json", "{\"error\":\"Filesystem not mounted\"}");
     return;
   }
-  File file = root.openNextFile();
-  while (file) {
-    if (!first) fileList += ",";
-    fileList += "{\"name\":\"" + String(file.name()) + "\",\"size\":" + String(file.size()) + "}";
-    first = false;
-    file = root.openNextFile();
+  size_t offset = 0;
+  size_t limit = kFsListDefaultLimit;
+  String prefix;
+  if (const AsyncWebParameter* p = request->getParam("offset")) {
+    long n = p->value().toInt();
+    offset = n > 0 ? n : 0;
+  }
+  if (const AsyncWebParameter* p = request->getParam("limit")) {
+    long n = p->value().toInt();
+    limit = n <= 0 ? kFsListDefaultLimit : n > (long)kFsListMaxLimit ? kFsListMaxLimit : n;
   }
-  fileList += "]";
-  request->send(200, "application/json", fileList);
+  if (const AsyncWebParameter* p = request->getParam("prefix")) {
+    prefix = p->value();
+    if (prefix.startsWith("/")) prefix = prefix.substring(1);
+  }
+  // The response holds on to this snapshot; uploads and deletes meanwhile
+  // swap in a new one.
+  std::shared_ptr<const FsIndex::Entries> entries = _fsIndex.entries();
+  size_t first, last;
+  FsIndex::prefixRange(*entries, prefix, first, last);
+  size_t total = last - first;
+  size_t begin = first + (offset < total ? offset : total);
+  size_t end = begin + limit < last ? begin + limit : last;
+  request->send(beginArenaJson(request, 200,
+    [entries, total, offset, limit, begin, end](JsonStreamWriter& json, size_t piece) {
+      size_t count = end - begin;
+      if (piece == 0) {
+        json.beginObject();
+        json.field("total", total);
+        json.field("offset", offset);
+        json.field("limit", limit);
+        json.key("files");
+        json.beginArray();
+      } else if (piece <= count) {
+        const FsEntry& entry = (*entries)[begin + piece - 1];
+        json.beginObject();
+        json.field("name", entry.name);
+        json.field("size", entry.size);
+        json.field("mtime", static_cast<uint32_t>(entry.mtime));
+        json.endObject();
+      } else if (piece == count + 1) {
+        json.endArray();
+        json.endObject();
+      } else {
+        return false;
+      }
+      return true;
+    }));
+}
+
+static const char kFsNoFile[] = "No file";
+static const char kFsBadFilename[] = "Invalid filename";
+
+WiFiManager::FsUploadSlot* WiFiManager::fsUploadSlot(AsyncWebServerRequest *request) {
+  for (FsUploadSlot& slot : _fsUploads) {
+    if (slot.request == request) return &slot;
+  }
+  return nullptr;
+}
+
+// Upload callback, once per chunk and file. Chunks go through the upload's
+// sector buffer; the handle stays open until the file's final chunk.
+void WiFiManager::handleFSUploadChunk(AsyncWebServerRequest *request, const String& filename, size_t index,
+                                      uint8_t *data, size_t len, bool final) {
+  FsUploadSlot* slot = fsUploadSlot(request);
+  if (!slot) {
+    if (index != 0 || !_fsMounted) return;
+#ifdef ENABLE_AUTH
+    // handleFSUpload() sends the challenge once the body has been read.
+    if (_useAuth && !request->authenticate(_portalUsername.c_str(), _portalPassword.c_str())) return;
+#endif
+    slot = fsUploadSlot(nullptr);
+    if (!slot) return;  // handleFSUpload() answers 503
+    slot->request = request;
+    slot->files = 0;
+    slot->bytes = 0;
+    slot->error = nullptr;
+    slot->startedAt = millis();
+    if (!slot->upload) slot->upload.reset(new FsUpload(SPIFFS));
+    // Dropped mid-upload: drop the temp file, keep the previous version.
+    onRequestEnd(request, [this, request]() {
+      FsUploadSlot* s = fsUploadSlot(request);
+      if (!s) return;
+      s->upload->abort();
+      s->request = nullptr;
+      debug("Upload aborted by client.");
+    });
+  }
+  if (slot->error) return;
+  FsUpload& upload = *slot->upload;
+  if (index == 0) {
+    if (filename.length() == 0 || filename.indexOf('/') >= 0) {
+      slot->error = kFsBadFilename;
+      return;
+    }
+    debug("Upload Start: " + filename);
+    if (!upload.begin("/" + filename)) {
+      slot->error = upload.error();
+      return;
+    }
+  }
+  if (!upload.running()) return;
+  if (len && !upload.write(data, len)) slot->error = upload.error();
+  if (final && upload.running()) {
+    if (upload.end()) {
+      _fsIndex.update(upload.path(), upload.written(), time(nullptr));
+      slot->files++;
+      slot->bytes += upload.written();
+      debug("Upload Complete: " + filename + " (" + String(upload.written()) + " bytes)");
+    } else {
+      slot->error = upload.error();
+    }
+  }
+}
+
+void WiFiManager::handleFSUpload(AsyncWebServerRequest *request) {
+  #ifdef ENABLE_AUTH
+  if (!checkAuthentication(request)) return;
+  #endif
+  FsUploadSlot* slot = fsUploadSlot(request);
+  if (!slot) {
+    if (!_fsMounted) respond(request, 503, "application/json", "{\"error\":\"Filesystem not mounted\"}");
+    else if (!fsUploadSlot(nullptr)) respond(request, 503, "application/json", "{\"error\":\"Too many uploads in progress\"}");
+    else respond(request, 400, "application/json", "{\"error\":\"No file\"}");
+    return;
+  }
+  slot->request = nullptr;
+  // Body ended without a final chunk (truncated multipart).
+  if (slot->upload->running()) slot->upload->abort();
+  if (!slot->error && slot->files == 0) slot->error = slot->upload->failed() ? slot->upload->error() : kFsNoFile;
+  char buf[160];
+  JsonStreamWriter json(reinterpret_cast<uint8_t*>(buf), sizeof(buf));
+  json.beginObject();
+  if (slot->error) json.field("error", slot->error);
+  else json.field("result", "ok");
+  json.field("files", slot->files);
+  json.field("bytes", slot->bytes);
+  json.field("elapsed_ms", millis() - slot->startedAt);
+  json.endObject();
+  int code = !slot->error ? 200 : slot->error == kFsNoFile || slot->error == kFsBadFilename ? 400 : 500;
+  respond(request, code, "application/json", String(buf, json.written()));
+  // The sector buffer is only held while an upload runs.
+  slot->upload.reset();
 }
 
 void WiFiManager::handleFSDelete(AsyncWebServerRequest *request) {
   #ifdef ENABLE_AUTH
   if (!checkAuthentication(request)) return;
   #endif
+  if (!_fsMounted) {
+    respond(request, 503, "application/json", "{\"error\":\"Filesystem not mounted\"}");
+    return;
+  }
   if (request->hasParam("path")) {
     String path = request->getParam("path")->value();
     if (SPIFFS.exists(path)) {
       SPIFFS.remove(path);
-      request->send(200, "application/json", "{\"result\":\"File deleted\"}");
+      _fsIndex.remove(path);
+      respond(request, 200, "application/json", "{\"result\":\"File deleted\"}");
       debug("Deleted file: " + path);
     } else {
-      request->send(404, "application/json", "{\"error\":\"File not found\"}");
+      respond(request, 404, "application/json", "{\"error\":\"File not found\"}");
     }
   } else {
-    request->send(400, "application/json", "{\"error\":\"Missing path parameter\"}");
+    respond(request, 400, "application/json", "{\"error\":\"Missing path parameter\"}");
+  }
+}
+
+void WiFiManager::handleFSDownload(AsyncWebServerRequest *request) {
+  #ifdef ENABLE_AUTH
+  if (!checkAuthentication(request)) return;
+  #endif
+  if (!_fsMounted) {
+    respond(request, 503, "application/json", "{\"error\":\"Filesystem not mounted\"}");
+    return;
+  }
+  if (!request->hasParam("path")) {
+    respond(request, 400, "application/json", "{\"error\":\"Missing path parameter\"}");
+    return;
+  }
+  String path = request->getParam("path")->value();
+  if (!path.startsWith("/")) path = "/" + path;
+  File file = SPIFFS.exists(path) ? SPIFFS.open(path, FILE_READ) : File();
+  if (!file || file.isDirectory()) {
+    respond(request, 404, "application/json", "{\"error\":\"File not found\"}");
+    return;
   }
+  char etag[24];
+  fileETag(file, etag, sizeof(etag));
+  charge(sendFile(request, file, path, etag, "no-cache", true));
 }
 #endif
 
@@ -677,41 +2039,188 @@ void WiFiManager::handleBackup(AsyncWebServerRequest *request) {
   #ifdef ENABLE_AUTH
   if (!checkAuthentication(request)) return;
   #endif
-  String backup = "{";
+  // Both forms show what was current when the request started: a restore,
+  // update or credential change landing while the response drains cannot
+  // mix into it or shift its rows.
+  RequestArena* arena = leaseArena(request);
+  const char* const* params = snapshotParams(arena);
+  size_t paramCount = params ? _params.size() : 0;
+  bool complete = params != nullptr;
+  const char* const* creds = nullptr;
+  const int* priorities = nullptr;
+  size_t credCount = 0;
 #ifdef ENABLE_MULTI_CRED
-  backup += "\"wifi_credentials\":[";
-  for (size_t i = 0; i < _wifiCredentials.size(); i++) {
-    backup += "{\"ssid\":\"" + _wifiCredentials[i].ssid + "\",\"password\":\"" + _wifiCredentials[i].password + "\"}";
-    if (i < _wifiCredentials.size()-1) backup += ",";
+  if (arena) {
+    creds = arena->copyStrings<2>(_wifiCredentials.size(), [this](size_t i, const char** cells) {
+      cells[0] = _wifiCredentials[i].ssid.c_str();
+      cells[1] = _wifiCredentials[i].password.c_str();
+    });
+    int* copied = static_cast<int*>(arena->allocate(_wifiCredentials.size() * sizeof(int), alignof(int)));
+    if (copied) {
+      for (size_t i = 0; i < _wifiCredentials.size(); i++) copied[i] = _wifiCredentials[i].priority;
+      priorities = copied;
+    }
+    credCount = creds && priorities ? _wifiCredentials.size() : 0;
+  }
+  complete = complete && creds && priorities;
+#endif
+  const AsyncWebParameter* format = request->getParam("format");
+  if (format && format->value() == "bin") {
+    // Encoded one record at a time from the snapshot as the connection
+    // drains. A partial snapshot would still carry a valid CRC, so none goes.
+    BackupEncoder* encoder = complete ? arena->make<BackupEncoder>(
+      [params, paramCount, creds, priorities, credCount](size_t index, BackupRecord& record) {
+        if (index < credCount) {
+          record = BackupRecord{BackupRecord::CREDENTIAL, creds[index * 2], creds[index * 2 + 1], priorities[index]};
+          return true;
+        }
+        index -= credCount;
+        if (index >= paramCount) return false;
+        const char* const* row = params + index * kParamColumns;
+        record = BackupRecord{BackupRecord::PARAMETER, row[kParamId], row[kParamValue], 0};
+        return true;
+      }) : nullptr;
+    if (!encoder) {
+      respond(request, 503, "application/json", "{\"error\":\"Out of memory\"}");
+      return;
+    }
+    AsyncWebServerResponse* response = request->beginChunkedResponse("application/octet-stream",
+      [encoder](uint8_t* buffer, size_t maxLen, size_t index) -> size_t { return encoder->read(buffer, maxLen); });
+    response->addHeader("Content-Disposition", "attachment; filename=\"wifimanager.bak\"");
+    request->send(response);
+    return;
   }
-  backup += "],";
+  // Pieces: the header, a row per credential, the "parameters" key, a row per
+  // parameter, the closing brackets.
+  request->send(beginArenaJson(request, arena, 200,
+    [params, paramCount, creds, priorities, credCount](JsonStreamWriter& json, size_t piece) {
+      if (piece == 0) {
+        json.beginObject();
+#ifdef ENABLE_MULTI_CRED
+        json.key("wifi_credentials");
+        json.beginArray();
 #endif
-  backup += "\"parameters\":[";
-  for (size_t i = 0; i < _params.size(); i++) {
-    backup += "{\"id\":\"" + String(_params[i]->getID()) + "\",\"label\":\"" + String(_params[i]->getLabel()) +
-              "\",\"value\":\"" + String(_params[i]->getValue()) + "\"";
+      } else if (piece <= credCount) {
+        const char* const* row = creds + (piece - 1) * 2;
+        json.beginObject();
+        json.field("ssid", row[0]);
+        json.field("password", row[1]);
+        json.field("priority", priorities[piece - 1]);
+        json.endObject();
+      } else if (piece == credCount + 1) {
+#ifdef ENABLE_MULTI_CRED
+        json.endArray();
+#endif
+        json.key("parameters");
+        json.beginArray();
+      } else if (piece <= credCount + 1 + paramCount) {
+        const char* const* row = params + (piece - credCount - 2) * kParamColumns;
+        json.beginObject();
+        json.field("id", row[kParamId]);
+        json.field("label", row[kParamLabel]);
+        json.field("value", row[kParamValue]);
 #ifdef ENABLE_LOCALIZATION
-    backup += ",\"group\":\"" + String(_params[i]->getGroup()) + "\"";
+        json.field("group", row[kParamGroup]);
+#endif
+        json.endObject();
+      } else if (piece == credCount + paramCount + 2) {
+        json.endArray();
+        json.endObject();
+      } else {
+        return false;
+      }
+      return true;
+    }));
+}
+
+// Body/upload callback: bytes go straight into the decoder, which keeps at
+// most one record.
+void WiFiManager::handleRestoreChunk(AsyncWebServerRequest *request, size_t index, uint8_t *data, size_t len) {
+  if (index == 0) {
+#ifdef ENABLE_AUTH
+    // handleRestore() sends the challenge once the body has been read.
+    if (_useAuth && !request->authenticate(_portalUsername.c_str(), _portalPassword.c_str())) return;
 #endif
-    backup += "}";
-    if (i < _params.size()-1) backup += ",";
+    if (_restoreRequest) return;  // handleRestore() answers 409
+    if (!_restore) _restore.reset(new BackupDecoder());
+    _restore->reset();
+    _restoreRequest = request;
+    onRequestEnd(request, [this, request]() {
+      if (_restoreRequest == request) _restoreRequest = nullptr;
+    });
   }
-  backup += "]";
-  backup += "}";
-  request->send(200, "application/json", backup);
+  if (_restoreRequest == request && len) _restore->write(data, len);
+}
+
+// Every record is checked before anything changes, so a restore applies all
+// fields or none. Returns an error, or nullptr once applied.
+const char* WiFiManager::applyBackup(const std::vector<BackupRecord>& records) {
+#ifdef ENABLE_MULTI_CRED
+  std::vector<WiFiCredential> credentials;
+#endif
+  std::vector<std::pair<WiFiManagerParameter*, const char*>> values;
+  for (const BackupRecord& record : records) {
+    if (record.type == BackupRecord::CREDENTIAL) {
+#ifdef ENABLE_MULTI_CRED
+      if (record.key.length() == 0 || record.key.length() > 32 || record.value.length() > 64) {
+        return "Invalid credential";
+      }
+      credentials.push_back(WiFiCredential{record.key, record.value, record.priority});
+      continue;
+#else
+      return "Credentials not supported";
+#endif
+    }
+    WiFiManagerParameter* param = _params.find(record.key);
+    if (!param) {
+      debug("Restore: unknown parameter " + record.key);
+      return "Unknown parameter";
+    }
+    if (!param->accepts(record.value.c_str())) {
+      debug("Restore: invalid value for " + record.key);
+      return "Invalid parameter value";
+    }
+    values.push_back(std::make_pair(param, record.value.c_str()));
+  }
+#ifdef ENABLE_MULTI_CRED
+  _wifiCredentials.swap(credentials);
+#endif
+  for (auto& value : values) value.first->setValue(value.second);
+  if (_saveConfigCallback) _saveConfigCallback();
+  return nullptr;
 }
 
 void WiFiManager::handleRestore(AsyncWebServerRequest *request) {
   #ifdef ENABLE_AUTH
   if (!checkAuthentication(request)) return;
   #endif
-  if (request->hasParam("backup", true)) {
-    String backup = request->getParam("backup", true)->value();
-    debug("Restore configuration (stub): " + backup);
-    request->send(200, "application/json", "{\"result\":\"Restore initiated (stub)\"}");
+  if (_restoreRequest != request) {
+    if (_restoreRequest) respond(request, 409, "application/json", "{\"error\":\"Another restore is in progress\"}");
+    else respond(request, 400, "application/json", "{\"error\":\"Missing backup data\"}");
+    return;
+  }
+  _restoreRequest = nullptr;
+  const char* error = _restore->finish() ? applyBackup(_restore->records()) : _restore->error();
+  size_t credentials = 0, parameters = 0;
+  for (const BackupRecord& record : _restore->records()) {
+    if (record.type == BackupRecord::CREDENTIAL) credentials++;
+    else parameters++;
+  }
+  _restore.reset();
+  char buf[128];
+  JsonStreamWriter json(reinterpret_cast<uint8_t*>(buf), sizeof(buf));
+  json.beginObject();
+  if (error) {
+    json.field("error", error);
   } else {
-    request->send(400, "application/json", "{\"error\":\"Missing backup data\"}");
+    json.field("result", "ok");
+    json.field("credentials", credentials);
+    json.field("parameters", parameters);
   }
+  json.endObject();
+  if (error) debug(String("Restore rejected: ") + error);
+  else debug("Configuration restored.");
+  respond(request, error ? 400 : 200, "application/json", String(buf, json.written()));
 }
 #endif
 
@@ -719,16 +2228,263 @@ void WiFiManager::handleDeviceInfo(AsyncWebServerRequest *request) {
   #ifdef ENABLE_AUTH
   if (!checkAuthentication(request)) return;
   #endif
-  String info = "{";
-  #if defined(USING_ESP32)
-    info += "\"free_heap\":" + String(ESP.getFreeHeap()) + ",";
+  struct Snapshot {
+    HeapTelemetry heap;
+    ArenaStats arenas;
+    SchedulerStats scheduler;
+    CaptiveDNSStats dns;
+    bool dnsRunning;
+    unsigned long uptime;
+    int32_t rssi;
+    IPAddress ip;
+  } snap;
+  snap.heap = getHeapTelemetry();
+  snap.arenas = getArenaStats();
+  snap.scheduler = getSchedulerStats();
+  snap.dns = getDNSStats();
+  snap.dnsRunning = _dns.running();
+  snap.uptime = millis();
+  snap.rssi = WiFi.RSSI();
+  snap.ip = WiFi.localIP();
+  // Small and fixed in size: one piece.
+  request->send(beginArenaJson(request, 200, [snap](JsonStreamWriter& json, size_t piece) {
+    if (piece) return false;
+    json.beginObject();
+    #if defined(USING_ESP32) || defined(USING_NATIVE_SIM)
+      json.field("free_heap", snap.heap.freeHeap);
+      json.key("heap");
+      json.beginObject();
+      json.field("free", snap.heap.freeHeap);
+      json.field("min_free", snap.heap.minFreeHeap);
+      json.field("largest_block", snap.heap.largestBlock);
+      json.field("min_largest_block", snap.heap.minLargestBlock);
+      json.key("largest_block_history");
+      json.beginArray();
+      for (uint8_t i = 0; i < snap.heap.samples; i++) json.value(snap.heap.history[i]);
+      json.endArray();
+      json.endObject();
+    #endif
+    json.key("arenas");
+    json.beginObject();
+    json.field("count", snap.arenas.arenas);
+    json.field("size", snap.arenas.arenaSize);
+    json.field("in_use", snap.arenas.inUse);
+    json.field("leases", snap.arenas.leases);
+    json.field("high_water", snap.arenas.highWater);
+    json.field("exhausted", snap.arenas.exhausted);
+    json.field("fallbacks", snap.arenas.fallbacks);
+    json.field("fallback_bytes", snap.arenas.fallbackBytes);
+    json.endObject();
+    json.key("scheduler");
+    json.beginObject();
+    json.field("running", snap.scheduler.running);
+    json.field("limit", snap.scheduler.totalLimit);
+    for (const RequestClassStats& c : snap.scheduler.classes) {
+      json.key(c.name);
+      json.beginObject();
+      json.field("limit", c.limit);
+      json.field("queue_limit", c.queueLimit);
+      json.field("running", c.running);
+      json.field("queued", c.queued);
+      json.field("max_queued", c.maxQueued);
+      json.field("admitted", c.admitted);
+      json.field("deferred", c.deferred);
+      json.field("busy", c.busy);
+      json.field("throttled", c.throttled);
+      json.field("expired", c.expired);
+      json.field("hold_ms", c.holdMillis);
+      json.endObject();
+    }
+    json.endObject();
+    json.key("dns");
+    json.beginObject();
+    json.field("running", snap.dnsRunning);
+    json.field("queries", snap.dns.queries);
+    json.field("answers", snap.dns.answers);
+    json.field("dropped", snap.dns.dropped);
+    json.endObject();
+    json.field("uptime_ms", snap.uptime);
+    json.field("rssi", snap.rssi);
+    json.key("ip");
+    json.valueIP(snap.ip);
+    json.endObject();
+    return true;
+  }));
+}
+
+#ifdef ENABLE_METRICS
+void WiFiManager::handleMetrics(AsyncWebServerRequest *request) {
+  #ifdef ENABLE_AUTH
+  if (!checkAuthentication(request)) return;
   #endif
-  info += "\"uptime_ms\":" + String(millis()) + ",";
-  info += "\"rssi\":" + String(WiFi.RSSI()) + ",";
-  info += "\"ip\":\"" + WiFi.localIP().toString() + "\"";
-  info += "}";
-  request->send(200, "application/json", info);
+  // Captured once: the exposition is rendered again for every chunk.
+  struct Snapshot {
+    std::vector<HttpMetrics::RouteSnapshot> routes;
+    HeapTelemetry heap;
+    SchedulerStats scheduler;
+    CaptiveDNSStats dns;
+    size_t wsClients;
+    uint8_t apStations;
+    unsigned long scanDuration;
+    bool scanned;
+    unsigned long uptime;
+    uint8_t route;
+  };
+  auto snap = std::make_shared<Snapshot>();
+  _metrics.snapshot(snap->routes);
+  snap->heap = getHeapTelemetry();
+  snap->scheduler = getSchedulerStats();
+  snap->dns = getDNSStats();
+  snap->wsClients = 0;
+#ifdef ENABLE_WEBSOCKETS
+  if (_ws) snap->wsClients = _ws->count();
+#endif
+  snap->apStations = WiFi.softAPgetStationNum();
+  auto scan = getScanSnapshot();
+  snap->scanned = static_cast<bool>(scan);
+  snap->scanDuration = scan ? scan->duration : 0;
+  snap->uptime = millis();
+  snap->route = _metrics.current();
+  request->send(request->beginChunkedResponse("text/plain; version=0.0.4; charset=utf-8",
+    [this, snap](uint8_t* buffer, size_t maxLen, size_t index) -> size_t {
+      MetricsWriter out(buffer, maxLen, index);
+      out.family("wm_http_requests_total", "counter", "HTTP requests handled, by route.");
+      for (const auto& r : snap->routes) out.sample("wm_http_requests_total", r.route, nullptr, r.requests);
+      out.family("wm_http_errors_total", "counter", "HTTP responses with status 400 or above, by route.");
+      for (const auto& r : snap->routes) out.sample("wm_http_errors_total", r.route, nullptr, r.errors);
+      out.family("wm_http_response_bytes_total", "counter", "HTTP response body bytes, by route.");
+      for (const auto& r : snap->routes) out.sample("wm_http_response_bytes_total", r.route, nullptr, r.bytes);
+      out.family("wm_http_request_duration_seconds", "histogram",
+                 "From the first request callback until the response is queued, by route.");
+      for (const auto& r : snap->routes) out.histogram("wm_http_request_duration_seconds", r);
+      char labels[40];
+      out.family("wm_http_running", "gauge", "Heavy requests running, by class.");
+      for (const auto& c : snap->scheduler.classes) {
+        snprintf(labels, sizeof(labels), "class=\"%s\"", c.name);
+        out.labeled("wm_http_running", labels, c.running);
+      }
+      out.family("wm_http_queue_depth", "gauge", "Heavy requests waiting for admission, by class.");
+      for (const auto& c : snap->scheduler.classes) {
+        snprintf(labels, sizeof(labels), "class=\"%s\"", c.name);
+        out.labeled("wm_http_queue_depth", labels, c.queued);
+      }
+      out.family("wm_http_rejected_total", "counter", "Heavy requests refused by admission control, by class and status.");
+      for (const auto& c : snap->scheduler.classes) {
+        snprintf(labels, sizeof(labels), "class=\"%s\",code=\"503\"", c.name);
+        out.labeled("wm_http_rejected_total", labels, c.busy + c.expired);
+        snprintf(labels, sizeof(labels), "class=\"%s\",code=\"429\"", c.name);
+        out.labeled("wm_http_rejected_total", labels, c.throttled);
+      }
+#if defined(USING_ESP32) || defined(USING_NATIVE_SIM)
+      out.family("wm_heap_free_bytes", "gauge", "Free heap.");
+      out.sample("wm_heap_free_bytes", nullptr, nullptr, snap->heap.freeHeap);
+      out.family("wm_heap_min_free_bytes", "gauge", "Lowest free heap since boot.");
+      out.sample("wm_heap_min_free_bytes", nullptr, nullptr, snap->heap.minFreeHeap);
+      out.family("wm_heap_largest_free_block_bytes", "gauge", "Largest allocatable heap block.");
+      out.sample("wm_heap_largest_free_block_bytes", nullptr, nullptr, snap->heap.largestBlock);
+#endif
+      out.family("wm_dns_queries_total", "counter", "Captive DNS queries received.");
+      out.sample("wm_dns_queries_total", nullptr, nullptr, snap->dns.queries);
+      out.family("wm_dns_dropped_total", "counter", "Captive DNS queries dropped as malformed.");
+      out.sample("wm_dns_dropped_total", nullptr, nullptr, snap->dns.dropped);
+      out.family("wm_websocket_clients", "gauge", "Connected /ws clients.");
+      out.sample("wm_websocket_clients", nullptr, nullptr, snap->wsClients);
+      out.family("wm_softap_stations", "gauge", "Stations associated with the portal access point.");
+      out.sample("wm_softap_stations", nullptr, nullptr, snap->apStations);
+      if (snap->scanned) {
+        out.family("wm_wifi_scan_duration_seconds", "gauge", "Duration of the last completed network scan.");
+        out.seconds("wm_wifi_scan_duration_seconds", nullptr, static_cast<uint64_t>(snap->scanDuration) * 1000);
+      }
+      out.family("wm_uptime_seconds", "gauge", "Time since boot.");
+      out.seconds("wm_uptime_seconds", nullptr, static_cast<uint64_t>(snap->uptime) * 1000);
+      _metrics.addBytes(snap->route, out.written());
+      return out.written();
+    }));
 }
+#endif
+
+#ifdef ENABLE_TRACE
+void WiFiManager::handleTrace(AsyncWebServerRequest *request) {
+  #ifdef ENABLE_AUTH
+  if (!checkAuthentication(request)) return;
+  #endif
+  struct Snapshot {
+    std::vector<TraceEvent> events;
+    uint32_t dropped;
+    uint32_t base;       // earliest timestamp, exported as ts 0
+    uint8_t tasks;
+  };
+  auto snap = std::make_shared<Snapshot>();
+  snap->dropped = WmTrace::snapshot(snap->events);
+  snap->base = snap->events.empty() ? 0 : snap->events[0].micros;
+  snap->tasks = 0;
+  // Spans written after the fact (span()) can start before the oldest slot,
+  // and an end whose begin was overwritten has nothing to close, so it is dropped.
+  uint8_t depth[WmTrace::kMaxTasks] = {};
+  std::vector<TraceEvent> kept;
+  kept.reserve(snap->events.size());
+  for (const TraceEvent& e : snap->events) {
+    if (static_cast<int32_t>(e.micros - snap->base) < 0) snap->base = e.micros;
+    if (e.task >= snap->tasks) snap->tasks = e.task + 1;
+    if (e.meta & kTraceBegin) depth[e.task]++;
+    else if (depth[e.task]) depth[e.task]--;
+    else continue;
+    kept.push_back(e);
+  }
+  snap->events.swap(kept);
+  // Pieces: the header, a name per task, an event each, the trailer.
+  request->send(beginArenaJson(request, 200, [snap](JsonStreamWriter& json, size_t piece) {
+    size_t tasks = snap->tasks;
+    size_t events = snap->events.size();
+    if (piece == 0) {
+      json.beginObject();
+      json.key("traceEvents");
+      json.beginArray();
+    } else if (piece <= tasks) {
+      uint8_t t = piece - 1;
+      json.beginObject();
+      json.field("name", "thread_name");
+      json.field("ph", "M");
+      json.field("pid", 1);
+      json.field("tid", t);
+      json.key("args");
+      json.beginObject();
+      json.field("name", WmTrace::taskName(t));
+      json.endObject();
+      json.endObject();
+    } else if (piece <= tasks + events) {
+      const TraceEvent& e = snap->events[piece - tasks - 1];
+      bool begin = e.meta & kTraceBegin;
+      json.beginObject();
+      json.field("name", WmTrace::tagName(e.tag));
+      json.field("cat", "wm");
+      json.field("ph", begin ? "B" : "E");
+      json.field("ts", static_cast<uint32_t>(e.micros - snap->base));
+      json.field("pid", 1);
+      json.field("tid", e.task);
+      if (begin) {
+        json.key("args");
+        json.beginObject();
+        json.field("core", e.meta & ~kTraceBegin);
+        json.endObject();
+      }
+      json.endObject();
+    } else if (piece == tasks + events + 1) {
+      json.endArray();
+      json.field("displayTimeUnit", "ms");
+      json.key("otherData");
+      json.beginObject();
+      json.field("dropped", snap->dropped);
+      json.field("capacity", WM_TRACE_EVENTS);
+      json.endObject();
+      json.endObject();
+    } else {
+      return false;
+    }
+    return true;
+  }));
+}
+#endif
 
 #ifdef ENABLE_TERMINAL
 void WiFiManager::handleTerminal(AsyncWebServerRequest *request) {
@@ -739,7 +2495,7 @@ void WiFiManager::handleTerminal(AsyncWebServerRequest *request) {
   page += "<h1>Terminal (stub)</h1>";
   page += "<p>This is a stub for an interactive terminal interface.</p>";
   page += "</body></html>";
-  request->send(200, "text/html", page);
+  respond(request, 200, "text/html", page);
 }
 #endif
 
@@ -753,10 +2509,11 @@ bool WiFiManager::startAPMode(const char* apName, const char* apPassword) {
 }
 
 #ifdef ENABLE_MULTI_CRED
-bool WiFiManager::addWiFiCredential(const char* ssid, const char* password) {
+bool WiFiManager::addWiFiCredential(const char* ssid, const char* password, int priority) {
   WiFiCredential cred;
   cred.ssid = ssid;
   cred.password = password;
+  cred.priority = priority;
   _wifiCredentials.push_back(cred);
   debug("Added WiFi credential: " + String(ssid));
   return true;
@@ -777,6 +2534,41 @@ AsyncWebSocket* WiFiManager::getWebSocket() {
 #endif
 
 // ----- Internal Helper Methods -----
+// Embedded assets win; SPIFFS still serves anything else, e.g. uploads.
+bool WiFiManager::servePortalAsset(AsyncWebServerRequest *request, const String& path) {
+  size_t sent = 0;
+  if (!sendEmbeddedAsset(request, _embeddedAssets, _embeddedAssetCount, path, &sent) &&
+      !(_fsMounted && sendPortalAsset(request, SPIFFS, path, &sent))) {
+    return false;
+  }
+  charge(sent);
+  return true;
+}
+
+void WiFiManager::respond(AsyncWebServerRequest *request, int code, const char* contentType, const String& body) {
+  request->send(code, contentType, body);
+  charge(body.length());
+}
+
+void WiFiManager::charge(size_t bytes) {
+#ifdef ENABLE_METRICS
+  _metrics.addBytes(_metrics.current(), bytes);
+#else
+  (void)bytes;
+#endif
+}
+
 void WiFiManager::startDNS() {
-  _dnsServer.start(53, "*", WiFi.softAPIP());
+  IPAddress ap = WiFi.softAPIP();
+  bool https = false;
+#if defined(ENABLE_HTTPS) && defined(HAS_ASYNC_WEBSERVER_SECURE)
+  https = _useHTTPS;
+#endif
+  // The port only when it is not the scheme's default (0 binds any port).
+  uint16_t port = _config.httpPort;
+  char portText[7] = "";
+  if (port && port != (https ? 443 : 80)) snprintf(portText, sizeof(portText), ":%u", port);
+  snprintf(_portalUrl, sizeof(_portalUrl), "%s://%u.%u.%u.%u%s/", https ? "https" : "http", ap[0], ap[1], ap[2],
+           ap[3], portText);
+  if (!_dns.begin(ap)) debug("Captive DNS could not start.");
 }
@@ -25,14 +25,33 @@
   #include <SPIFFS.h>
   #include <AsyncTCP.h>
   #include <ESPAsyncWebServer.h>
+#elif defined(NATIVE_SIM)
+  // Host build on top of lib/NativeSim (see [env:native]).
+  #define USING_NATIVE_SIM
+  #include <WiFi.h>
+  #include <ESPmDNS.h>
+  #include <SPIFFS.h>
+  #include <AsyncTCP.h>
+  #include <ESPAsyncWebServer.h>
 #else
   #error "This library targets ESP32 family only."
 #endif
 
-#include <DNSServer.h>
+#include <Preferences.h>
+#include <atomic>
+#include <memory>
 #include <vector>
 #include <functional>
 #include "WiFiManagerParameter.h"
+#include "WiFiManagerParamRegistry.h"
+#include "WiFiManagerParamSchema.h"
+#include "WiFiManagerArena.h"
+#include "WiFiManagerDNS.h"
+#include "WiFiManagerScheduler.h"
+#include "WiFiManagerTrace.h"
+
+struct EmbeddedAsset;  // WiFiManagerAssets.h
+class JsonStreamWriter;  // WiFiManagerJson.h
 
 // Build modes removed; always provide full UI+API via feature flags.
 
@@ -51,19 +70,78 @@
   #include <AsyncWebSocket.h>
 #endif
 
+#ifdef ENABLE_SERIAL_MONITOR
+  #include "WiFiManagerSerial.h"
+#endif
+
+#ifdef ENABLE_OTA
+  #include "WiFiManagerOta.h"
+#endif
+
+#ifdef ENABLE_BACKUP_RESTORE
+  #include "WiFiManagerBackup.h"
+#endif
+
+#ifdef ENABLE_FS_EXPLORER
+  #include "WiFiManagerFsUpload.h"
+  #include "WiFiManagerFsIndex.h"
+#endif
+
+#ifdef ENABLE_METRICS
+  #include "WiFiManagerMetrics.h"
+#endif
+
 // Network scan result structure
 struct WiFiNetwork {
   String ssid;
   int32_t rssi;
   uint8_t encryptionType;
+  int32_t channel;
+  uint8_t bssid[6];
+};
+
+// Progress of the non-blocking connect state machine (see beginConnect()).
+enum class ConnectState : uint8_t {
+  IDLE,        // no attempt since boot
+  CONNECTING,  // associating / waiting for an address
+  CONNECTED,   // last attempt obtained an IP
+  FAILED       // every candidate was rejected or timed out
+};
+
+// How the last autoConnect() got online.
+enum class ConnectPath : uint8_t {
+  NONE,
+  FAST,    // cached BSSID/channel with the previous DHCP lease as static IP
+  NORMAL   // scan/probe + DHCP
+};
+
+// Heap headroom over time: the largest free block is what TLS and OTA need,
+// and it shrinks as the heap fragments even when the free total does not.
+struct HeapTelemetry {
+  static const uint8_t kHistory = 16;
+  uint32_t freeHeap;
+  uint32_t largestBlock;
+  uint32_t minFreeHeap;      // since boot
+  uint32_t minLargestBlock;  // lowest sampled
+  uint32_t history[kHistory];  // largest block per heapSampleInterval, oldest first
+  uint8_t samples;             // valid entries in history
 };
 
 // ---------- Configuration Structure ----------
 struct WiFiManagerConfig {
   uint16_t httpPort = 80;
-  unsigned long connectTimeout = 10000;       // in milliseconds
+  unsigned long connectTimeout = 10000;       // in milliseconds, per candidate network
   unsigned long configPortalTimeout = 180000;   // in milliseconds
+  unsigned long scanCacheTTL = 30000;           // in milliseconds; older scan results trigger a background rescan
   bool autoReconnect = true;
+  bool fastReconnect = true;                    // rejoin the last BSSID with its cached lease first (NVS)
+  bool mountFilesystem = true;                  // false skips SPIFFS at boot; needs embedded assets for the UI
+  uint8_t requestArenas = 0;                    // per-request arenas for JSON handlers (0 = off, max 32)
+  uint16_t requestArenaSize = 1024;             // bytes per arena, allocated once in begin()
+  unsigned long heapSampleInterval = 60000;     // in milliseconds; largest-free-block history period
+  bool admissionControl = true;                 // cap and queue the heavy routes (see WiFiManagerScheduler.h)
+  uint8_t maxHeavyRequests = 3;                 // heavy requests running at once over all classes (0 = no cap)
+  unsigned long heavyQueueTimeout = 5000;       // in milliseconds; a heavy request queued longer gets 503
 #ifdef ENABLE_AUTH
   bool useAuth = false;
   String portalUsername = "";
@@ -73,6 +151,9 @@ struct WiFiManagerConfig {
   bool enableSerialMonitor = false;
   unsigned int serialMonitorBufferSize = 5000;
 #endif
+#ifdef ENABLE_OTA
+  bool rebootAfterOTA = true;                   // restart into the new image once /ota succeeds
+#endif
 };
 
 /// Structure for multi-credential support.
@@ -80,6 +161,7 @@ struct WiFiManagerConfig {
 struct WiFiCredential {
   String ssid;
   String password;
+  int priority;  // higher wins over a stronger signal
 };
 #endif
 
@@ -97,6 +179,16 @@ public:
   bool startConfigPortal(const char* apName, const char* apPassword = nullptr);
   void stopConfigPortal();
   bool connectToNetwork(const char* ssid, const char* password);
+  // Queues a connection attempt and returns at once; loop() drives it and
+  // getConnectState() reports the outcome. Safe to call from web handlers.
+  bool beginConnect(const char* ssid, const char* password);
+  ConnectState getConnectState() const;
+  unsigned long getConnectDuration() const;
+  // Time-to-connected of the last autoConnect() that succeeded on `path`,
+  // measured from the call (0 if that path never connected).
+  ConnectPath getLastConnectPath() const;
+  unsigned long getTimeToConnected(ConnectPath path) const;
+  void clearFastReconnect();
   bool disconnectFromNetwork();
   void resetSettings();
 
@@ -104,9 +196,19 @@ public:
   void setAPStaticIPConfig(IPAddress ip, IPAddress gateway, IPAddress subnet);
   void setSTAStaticIPConfig(IPAddress ip, IPAddress gateway, IPAddress subnet, IPAddress dns = IPAddress(0,0,0,0));
 
-  // Custom parameters.
+  // Custom parameters. Ids must be unique: addParameter() returns false (and
+  // keeps ownership with the caller) for a duplicate. Runtime parameters are
+  // deleted with the manager; schema parameters stay with their ParamBlock,
+  // which must outlive it.
   bool addParameter(WiFiManagerParameter* param);
+  template <size_t N, size_t ValueBytes>
+  bool addParameters(ParamBlock<N, ValueBytes>& block) {
+    bool added = true;
+    for (size_t i = 0; i < block.size(); i++) added &= addParameter(block[i]);
+    return added && block.size() == N;
+  }
   std::vector<WiFiManagerParameter*> getParameters() const;
+  WiFiManagerParameter* getParameter(const char* id) const;
 
   // Debug & callbacks.
   void setDebugOutput(bool debug, Print& debugPort = Serial);
@@ -120,6 +222,12 @@ public:
   void setCustomBodyFooter(const char* html);
 #endif
 
+  // Portal assets compiled into flash, looked up before SPIFFS. The table must
+  // be sorted by path (see embeddedAssetsSorted). ENABLE_EMBEDDED_ASSETS
+  // installs the generated table by default.
+  void setEmbeddedAssets(const EmbeddedAsset* table, size_t count);
+  bool isFilesystemMounted() const;
+
   // mDNS support.
 #ifdef ENABLE_MDNS
   void setMDNSHostname(const char* hostname);
@@ -137,41 +245,85 @@ public:
   bool isAuthenticationEnabled() const;
 #endif
 
-  // Serial monitor support.
+  // Serial monitor support. Debug output, and anything the sketch prints to
+  // getSerialMonitorOutput(), is mirrored to Serial and streamed to
+  // /serial_ws. The buffer is a fixed ring sized on first enable;
+  // getSerialMonitorBuffer() returns what has not been streamed yet.
 #ifdef ENABLE_SERIAL_MONITOR
   void enableSerialMonitor(bool enable, unsigned int bufferSize = 5000);
   bool isSerialMonitorEnabled() const;
   String getSerialMonitorBuffer() const;
+  Print& getSerialMonitorOutput();
+  uint32_t getSerialMonitorDropped() const;  // bytes lost to a full ring
 #endif
 
-  // JSON API endpoints and network scan.
+  // Network scan. Scans run in the background; scanNetworks() returns the
+  // cached result set and starts a refresh when forced or older than the TTL.
   std::vector<WiFiNetwork> scanNetworks(bool forceScan = false);
+  bool startScan();
+  bool isScanInProgress() const;
+  unsigned long getLastScanTime() const;
 
   // Status methods.
   String getConnectionStatus();
   uint8_t getLastConxResult();
 
+  // Request arena counters and heap headroom (also in /device_info).
+  ArenaStats getArenaStats() const;
+  HeapTelemetry getHeapTelemetry() const;
+
+  // Admission control: running and queued limits of a heavy request class,
+  // and per-class queue depths and refusals (also in /device_info and
+  // /metrics).
+  void setRequestClassLimits(RequestClass cls, uint8_t running, uint8_t queued);
+  SchedulerStats getSchedulerStats() const;
+
+  // Captive DNS counters (also in /device_info and /metrics).
+  CaptiveDNSStats getDNSStats() const;
+
   // Advanced endpoints:
 #ifdef ENABLE_OTA
+  // POST /ota: multipart file upload or raw application/octet-stream body,
+  // streamed into flash. The final response reports size, time and SHA-256.
   void handleOTA(AsyncWebServerRequest *request);
 #endif
 #ifdef ENABLE_FS_EXPLORER
+  // GET /fs/list?offset=&limit=&prefix=: one page of the directory index,
+  // streamed as {"total","offset","limit","files":[{name,size,mtime}]}.
   void handleFSList(AsyncWebServerRequest *request);
-  void handleFSUpload(AsyncWebServerRequest *request); // via onUpload callback
+  // POST /fs/upload: multipart, one or more files, each written to a temp file
+  // and renamed onto /<filename> once complete.
+  void handleFSUpload(AsyncWebServerRequest *request);
   void handleFSDelete(AsyncWebServerRequest *request);
+  // GET /fs/download?path=: the file as an attachment; resumable with Range.
+  void handleFSDownload(AsyncWebServerRequest *request);
 #endif
 #ifdef ENABLE_BACKUP_RESTORE
+  // GET /backup: credentials and parameters as JSON, or with ?format=bin as
+  // the CRC-protected binary snapshot described in WiFiManagerBackup.h.
   void handleBackup(AsyncWebServerRequest *request);
+  // POST /restore: a binary snapshot as raw body or multipart file. Applied
+  // only if the whole document decodes, its CRC matches and every value is
+  // accepted.
   void handleRestore(AsyncWebServerRequest *request);
 #endif
   void handleDeviceInfo(AsyncWebServerRequest *request);
+#ifdef ENABLE_METRICS
+  // GET /metrics: per-route request/error/byte counters and latency
+  // histograms plus heap, client and scan gauges, in Prometheus text format.
+  void handleMetrics(AsyncWebServerRequest *request);
+#endif
+#ifdef ENABLE_TRACE
+  // GET /trace: the trace ring as Chrome trace JSON (see WiFiManagerTrace.h).
+  void handleTrace(AsyncWebServerRequest *request);
+#endif
 #ifdef ENABLE_TERMINAL
   void handleTerminal(AsyncWebServerRequest *request);
 #endif
 
   // Multi-credential support.
 #ifdef ENABLE_MULTI_CRED
-  bool addWiFiCredential(const char* ssid, const char* password);
+  bool addWiFiCredential(const char* ssid, const char* password, int priority = 0);
 #endif
 
   // Localization support.
@@ -186,8 +338,9 @@ public:
 private:
   WiFiManagerConfig _config;
   AsyncWebServer* _server; // HTTP/HTTPS server pointer.
-  DNSServer _dnsServer;
-  std::vector<WiFiManagerParameter*> _params;
+  CaptiveDNS _dns;
+  char _portalUrl[32];  // "http[s]://<AP address>[:port]/", where OS probes are redirected
+  ParamRegistry _params;
 #ifdef ENABLE_MULTI_CRED
   std::vector<WiFiCredential> _wifiCredentials;
 #endif
@@ -199,6 +352,17 @@ private:
 #ifdef ENABLE_HTML_INTERFACE
   String _customHeadElement;
   String _customBodyFooter;
+  // Fallback root page (no index.html): everything around the status line is
+  // rendered once per content version and shared with in-flight responses.
+  struct RootPage {
+    uint32_t version;
+    uint32_t paramRevision;
+    String head;  // up to the status slot
+    String tail;
+  };
+  std::shared_ptr<const RootPage> _rootPage;
+  std::atomic<uint32_t> _rootPageVersion;  // addParameter, custom head/footer
+  std::shared_ptr<const RootPage> getRootPage();
 #endif
 #ifdef ENABLE_MDNS
   bool _useMDNS;
@@ -219,19 +383,208 @@ private:
 #endif
 #ifdef ENABLE_SERIAL_MONITOR
   bool _enableSerialMonitor;
-  String _serialMonitorBuffer;
   unsigned int _serialMonitorBufferSize;
-  unsigned long _lastSerialUpdate;
+  unsigned long _lastSerialUpdate;  // last frame sent to /serial_ws
+  std::unique_ptr<SerialRing> _serialRing;
+  std::unique_ptr<SerialTee> _serialTee;
+  bool _serialRoutesAdded;
+#ifdef ENABLE_WEBSOCKETS
+  AsyncWebSocket* _serialWs;
+#endif
+  void setupSerialMonitor();
+  void flushSerialMonitor();
 #endif
 #ifdef ENABLE_LOCALIZATION
   String _language;  // e.g., "en", "es", etc.
 #endif
 #ifdef ENABLE_WEBSOCKETS
   AsyncWebSocket* _ws;
+  // Status as last pushed on /ws. loop() samples the radio and sends only the
+  // fields that differ; a new client gets the full state once on connect.
+  // Only loop() touches it.
+  struct PublishedStatus {
+    const char* status;
+    uint32_t ip;
+    int32_t rssi;
+    char ssid[33];
+    uint32_t paramRevision;
+  };
+  PublishedStatus _published;
+  unsigned long _lastStatusSample;
+  void publishStatusDelta();
+  void sendStatusSnapshot(AsyncWebSocketClient* client);
+  void sendWsJson(AsyncWebSocketClient* client, const std::function<void(JsonStreamWriter&)>& render);
+#endif
+
+  wifi_event_id_t _wifiEventId;  // removed in the destructor
+
+#ifdef ENABLE_OTA
+  // One update at a time; _otaRequest is the upload that owns the updater.
+  std::unique_ptr<OtaUpdate> _ota;
+  AsyncWebServerRequest* _otaRequest;
+  unsigned long _otaLastProgress;  // last progress message on /ws
+  unsigned long _otaRebootAt;      // 0 = no reboot pending
+  void handleOTAChunk(AsyncWebServerRequest *request, size_t index, uint8_t *data, size_t len, bool final,
+                      size_t total);
+  void notifyOtaProgress();
+#endif
+
+#ifdef ENABLE_BACKUP_RESTORE
+  // One restore at a time; the body is decoded as it arrives.
+  std::unique_ptr<BackupDecoder> _restore;
+  AsyncWebServerRequest* _restoreRequest;
+  void handleRestoreChunk(AsyncWebServerRequest *request, size_t index, uint8_t *data, size_t len);
+  const char* applyBackup(const std::vector<BackupRecord>& records);
+#endif
+
+#ifdef ENABLE_FS_EXPLORER
+  // Uploads in flight, each keeping one file handle open across chunks.
+  static const size_t kMaxFsUploads = 2;
+  struct FsUploadSlot {
+    AsyncWebServerRequest* request = nullptr;
+    std::unique_ptr<FsUpload> upload;
+    size_t files = 0;
+    size_t bytes = 0;
+    unsigned long startedAt = 0;
+    const char* error = nullptr;
+  };
+  FsUploadSlot _fsUploads[kMaxFsUploads];
+  FsIndex _fsIndex;
+  FsUploadSlot* fsUploadSlot(AsyncWebServerRequest *request);
+  void handleFSUploadChunk(AsyncWebServerRequest *request, const String& filename, size_t index, uint8_t *data,
+                           size_t len, bool final);
+#endif
+
+  bool _fsMounted;
+  const EmbeddedAsset* _embeddedAssets;
+  size_t _embeddedAssetCount;
+  bool servePortalAsset(AsyncWebServerRequest *request, const String& path);
+  // Responses are charged to the route whose handler is running (with
+  // ENABLE_METRICS) where they are sent: respond() for a body in memory,
+  // charge() for the length of any other body.
+  void respond(AsyncWebServerRequest *request, int code, const char* contentType, const String& body);
+  void charge(size_t bytes);
+
+  // Handler temporaries. leaseArena() leases an arena for the request and
+  // resets it through onRequestEnd(); beginArenaJson() puts the renderer and
+  // everything it captured there, next to any values the handler copied in
+  // when the request started. Renderers are piece-wise (see JsonCursor).
+  ArenaPool _arenas;
+  RequestArena* leaseArena(AsyncWebServerRequest *request);
+  template <typename Render>
+  AsyncWebServerResponse* beginArenaJson(AsyncWebServerRequest *request, int code, Render&& render);
+  template <typename Render>
+  AsyncWebServerResponse* beginArenaJson(AsyncWebServerRequest *request, RequestArena* arena, int code, Render&& render);
+  // Every parameter's strings as the request found them, a row per parameter.
+  enum ParamColumn { kParamId, kParamLabel, kParamValue, kParamType, kParamAttributes, kParamGroup, kParamColumns };
+  const char* const* snapshotParams(RequestArena* arena);
+
+  uint32_t _heapHistory[HeapTelemetry::kHistory];
+  uint8_t _heapHistoryPos;
+  uint8_t _heapSamples;
+  uint32_t _minLargestBlock;
+  unsigned long _heapSampledAt;
+  void sampleHeap();
+
+  // Registers an endpoint on _server; with ENABLE_METRICS every callback is
+  // wrapped to feed _metrics. Latency runs until the request handler returns,
+  // from admission for heavy routes (so it covers the upload body and any
+  // wait in the queue) and from the handler itself otherwise. With
+  // ENABLE_TRACE every callback is also a trace span tagged with the URI.
+  // Heavy routes go through _scheduler first (see WiFiManagerScheduler.h).
+  void route(const char* uri, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest,
+             ArUploadHandlerFunction onUpload = nullptr, ArBodyHandlerFunction onBody = nullptr);
+
+  // A request has one onDisconnect hook. An admitted heavy request's belongs
+  // to the scheduler, so handlers register theirs here instead.
+  void onRequestEnd(AsyncWebServerRequest *request, const ArDisconnectHandler& fn);
+  // `route` is the metrics route refusals are counted under.
+  RequestScheduler _scheduler;
+  bool admit(AsyncWebServerRequest *request, RequestClass cls, uint8_t route, const ArRequestHandlerFunction* deferred);
+  void releaseHeavy(AsyncWebServerRequest *request);
+  void refuse(AsyncWebServerRequest *request, RequestClass cls, uint8_t route, int code, uint32_t startedAt);
+  void expireQueued();
+#ifdef ENABLE_METRICS
+  HttpMetrics _metrics;
+  ArRequestHandlerFunction timed(uint8_t route, ArRequestHandlerFunction onRequest);
+#endif
+#ifdef ENABLE_TRACE
+  ArRequestHandlerFunction traced(uint16_t tag, ArRequestHandlerFunction onRequest);
 #endif
 
+  // Background scan state. The snapshot is replaced atomically when a scan
+  // completes, so handlers can keep streaming the one they picked up.
+  struct ScanSnapshot {
+    std::vector<WiFiNetwork> networks;
+    unsigned long timestamp;
+    unsigned long duration;  // ms the radio took
+  };
+  std::shared_ptr<const ScanSnapshot> _scanSnapshot;
+  std::atomic<bool> _scanInProgress;
+  unsigned long _scanStartedAt;
+  std::shared_ptr<const ScanSnapshot> getScanSnapshot() const;
+  std::shared_ptr<const ScanSnapshot> getFreshScan(bool scanIfStale);
+  void onScanDone();
+
+  // Connection state machine. Only loop() touches the candidate list; web
+  // handlers hand a request over through _pendingConnect, and the WiFi event
+  // task reports through the atomics.
+  // A candidate matched against a scan is pinned to the BSSID and channel it
+  // was heard on, so WiFi.begin() skips the all-channel probe.
+  struct ConnectCandidate {
+    String ssid;
+    String password;
+    int priority;
+    int32_t rssi;
+    int32_t channel;  // 0 = not pinned
+    uint8_t bssid[6];
+    ConnectCandidate() : ConnectCandidate(String(), String()) {}
+    ConnectCandidate(const String& s, const String& p, int prio = 0)
+      : ssid(s), password(p), priority(prio), rssi(0), channel(0), bssid{0, 0, 0, 0, 0, 0} {}
+  };
+  std::vector<ConnectCandidate> _connectQueue;
+  size_t _connectIndex;
+  ConnectCandidate _pendingConnect;
+  std::atomic<uint8_t> _pendingConnectState;  // 0 free, 1 being written, 2 ready
+  std::atomic<ConnectState> _connectState;
+  std::atomic<bool> _connectGotIP;
+  std::atomic<uint8_t> _connectFailReason;
+  unsigned long _connectStartedAt;
+  unsigned long _attemptStartedAt;
+  unsigned long _connectDuration;
+  void rankCandidates(std::vector<ConnectCandidate>& candidates, const ScanSnapshot* scan);
+  void startConnect(std::vector<ConnectCandidate> candidates);
+  void startConnectAttempt();
+  void processConnect();
+  void finishConnect(ConnectState state);
+  bool waitForConnect();
+  void notifyConnectState();
+
+  // Fast reconnect: the last good association and lease, kept in NVS and
+  // rewritten only when they change. The passphrase is not part of it; it
+  // comes from the driver's stored config or the credential list.
+  struct FastReconnectRecord {
+    uint32_t version;
+    char ssid[33];
+    uint8_t bssid[6];
+    int32_t channel;
+    uint32_t ip, gateway, subnet, dns;
+  };
+  bool _staStaticIP;    // user-configured STA address; never replaced by a cached lease
+  bool _leaseApplied;   // a cached lease is currently configured as static IP
+  bool _leaseRenewing;  // DHCP restarted after a fast reconnect, waiting for its lease
+  ConnectPath _connectPath;
+  unsigned long _timeToConnected[3];
+  bool tryFastReconnect();
+  bool storedPassword(const char* ssid, String& password) const;
+  void releaseLease();
+  bool loadFastReconnect(FastReconnectRecord& record);
+  void saveFastReconnect();
+
   // Helper functions.
   String getInputTypeString(ParameterType type);
+  const char* getInputTypeName(ParameterType type);
+  const char* getConnectionStatusText();
   
   // Internal HTTP handlers.
   void handleRoot(AsyncWebServerRequest *request);
@@ -239,6 +592,7 @@ private:
   void handleConnect(AsyncWebServerRequest *request);
   void handleReset(AsyncWebServerRequest *request);
   void handleNotFound(AsyncWebServerRequest *request);
+  void handleCaptiveProbe(AsyncWebServerRequest *request);
   void handleStatusJSON(AsyncWebServerRequest *request);
   void handleParamsJSON(AsyncWebServerRequest *request);
   void handleUpdateParams(AsyncWebServerRequest *request);
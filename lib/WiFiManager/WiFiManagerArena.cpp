@@ -0,0 +1,91 @@
+#include "WiFiManagerArena.h"
+
+static const size_t kMaxArenas = 32;  // bits in ArenaPool::_free
+
+static size_t alignUp(size_t n, size_t align) { return (n + align - 1) & ~(align - 1); }
+
+// ----- RequestArena -----
+RequestArena::RequestArena(ArenaPool* pool, uint8_t* buffer, size_t size)
+  : _pool(pool), _buffer(buffer), _size(size), _used(0), _cleanups(nullptr), _overflow(nullptr) {}
+
+void* RequestArena::allocate(size_t size, size_t align) {
+  size_t offset = alignUp(reinterpret_cast<uintptr_t>(_buffer) + _used, align) - reinterpret_cast<uintptr_t>(_buffer);
+  if (_buffer && offset + size <= _size) {
+    _used = offset + size;
+    return _buffer + offset;
+  }
+  // Too big for what is left: a heap block, freed with the arena.
+  size_t header = alignUp(sizeof(Overflow), alignof(std::max_align_t));
+  Overflow* block = static_cast<Overflow*>(malloc(header + size));
+  if (!block) return nullptr;
+  block->next = _overflow;
+  _overflow = block;
+  if (_pool->enabled()) {
+    _pool->_stats.fallbacks++;
+    _pool->_stats.fallbackBytes += size;
+  }
+  return reinterpret_cast<uint8_t*>(block) + header;
+}
+
+void RequestArena::reset() {
+  for (Cleanup* c = _cleanups; c; c = c->next) c->destroy(c->object);
+  _cleanups = nullptr;
+  while (_overflow) {
+    Overflow* next = _overflow->next;
+    free(_overflow);
+    _overflow = next;
+  }
+  if (_used > _pool->_stats.highWater) _pool->_stats.highWater = _used;
+  _used = 0;
+}
+
+// ----- ArenaPool -----
+ArenaPool::ArenaPool() : _arenas(nullptr), _count(0), _size(0), _free(0) {
+  memset(&_stats, 0, sizeof(_stats));
+}
+
+ArenaPool::~ArenaPool() {
+  for (uint16_t i = 0; i < _count; i++) _arenas[i].~RequestArena();
+}
+
+void ArenaPool::begin(uint16_t count, size_t size) {
+  if (_count || count == 0) return;  // the block is allocated once, at startup
+  if (count > kMaxArenas) count = kMaxArenas;
+  size = alignUp(size, alignof(std::max_align_t));
+  size_t headers = alignUp(count * sizeof(RequestArena), alignof(std::max_align_t));
+  _block.reset(new (std::nothrow) uint8_t[headers + count * size + alignof(std::max_align_t)]);
+  if (!_block) return;
+  uint8_t* base = reinterpret_cast<uint8_t*>(alignUp(reinterpret_cast<uintptr_t>(_block.get()), alignof(std::max_align_t)));
+  _arenas = reinterpret_cast<RequestArena*>(base);
+  for (uint16_t i = 0; i < count; i++) new (&_arenas[i]) RequestArena(this, base + headers + i * size, size);
+  _count = count;
+  _size = size;
+  _free = count == 32 ? 0xFFFFFFFFu : (1u << count) - 1;
+  _stats.arenas = count;
+  _stats.arenaSize = size;
+}
+
+RequestArena* ArenaPool::acquire() {
+  if (_free) {
+    int i = __builtin_ctz(_free);
+    _free &= ~(1u << i);
+    _stats.leases++;
+    _stats.inUse++;
+    return &_arenas[i];
+  }
+  if (enabled()) _stats.exhausted++;
+  return new (std::nothrow) RequestArena(this, nullptr, 0);
+}
+
+void ArenaPool::release(RequestArena* arena) {
+  if (!arena) return;
+  arena->reset();
+  if (arena >= _arenas && arena < _arenas + _count) {
+    _free |= 1u << (arena - _arenas);
+    _stats.inUse--;
+  } else {
+    delete arena;
+  }
+}
+
+ArenaStats ArenaPool::stats() const { return _stats; }
@@ -0,0 +1,145 @@
+#ifndef WIFI_MANAGER_ARENA_H
+#define WIFI_MANAGER_ARENA_H
+
+#include <Arduino.h>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// Per-request bump allocation for HTTP handlers.
+//
+// A handler leases one arena from a small pool that is allocated once, puts
+// its temporaries (response state, renderers) in it, and the whole arena is
+// reset when the request goes away. Long-lived heap blocks are never
+// interleaved with per-request garbage, so the heap does not fragment around
+// them. Allocations that do not fit, and requests that find every arena busy,
+// fall back to the heap and are counted. Leases, allocations and releases all
+// happen on the web server task.
+
+struct ArenaStats {
+  uint16_t arenas;         // pool size (0 = disabled)
+  uint32_t arenaSize;      // bytes per arena
+  uint32_t leases;         // requests served from a pooled arena
+  uint16_t inUse;
+  uint32_t exhausted;      // requests that found every arena busy
+  uint32_t fallbacks;      // allocations served from the heap instead
+  uint32_t fallbackBytes;
+  uint32_t highWater;      // most arena bytes one request used
+};
+
+class ArenaPool;
+
+class RequestArena {
+public:
+  void* allocate(size_t size, size_t align = alignof(std::max_align_t));
+
+  // Constructs a T in the arena; its destructor runs when the arena is
+  // released. nullptr only if the heap fallback fails too.
+  template <typename T, typename... Args>
+  T* make(Args&&... args) {
+    Cleanup* cleanup = nullptr;
+    if (!std::is_trivially_destructible<T>::value) {
+      cleanup = static_cast<Cleanup*>(allocate(sizeof(Cleanup), alignof(Cleanup)));
+      if (!cleanup) return nullptr;
+    }
+    void* mem = allocate(sizeof(T), alignof(T));
+    if (!mem) return nullptr;
+    T* object = new (mem) T(std::forward<Args>(args)...);
+    if (cleanup) {
+      cleanup->destroy = [](void* p) { static_cast<T*>(p)->~T(); };
+      cleanup->object = object;
+      cleanup->next = _cleanups;
+      _cleanups = cleanup;
+    }
+    return object;
+  }
+
+  // Copies `rows` x Columns strings into one block, so a response can render
+  // values that were current when it started. `row(i, cells)` points cells at
+  // row i's strings (nullptr = "") and is called twice per row, to measure
+  // and to copy; a string that grew in between is cut short. Returns the
+  // row-major table, or nullptr.
+  template <size_t Columns, typename Row>
+  const char* const* copyStrings(size_t rows, const Row& row) {
+    const char* cells[Columns];
+    size_t bytes = 0;
+    for (size_t i = 0; i < rows; i++) {
+      row(i, cells);
+      for (size_t c = 0; c < Columns; c++) bytes += (cells[c] ? strlen(cells[c]) : 0) + 1;
+    }
+    const char** table = static_cast<const char**>(allocate(rows * Columns * sizeof(char*) + bytes, alignof(char*)));
+    if (!table) return nullptr;
+    char* text = reinterpret_cast<char*>(table + rows * Columns);
+    char* end = text + bytes;
+    for (size_t i = 0; i < rows; i++) {
+      row(i, cells);
+      for (size_t c = 0; c < Columns; c++) {
+        const char* s = cells[c] ? cells[c] : "";
+        size_t cellsLeft = (rows - i) * Columns - c;  // each keeps at least its terminator
+        size_t n = strlen(s);
+        if (n > static_cast<size_t>(end - text) - cellsLeft) n = static_cast<size_t>(end - text) - cellsLeft;
+        memcpy(text, s, n);
+        text[n] = '\0';
+        table[i * Columns + c] = text;
+        text += n + 1;
+      }
+    }
+    return table;
+  }
+
+  size_t used() const { return _used; }
+  size_t capacity() const { return _size; }
+
+private:
+  friend class ArenaPool;
+  struct Cleanup {
+    void (*destroy)(void*);
+    void* object;
+    Cleanup* next;
+  };
+  struct Overflow {
+    Overflow* next;
+  };
+
+  RequestArena(ArenaPool* pool, uint8_t* buffer, size_t size);
+  void reset();
+
+  ArenaPool* _pool;
+  uint8_t* _buffer;
+  size_t _size;
+  size_t _used;
+  Cleanup* _cleanups;
+  Overflow* _overflow;
+};
+
+class ArenaPool {
+public:
+  ArenaPool();
+  ~ArenaPool();
+
+  // Allocates `count` arenas of `size` bytes in one block; 0 disables leasing.
+  void begin(uint16_t count, size_t size);
+  bool enabled() const { return _count > 0; }
+
+  // A free pooled arena, or a heap-backed one when all are busy or the pool
+  // is disabled (not counted in the stats then).
+  RequestArena* acquire();
+  void release(RequestArena* arena);
+
+  ArenaStats stats() const;
+
+private:
+  friend class RequestArena;
+
+  std::unique_ptr<uint8_t[]> _block;
+  RequestArena* _arenas;  // in _block, ahead of the buffers
+  uint16_t _count;
+  size_t _size;
+  uint32_t _free;         // bit i set = arena i available
+  ArenaStats _stats;
+};
+
+#endif // WIFI_MANAGER_ARENA_H
@@ -0,0 +1,273 @@
+#include "WiFiManagerAssets.h"
+#include <memory>
+#include <vector>
+#ifdef ENABLE_EMBEDDED_ASSETS
+#include <portal_assets.h>
+#endif
+
+static const char kImmutable[] = "public, max-age=31536000, immutable";
+static const char kRevalidate[] = "no-cache";
+
+bool isFingerprintedAsset(const String& path) {
+  int ext = path.lastIndexOf('.');
+  if (ext < 9 || path[ext - 9] != '.') return false;
+  for (int i = ext - 8; i < ext; i++) {
+    char c = path[i];
+    if (!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f'))) return false;
+  }
+  return true;
+}
+
+// The last 8 bytes of a gzip member are CRC-32 and ISIZE of the content.
+static bool gzipETag(File& file, char* etag, size_t len) {
+  size_t size = file.size();
+  uint8_t trailer[8];
+  bool ok = size >= 18 && file.seek(size - sizeof(trailer)) && file.read(trailer, sizeof(trailer)) == sizeof(trailer);
+  file.seek(0);
+  if (!ok) return false;
+  snprintf(etag, len, "\"%02x%02x%02x%02x-%02x%02x%02x%02x\"", trailer[3], trailer[2], trailer[1], trailer[0],
+           trailer[7], trailer[6], trailer[5], trailer[4]);
+  return true;
+}
+
+static void sendNotModified(AsyncWebServerRequest* request, const char* etag, const char* cacheControl) {
+  AsyncWebServerResponse* response = request->beginResponse(304);
+  response->addHeader("ETag", etag);
+  response->addHeader("Cache-Control", cacheControl);
+  request->send(response);
+}
+
+bool sendPortalAsset(AsyncWebServerRequest* request, fs::FS& fs, const String& path, size_t* sent) {
+  String gzPath = path + ".gz";
+  bool gzipped = fs.exists(gzPath);
+  if (!gzipped && !fs.exists(path)) return false;
+  File file = fs.open(gzipped ? gzPath : path, FILE_READ);
+  if (!file || file.isDirectory()) return false;
+
+  const char* cacheControl = isFingerprintedAsset(path) ? kImmutable : kRevalidate;
+  char etag[24] = {0};
+  if (!gzipped || !gzipETag(file, etag, sizeof(etag))) fileETag(file, etag, sizeof(etag));
+  size_t length = sendFile(request, file, path, etag, cacheControl);
+  if (sent) *sent = length;
+  return true;
+}
+
+// ----- Files and byte ranges -----
+static const char kByteRangesBoundary[] = "wm-byteranges-5f3a9c1e";
+
+static const char* contentTypeFor(const String& path) {
+  if (path.endsWith(".html") || path.endsWith(".htm")) return "text/html";
+  if (path.endsWith(".css")) return "text/css";
+  if (path.endsWith(".js")) return "application/javascript";
+  if (path.endsWith(".json")) return "application/json";
+  if (path.endsWith(".png")) return "image/png";
+  if (path.endsWith(".jpg") || path.endsWith(".jpeg")) return "image/jpeg";
+  if (path.endsWith(".gif")) return "image/gif";
+  if (path.endsWith(".ico")) return "image/x-icon";
+  if (path.endsWith(".svg")) return "image/svg+xml";
+  if (path.endsWith(".txt") || path.endsWith(".log")) return "text/plain";
+  if (path.endsWith(".csv")) return "text/csv";
+  if (path.endsWith(".gz")) return "application/x-gzip";
+  return "application/octet-stream";
+}
+
+static bool parseSize(const char*& p, size_t& out) {
+  if (*p < '0' || *p > '9') return false;
+  size_t v = 0;
+  while (*p >= '0' && *p <= '9') {
+    size_t digit = *p++ - '0';
+    if (v > (SIZE_MAX - digit) / 10) return false;
+    v = v * 10 + digit;
+  }
+  out = v;
+  return true;
+}
+
+int parseByteRanges(const char* header, size_t size, ByteRange* out, size_t maxRanges) {
+  if (!header || strncasecmp(header, "bytes=", 6) != 0) return -1;
+  const char* p = header + 6;
+  size_t specs = 0;
+  int count = 0;
+  for (;;) {
+    while (*p == ' ' || *p == '\t') p++;
+    if (++specs > maxRanges) return -1;
+    size_t first = 0, last = SIZE_MAX;
+    if (*p == '-') {
+      size_t suffix;
+      if (!parseSize(++p, suffix)) return -1;
+      if (suffix == 0 || size == 0) first = SIZE_MAX;  // unsatisfiable
+      else first = suffix < size ? size - suffix : 0;
+    } else {
+      if (!parseSize(p, first) || *p++ != '-') return -1;
+      if (*p >= '0' && *p <= '9') {
+        if (!parseSize(p, last) || last < first) return -1;
+      }
+    }
+    if (first < size) {
+      out[count].first = first;
+      out[count].last = last < size - 1 ? last : size - 1;
+      count++;
+    }
+    while (*p == ' ' || *p == '\t') p++;
+    if (*p == '\0') return count;
+    if (*p++ != ',') return -1;
+  }
+}
+
+void fileETag(File& file, char* etag, size_t len) {
+  snprintf(etag, len, "\"%x-%lx\"", static_cast<unsigned>(file.size()), static_cast<unsigned long>(file.getLastWrite()));
+}
+
+namespace {
+
+// Body of a 206: for every range an optional multipart head, then the bytes
+// of the range read from the file; then an optional closing delimiter.
+struct RangeBody {
+  struct Part {
+    String head;
+    size_t from;
+    size_t len;
+  };
+  File file;
+  std::vector<Part> parts;
+  String tail;
+
+  size_t length() const {
+    size_t n = tail.length();
+    for (const Part& part : parts) n += part.head.length() + part.len;
+    return n;
+  }
+
+  size_t fill(uint8_t* buffer, size_t maxLen, size_t index) {
+    size_t written = 0;
+    size_t pos = 0;  // body offset of the current segment
+    auto copy = [&](const String& text) {
+      size_t at = index + written;
+      if (written < maxLen && at >= pos && at < pos + text.length()) {
+        size_t n = pos + text.length() - at;
+        if (n > maxLen - written) n = maxLen - written;
+        memcpy(buffer + written, text.c_str() + (at - pos), n);
+        written += n;
+      }
+      pos += text.length();
+    };
+    for (const Part& part : parts) {
+      copy(part.head);
+      size_t at = index + written;
+      if (written < maxLen && at >= pos && at < pos + part.len) {
+        size_t offset = part.from + (at - pos);
+        if (file.position() != offset) file.seek(offset);
+        size_t n = pos + part.len - at;
+        if (n > maxLen - written) n = maxLen - written;
+        size_t got = file.read(buffer + written, n);
+        written += got;
+        if (got < n) return written;  // short read; the next call retries
+      }
+      pos += part.len;
+    }
+    copy(tail);
+    return written;
+  }
+};
+
+} // namespace
+
+size_t sendFile(AsyncWebServerRequest* request, File file, const String& path, const char* etag,
+                const char* cacheControl, bool download) {
+  if (etag && etag[0] && request->header("If-None-Match") == etag) {
+    file.close();
+    sendNotModified(request, etag, cacheControl);
+    return 0;
+  }
+  size_t size = file.size();
+  bool gzipped = String(file.name()).endsWith(".gz") && !path.endsWith(".gz");
+  ByteRange ranges[kMaxByteRanges];
+  int count = -1;
+  if (request->method() == HTTP_GET && request->hasHeader("Range")) {
+    // If-Range only ever matches our (strong) ETag; a date never does, so a
+    // client holding an older copy gets the whole file.
+    String ifRange = request->header("If-Range");
+    if (ifRange.length() == 0 || (etag && ifRange == etag)) {
+      count = parseByteRanges(request->header("Range").c_str(), size, ranges, kMaxByteRanges);
+    }
+    // Content-Encoding would apply to the multipart body as a whole, which
+    // clients then fail to gunzip; several ranges of a gzip asset get it all.
+    if (gzipped && count > 1) count = -1;
+  }
+
+  AsyncWebServerResponse* response;
+  size_t length = 0;
+  if (count < 0) {
+    response = request->beginResponse(file, path, String(), download);
+    length = size;
+  } else if (count == 0) {
+    file.close();
+    response = request->beginResponse(416);
+    response->addHeader("Content-Range", "bytes */" + String(size));
+  } else {
+    String contentType = download ? "application/octet-stream" : contentTypeFor(path);
+    std::shared_ptr<RangeBody> body = std::make_shared<RangeBody>();
+    body->file = file;
+    for (int i = 0; i < count; i++) {
+      String contentRange = "bytes " + String(ranges[i].first) + "-" + String(ranges[i].last) + "/" + String(size);
+      String head;
+      if (count > 1) {
+        head = String(i ? "\r\n--" : "--") + kByteRangesBoundary + "\r\nContent-Type: " + contentType +
+               "\r\nContent-Range: " + contentRange + "\r\n\r\n";
+      }
+      body->parts.push_back(RangeBody::Part{head, ranges[i].first, ranges[i].last - ranges[i].first + 1});
+    }
+    if (count > 1) body->tail = String("\r\n--") + kByteRangesBoundary + "--\r\n";
+    length = body->length();
+    response = request->beginResponse(count > 1 ? String("multipart/byteranges; boundary=") + kByteRangesBoundary
+                                                : contentType,
+                                      body->length(), [body](uint8_t* buffer, size_t maxLen, size_t index) -> size_t {
+                                        return body->fill(buffer, maxLen, index);
+                                      });
+    response->setCode(206);
+    if (count == 1) {
+      response->addHeader("Content-Range", "bytes " + String(ranges[0].first) + "-" + String(ranges[0].last) + "/" +
+                                               String(size));
+    }
+    if (gzipped) response->addHeader("Content-Encoding", "gzip");
+    if (download) {
+      response->addHeader("Content-Disposition", "attachment; filename=\"" + path.substring(path.lastIndexOf('/') + 1) + "\"");
+    }
+  }
+  response->addHeader("Accept-Ranges", "bytes");
+  if (etag && etag[0]) response->addHeader("ETag", etag);
+  response->addHeader("Cache-Control", cacheControl);
+  request->send(response);
+  return length;
+}
+
+const EmbeddedAsset* findEmbeddedAsset(const EmbeddedAsset* table, size_t count, const char* path) {
+  size_t lo = 0, hi = count;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    int cmp = strcmp(path, table[mid].path);
+    if (cmp == 0) return &table[mid];
+    if (cmp < 0) hi = mid;
+    else lo = mid + 1;
+  }
+  return nullptr;
+}
+
+bool sendEmbeddedAsset(AsyncWebServerRequest* request, const EmbeddedAsset* table, size_t count, const String& path,
+                       size_t* sent) {
+  const EmbeddedAsset* asset = findEmbeddedAsset(table, count, path.c_str());
+  if (!asset) return false;
+  const char* cacheControl = isFingerprintedAsset(path) ? kImmutable : kRevalidate;
+  if (request->header("If-None-Match") == asset->etag) {
+    sendNotModified(request, asset->etag, cacheControl);
+    if (sent) *sent = 0;
+    return true;
+  }
+  AsyncWebServerResponse* response = request->beginResponse_P(200, asset->contentType, asset->data, asset->length);
+  response->addHeader("Content-Encoding", "gzip");
+  response->addHeader("ETag", asset->etag);
+  response->addHeader("Cache-Control", cacheControl);
+  request->send(response);
+  if (sent) *sent = asset->length;
+  return true;
+}
@@ -0,0 +1,93 @@
+#ifndef WIFI_MANAGER_ASSETS_H
+#define WIFI_MANAGER_ASSETS_H
+
+#include <Arduino.h>
+#include <FS.h>
+#include <ESPAsyncWebServer.h>
+
+// Portal file serving.
+//
+// scripts/build_assets.py stores every text asset as `<name>.gz` and gives
+// stylesheets and scripts content-hashed names (style.1ce633e8.css). Those are
+// sent with Content-Encoding: gzip and a strong ETag read from the gzip trailer
+// (CRC-32 and length of the original), so a revalidation costs an 8-byte read
+// and a 304. Hashed names are `immutable`; everything else is `no-cache`, i.e.
+// always revalidated. Plain files from an unprocessed data/ are still served,
+// with an ETag made of size and mtime.
+
+// Sends `path` or its .gz variant from `fs`. Returns false if neither exists.
+// `sent`, if given, receives the length of the body sent.
+bool sendPortalAsset(AsyncWebServerRequest* request, fs::FS& fs, const String& path, size_t* sent = nullptr);
+
+// True for names of the form <stem>.<8 hex digits>.<ext>.
+bool isFingerprintedAsset(const String& path);
+
+// ----- Files and byte ranges -----
+// Files sent from SPIFFS (portal assets and FS explorer downloads) carry
+// Accept-Ranges and answer Range requests with 206 Partial Content, one range
+// as a plain body and several as multipart/byteranges. Each range is read by
+// seeking straight to it. A Range with If-Range naming another ETag, a
+// malformed header or more than kMaxByteRanges ranges get the whole file;
+// ranges that all start past the end get 416.
+
+struct ByteRange {
+  size_t first;
+  size_t last;  // inclusive
+};
+
+static const size_t kMaxByteRanges = 8;
+
+// Parses a Range header for a resource of `size` bytes. Returns the number of
+// satisfiable ranges stored in `out`, 0 if none is satisfiable, or -1 if the
+// header is to be ignored.
+int parseByteRanges(const char* header, size_t size, ByteRange* out, size_t maxRanges);
+
+// "<size>-<mtime>" in hex, for files without a content hash.
+void fileETag(File& file, char* etag, size_t len);
+
+// Sends an open file honouring If-None-Match, Range and If-Range. A `.gz`
+// file sent under another path gets Content-Encoding: gzip; ranges then apply
+// to the compressed bytes. Returns the length of the body sent (0 for 304
+// and 416).
+size_t sendFile(AsyncWebServerRequest* request, File file, const String& path, const char* etag,
+                const char* cacheControl, bool download = false);
+
+// ----- Embedded assets -----
+// With ENABLE_EMBEDDED_ASSETS the same gzip streams are compiled into the
+// firmware instead (portal_assets.h, generated by scripts/build_assets.py), so
+// the UI works without a data/ image and begin() can skip the SPIFFS mount.
+// Entries live in flash and are sent from there without a RAM copy.
+
+struct EmbeddedAsset {
+  const char* path;         // request path, e.g. "/style.1ce633e8.css"
+  const uint8_t* data;      // gzip stream (PROGMEM)
+  uint32_t length;
+  const char* etag;         // same "crc-isize" form as the SPIFFS path
+  const char* contentType;
+};
+
+constexpr int compareAssetPath(const char* a, const char* b) {
+  return (*a != *b || *a == '\0') ? static_cast<unsigned char>(*a) - static_cast<unsigned char>(*b)
+                                  : compareAssetPath(a + 1, b + 1);
+}
+
+// Lookups binary-search the table, so it must be strictly sorted by path;
+// generated tables check this with a static_assert.
+constexpr bool embeddedAssetsSorted(const EmbeddedAsset* table, size_t count) {
+  return count < 2 || (compareAssetPath(table[0].path, table[1].path) < 0 && embeddedAssetsSorted(table + 1, count - 1));
+}
+
+const EmbeddedAsset* findEmbeddedAsset(const EmbeddedAsset* table, size_t count, const char* path);
+
+// Sends `path` from `table`. Returns false if it is not embedded; `sent` as
+// for sendPortalAsset().
+bool sendEmbeddedAsset(AsyncWebServerRequest* request, const EmbeddedAsset* table, size_t count, const String& path,
+                       size_t* sent = nullptr);
+
+#ifdef ENABLE_EMBEDDED_ASSETS
+// Defined by the generated portal_assets.h.
+extern const EmbeddedAsset kPortalAssets[];
+extern const size_t kPortalAssetCount;
+#endif
+
+#endif // WIFI_MANAGER_ASSETS_H
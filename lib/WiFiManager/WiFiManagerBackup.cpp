@@ -0,0 +1,451 @@
+#include "WiFiManagerBackup.h"
+
+static const uint8_t kMagic[] = {'W', 'M', 'B', 'K'};
+static const uint8_t kTagEnd = 0xFF;
+
+const uint8_t BackupEncoder::kVersion;
+const size_t BackupDecoder::kMaxRecordSize;
+const size_t BackupDecoder::kMaxRecords;
+const uint8_t BackupDecoder::kMaxJsonDepth;
+
+uint32_t backupCrc32(uint32_t crc, const uint8_t* data, size_t len) {
+  // Nibble table: 64 bytes of flash instead of 1 KB.
+  static const uint32_t kTable[16] = {
+    0x00000000, 0x1db71064, 0x3b6e20c8, 0x26d930ac, 0x76dc4190, 0x6b6b51f4, 0x4db26158, 0x5005713c,
+    0xedb88320, 0xf00f9344, 0xd6d6a3e8, 0xcb61b38c, 0x9b64c2b0, 0x86d3d2d4, 0xa00ae278, 0xbdbdf21c,
+  };
+  crc = ~crc;
+  for (size_t i = 0; i < len; i++) {
+    crc ^= data[i];
+    crc = (crc >> 4) ^ kTable[crc & 0x0F];
+    crc = (crc >> 4) ^ kTable[crc & 0x0F];
+  }
+  return ~crc;
+}
+
+static bool isJsonSpace(uint8_t b) { return b == ' ' || b == '\t' || b == '\n' || b == '\r'; }
+
+static void putVarint(std::vector<uint8_t>& out, uint32_t v) {
+  while (v >= 0x80) {
+    out.push_back(static_cast<uint8_t>(v | 0x80));
+    v >>= 7;
+  }
+  out.push_back(static_cast<uint8_t>(v));
+}
+
+static void putString(std::vector<uint8_t>& out, const String& s) {
+  putVarint(out, s.length());
+  out.insert(out.end(), s.c_str(), s.c_str() + s.length());
+}
+
+static bool getVarint(const uint8_t*& p, const uint8_t* end, uint32_t& v) {
+  v = 0;
+  for (uint8_t shift = 0; p < end && shift < 35; shift += 7) {
+    uint8_t b = *p++;
+    v |= static_cast<uint32_t>(b & 0x7F) << shift;
+    if (!(b & 0x80)) return true;
+  }
+  return false;
+}
+
+static bool getString(const uint8_t*& p, const uint8_t* end, String& s) {
+  uint32_t len;
+  if (!getVarint(p, end, len) || len > static_cast<size_t>(end - p)) return false;
+  s = String(reinterpret_cast<const char*>(p), len);
+  p += len;
+  return true;
+}
+
+// ----- Encoder -----
+BackupEncoder::BackupEncoder(Source source)
+  : _source(source), _pendingPos(0), _index(0), _crc(0), _stage(HEADER) {}
+
+void BackupEncoder::encodeNext() {
+  _pending.clear();
+  _pendingPos = 0;
+  if (_stage == HEADER) {
+    _pending.assign(kMagic, kMagic + sizeof(kMagic));
+    _pending.push_back(kVersion);
+    _stage = RECORDS;
+  } else if (_stage == RECORDS) {
+    BackupRecord record;
+    if (!_source(_index, record)) {
+      _stage = END;
+      encodeNext();
+      return;
+    }
+    _index++;
+    std::vector<uint8_t> payload;
+    putString(payload, record.key);
+    putString(payload, record.value);
+    if (record.type == BackupRecord::CREDENTIAL) {
+      putVarint(payload, (static_cast<uint32_t>(record.priority) << 1) ^ static_cast<uint32_t>(record.priority >> 31));
+    }
+    _pending.push_back(record.type);
+    putVarint(_pending, payload.size());
+    _pending.insert(_pending.end(), payload.begin(), payload.end());
+  } else if (_stage == END) {
+    uint32_t crc = _crc;
+    _pending.push_back(kTagEnd);
+    _pending.push_back(4);
+    for (int i = 0; i < 4; i++) _pending.push_back(static_cast<uint8_t>(crc >> (8 * i)));
+    _stage = DONE;
+    return;
+  }
+  _crc = backupCrc32(_crc, _pending.data(), _pending.size());
+}
+
+size_t BackupEncoder::read(uint8_t* buffer, size_t maxLen) {
+  size_t written = 0;
+  while (written < maxLen) {
+    if (_pendingPos == _pending.size()) {
+      if (_stage == DONE) break;
+      encodeNext();
+    }
+    size_t n = _pending.size() - _pendingPos;
+    if (n > maxLen - written) n = maxLen - written;
+    memcpy(buffer + written, _pending.data() + _pendingPos, n);
+    _pendingPos += n;
+    written += n;
+  }
+  return written;
+}
+
+// ----- Decoder -----
+BackupDecoder::BackupDecoder() { reset(); }
+
+void BackupDecoder::reset() {
+  _state = MAGIC;
+  _tag = 0;
+  _length = 0;
+  _shift = 0;
+  _pos = 0;
+  _crc = 0;
+  _complete = false;
+  _payload.clear();
+  _records.clear();
+  _error = nullptr;
+  _json = J_VALUE;
+  _depth = 0;
+  _isKey = false;
+  _unit = 0;
+  _highSurrogate = 0;
+  _section = 0;
+  _member = M_NONE;
+  _inRecord = false;
+  _haveKey = false;
+  _text = String();
+}
+
+bool BackupDecoder::fail(const char* error) {
+  if (!_error) _error = error;
+  _records.clear();
+  _payload.clear();
+  _text = String();
+  return false;
+}
+
+bool BackupDecoder::write(const uint8_t* data, size_t len) {
+  if (_error) return false;
+  size_t crcFrom = 0;  // bytes of this chunk before crcFrom are in _crc
+  for (size_t i = 0; i < len; i++) {
+    uint8_t b = data[i];
+    switch (_state) {
+      case MAGIC:
+        if (_pos == 0 && isJsonSpace(b)) break;
+        if (_pos == 0 && b == '{') {
+          _state = JSON;
+          if (!jsonByte(b)) return false;
+          break;
+        }
+        if (_pos < sizeof(kMagic) ? b != kMagic[_pos] : b != BackupEncoder::kVersion) {
+          return fail(_pos < sizeof(kMagic) ? "Not a backup" : "Unsupported backup version");
+        }
+        if (++_pos == sizeof(kMagic) + 1) _state = TAG;
+        break;
+      case TAG:
+        if (b == kTagEnd) {
+          // The CRC covers everything before the end record.
+          _crc = backupCrc32(_crc, data + crcFrom, i - crcFrom);
+          crcFrom = len;
+        }
+        _tag = b;
+        _length = 0;
+        _shift = 0;
+        _state = LENGTH;
+        break;
+      case LENGTH:
+        if (_shift > 28) return fail("Bad record length");
+        _length |= static_cast<uint32_t>(b & 0x7F) << _shift;
+        _shift += 7;
+        if (b & 0x80) break;
+        _pos = 0;
+        if (_tag == kTagEnd && _length != 4) return fail("Bad end record");
+        if (_tag != BackupRecord::CREDENTIAL && _tag != BackupRecord::PARAMETER && _tag != kTagEnd) {
+          _state = _length ? SKIP : TAG;
+          break;
+        }
+        if (_length > kMaxRecordSize) return fail("Record too large");
+        _payload.clear();
+        _payload.reserve(_length);
+        _state = PAYLOAD;
+        if (_length == 0 && !parseRecord()) return false;
+        break;
+      case PAYLOAD: {
+        size_t n = len - i < _length - _pos ? len - i : _length - _pos;
+        _payload.insert(_payload.end(), data + i, data + i + n);
+        _pos += n;
+        i += n - 1;
+        if (_pos == _length && !parseRecord()) return false;
+        break;
+      }
+      case SKIP: {
+        size_t n = len - i < _length - _pos ? len - i : _length - _pos;
+        _pos += n;
+        i += n - 1;
+        if (_pos == _length) _state = TAG;
+        break;
+      }
+      case TRAILING:
+        return fail("Data after end of backup");
+      case JSON:
+        if (!jsonByte(b)) return false;
+        break;
+    }
+  }
+  // Once past the end tag the remaining bytes are the CRC itself.
+  if (_state != JSON && crcFrom < len && _tag != kTagEnd) _crc = backupCrc32(_crc, data + crcFrom, len - crcFrom);
+  return true;
+}
+
+bool BackupDecoder::parseRecord() {
+  const uint8_t* p = _payload.data();
+  const uint8_t* end = p + _payload.size();
+  _state = TAG;
+  if (_tag == kTagEnd) {
+    uint32_t crc = 0;
+    for (int i = 0; i < 4; i++) crc |= static_cast<uint32_t>(p[i]) << (8 * i);
+    if (crc != _crc) return fail("CRC mismatch");
+    _complete = true;
+    _state = TRAILING;
+    return true;
+  }
+  if (_records.size() == kMaxRecords) return fail("Too many records");
+  BackupRecord record;
+  record.type = static_cast<BackupRecord::Type>(_tag);
+  record.priority = 0;
+  if (!getString(p, end, record.key) || !getString(p, end, record.value)) return fail("Malformed record");
+  if (record.type == BackupRecord::CREDENTIAL) {
+    uint32_t zigzag;
+    if (!getVarint(p, end, zigzag)) return fail("Malformed record");
+    record.priority = static_cast<int32_t>((zigzag >> 1) ^ (~(zigzag & 1) + 1));
+  }
+  // Fields appended by later versions are ignored.
+  _records.push_back(record);
+  return true;
+}
+
+// ----- JSON -----
+// One byte at a time, like the binary form: the decoder keeps the string or
+// literal being read and the record around it, nothing else of the document.
+static int hexDigit(uint8_t b) {
+  if (b >= '0' && b <= '9') return b - '0';
+  if (b >= 'a' && b <= 'f') return b - 'a' + 10;
+  if (b >= 'A' && b <= 'F') return b - 'A' + 10;
+  return -1;
+}
+
+bool BackupDecoder::jsonByte(uint8_t b) {
+  switch (_json) {
+    case J_STRING:
+      if (b == '"') return !_highSurrogate ? jsonScalar(true) : fail("Malformed JSON");
+      if (b == '\\') {
+        _json = J_ESCAPE;
+        return true;
+      }
+      if (b < 0x20 || _highSurrogate) return fail("Malformed JSON");
+      return jsonChar(static_cast<char>(b));
+    case J_ESCAPE: {
+      static const char kFrom[] = "\"\\/bfnrt";
+      static const char kTo[] = "\"\\/\b\f\n\r\t";
+      if (b == 'u') {
+        _json = J_UNICODE;
+        _unit = 0;
+        _pos = 0;
+        return true;
+      }
+      const char* at = b ? strchr(kFrom, b) : nullptr;
+      if (!at || _highSurrogate) return fail("Malformed JSON");
+      _json = J_STRING;
+      return jsonChar(kTo[at - kFrom]);
+    }
+    case J_UNICODE: {
+      int digit = hexDigit(b);
+      if (digit < 0) return fail("Malformed JSON");
+      _unit = static_cast<uint16_t>(_unit << 4 | digit);
+      if (++_pos < 4) return true;
+      _json = J_STRING;
+      return jsonCodeUnit(_unit);
+    }
+    case J_LITERAL:
+      if ((b >= '0' && b <= '9') || (b >= 'a' && b <= 'z') || b == '-' || b == '+' || b == '.' || b == 'E') {
+        return jsonChar(static_cast<char>(b));
+      }
+      if (!jsonScalar(false)) return false;
+      break;  // the byte after the literal is read below
+    default:
+      break;
+  }
+  if (isJsonSpace(b)) return true;
+  switch (_json) {
+    case J_VALUE_OR_END:
+      if (b == ']') return jsonClose(b);
+      // fall through
+    case J_VALUE:
+      if (b == '{' || b == '[') return jsonOpen(b);
+      _text = String();
+      if (b == '"') {
+        _json = J_STRING;
+        _isKey = false;
+        return true;
+      }
+      if (!strchr("-0123456789tfn", b) || !b) return fail("Malformed JSON");
+      _json = J_LITERAL;
+      return jsonChar(static_cast<char>(b));
+    case J_KEY_OR_END:
+      if (b == '}') return jsonClose(b);
+      // fall through
+    case J_KEY:
+      if (b != '"') return fail("Malformed JSON");
+      _text = String();
+      _json = J_STRING;
+      _isKey = true;
+      return true;
+    case J_COLON:
+      if (b != ':') return fail("Malformed JSON");
+      _json = J_VALUE;
+      return true;
+    case J_COMMA_OR_END:
+      if (b == '}' || b == ']') return jsonClose(b);
+      if (b != ',') return fail("Malformed JSON");
+      _json = _open[_depth - 1] == '{' ? J_KEY : J_VALUE;
+      return true;
+    case J_DONE:
+      return fail("Data after end of backup");
+    default:
+      return fail("Malformed JSON");
+  }
+}
+
+bool BackupDecoder::jsonChar(char c) {
+  if (_text.length() >= kMaxRecordSize) return fail("Record too large");
+  _text += c;
+  return true;
+}
+
+// A \uXXXX escape as UTF-8; surrogate pairs arrive as two escapes.
+bool BackupDecoder::jsonCodeUnit(uint16_t unit) {
+  uint32_t cp = unit;
+  if (unit >= 0xD800 && unit < 0xDC00) {
+    if (_highSurrogate) return fail("Malformed JSON");
+    _highSurrogate = unit;
+    return true;
+  }
+  if (unit >= 0xDC00 && unit < 0xE000) {
+    if (!_highSurrogate) return fail("Malformed JSON");
+    cp = 0x10000 + ((static_cast<uint32_t>(_highSurrogate - 0xD800) << 10) | (unit - 0xDC00));
+    _highSurrogate = 0;
+  } else if (_highSurrogate || unit == 0) {
+    return fail("Malformed JSON");
+  }
+  if (cp < 0x80) return jsonChar(static_cast<char>(cp));
+  if (cp < 0x800) return jsonChar(static_cast<char>(0xC0 | cp >> 6)) && jsonChar(static_cast<char>(0x80 | (cp & 0x3F)));
+  if (cp < 0x10000) {
+    return jsonChar(static_cast<char>(0xE0 | cp >> 12)) && jsonChar(static_cast<char>(0x80 | ((cp >> 6) & 0x3F))) &&
+           jsonChar(static_cast<char>(0x80 | (cp & 0x3F)));
+  }
+  return jsonChar(static_cast<char>(0xF0 | cp >> 18)) && jsonChar(static_cast<char>(0x80 | ((cp >> 12) & 0x3F))) &&
+         jsonChar(static_cast<char>(0x80 | ((cp >> 6) & 0x3F))) && jsonChar(static_cast<char>(0x80 | (cp & 0x3F)));
+}
+
+// Depth 1 is the document, 2 a section's array, 3 one record in it.
+bool BackupDecoder::jsonOpen(uint8_t b) {
+  if (_depth == 0 && b != '{') return fail("Not a backup");
+  if (_depth == kMaxJsonDepth) return fail("Malformed JSON");
+  if (_depth == 2 && b == '{' && _section && _open[1] == '[') {
+    if (_records.size() == kMaxRecords) return fail("Too many records");
+    _record = BackupRecord{static_cast<BackupRecord::Type>(_section), String(), String(), 0};
+    _inRecord = true;
+    _haveKey = false;
+  }
+  _member = M_NONE;
+  _open[_depth++] = static_cast<char>(b);
+  _json = b == '{' ? J_KEY_OR_END : J_VALUE_OR_END;
+  return true;
+}
+
+bool BackupDecoder::jsonClose(uint8_t b) {
+  if ((b == '}') != (_open[_depth - 1] == '{')) return fail("Malformed JSON");
+  if (_depth == 3 && _inRecord) {
+    if (!_haveKey) return fail("Malformed record");
+    _records.push_back(_record);
+    _record = BackupRecord();
+    _inRecord = false;
+  }
+  _member = M_NONE;
+  if (--_depth == 0) {
+    _complete = true;
+    _json = J_DONE;
+  } else {
+    _json = J_COMMA_OR_END;
+  }
+  return true;
+}
+
+// A member name, string or literal has ended; `_text` holds it.
+bool BackupDecoder::jsonScalar(bool isString) {
+  const String& text = _text;
+  if (_isKey) {
+    _isKey = false;
+    _json = J_COLON;
+    if (_depth == 1) {
+      _section = text == "wifi_credentials" ? BackupRecord::CREDENTIAL
+                 : text == "parameters"     ? BackupRecord::PARAMETER
+                                            : 0;
+    } else if (_depth == 3 && _inRecord) {
+      bool cred = _record.type == BackupRecord::CREDENTIAL;
+      _member = text == (cred ? "ssid" : "id")         ? M_KEY
+                : text == (cred ? "password" : "value") ? M_VALUE
+                : cred && text == "priority"            ? M_PRIORITY
+                                                        : M_NONE;
+    }
+    return true;
+  }
+  _json = J_COMMA_OR_END;
+  char* end = nullptr;
+  if (!isString && text != "true" && text != "false" && text != "null") {
+    strtod(text.c_str(), &end);
+    if (*end) return fail("Malformed JSON");
+  }
+  if (_depth != 3 || !_inRecord || _member == M_NONE) return true;
+  if (_member == M_PRIORITY) {
+    long priority = isString ? 0 : strtol(text.c_str(), &end, 10);
+    if (isString || *end || priority < INT32_MIN || priority > INT32_MAX) return fail("Malformed record");
+    _record.priority = static_cast<int32_t>(priority);
+  } else if (!isString) {
+    return fail("Malformed record");
+  } else if (_member == M_KEY) {
+    _record.key = text;
+    _haveKey = true;
+  } else {
+    _record.value = text;
+  }
+  _member = M_NONE;
+  return true;
+}
+
+bool BackupDecoder::finish() {
+  if (_error) return false;
+  if (!_complete) return fail("Truncated backup");
+  return true;
+}
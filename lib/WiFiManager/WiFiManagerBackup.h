@@ -0,0 +1,122 @@
+#ifndef WIFI_MANAGER_BACKUP_H
+#define WIFI_MANAGER_BACKUP_H
+
+#include <Arduino.h>
+#include <functional>
+#include <vector>
+
+// Binary configuration snapshot (GET /backup?format=bin, POST /restore).
+//
+//   "WMBK" version:u8  record*  end-record
+//   record     = tag:u8 length:varint payload[length]
+//   credential = tag 0x01: str ssid, str password, varint zigzag(priority)
+//   parameter  = tag 0x02: str id, str value
+//   end-record = tag 0xFF, length 4, CRC-32 (IEEE, little endian) of every
+//                byte before its tag
+//   str        = length:varint bytes
+//
+// Varints are unsigned LEB128. Readers skip record tags they do not know, so
+// later versions can add records without breaking older firmware. Encoder
+// and decoder both work one record at a time: neither ever holds more than
+// one record (at most kMaxRecordSize bytes) of the document.
+//
+// The decoder also reads the JSON form GET /backup serves, told apart by its
+// first byte ('{' rather than 'W'):
+//
+//   {"wifi_credentials":[{"ssid":s,"password":s,"priority":n},...],
+//    "parameters":[{"id":s,"value":s,...},...]}
+//
+// Members it does not use (label, group) and unknown keys are skipped. JSON
+// carries no CRC; a document that does not close is truncated.
+
+struct BackupRecord {
+  enum Type : uint8_t { CREDENTIAL = 0x01, PARAMETER = 0x02 };
+  Type type;
+  String key;    // ssid or parameter id
+  String value;  // password or parameter value
+  int32_t priority;
+};
+
+uint32_t backupCrc32(uint32_t crc, const uint8_t* data, size_t len);
+
+class BackupEncoder {
+public:
+  static const uint8_t kVersion = 1;
+
+  // Fills the record at `index`; false once past the last one.
+  typedef std::function<bool(size_t index, BackupRecord& record)> Source;
+
+  explicit BackupEncoder(Source source);
+
+  // Next bytes of the document; 0 once it is complete.
+  size_t read(uint8_t* buffer, size_t maxLen);
+  size_t records() const { return _index; }
+
+private:
+  void encodeNext();
+
+  Source _source;
+  std::vector<uint8_t> _pending;  // current record (or header)
+  size_t _pendingPos;
+  size_t _index;
+  uint32_t _crc;
+  enum { HEADER, RECORDS, END, DONE } _stage;
+};
+
+class BackupDecoder {
+public:
+  static const size_t kMaxRecordSize = 1024;
+  static const size_t kMaxRecords = 256;
+
+  BackupDecoder();
+
+  void reset();
+  // Consumes the next bytes; false once the document is known to be bad.
+  bool write(const uint8_t* data, size_t len);
+  // True if the document ended with a matching CRC.
+  bool finish();
+
+  bool failed() const { return _error != nullptr; }
+  const char* error() const { return _error; }
+  const std::vector<BackupRecord>& records() const { return _records; }
+
+private:
+  static const uint8_t kMaxJsonDepth = 8;
+
+  bool fail(const char* error);
+  bool parseRecord();
+  bool jsonByte(uint8_t b);
+  bool jsonChar(char c);
+  bool jsonCodeUnit(uint16_t unit);
+  bool jsonOpen(uint8_t b);
+  bool jsonClose(uint8_t b);
+  bool jsonScalar(bool isString);
+
+  enum { MAGIC, TAG, LENGTH, PAYLOAD, SKIP, TRAILING, JSON } _state;
+  uint8_t _tag;
+  uint32_t _length;
+  uint8_t _shift;
+  size_t _pos;  // bytes of the header or payload seen so far
+  uint32_t _crc;
+  bool _complete;
+  std::vector<uint8_t> _payload;
+  std::vector<BackupRecord> _records;
+  const char* _error;
+
+  // JSON form
+  enum { J_VALUE, J_VALUE_OR_END, J_KEY, J_KEY_OR_END, J_COLON, J_COMMA_OR_END,
+         J_STRING, J_ESCAPE, J_UNICODE, J_LITERAL, J_DONE } _json;
+  char _open[kMaxJsonDepth];  // '{' or '[' per nesting level
+  uint8_t _depth;
+  bool _isKey;                // the string being read is a member name
+  uint16_t _unit;             // \uXXXX being read
+  uint16_t _highSurrogate;    // first half of a pair, 0 if none
+  uint8_t _section;           // record type of the array being read, 0 = skip
+  enum { M_NONE, M_KEY, M_VALUE, M_PRIORITY } _member;
+  bool _inRecord;
+  bool _haveKey;
+  BackupRecord _record;
+  String _text;               // string or literal being read
+};
+
+#endif // WIFI_MANAGER_BACKUP_H
@@ -0,0 +1,75 @@
+#include "WiFiManagerDNS.h"
+#include "WiFiManagerTrace.h"
+
+const size_t CaptiveDNS::kMaxPacket;
+
+static const size_t kHeaderSize = 12;
+static const std::memory_order kRelaxed = std::memory_order_relaxed;
+
+CaptiveDNS::CaptiveDNS() : _queries(0), _answers(0), _dropped(0) {
+  memset(_record, 0, sizeof(_record));
+}
+
+// ----- Setup -----
+bool CaptiveDNS::begin(const IPAddress& portal, uint16_t port, uint32_t ttl) {
+  end();
+  // Pointer to the question name at offset 12, type A, class IN.
+  const uint8_t head[] = {0xC0, 0x0C, 0x00, 0x01, 0x00, 0x01,
+                          static_cast<uint8_t>(ttl >> 24), static_cast<uint8_t>(ttl >> 16),
+                          static_cast<uint8_t>(ttl >> 8), static_cast<uint8_t>(ttl), 0x00, 0x04};
+  memcpy(_record, head, sizeof(head));
+  for (uint8_t i = 0; i < 4; i++) _record[sizeof(head) + i] = portal[i];
+  _udp.onPacket([this](AsyncUDPPacket& packet) {
+    WM_TRACE_SCOPE(kTraceDns);
+    _queries.fetch_add(1, kRelaxed);
+    uint8_t reply[kMaxPacket];
+    size_t len = answer(packet.data(), packet.length(), reply);
+    if (len) packet.write(reply, len);
+  });
+  return _udp.listen(port);
+}
+
+void CaptiveDNS::end() {
+  _udp.close();
+}
+
+// ----- Answer -----
+size_t CaptiveDNS::answer(const uint8_t* query, size_t len, uint8_t* reply) {
+  // A standard query (QR=0, opcode 0) with exactly one question.
+  if (len < kHeaderSize || len > kMaxPacket || (query[2] & 0xF8) != 0 || query[4] != 0 || query[5] != 1) {
+    _dropped.fetch_add(1, kRelaxed);
+    return 0;
+  }
+  // Skip the question name; queries never compress it.
+  size_t pos = kHeaderSize;
+  while (pos < len && query[pos] != 0) {
+    if (query[pos] & 0xC0) pos = len;
+    else pos += 1 + query[pos];
+  }
+  size_t end = pos + 1 + 4;  // root label, QTYPE, QCLASS
+  if (pos >= len || end > len || end + sizeof(_record) > kMaxPacket) {
+    _dropped.fetch_add(1, kRelaxed);
+    return 0;
+  }
+  bool isA = query[end - 4] == 0 && query[end - 3] == 1 && query[end - 2] == 0 && query[end - 1] == 1;
+
+  // Header and question as received; additional records (EDNS) are left out.
+  memcpy(reply, query, end);
+  reply[2] = 0x84 | (query[2] & 0x01);  // response, authoritative, keep RD
+  reply[3] = 0x80;                      // RA, NOERROR
+  reply[6] = 0;
+  reply[7] = isA ? 1 : 0;
+  reply[8] = reply[9] = reply[10] = reply[11] = 0;
+  if (!isA) return end;
+  memcpy(reply + end, _record, sizeof(_record));
+  _answers.fetch_add(1, kRelaxed);
+  return end + sizeof(_record);
+}
+
+CaptiveDNSStats CaptiveDNS::stats() const {
+  CaptiveDNSStats s;
+  s.queries = _queries.load(kRelaxed);
+  s.answers = _answers.load(kRelaxed);
+  s.dropped = _dropped.load(kRelaxed);
+  return s;
+}
@@ -0,0 +1,49 @@
+#ifndef WIFI_MANAGER_DNS_H
+#define WIFI_MANAGER_DNS_H
+
+#include <Arduino.h>
+#include <AsyncUDP.h>
+#include <atomic>
+
+// Captive-portal DNS responder.
+//
+// Every A query, whatever the name, resolves to the portal address, so the
+// connectivity probe a phone sends right after joining the access point
+// reaches the portal and the OS opens its sign-in sheet. Packets are answered
+// from the AsyncUDP callback as they arrive (the async_udp task on the
+// device), not from WiFiManager::loop(), so a burst of probes is answered at
+// once rather than one per loop pass. The answer record is built once in
+// begin(); a reply is the query's header and question with that record
+// appended, assembled on the stack. Other query types get an empty NOERROR
+// answer, which sends clients back to their A lookup.
+
+struct CaptiveDNSStats {
+  uint32_t queries;  // datagrams received
+  uint32_t answers;  // A records sent
+  uint32_t dropped;  // malformed or not a standard query; no reply
+};
+
+class CaptiveDNS {
+public:
+  static const size_t kMaxPacket = 512;  // plain DNS over UDP, no EDNS
+
+  CaptiveDNS();
+
+  bool begin(const IPAddress& portal, uint16_t port = 53, uint32_t ttl = 60);
+  void end();
+  bool running() const { return _udp.connected(); }
+
+  // The reply to `query` in `reply` (kMaxPacket bytes); 0 = send nothing.
+  size_t answer(const uint8_t* query, size_t len, uint8_t* reply);
+
+  CaptiveDNSStats stats() const;
+
+private:
+  AsyncUDP _udp;
+  uint8_t _record[16];  // name pointer, type A, class IN, TTL, length, address
+  std::atomic<uint32_t> _queries;
+  std::atomic<uint32_t> _answers;
+  std::atomic<uint32_t> _dropped;
+};
+
+#endif // WIFI_MANAGER_DNS_H
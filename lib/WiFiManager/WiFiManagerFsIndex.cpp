@@ -0,0 +1,60 @@
+#include "WiFiManagerFsIndex.h"
+#include <algorithm>
+
+static bool nameLess(const FsEntry& entry, const char* name) { return strcmp(entry.name.c_str(), name) < 0; }
+
+FsIndex::FsIndex(fs::FS& fs) : _fs(fs), _walks(0) {}
+
+const char* FsIndex::baseName(const String& path) {
+  const char* name = path.c_str();
+  return *name == '/' ? name + 1 : name;
+}
+
+std::shared_ptr<const FsIndex::Entries> FsIndex::entries() {
+  if (_entries) return _entries;
+  std::shared_ptr<Entries> walked = std::make_shared<Entries>();
+  File dir = _fs.open("/");
+  File file = dir ? dir.openNextFile() : File();
+  while (file) {
+    if (!file.isDirectory()) walked->push_back(FsEntry{file.name(), static_cast<uint32_t>(file.size()), file.getLastWrite()});
+    file = dir.openNextFile();
+  }
+  std::sort(walked->begin(), walked->end(),
+            [](const FsEntry& a, const FsEntry& b) { return strcmp(a.name.c_str(), b.name.c_str()) < 0; });
+  _walks++;
+  _entries = walked;
+  return _entries;
+}
+
+void FsIndex::update(const String& path, uint32_t size, time_t mtime) {
+  if (!_entries) return;  // the first listing walks anyway
+  const char* name = baseName(path);
+  std::shared_ptr<Entries> next = std::make_shared<Entries>(*_entries);
+  auto it = std::lower_bound(next->begin(), next->end(), name, nameLess);
+  if (it != next->end() && it->name == name) {
+    it->size = size;
+    it->mtime = mtime;
+  } else {
+    next->insert(it, FsEntry{name, size, mtime});
+  }
+  _entries = next;
+}
+
+void FsIndex::remove(const String& path) {
+  if (!_entries) return;
+  const char* name = baseName(path);
+  auto it = std::lower_bound(_entries->begin(), _entries->end(), name, nameLess);
+  if (it == _entries->end() || it->name != name) return;
+  std::shared_ptr<Entries> next = std::make_shared<Entries>(*_entries);
+  next->erase(next->begin() + (it - _entries->begin()));
+  _entries = next;
+}
+
+void FsIndex::prefixRange(const Entries& entries, const String& prefix, size_t& first, size_t& last) {
+  auto begin = std::lower_bound(entries.begin(), entries.end(), prefix.c_str(), nameLess);
+  auto end = std::partition_point(begin, entries.end(), [&prefix](const FsEntry& entry) {
+    return strncmp(entry.name.c_str(), prefix.c_str(), prefix.length()) == 0;
+  });
+  first = begin - entries.begin();
+  last = end - entries.begin();
+}
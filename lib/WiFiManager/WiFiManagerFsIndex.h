@@ -0,0 +1,45 @@
+#ifndef WIFI_MANAGER_FS_INDEX_H
+#define WIFI_MANAGER_FS_INDEX_H
+
+#include <Arduino.h>
+#include <FS.h>
+#include <memory>
+#include <vector>
+
+// In-memory index of the SPIFFS root for the file explorer.
+//
+// Walking the root with openNextFile() opens every file, so a listing costs
+// one name lookup per entry. The index walks once, on first use, and is then
+// kept current by the upload and delete handlers. Entries are sorted by name
+// so a prefix is a contiguous range. Updates replace the whole vector (copy on
+// write), which lets a response that is still streaming keep its snapshot.
+struct FsEntry {
+  String name;  // without the leading '/'
+  uint32_t size;
+  time_t mtime;
+};
+
+class FsIndex {
+public:
+  typedef std::vector<FsEntry> Entries;
+
+  explicit FsIndex(fs::FS& fs);
+
+  std::shared_ptr<const Entries> entries();  // walks the root on first use
+  void update(const String& path, uint32_t size, time_t mtime);
+  void remove(const String& path);
+  void invalidate() { _entries.reset(); }
+  uint32_t walks() const { return _walks; }
+
+  // Index range [first, last) of the names starting with prefix.
+  static void prefixRange(const Entries& entries, const String& prefix, size_t& first, size_t& last);
+
+private:
+  static const char* baseName(const String& path);
+
+  fs::FS& _fs;
+  std::shared_ptr<const Entries> _entries;
+  uint32_t _walks;
+};
+
+#endif // WIFI_MANAGER_FS_INDEX_H
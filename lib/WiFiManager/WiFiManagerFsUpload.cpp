@@ -0,0 +1,95 @@
+#include "WiFiManagerFsUpload.h"
+
+// SPIFFS names are limited to 31 characters, so the temp file gets a short
+// numbered name rather than a suffix on the target.
+static uint32_t s_uploadSeq = 0;
+
+FsUpload::FsUpload(fs::FS& fs)
+  : _fs(fs), _buffered(0), _written(0), _running(false), _error(nullptr) {}
+
+FsUpload::~FsUpload() { abort(); }
+
+bool FsUpload::begin(const String& path) {
+  abort();
+  _error = nullptr;
+  _path = path;
+  _written = 0;
+  _buffered = 0;
+  _temp = "/.upload" + String(s_uploadSeq++ % 100);
+  if (!_buffer) _buffer.reset(new uint8_t[kWriteSize]);
+  _file = _fs.open(_temp, FILE_WRITE);
+  if (!_file) {
+    fail("Failed to create file");
+    return false;
+  }
+  _running = true;
+  return true;
+}
+
+bool FsUpload::write(const uint8_t* data, size_t len) {
+  if (!_running) return false;
+  while (len) {
+    // Whole sectors go straight through when nothing is pending.
+    if (!_buffered && len >= kWriteSize) {
+      size_t n = len - len % kWriteSize;
+      if (_file.write(data, n) != n) {
+        fail("Write failed");
+        return false;
+      }
+      _written += n;
+      data += n;
+      len -= n;
+      continue;
+    }
+    size_t n = kWriteSize - _buffered;
+    if (n > len) n = len;
+    memcpy(_buffer.get() + _buffered, data, n);
+    _buffered += n;
+    data += n;
+    len -= n;
+    if (_buffered == kWriteSize && !flush()) return false;
+  }
+  return true;
+}
+
+bool FsUpload::flush() {
+  if (!_buffered) return true;
+  if (_file.write(_buffer.get(), _buffered) != _buffered) {
+    fail("Write failed");
+    return false;
+  }
+  _written += _buffered;
+  _buffered = 0;
+  return true;
+}
+
+bool FsUpload::end() {
+  if (!_running || !flush()) return false;
+  _file.close();
+  _running = false;
+  // SPIFFS rename does not replace an existing file.
+  if (_fs.exists(_path)) _fs.remove(_path);
+  if (!_fs.rename(_temp, _path)) {
+    _fs.remove(_temp);
+    _error = "Rename failed";
+    return false;
+  }
+  _buffer.reset();
+  return true;
+}
+
+void FsUpload::abort() {
+  if (!_running) return;
+  fail("Aborted");
+}
+
+void FsUpload::fail(const char* error) {
+  _error = error;
+  _running = false;
+  _buffered = 0;
+  if (_file) {
+    _file.close();
+    _fs.remove(_temp);
+  }
+  _buffer.reset();
+}
@@ -0,0 +1,53 @@
+#ifndef WIFI_MANAGER_FS_UPLOAD_H
+#define WIFI_MANAGER_FS_UPLOAD_H
+
+#include <Arduino.h>
+#include <FS.h>
+#include <memory>
+
+// File explorer upload into SPIFFS.
+//
+// The upload callback hands over one TCP segment (~1.4 KB) at a time. Opening
+// the target for append on every chunk costs a name lookup, a walk of the
+// object index to the end of the file and an index flush on close, so the
+// cost of each chunk grows with the file. FsUpload instead keeps one handle
+// open for the whole upload and collects chunks into sector-sized writes.
+// Data goes to a hidden temp file that replaces the target only once the
+// upload completed; an aborted upload removes the temp file and leaves the
+// previous version in place.
+class FsUpload {
+public:
+  static const size_t kWriteSize = 4096;  // one flash sector / SPIFFS block
+
+  explicit FsUpload(fs::FS& fs);
+  ~FsUpload();  // aborts an unfinished upload
+  FsUpload(const FsUpload&) = delete;
+  FsUpload& operator=(const FsUpload&) = delete;
+
+  bool begin(const String& path);
+  bool write(const uint8_t* data, size_t len);
+  bool end();  // flushes, then renames the temp file onto the target
+  void abort();
+
+  bool running() const { return _running; }
+  bool failed() const { return _error != nullptr; }
+  const char* error() const { return _error; }
+  const String& path() const { return _path; }
+  size_t written() const { return _written; }
+
+private:
+  bool flush();
+  void fail(const char* error);
+
+  fs::FS& _fs;
+  File _file;
+  String _path;
+  String _temp;
+  std::unique_ptr<uint8_t[]> _buffer;
+  size_t _buffered;
+  size_t _written;
+  bool _running;
+  const char* _error;
+};
+
+#endif // WIFI_MANAGER_FS_UPLOAD_H
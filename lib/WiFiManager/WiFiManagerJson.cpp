@@ -0,0 +1,124 @@
+#include "WiFiManagerJson.h"
+
+JsonStreamWriter::JsonStreamWriter(uint8_t* buf, size_t maxLen, size_t skip) : _out(buf, maxLen, skip) {}
+
+JsonStreamWriter::JsonStreamWriter(uint8_t* buf, size_t maxLen, size_t skip, const State& state)
+  : _out(buf, maxLen, skip), _state(state) {}
+
+// ----- Output -----
+void JsonStreamWriter::escaped(const char* s) {
+  static const char hex[] = "0123456789abcdef";
+  const char* run = s;
+  for (; *s; s++) {
+    unsigned char c = static_cast<unsigned char>(*s);
+    if (c >= 0x20 && c != '"' && c != '\\') continue;
+    raw(run, s - run);
+    raw('\\');
+    switch (c) {
+      case '"': raw('"'); break;
+      case '\\': raw('\\'); break;
+      case '\n': raw('n'); break;
+      case '\r': raw('r'); break;
+      case '\t': raw('t'); break;
+      default: {
+        char esc[5] = {'u', '0', '0', hex[c >> 4], hex[c & 0xF]};
+        raw(esc, sizeof(esc));
+      }
+    }
+    run = s + 1;
+  }
+  raw(run, s - run);
+}
+
+// Commas are implied by position: every element after the first in a
+// container gets one, a value directly after its key does not.
+void JsonStreamWriter::separator() {
+  if (_state.afterKey) {
+    _state.afterKey = false;
+    return;
+  }
+  if (_state.depth == 0) return;
+  uint32_t bit = 1UL << ((_state.depth - 1) & 31);
+  if (_state.hasItems & bit) raw(',');
+  _state.hasItems |= bit;
+}
+
+// ----- Structure -----
+void JsonStreamWriter::beginObject() {
+  separator();
+  raw('{');
+  _state.depth++;
+  _state.hasItems &= ~(1UL << ((_state.depth - 1) & 31));
+}
+
+void JsonStreamWriter::endObject() {
+  raw('}');
+  if (_state.depth) _state.depth--;
+}
+
+void JsonStreamWriter::beginArray() {
+  separator();
+  raw('[');
+  _state.depth++;
+  _state.hasItems &= ~(1UL << ((_state.depth - 1) & 31));
+}
+
+void JsonStreamWriter::endArray() {
+  raw(']');
+  if (_state.depth) _state.depth--;
+}
+
+void JsonStreamWriter::key(const char* name) {
+  separator();
+  raw('"');
+  escaped(name);
+  raw("\":", 2);
+  _state.afterKey = true;
+}
+
+// ----- Values -----
+void JsonStreamWriter::value(const char* str) {
+  separator();
+  raw('"');
+  escaped(str ? str : "");
+  raw('"');
+}
+
+void JsonStreamWriter::value(long long number) {
+  separator();
+  char tmp[24];
+  int len = snprintf(tmp, sizeof(tmp), "%lld", number);
+  raw(tmp, len);
+}
+
+void JsonStreamWriter::value(unsigned long long number) {
+  separator();
+  char tmp[24];
+  int len = snprintf(tmp, sizeof(tmp), "%llu", number);
+  raw(tmp, len);
+}
+
+void JsonStreamWriter::value(bool flag) {
+  separator();
+  if (flag) raw("true", 4);
+  else raw("false", 5);
+}
+
+void JsonStreamWriter::valueNull() {
+  separator();
+  raw("null", 4);
+}
+
+void JsonStreamWriter::valueIP(const IPAddress& ip) {
+  separator();
+  char tmp[18];
+  int len = snprintf(tmp, sizeof(tmp), "\"%u.%u.%u.%u\"", ip[0], ip[1], ip[2], ip[3]);
+  raw(tmp, len);
+}
+
+// ----- Measuring -----
+size_t measureJson(const JsonRenderer& render) {
+  JsonStreamWriter json(nullptr, 0, 0);
+  render(json);
+  return json.produced();
+}
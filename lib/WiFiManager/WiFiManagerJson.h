@@ -0,0 +1,108 @@
+#ifndef WIFI_MANAGER_JSON_H
+#define WIFI_MANAGER_JSON_H
+
+#include <Arduino.h>
+#include <functional>
+#include "WiFiManagerWindow.h"
+
+// Streaming JSON emitter used by the API handlers.
+//
+// A writer is bound to one OutputWindow of a chunked response: the renderer
+// emits the whole document every time, and only the bytes for this chunk are
+// copied, straight into the TCP buffer. Nothing is buffered on the heap, so peak memory does not depend on how many
+// parameters or networks are listed. Renderers must therefore be
+// deterministic across calls; volatile values (RSSI, heap, ...) are captured
+// once when the request arrives. Long documents are rendered in pieces
+// through a JsonCursor instead, so a chunk only replays the piece it resumes.
+class JsonStreamWriter {
+public:
+  // Nesting at a point in the document, for resuming there.
+  struct State {
+    State() : hasItems(0), depth(0), afterKey(false) {}
+    uint32_t hasItems;  // bit per nesting level: container already has an element
+    uint8_t depth;
+    bool afterKey;
+  };
+
+  JsonStreamWriter(uint8_t* buf, size_t maxLen, size_t skip = 0);
+  JsonStreamWriter(uint8_t* buf, size_t maxLen, size_t skip, const State& state);
+
+  void beginObject();
+  void endObject();
+  void beginArray();
+  void endArray();
+  void key(const char* name);
+
+  void value(const char* str);
+  void value(const String& str) { value(str.c_str()); }
+  void value(long long number);
+  void value(unsigned long long number);
+  void value(int number) { value(static_cast<long long>(number)); }
+  void value(unsigned int number) { value(static_cast<unsigned long long>(number)); }
+  void value(long number) { value(static_cast<long long>(number)); }
+  void value(unsigned long number) { value(static_cast<unsigned long long>(number)); }
+  void value(bool flag);
+  void valueNull();
+  void valueIP(const IPAddress& ip);
+
+  // key + value in one call.
+  template <typename T>
+  void field(const char* name, const T& v) {
+    key(name);
+    value(v);
+  }
+
+  size_t written() const { return _out.written(); }  // bytes placed in buf
+  size_t produced() const { return _out.produced(); }  // logical document offset
+  bool full() const { return _out.full(); }
+  State state() const { return _state; }
+
+private:
+  void separator();
+  void raw(const char* s, size_t len) { _out.write(s, len); }
+  void raw(char c) { _out.write(c); }
+  void escaped(const char* s);
+
+  OutputWindow _out;
+  State _state;
+};
+
+// Resumable rendering for chunked responses. `render(json, piece)` writes
+// piece number `piece` of the document (a header, one list row, a closing
+// bracket, ...) and returns false once there is no such piece. The cursor
+// remembers which piece the last chunk stopped in, where it starts and the
+// nesting there, so each chunk renders only from that piece on rather than
+// the whole document from its first byte.
+class JsonCursor {
+public:
+  JsonCursor() : _piece(0), _start(0) {}
+
+  template <typename Render>
+  size_t fill(uint8_t* buf, size_t maxLen, size_t index, const Render& render) {
+    if (index < _start) *this = JsonCursor();  // rewound: start over
+    size_t written = 0;
+    while (written < maxLen) {
+      size_t at = index + written;
+      JsonStreamWriter json(buf + written, maxLen - written, at - _start, _state);
+      if (!render(json, _piece)) break;
+      written += json.written();
+      if (_start + json.produced() > index + written) break;  // piece continues in the next chunk
+      _start += json.produced();
+      _state = json.state();
+      _piece++;
+    }
+    return written;
+  }
+
+private:
+  size_t _piece;
+  size_t _start;  // document offset of _piece
+  JsonStreamWriter::State _state;
+};
+
+typedef std::function<void(JsonStreamWriter& json)> JsonRenderer;
+
+// Total size of the document `render` produces (used by tests and benchmarks).
+size_t measureJson(const JsonRenderer& render);
+
+#endif // WIFI_MANAGER_JSON_H
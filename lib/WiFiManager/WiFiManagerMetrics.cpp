@@ -0,0 +1,141 @@
+#include "WiFiManagerMetrics.h"
+
+// Upper bucket bounds: 0.5 ms .. 5 s, roughly 1-2.5-5 per decade.
+const uint32_t HttpMetrics::kBoundsMicros[HttpMetrics::kBounds] = {
+  500, 1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000, 500000, 1000000, 2500000, 5000000,
+};
+const uint8_t HttpMetrics::kMaxRoutes;
+const uint8_t HttpMetrics::kNoRoute;
+const uint8_t HttpMetrics::kBounds;
+
+static const std::memory_order kRelaxed = std::memory_order_relaxed;
+
+// ----- HttpMetrics -----
+HttpMetrics::HttpMetrics() : _count(0), _current(kNoRoute) {
+  for (Route& r : _routes) {
+    r.route = nullptr;
+    r.requests.store(0, kRelaxed);
+    r.errors.store(0, kRelaxed);
+    r.bytes.store(0, kRelaxed);
+    r.sumMicros.store(0, kRelaxed);
+    for (auto& b : r.buckets) b.store(0, kRelaxed);
+  }
+}
+
+uint8_t HttpMetrics::addRoute(const char* route) {
+  uint8_t n = _count.load(kRelaxed);
+  for (uint8_t i = 0; i < n; i++) {
+    if (strcmp(_routes[i].route, route) == 0) return i;  // same path, other method
+  }
+  if (n >= kMaxRoutes) return kNoRoute;
+  _routes[n].route = route;
+  _count.store(n + 1, std::memory_order_release);
+  return n;
+}
+
+void HttpMetrics::record(uint8_t route, uint32_t micros, int code, size_t bytes) {
+  if (route >= kMaxRoutes) return;
+  Route& r = _routes[route];
+  uint8_t bucket = 0;
+  while (bucket < kBounds && micros > kBoundsMicros[bucket]) bucket++;
+  r.requests.fetch_add(1, kRelaxed);
+  if (code >= 400) r.errors.fetch_add(1, kRelaxed);
+  if (bytes) r.bytes.fetch_add(bytes, kRelaxed);
+  r.sumMicros.fetch_add(micros, kRelaxed);
+  r.buckets[bucket].fetch_add(1, kRelaxed);
+}
+
+void HttpMetrics::addBytes(uint8_t route, size_t bytes) {
+  if (route < kMaxRoutes && bytes) _routes[route].bytes.fetch_add(bytes, kRelaxed);
+}
+
+void HttpMetrics::snapshot(std::vector<RouteSnapshot>& out) const {
+  uint8_t n = _count.load(std::memory_order_acquire);
+  out.resize(n);
+  for (uint8_t i = 0; i < n; i++) {
+    const Route& r = _routes[i];
+    RouteSnapshot& s = out[i];
+    s.route = r.route;
+    s.requests = r.requests.load(kRelaxed);
+    s.errors = r.errors.load(kRelaxed);
+    s.bytes = r.bytes.load(kRelaxed);
+    s.sumMicros = r.sumMicros.load(kRelaxed);
+    for (uint8_t b = 0; b <= kBounds; b++) s.buckets[b] = r.buckets[b].load(kRelaxed);
+  }
+}
+
+// ----- MetricsWriter -----
+MetricsWriter::MetricsWriter(uint8_t* buf, size_t maxLen, size_t skip) : _out(buf, maxLen, skip) {}
+
+void MetricsWriter::family(const char* name, const char* type, const char* help) {
+  raw("# HELP ");
+  raw(name);
+  raw(" ");
+  raw(help);
+  raw("\n# TYPE ");
+  raw(name);
+  raw(" ");
+  raw(type);
+  raw("\n");
+}
+
+void MetricsWriter::labels(const char* name, const char* route, const char* le) {
+  raw(name);
+  if (!route && !le) return;
+  raw("{");
+  if (route) {
+    raw("route=\"");
+    raw(route);
+    raw("\"");
+  }
+  if (le) {
+    raw(route ? ",le=\"" : "le=\"");
+    raw(le);
+    raw("\"");
+  }
+  raw("}");
+}
+
+void MetricsWriter::sample(const char* name, const char* route, const char* le, unsigned long long value) {
+  char text[24];
+  labels(name, route, le);
+  raw(text, snprintf(text, sizeof(text), " %llu\n", value));
+}
+
+void MetricsWriter::seconds(const char* name, const char* route, uint64_t micros) {
+  char text[32];
+  labels(name, route, nullptr);
+  raw(text, snprintf(text, sizeof(text), " %llu.%06llu\n", static_cast<unsigned long long>(micros / 1000000),
+                     static_cast<unsigned long long>(micros % 1000000)));
+}
+
+void MetricsWriter::labeled(const char* name, const char* labels, unsigned long long value) {
+  char text[24];
+  raw(name);
+  raw("{");
+  raw(labels);
+  raw("}");
+  raw(text, snprintf(text, sizeof(text), " %llu\n", value));
+}
+
+void MetricsWriter::histogram(const char* name, const HttpMetrics::RouteSnapshot& route) {
+  char metric[64];
+  char le[16];
+  snprintf(metric, sizeof(metric), "%s_bucket", name);
+  unsigned long long cumulative = 0;
+  for (uint8_t b = 0; b < HttpMetrics::kBounds; b++) {
+    cumulative += route.buckets[b];
+    uint32_t us = HttpMetrics::kBoundsMicros[b];
+    // Shortest decimal form of the bound in seconds: 0.0005, 0.001, 2.5, ...
+    int len = snprintf(le, sizeof(le), "%u.%06u", static_cast<unsigned>(us / 1000000), static_cast<unsigned>(us % 1000000));
+    while (len > 0 && le[len - 1] == '0') le[--len] = '\0';
+    if (len > 0 && le[len - 1] == '.') le[--len] = '\0';
+    sample(metric, route.route, le, cumulative);
+  }
+  cumulative += route.buckets[HttpMetrics::kBounds];
+  sample(metric, route.route, "+Inf", cumulative);
+  snprintf(metric, sizeof(metric), "%s_sum", name);
+  seconds(metric, route.route, route.sumMicros);
+  snprintf(metric, sizeof(metric), "%s_count", name);
+  sample(metric, route.route, nullptr, cumulative);
+}
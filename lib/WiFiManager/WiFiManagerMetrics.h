@@ -0,0 +1,95 @@
+#ifndef WIFI_MANAGER_METRICS_H
+#define WIFI_MANAGER_METRICS_H
+
+#include <Arduino.h>
+#include <atomic>
+#include <vector>
+#include "WiFiManagerWindow.h"
+
+// Per-route HTTP metrics for /metrics (Prometheus text format 0.0.4).
+//
+// Every route registered in begin() owns a fixed slot: request, error and
+// byte counters plus a latency histogram with fixed bucket bounds. Recording
+// is a few relaxed atomic increments, 32-bit and lock-free on Xtensa and on
+// the host except for the 64-bit latency sum (on Xtensa a short critical
+// section in libatomic): no allocation, so instrumented handlers never wait
+// on a scrape. A scrape copies the slots into a snapshot and streams that.
+
+class HttpMetrics {
+public:
+  static const uint8_t kMaxRoutes = 24;
+  static const uint8_t kNoRoute = 0xFF;
+  static const uint8_t kBounds = 13;               // finite buckets; +Inf follows
+  static const uint32_t kBoundsMicros[kBounds];
+
+  struct RouteSnapshot {
+    const char* route;
+    uint32_t requests;
+    uint32_t errors;                               // responses with status >= 400
+    uint32_t bytes;                                // response body bytes
+    uint64_t sumMicros;
+    uint32_t buckets[kBounds + 1];                 // not cumulative; last is +Inf
+  };
+
+  HttpMetrics();
+
+  // Registers a route label (kept by pointer); kNoRoute once the table is full.
+  uint8_t addRoute(const char* route);
+  void record(uint8_t route, uint32_t micros, int code, size_t bytes);
+  void addBytes(uint8_t route, size_t bytes);
+
+  // Route whose handler is running on the server task, so responses streamed
+  // after it returns can still be charged to it.
+  uint8_t current() const { return _current; }
+  uint8_t enter(uint8_t route) {
+    uint8_t outer = _current;
+    _current = route;
+    return outer;
+  }
+  void leave(uint8_t outer) { _current = outer; }
+
+  void snapshot(std::vector<RouteSnapshot>& out) const;
+
+private:
+  struct Route {
+    const char* route;
+    std::atomic<uint32_t> requests;
+    std::atomic<uint32_t> errors;
+    std::atomic<uint32_t> bytes;
+    std::atomic<uint64_t> sumMicros;
+    std::atomic<uint32_t> buckets[kBounds + 1];
+  };
+
+  Route _routes[kMaxRoutes];
+  std::atomic<uint8_t> _count;
+  uint8_t _current;
+};
+
+// Prometheus text writer over an OutputWindow, like JsonStreamWriter: the
+// renderer emits the whole exposition on every call and only the bytes for
+// this chunk are copied out.
+class MetricsWriter {
+public:
+  MetricsWriter(uint8_t* buf, size_t maxLen, size_t skip = 0);
+
+  // "# HELP" and "# TYPE" lines opening a metric family.
+  void family(const char* name, const char* type, const char* help);
+  // name{route="...",le="..."} value; route and le may be nullptr.
+  void sample(const char* name, const char* route, const char* le, unsigned long long value);
+  // Same, with `micros` written as seconds.
+  void seconds(const char* name, const char* route, uint64_t micros);
+  // name{labels} value, with `labels` already formatted: class="scan",code="503".
+  void labeled(const char* name, const char* labels, unsigned long long value);
+  void histogram(const char* name, const HttpMetrics::RouteSnapshot& route);
+
+  size_t written() const { return _out.written(); }
+
+private:
+  void labels(const char* name, const char* route, const char* le);
+  void raw(const char* s, size_t len) { _out.write(s, len); }
+  void raw(const char* s) { raw(s, strlen(s)); }
+
+  OutputWindow _out;
+};
+
+#endif // WIFI_MANAGER_METRICS_H
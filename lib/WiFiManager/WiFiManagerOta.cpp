@@ -0,0 +1,221 @@
+#include "WiFiManagerOta.h"
+
+// ----- SHA-256 -----
+#ifdef ESP_PLATFORM
+
+Sha256::Sha256() {
+  mbedtls_sha256_init(&_ctx);
+  reset();
+}
+
+Sha256::~Sha256() { mbedtls_sha256_free(&_ctx); }
+
+void Sha256::reset() { mbedtls_sha256_starts(&_ctx, 0); }
+
+void Sha256::update(const uint8_t* data, size_t len) { mbedtls_sha256_update(&_ctx, data, len); }
+
+void Sha256::finish(uint8_t digest[kDigestSize]) { mbedtls_sha256_finish(&_ctx, digest); }
+
+#else
+
+static const uint32_t kRoundConstants[64] = {
+  0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+  0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+  0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+  0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+  0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+  0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+  0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+  0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+static inline uint32_t rotr(uint32_t x, unsigned n) { return (x >> n) | (x << (32 - n)); }
+
+Sha256::Sha256() { reset(); }
+
+Sha256::~Sha256() {}
+
+void Sha256::reset() {
+  static const uint32_t kInit[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                                    0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+  memcpy(_state, kInit, sizeof(_state));
+  _length = 0;
+  _blockLen = 0;
+}
+
+void Sha256::compress(const uint8_t block[64]) {
+  uint32_t w[64];
+  for (int i = 0; i < 16; i++) {
+    w[i] = (uint32_t(block[4 * i]) << 24) | (uint32_t(block[4 * i + 1]) << 16) |
+           (uint32_t(block[4 * i + 2]) << 8) | uint32_t(block[4 * i + 3]);
+  }
+  for (int i = 16; i < 64; i++) {
+    uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+    uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+    w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+  }
+  uint32_t a = _state[0], b = _state[1], c = _state[2], d = _state[3];
+  uint32_t e = _state[4], f = _state[5], g = _state[6], h = _state[7];
+  for (int i = 0; i < 64; i++) {
+    uint32_t t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) + kRoundConstants[i] + w[i];
+    uint32_t t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+    h = g;
+    g = f;
+    f = e;
+    e = d + t1;
+    d = c;
+    c = b;
+    b = a;
+    a = t1 + t2;
+  }
+  _state[0] += a;
+  _state[1] += b;
+  _state[2] += c;
+  _state[3] += d;
+  _state[4] += e;
+  _state[5] += f;
+  _state[6] += g;
+  _state[7] += h;
+}
+
+void Sha256::update(const uint8_t* data, size_t len) {
+  _length += len;
+  if (_blockLen) {
+    size_t n = len < 64 - _blockLen ? len : 64 - _blockLen;
+    memcpy(_block + _blockLen, data, n);
+    _blockLen += n;
+    data += n;
+    len -= n;
+    if (_blockLen < 64) return;
+    compress(_block);
+    _blockLen = 0;
+  }
+  // Whole blocks are hashed straight from the caller's buffer.
+  for (; len >= 64; data += 64, len -= 64) compress(data);
+  memcpy(_block, data, len);
+  _blockLen = len;
+}
+
+void Sha256::finish(uint8_t digest[kDigestSize]) {
+  uint64_t bits = _length * 8;
+  uint8_t pad[72] = {0x80};
+  size_t padLen = (_blockLen < 56 ? 56 : 120) - _blockLen;
+  for (int i = 0; i < 8; i++) pad[padLen + i] = uint8_t(bits >> (56 - 8 * i));
+  update(pad, padLen + 8);
+  for (int i = 0; i < 8; i++) {
+    digest[4 * i] = uint8_t(_state[i] >> 24);
+    digest[4 * i + 1] = uint8_t(_state[i] >> 16);
+    digest[4 * i + 2] = uint8_t(_state[i] >> 8);
+    digest[4 * i + 3] = uint8_t(_state[i]);
+  }
+}
+
+#endif
+
+void Sha256::toHex(const uint8_t digest[kDigestSize], char out[2 * kDigestSize + 1]) {
+  static const char kHex[] = "0123456789abcdef";
+  for (size_t i = 0; i < kDigestSize; i++) {
+    out[2 * i] = kHex[digest[i] >> 4];
+    out[2 * i + 1] = kHex[digest[i] & 0x0F];
+  }
+  out[2 * kDigestSize] = '\0';
+}
+
+static int hexNibble(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+bool Sha256::fromHex(const char* hex, uint8_t digest[kDigestSize]) {
+  if (!hex || strlen(hex) != 2 * kDigestSize) return false;
+  for (size_t i = 0; i < kDigestSize; i++) {
+    int hi = hexNibble(hex[2 * i]);
+    int lo = hexNibble(hex[2 * i + 1]);
+    if (hi < 0 || lo < 0) return false;
+    digest[i] = uint8_t(hi << 4 | lo);
+  }
+  return true;
+}
+
+// ----- OTA -----
+OtaUpdate::OtaUpdate()
+  : _hasExpected(false), _running(false), _rejected(false), _error(nullptr), _written(0), _size(0), _startedAt(0),
+    _finishedAt(0), _digest("") {}
+
+bool OtaUpdate::begin(size_t size, const char* expectedSha256) {
+  if (_running) abort();
+  _error = nullptr;
+  _rejected = false;
+  _written = 0;
+  _digest[0] = '\0';
+  _size = size == UPDATE_SIZE_UNKNOWN ? 0 : size;
+  _startedAt = millis();
+  _finishedAt = 0;
+  _sha.reset();
+  _hasExpected = expectedSha256 && *expectedSha256;
+  if (_hasExpected && !Sha256::fromHex(expectedSha256, _expected)) {
+    fail("Invalid SHA-256 digest", true);
+    return false;
+  }
+  if (!Update.begin(size, U_FLASH)) {
+    fail(Update.errorString());
+    return false;
+  }
+  _running = true;
+  return true;
+}
+
+bool OtaUpdate::write(const uint8_t* data, size_t len) {
+  if (!_running) return false;
+  _sha.update(data, len);
+  if (Update.write(const_cast<uint8_t*>(data), len) != len) {
+    fail(Update.errorString());
+    Update.abort();
+    return false;
+  }
+  _written += len;
+  return true;
+}
+
+bool OtaUpdate::end() {
+  if (!_running) return false;
+  uint8_t actual[Sha256::kDigestSize];
+  _sha.finish(actual);
+  Sha256::toHex(actual, _digest);
+  _finishedAt = millis();
+  if (_hasExpected && memcmp(actual, _expected, sizeof(actual)) != 0) {
+    Update.abort();
+    fail("SHA-256 mismatch", true);
+    return false;
+  }
+  if (!Update.end(true)) {
+    fail(Update.errorString());
+    return false;
+  }
+  _running = false;
+  return true;
+}
+
+void OtaUpdate::abort() {
+  if (!_running) return;
+  Update.abort();
+  fail("Aborted");
+}
+
+void OtaUpdate::fail(const char* error, bool rejected) {
+  _error = error;
+  _rejected = rejected;
+  _running = false;
+  if (!_finishedAt) _finishedAt = millis();
+}
+
+unsigned long OtaUpdate::elapsedMs() const {
+  return (_finishedAt ? _finishedAt : millis()) - _startedAt;
+}
+
+uint32_t OtaUpdate::bytesPerSecond() const {
+  unsigned long ms = elapsedMs();
+  return ms ? static_cast<uint32_t>(uint64_t(_written) * 1000 / ms) : 0;
+}
@@ -0,0 +1,89 @@
+#ifndef WIFI_MANAGER_OTA_H
+#define WIFI_MANAGER_OTA_H
+
+#include <Arduino.h>
+#include <Update.h>
+
+#ifdef ESP_PLATFORM
+  #include <mbedtls/sha256.h>
+#endif
+
+// Streaming firmware update.
+//
+// An upload is fed to OtaUpdate chunk by chunk as it arrives: every chunk is
+// hashed and handed to Update.write() (which stages it through one flash
+// sector), so RAM use does not depend on the image size. end() compares the
+// SHA-256 with the digest the client announced before Update.end() activates
+// the new partition; a mismatch aborts and the running firmware stays.
+
+// Incremental SHA-256 (FIPS 180-4). On the ESP32 this wraps mbedtls, which
+// uses the SHA accelerator.
+class Sha256 {
+public:
+  static const size_t kDigestSize = 32;
+
+  Sha256();
+  ~Sha256();
+  Sha256(const Sha256&) = delete;
+  Sha256& operator=(const Sha256&) = delete;
+
+  void reset();
+  void update(const uint8_t* data, size_t len);
+  void finish(uint8_t digest[kDigestSize]);
+
+  // 64 lowercase hex digits plus NUL.
+  static void toHex(const uint8_t digest[kDigestSize], char out[2 * kDigestSize + 1]);
+  // Accepts upper or lower case; false unless exactly 64 hex digits.
+  static bool fromHex(const char* hex, uint8_t digest[kDigestSize]);
+
+private:
+#ifdef ESP_PLATFORM
+  mbedtls_sha256_context _ctx;
+#else
+  void compress(const uint8_t block[64]);
+  uint32_t _state[8];
+  uint64_t _length;  // bytes hashed so far
+  uint8_t _block[64];
+  size_t _blockLen;
+#endif
+};
+
+class OtaUpdate {
+public:
+  OtaUpdate();
+
+  // size may be UPDATE_SIZE_UNKNOWN; expectedSha256 (hex) may be empty, in
+  // which case the digest is only reported.
+  bool begin(size_t size, const char* expectedSha256);
+  bool write(const uint8_t* data, size_t len);
+  bool end();
+  void abort();
+
+  bool running() const { return _running; }
+  bool failed() const { return _error != nullptr; }
+  const char* error() const { return _error; }
+  bool digestRejected() const { return _rejected; }  // bad or mismatching digest, not a flash error
+  size_t written() const { return _written; }
+  size_t size() const { return _size; }  // 0 when unknown
+  unsigned long startedAt() const { return _startedAt; }
+  unsigned long elapsedMs() const;
+  uint32_t bytesPerSecond() const;
+  const char* digest() const { return _digest; }  // hex, set by end()
+
+private:
+  void fail(const char* error, bool rejected = false);
+
+  Sha256 _sha;
+  uint8_t _expected[Sha256::kDigestSize];
+  bool _hasExpected;
+  bool _running;
+  bool _rejected;
+  const char* _error;
+  size_t _written;
+  size_t _size;
+  unsigned long _startedAt;
+  unsigned long _finishedAt;
+  char _digest[2 * Sha256::kDigestSize + 1];
+};
+
+#endif // WIFI_MANAGER_OTA_H
@@ -0,0 +1,58 @@
+#include "WiFiManagerParamRegistry.h"
+
+ParamRegistry::ParamRegistry() : _slots(16, 0) {}
+
+uint32_t ParamRegistry::hash(const char* id, size_t len) {
+  // FNV-1a: ids are short, so a byte loop beats anything cleverer.
+  uint32_t h = 2166136261u;
+  for (size_t i = 0; i < len; i++) {
+    h ^= static_cast<uint8_t>(id[i]);
+    h *= 16777619u;
+  }
+  return h;
+}
+
+// Slot holding `id`, or the empty slot where it would go.
+size_t ParamRegistry::slotOf(uint32_t h, const char* id, size_t len) const {
+  size_t mask = _slots.size() - 1;
+  for (size_t slot = h & mask;; slot = (slot + 1) & mask) {
+    uint16_t entry = _slots[slot];
+    if (entry == 0) return slot;
+    size_t i = entry - 1;
+    if (_hashes[i] != h) continue;
+    const char* other = _params[i]->getID();
+    if (strncmp(other, id, len) == 0 && other[len] == '\0') return slot;
+  }
+}
+
+void ParamRegistry::rebuild(size_t slots) {
+  _slots.assign(slots, 0);
+  size_t mask = slots - 1;
+  for (size_t i = 0; i < _params.size(); i++) {
+    size_t slot = _hashes[i] & mask;
+    while (_slots[slot]) slot = (slot + 1) & mask;
+    _slots[slot] = static_cast<uint16_t>(i + 1);
+  }
+}
+
+bool ParamRegistry::add(WiFiManagerParameter* param) {
+  if (!param || _params.size() >= 0xFFFF) return false;
+  const char* id = param->getID();
+  size_t len = strlen(id);
+  uint32_t h = hash(id, len);
+  size_t slot = slotOf(h, id, len);
+  if (_slots[slot]) return false;
+  _params.push_back(param);
+  _hashes.push_back(h);
+  if (_params.size() * 2 > _slots.size()) {
+    rebuild(_slots.size() * 2);
+  } else {
+    _slots[slot] = static_cast<uint16_t>(_params.size());
+  }
+  return true;
+}
+
+WiFiManagerParameter* ParamRegistry::find(const char* id, size_t len) const {
+  uint16_t entry = _slots[slotOf(hash(id, len), id, len)];
+  return entry ? _params[entry - 1] : nullptr;
+}
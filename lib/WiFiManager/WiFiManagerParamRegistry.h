@@ -0,0 +1,41 @@
+#ifndef WIFI_MANAGER_PARAM_REGISTRY_H
+#define WIFI_MANAGER_PARAM_REGISTRY_H
+
+#include <Arduino.h>
+#include <vector>
+#include "WiFiManagerParameter.h"
+
+// Custom parameters in registration order, plus an open-addressing table
+// keyed by id hash so form fields, restores and lookups find their parameter
+// without scanning the list. The table holds 16-bit slots (index + 1, 0 =
+// empty) and is kept at most half full: 500 parameters cost 2 KB of slots
+// and 2 KB of cached hashes.
+class ParamRegistry {
+public:
+  typedef std::vector<WiFiManagerParameter*>::const_iterator const_iterator;
+
+  ParamRegistry();
+
+  // False for a null parameter or an id that is already registered.
+  bool add(WiFiManagerParameter* param);
+  WiFiManagerParameter* find(const char* id, size_t len) const;
+  WiFiManagerParameter* find(const String& id) const { return find(id.c_str(), id.length()); }
+
+  const std::vector<WiFiManagerParameter*>& list() const { return _params; }
+  size_t size() const { return _params.size(); }
+  WiFiManagerParameter* operator[](size_t i) const { return _params[i]; }
+  const_iterator begin() const { return _params.begin(); }
+  const_iterator end() const { return _params.end(); }
+
+  static uint32_t hash(const char* id, size_t len);
+
+private:
+  void rebuild(size_t slots);
+  size_t slotOf(uint32_t hash, const char* id, size_t len) const;
+
+  std::vector<WiFiManagerParameter*> _params;
+  std::vector<uint32_t> _hashes;  // per parameter, so rebuilds never rehash ids
+  std::vector<uint16_t> _slots;   // size is a power of two
+};
+
+#endif // WIFI_MANAGER_PARAM_REGISTRY_H
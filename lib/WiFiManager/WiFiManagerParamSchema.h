@@ -0,0 +1,84 @@
+#ifndef WIFI_MANAGER_PARAM_SCHEMA_H
+#define WIFI_MANAGER_PARAM_SCHEMA_H
+
+#include <new>
+#include <type_traits>
+#include "WiFiManagerParameter.h"
+
+// Compile-time parameter schemas.
+//
+//   static constexpr ParamSpec kSchema[] = {
+//     textParam("mqtt_server", "MQTT Server", 40, "mqtt.example.com", "MQTT"),
+//     numberParam("mqtt_port", "MQTT Port", 1, 65535, "1883", "MQTT"),
+//     toggleParam("mqtt_tls", "Use TLS", false, "MQTT"),
+//   };
+//   static ParamBlock<schemaSize(kSchema), schemaValueBytes(kSchema)> params(kSchema);
+//   ...
+//   wifiManager.addParameters(params);
+//
+// The table and every string in it stay in flash. The block holds one small
+// WiFiManagerParameter per entry plus all value buffers in a single array
+// sized by the compiler, so registering a schema allocates nothing per
+// parameter and nothing at all when the block is static.
+
+constexpr ParamSpec textParam(const char* id, const char* label, uint16_t length, const char* defaultValue = "",
+                              const char* group = "", const char* attributes = "") {
+  return ParamSpec{id, label, ParameterType::TEXT, length, defaultValue, group, attributes, 1, 0};
+}
+
+constexpr ParamSpec numberParam(const char* id, const char* label, int32_t min, int32_t max,
+                                const char* defaultValue, const char* group = "", const char* attributes = "") {
+  return ParamSpec{id, label, ParameterType::NUMBER, 11, defaultValue, group, attributes, min, max};
+}
+
+constexpr ParamSpec toggleParam(const char* id, const char* label, bool on, const char* group = "") {
+  return ParamSpec{id, label, ParameterType::TOGGLE, 5, on ? "true" : "false", group, "", 1, 0};
+}
+
+// Any other type; `length` bounds the value.
+constexpr ParamSpec typedParam(const char* id, const char* label, ParameterType type, uint16_t length,
+                               const char* defaultValue = "", const char* group = "", const char* attributes = "") {
+  return ParamSpec{id, label, type, length, defaultValue, group, attributes, 1, 0};
+}
+
+template <size_t N>
+constexpr size_t schemaSize(const ParamSpec (&)[N]) {
+  return N;
+}
+
+// Value bytes for the whole schema, terminators included.
+template <size_t N>
+constexpr size_t schemaValueBytes(const ParamSpec (&schema)[N], size_t i = 0) {
+  return i == N ? 0 : schema[i].length + 1 + schemaValueBytes(schema, i + 1);
+}
+
+template <size_t N, size_t ValueBytes>
+class ParamBlock {
+public:
+  explicit ParamBlock(const ParamSpec (&schema)[N]) : _count(0) {
+    char* value = _values;
+    for (size_t i = 0; i < N; i++) {
+      if (value + schema[i].length + 1 > _values + ValueBytes) break;  // undersized block
+      new (&_params[i]) WiFiManagerParameter(schema[i], value);
+      value += schema[i].length + 1;
+      _count++;
+    }
+  }
+
+  ~ParamBlock() {
+    for (size_t i = 0; i < _count; i++) (*this)[i]->~WiFiManagerParameter();
+  }
+
+  ParamBlock(const ParamBlock&) = delete;
+  ParamBlock& operator=(const ParamBlock&) = delete;
+
+  size_t size() const { return _count; }
+  WiFiManagerParameter* operator[](size_t i) { return reinterpret_cast<WiFiManagerParameter*>(&_params[i]); }
+
+private:
+  typename std::aligned_storage<sizeof(WiFiManagerParameter), alignof(WiFiManagerParameter)>::type _params[N];
+  size_t _count;
+  char _values[ValueBytes];
+};
+
+#endif // WIFI_MANAGER_PARAM_SCHEMA_H
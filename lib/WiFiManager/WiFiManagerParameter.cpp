@@ -1,48 +1,106 @@
 #include "WiFiManagerParameter.h"
 
+std::atomic<uint32_t> WiFiManagerParameter::_revision(0);
+
+WiFiManagerParameter::WiFiManagerParameter(const ParamSpec& spec, char* buffer) : _spec(&spec), _buffer(buffer) {
+    strncpy(_buffer, spec.defaultValue, spec.length);
+    _buffer[spec.length] = '\0';
+}
+
 // Constructor for basic text parameter.
 WiFiManagerParameter::WiFiManagerParameter(const char* id, const char* label, const char* defaultValue, int length,
                          const char* customHTML, int labelPlacement, const char* group)
-    : _id(id), _label(label), _value(defaultValue), _length(length),
-      _customHTML(customHTML), _customAttributes(""), _labelPlacement(labelPlacement),
-      _type(ParameterType::TEXT), _group(group)
-{}
+    : _buffer(nullptr), _owned(new Owned())
+{
+    _owned->id = id;
+    _owned->label = label;
+    _owned->group = group;
+    _owned->customHTML = customHTML;
+    _owned->value = defaultValue;
+    _owned->labelPlacement = labelPlacement;
+    _owned->spec = ParamSpec{_owned->id.c_str(), _owned->label.c_str(), ParameterType::TEXT, static_cast<uint16_t>(length),
+                             "", _owned->group.c_str(), _owned->attributes.c_str(), 1, 0};
+    _spec = &_owned->spec;
+}
 
 // Constructor for advanced parameter types.
 WiFiManagerParameter::WiFiManagerParameter(const char* id, const char* label, const char* defaultValue,
                          ParameterType type, const char* customAttributes, const char* group)
-    : _id(id), _label(label), _value(defaultValue), _type(type),
-      _customAttributes(customAttributes), _length(0), _labelPlacement(1), _group(group)
-{}
+    : _buffer(nullptr), _owned(new Owned())
+{
+    _owned->id = id;
+    _owned->label = label;
+    _owned->group = group;
+    _owned->attributes = customAttributes;
+    _owned->value = defaultValue;
+    _owned->labelPlacement = 1;
+    _owned->spec = ParamSpec{_owned->id.c_str(), _owned->label.c_str(), type, 0,
+                             "", _owned->group.c_str(), _owned->attributes.c_str(), 1, 0};
+    _spec = &_owned->spec;
+}
 
-const char* WiFiManagerParameter::getID() const { return _id.c_str(); }
-const char* WiFiManagerParameter::getLabel() const { return _label.c_str(); }
-const char* WiFiManagerParameter::getValue() const { return _value.c_str(); }
-ParameterType WiFiManagerParameter::getType() const { return _type; }
-const char* WiFiManagerParameter::getCustomAttributes() const { return _customAttributes.c_str(); }
-const char* WiFiManagerParameter::getCustomHTML() const { return _customHTML.c_str(); }
-int WiFiManagerParameter::getLabelPlacement() const { return _labelPlacement; }
-const char* WiFiManagerParameter::getGroup() const { return _group.c_str(); }
+// Schema parameters only get an Owned block once something overrides the
+// schema; it starts as a copy of the flash entry.
+WiFiManagerParameter::Owned& WiFiManagerParameter::owned() {
+    if (!_owned) {
+        _owned.reset(new Owned());
+        _owned->spec = *_spec;
+        _owned->labelPlacement = 1;
+        _spec = &_owned->spec;
+    }
+    return *_owned;
+}
+
+const char* WiFiManagerParameter::getID() const { return _spec->id; }
+const char* WiFiManagerParameter::getLabel() const { return _spec->label; }
+const char* WiFiManagerParameter::getValue() const { return _buffer ? _buffer : _owned->value.c_str(); }
+ParameterType WiFiManagerParameter::getType() const { return _spec->type; }
+const char* WiFiManagerParameter::getCustomAttributes() const { return _spec->attributes; }
+const char* WiFiManagerParameter::getCustomHTML() const { return _owned ? _owned->customHTML.c_str() : ""; }
+int WiFiManagerParameter::getLabelPlacement() const { return _owned ? _owned->labelPlacement : 1; }
+const char* WiFiManagerParameter::getGroup() const { return _spec->group; }
 
 void WiFiManagerParameter::setValue(const char* value) {
-    if (validateValue(value)) { _value = value; }
+    if (!validateValue(value) || strcmp(getValue(), value) == 0) return;
+    if (_buffer) {
+        strcpy(_buffer, value);  // validateValue() checked the length
+    } else {
+        _owned->value = value;
+    }
+    _valueRevision = ++_revision;
 }
 
 void WiFiManagerParameter::setCustomAttributes(const char* attributes) {
-    _customAttributes = attributes;
+    Owned& o = owned();
+    o.attributes = attributes;
+    o.spec.attributes = o.attributes.c_str();
+    _revision++;
 }
 
+uint32_t WiFiManagerParameter::revision() { return _revision.load(); }
+uint32_t WiFiManagerParameter::valueRevision() const { return _valueRevision; }
+
 void WiFiManagerParameter::setValidation(std::function<bool(const char*)> validator) {
-    _validator = validator;
+    owned().validator = validator;
+}
+
+bool WiFiManagerParameter::accepts(const char* value) const {
+    return validateValue(value);
 }
 
 bool WiFiManagerParameter::isValid() const {
-    return validateValue(_value.c_str());
+    return validateValue(getValue());
 }
 
 bool WiFiManagerParameter::validateValue(const char* value) const {
-    if (_validator) return _validator(value);
-    switch (_type) {
+    if (_buffer && strlen(value) > _spec->length) return false;
+    if (_owned && _owned->validator) return _owned->validator(value);
+    if ((_spec->type == ParameterType::NUMBER || _spec->type == ParameterType::SLIDER) && _spec->min <= _spec->max) {
+        char* end;
+        long n = strtol(value, &end, 10);
+        if (end == value || *end || n < _spec->min || n > _spec->max) return false;
+    }
+    switch (_spec->type) {
         case ParameterType::NUMBER:
             for (const char* p = value; *p; p++) { if (*p != '-' && *p != '.' && (*p < '0' || *p > '9')) return false; }
             return true;
@@ -79,71 +137,74 @@ bool WiFiManagerParameter::validateValue(const char* value) const {
 }
 
 String WiFiManagerParameter::generateInputHTML() const {
+    const String id(getID()), label(getLabel()), value(getValue()), attributes(getCustomAttributes());
+    const ParameterType type = getType();
+    const int labelPlacement = getLabelPlacement();
     String html = "<div class='form-field'>";
-    if (_labelPlacement == 1) { html += "<label for='" + _id + "'>" + _label + "</label>"; }
-    switch (_type) {
+    if (labelPlacement == 1) { html += "<label for='" + id + "'>" + label + "</label>"; }
+    switch (type) {
         case ParameterType::PASSWORD:
-            html += "<input type='password' id='" + _id + "' name='" + _id + "' value='" + _value + "'";
+            html += "<input type='password' id='" + id + "' name='" + id + "' value='" + value + "'";
             break;
         case ParameterType::NUMBER:
-            html += "<input type='number' id='" + _id + "' name='" + _id + "' value='" + _value + "'";
+            html += "<input type='number' id='" + id + "' name='" + id + "' value='" + value + "'";
             break;
         case ParameterType::TOGGLE:
-            html += "<input type='checkbox' id='" + _id + "' name='" + _id + "'";
-            if (_value == "true") html += " checked";
+            html += "<input type='checkbox' id='" + id + "' name='" + id + "'";
+            if (value == "true") html += " checked";
             break;
         case ParameterType::SLIDER:
-            html += "<input type='range' id='" + _id + "' name='" + _id + "' value='" + _value + "'";
+            html += "<input type='range' id='" + id + "' name='" + id + "' value='" + value + "'";
             break;
         case ParameterType::SELECT:
-            html += "<select id='" + _id + "' name='" + _id + "'>" + _customAttributes + "</select>";
+            html += "<select id='" + id + "' name='" + id + "'>" + attributes + "</select>";
             break;
         case ParameterType::EMAIL:
-            html += "<input type='email' id='" + _id + "' name='" + _id + "' value='" + _value + "'";
+            html += "<input type='email' id='" + id + "' name='" + id + "' value='" + value + "'";
             break;
         case ParameterType::URL:
-            html += "<input type='url' id='" + _id + "' name='" + _id + "' value='" + _value + "'";
+            html += "<input type='url' id='" + id + "' name='" + id + "' value='" + value + "'";
             break;
         case ParameterType::SEARCH:
-            html += "<input type='search' id='" + _id + "' name='" + _id + "' value='" + _value + "'";
+            html += "<input type='search' id='" + id + "' name='" + id + "' value='" + value + "'";
             break;
         case ParameterType::TEL:
-            html += "<input type='tel' id='" + _id + "' name='" + _id + "' value='" + _value + "'";
+            html += "<input type='tel' id='" + id + "' name='" + id + "' value='" + value + "'";
             break;
         case ParameterType::DATE:
-            html += "<input type='date' id='" + _id + "' name='" + _id + "' value='" + _value + "'";
+            html += "<input type='date' id='" + id + "' name='" + id + "' value='" + value + "'";
             break;
         case ParameterType::TIME:
-            html += "<input type='time' id='" + _id + "' name='" + _id + "' value='" + _value + "'";
+            html += "<input type='time' id='" + id + "' name='" + id + "' value='" + value + "'";
             break;
         case ParameterType::DATETIME_LOCAL:
-            html += "<input type='datetime-local' id='" + _id + "' name='" + _id + "' value='" + _value + "'";
+            html += "<input type='datetime-local' id='" + id + "' name='" + id + "' value='" + value + "'";
             break;
         case ParameterType::MONTH:
-            html += "<input type='month' id='" + _id + "' name='" + _id + "' value='" + _value + "'";
+            html += "<input type='month' id='" + id + "' name='" + id + "' value='" + value + "'";
             break;
         case ParameterType::WEEK:
-            html += "<input type='week' id='" + _id + "' name='" + _id + "' value='" + _value + "'";
+            html += "<input type='week' id='" + id + "' name='" + id + "' value='" + value + "'";
             break;
         case ParameterType::COLOR:
-            html += "<input type='color' id='" + _id + "' name='" + _id + "' value='" + _value + "'";
+            html += "<input type='color' id='" + id + "' name='" + id + "' value='" + value + "'";
             break;
         case ParameterType::FILE:
-            html += "<input type='file' id='" + _id + "' name='" + _id + "'";
+            html += "<input type='file' id='" + id + "' name='" + id + "'";
             break;
         case ParameterType::HIDDEN:
-            html += "<input type='hidden' id='" + _id + "' name='" + _id + "' value='" + _value + "'";
+            html += "<input type='hidden' id='" + id + "' name='" + id + "' value='" + value + "'";
             break;
         case ParameterType::TEXTAREA:
-            html += "<textarea id='" + _id + "' name='" + _id + "'" + (_customAttributes.length() > 0 ? " " + _customAttributes : "") + ">" + _value + "</textarea>";
+            html += "<textarea id='" + id + "' name='" + id + "'" + (attributes.length() > 0 ? " " + attributes : "") + ">" + value + "</textarea>";
             return html + "</div>";
         default:
-            html += "<input type='text' id='" + _id + "' name='" + _id + "' value='" + _value + "'";
+            html += "<input type='text' id='" + id + "' name='" + id + "' value='" + value + "'";
             break;
     }
-    if (_customAttributes.length() > 0 && _type != ParameterType::SELECT) { html += " " + _customAttributes; }
-    if (_type != ParameterType::SELECT && _type != ParameterType::TEXTAREA) { html += ">"; }
-    if (_labelPlacement == 2) { html += "<label for='" + _id + "'>" + _label + "</label>"; }
+    if (attributes.length() > 0 && type != ParameterType::SELECT) { html += " " + attributes; }
+    if (type != ParameterType::SELECT && type != ParameterType::TEXTAREA) { html += ">"; }
+    if (labelPlacement == 2) { html += "<label for='" + id + "'>" + label + "</label>"; }
     html += "</div>";
     return html;
 }
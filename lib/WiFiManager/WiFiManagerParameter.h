@@ -2,7 +2,9 @@
 #define WIFI_MANAGER_PARAMETER_H
 
 #include <Arduino.h>
+#include <atomic>
 #include <functional>
+#include <memory>
 
 enum class ParameterType {
     TEXT,
@@ -26,8 +28,27 @@ enum class ParameterType {
     TEXTAREA
 };
 
+// Constant description of a parameter. Declared as a `static constexpr` table
+// (see WiFiManagerParamSchema.h) it is placed in flash and never copied.
+struct ParamSpec {
+    const char* id;
+    const char* label;
+    ParameterType type;
+    uint16_t length;           // longest value accepted, in bytes
+    const char* defaultValue;
+    const char* group;
+    const char* attributes;    // extra HTML attributes, or the <option>s of a SELECT
+    int32_t min;               // NUMBER/SLIDER bounds, unchecked when min > max
+    int32_t max;
+};
+
 class WiFiManagerParameter {
 public:
+    // Schema parameter: reads id, label, type and limits from `spec` and keeps
+    // its value in `buffer` (spec.length + 1 bytes). Neither is copied, so both
+    // must outlive the parameter; ParamBlock arranges that.
+    WiFiManagerParameter(const ParamSpec& spec, char* buffer);
+
     // Constructor for basic text parameter.
     WiFiManagerParameter(const char* id, const char* label, const char* defaultValue, int length,
                          const char* customHTML = "", int labelPlacement = 1, const char* group = "");
@@ -53,22 +74,47 @@ public:
     
     // Validation.
     void setValidation(std::function<bool(const char*)> validator);
+    // True if setValue(value) would take it.
+    bool accepts(const char* value) const;
+
+    // Bumped whenever any parameter's value or attributes change, so rendered
+    // pages can tell whether they are still current.
+    static uint32_t revision();
+    // revision() as of this parameter's last value change (0 = never changed).
+    uint32_t valueRevision() const;
     
+    const ParamSpec& getSpec() const { return *_spec; }
+    // True for schema parameters, whose storage belongs to their ParamBlock.
+    bool isSchemaBacked() const { return _buffer != nullptr; }
+
     // HTML Generation.
     String getHTML() const;
+
+    WiFiManagerParameter(const WiFiManagerParameter&) = delete;
+    WiFiManagerParameter& operator=(const WiFiManagerParameter&) = delete;
     
 private:
-    String _id;
-    String _label;
-    String _value;
-    ParameterType _type;
-    String _customAttributes;
-    String _customHTML;
-    int _length;
-    int _labelPlacement;
-    String _group;
-    std::function<bool(const char*)> _validator;
-    
+    // Strings of a parameter built at runtime, and of schema parameters whose
+    // attributes or validator were replaced. `spec` points into them.
+    struct Owned {
+        ParamSpec spec;
+        String id;
+        String label;
+        String group;
+        String attributes;
+        String customHTML;
+        String value;  // runtime parameters only
+        int labelPlacement;
+        std::function<bool(const char*)> validator;
+    };
+
+    const ParamSpec* _spec;
+    char* _buffer;  // schema parameters: the value, spec.length + 1 bytes
+    std::unique_ptr<Owned> _owned;
+    uint32_t _valueRevision = 0;
+    static std::atomic<uint32_t> _revision;
+
+    Owned& owned();
     bool validateValue(const char* value) const;
     String generateInputHTML() const;
 };
@@ -0,0 +1,221 @@
+#include "WiFiManagerScheduler.h"
+
+const uint8_t RequestScheduler::kClasses;
+const uint8_t RequestScheduler::kMaxEntries;
+
+// Heavy routes by URI; everything else, static assets included, is light.
+static const struct {
+  const char* uri;
+  RequestClass cls;
+} kHeavyRoutes[] = {
+  {"/scan", RequestClass::SCAN},
+  {"/connect", RequestClass::CONNECT},
+  {"/fs/upload", RequestClass::TRANSFER},
+  {"/fs/download", RequestClass::TRANSFER},
+  {"/backup", RequestClass::TRANSFER},
+  {"/restore", RequestClass::TRANSFER},
+  {"/ota", RequestClass::OTA},
+};
+
+// ----- Setup -----
+RequestScheduler::RequestScheduler()
+  : _totalLimit(3), _running(0), _queued(0), _order(0), _queueTimeout(5000) {
+  static const char* kNames[kClasses] = {"scan", "connect", "transfer", "ota"};
+  // Scans answer from the cache and connects only queue an attempt, so both
+  // are quick but pointless to run twice at once; transfers hold a file and
+  // the flash; an OTA owns the update partition and cannot wait.
+  static const uint8_t kLimits[kClasses][2] = {{1, 4}, {1, 1}, {2, 2}, {1, 0}};
+  memset(_classes, 0, sizeof(_classes));
+  for (uint8_t i = 0; i < kClasses; i++) {
+    _classes[i].name = kNames[i];
+    _classes[i].limit = kLimits[i][0];
+    _classes[i].queueLimit = kLimits[i][1];
+  }
+  for (Entry& e : _entries) {
+    e.request = nullptr;
+    e.deferred = nullptr;
+    e.state = FREE;
+  }
+}
+
+RequestClass RequestScheduler::classify(const char* uri) {
+  for (const auto& route : kHeavyRoutes) {
+    if (strcmp(route.uri, uri) == 0) return route.cls;
+  }
+  return RequestClass::LIGHT;
+}
+
+void RequestScheduler::setLimits(RequestClass cls, uint8_t running, uint8_t queued) {
+  std::lock_guard<std::recursive_mutex> hold(_lock);
+  if (cls == RequestClass::LIGHT) return;
+  of(cls).limit = running;
+  of(cls).queueLimit = queued;
+}
+
+// ----- Admission -----
+RequestScheduler::Entry* RequestScheduler::find(AsyncWebServerRequest* request) {
+  for (Entry& e : _entries) {
+    if (e.state != FREE && e.request == request) return &e;
+  }
+  return nullptr;
+}
+
+const RequestScheduler::Entry* RequestScheduler::find(AsyncWebServerRequest* request) const {
+  return const_cast<RequestScheduler*>(this)->find(request);
+}
+
+bool RequestScheduler::hasRoom(RequestClass cls) const {
+  const RequestClassStats& c = of(cls);
+  return (!c.limit || c.running < c.limit) && (!_totalLimit || _running < _totalLimit);
+}
+
+RequestScheduler::Verdict RequestScheduler::admit(AsyncWebServerRequest* request, RequestClass cls, uint8_t tag,
+                                                  const ArRequestHandlerFunction* deferred, unsigned long now) {
+  std::lock_guard<std::recursive_mutex> hold(_lock);
+  RequestClassStats& c = of(cls);
+  uint32_t client = static_cast<uint32_t>(request->client()->remoteIP());
+  Entry* slot = nullptr;
+  bool holding = false;
+  for (Entry& e : _entries) {
+    if (e.state == FREE) {
+      if (!slot) slot = &e;
+    } else if (e.cls == cls && e.client == client) {
+      holding = true;
+    }
+  }
+  // Queued requests keep their turn: a newcomer runs only if nobody waits.
+  bool run = hasRoom(cls) && c.queued == 0;
+  if (slot && (run || (deferred && c.queued < c.queueLimit))) {
+    slot->request = request;
+    slot->deferred = deferred;
+    slot->then = nullptr;
+    slot->client = client;
+    slot->since = now;
+    slot->arrived = micros();
+    slot->order = _order++;
+    slot->cls = cls;
+    slot->tag = tag;
+    if (run) {
+      slot->state = RUNNING;
+      c.running++;
+      _running++;
+      c.admitted++;
+      return RUN;
+    }
+    slot->state = WAITING;
+    c.queued++;
+    _queued++;
+    if (c.queued > c.maxQueued) c.maxQueued = c.queued;
+    return QUEUED;
+  }
+  if (holding) {
+    c.throttled++;
+    return THROTTLED;
+  }
+  c.busy++;
+  return BUSY;
+}
+
+bool RequestScheduler::isRunning(AsyncWebServerRequest* request) const {
+  std::lock_guard<std::recursive_mutex> hold(_lock);
+  const Entry* e = find(request);
+  return e && e->state == RUNNING;
+}
+
+bool RequestScheduler::arrivedAt(AsyncWebServerRequest* request, uint32_t* arrived) const {
+  std::lock_guard<std::recursive_mutex> hold(_lock);
+  const Entry* e = find(request);
+  if (!e) return false;
+  *arrived = e->arrived;
+  return true;
+}
+
+bool RequestScheduler::chain(AsyncWebServerRequest* request, const ArDisconnectHandler& fn) {
+  std::lock_guard<std::recursive_mutex> hold(_lock);
+  Entry* e = find(request);
+  if (!e) return false;
+  e->then = fn;
+  return true;
+}
+
+void RequestScheduler::release(AsyncWebServerRequest* request, unsigned long now) {
+  std::lock_guard<std::recursive_mutex> hold(_lock);
+  Entry* e = find(request);
+  if (!e) return;
+  RequestClassStats& c = of(e->cls);
+  if (e->state == RUNNING) {
+    c.running--;
+    _running--;
+    uint32_t held = now - e->since;
+    c.holdMillis = c.holdMillis ? c.holdMillis + (static_cast<int32_t>(held - c.holdMillis) / 4) : held;
+  } else {
+    c.queued--;  // the client gave up waiting
+    _queued--;
+  }
+  ArDisconnectHandler then;
+  then.swap(e->then);
+  e->state = FREE;
+  e->request = nullptr;
+  if (then) then();
+}
+
+// ----- Queue -----
+AsyncWebServerRequest* RequestScheduler::next(const ArRequestHandlerFunction** handler, unsigned long now) {
+  std::lock_guard<std::recursive_mutex> hold(_lock);
+  Entry* oldest = nullptr;
+  for (Entry& e : _entries) {
+    if (e.state == WAITING && hasRoom(e.cls) && (!oldest || static_cast<int32_t>(e.order - oldest->order) < 0)) {
+      oldest = &e;
+    }
+  }
+  if (!oldest) return nullptr;
+  RequestClassStats& c = of(oldest->cls);
+  c.queued--;
+  _queued--;
+  c.running++;
+  _running++;
+  c.admitted++;
+  c.deferred++;
+  oldest->state = RUNNING;
+  oldest->since = now;
+  *handler = oldest->deferred;
+  return oldest->request;
+}
+
+AsyncWebServerRequest* RequestScheduler::expired(RequestClass* cls, uint8_t* tag, uint32_t* arrived,
+                                                 unsigned long now) {
+  std::lock_guard<std::recursive_mutex> hold(_lock);
+  for (Entry& e : _entries) {
+    if (e.state != WAITING || now - e.since < _queueTimeout) continue;
+    RequestClassStats& c = of(e.cls);
+    c.queued--;
+    _queued--;
+    c.expired++;
+    e.state = FREE;
+    *cls = e.cls;
+    *tag = e.tag;
+    *arrived = e.arrived;
+    AsyncWebServerRequest* request = e.request;
+    e.request = nullptr;
+    return request;
+  }
+  return nullptr;
+}
+
+uint32_t RequestScheduler::retryAfter(RequestClass cls) const {
+  std::lock_guard<std::recursive_mutex> hold(_lock);
+  const RequestClassStats& c = of(cls);
+  uint32_t slots = c.limit ? c.limit : 1;
+  uint32_t ahead = c.running + c.queued + 1;
+  uint32_t seconds = (c.holdMillis * ahead / slots + 999) / 1000;
+  return seconds < 1 ? 1 : seconds > 60 ? 60 : seconds;
+}
+
+SchedulerStats RequestScheduler::stats() const {
+  std::lock_guard<std::recursive_mutex> hold(_lock);
+  SchedulerStats s;
+  memcpy(s.classes, _classes, sizeof(_classes));
+  s.running = _running;
+  s.totalLimit = _totalLimit;
+  return s;
+}
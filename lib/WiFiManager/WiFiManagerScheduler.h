@@ -0,0 +1,133 @@
+#ifndef WIFI_MANAGER_SCHEDULER_H
+#define WIFI_MANAGER_SCHEDULER_H
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+#include <atomic>
+#include <mutex>
+
+// Admission control for the expensive routes.
+//
+// Every route registered in begin() has a cost class. Light requests (status,
+// parameters, static assets) are never queued or refused, so they go first
+// whenever the heavy ones are held back. Each heavy class caps how many of its
+// requests run at once, and all heavy classes together share a second cap. A
+// heavy request that finds no room waits in its class's short FIFO queue and
+// is started when a running one goes away; uploads cannot wait (their body is
+// already arriving) and bodiless requests wait only while the queue has room.
+// Anything else is refused: 429 when the same client already holds a place in
+// that class, 503 otherwise, both with a Retry-After estimate. A request holds
+// its place until it is torn down, so a streamed download counts for as long
+// as it streams. Calls come from the web server task and from loop(), which
+// times out queued requests while no new ones arrive; each call holds a lock,
+// and lock()/unlock() hold it across several, so a request handed out by
+// expired() cannot be torn down (release() waits) while it is answered.
+
+enum class RequestClass : uint8_t {
+  LIGHT,     // never queued or refused
+  SCAN,      // /scan
+  CONNECT,   // /connect
+  TRANSFER,  // /fs/upload, /fs/download, /backup, /restore
+  OTA,       // /ota
+};
+
+struct RequestClassStats {
+  const char* name;
+  uint8_t limit;        // running at once (0 = unlimited)
+  uint8_t queueLimit;
+  uint8_t running;
+  uint8_t queued;
+  uint8_t maxQueued;    // deepest the queue has been
+  uint32_t admitted;    // started, at once or from the queue
+  uint32_t deferred;    // of those, waited in the queue first
+  uint32_t busy;        // refused with 503
+  uint32_t throttled;   // refused with 429
+  uint32_t expired;     // waited past the queue timeout, then 503
+  uint32_t holdMillis;  // smoothed time a request keeps its place
+};
+
+struct SchedulerStats {
+  RequestClassStats classes[4];  // SCAN, CONNECT, TRANSFER, OTA
+  uint8_t running;               // heavy requests running, all classes
+  uint8_t totalLimit;            // 0 = unlimited
+};
+
+class RequestScheduler {
+public:
+  static const uint8_t kClasses = 4;      // heavy classes, SCAN..OTA
+  static const uint8_t kMaxEntries = 12;  // heavy requests running or queued
+
+  enum Verdict : uint8_t { RUN, QUEUED, BUSY, THROTTLED };
+
+  RequestScheduler();
+
+  static RequestClass classify(const char* uri);
+
+  void setLimits(RequestClass cls, uint8_t running, uint8_t queued);
+  void setTotalLimit(uint8_t running) { _totalLimit = running; }
+  void setQueueTimeout(unsigned long ms) { _queueTimeout = ms; }
+
+  // Decides for a new heavy request. RUN and QUEUED take a place that
+  // release() gives back; a queued request is handed out by next() with the
+  // `deferred` handler it was admitted with (nullptr: it cannot wait). `tag`
+  // is the caller's (the metrics route) and comes back from expired().
+  Verdict admit(AsyncWebServerRequest* request, RequestClass cls, uint8_t tag,
+                const ArRequestHandlerFunction* deferred, unsigned long now);
+  bool isRunning(AsyncWebServerRequest* request) const;
+  // micros() when `request` was admitted; false if it holds no place.
+  bool arrivedAt(AsyncWebServerRequest* request, uint32_t* arrived) const;
+  // Keeps `fn` to run when `request` gives back its place, since its
+  // onDisconnect belongs to the scheduler; false if it holds none.
+  bool chain(AsyncWebServerRequest* request, const ArDisconnectHandler& fn);
+  // The request went away: runs its chained hook and frees its place.
+  void release(AsyncWebServerRequest* request, unsigned long now);
+  // Oldest queued request that may start now, marked running, with the
+  // handler to run for it; nullptr if none.
+  AsyncWebServerRequest* next(const ArRequestHandlerFunction** handler, unsigned long now);
+  // Oldest queued request that waited past the timeout, removed, with its
+  // class, tag and arrival (as from arrivedAt()); nullptr if none.
+  AsyncWebServerRequest* expired(RequestClass* cls, uint8_t* tag, uint32_t* arrived, unsigned long now);
+  // Unlocked: a cheap check before taking the lock.
+  bool hasQueued() const { return _queued > 0; }
+
+  void lock() const { _lock.lock(); }
+  void unlock() const { _lock.unlock(); }
+
+  // Seconds a refused client should wait: the class's smoothed hold time for
+  // every request ahead of it per running slot, 1..60.
+  uint32_t retryAfter(RequestClass cls) const;
+
+  SchedulerStats stats() const;
+
+private:
+  enum State : uint8_t { FREE, WAITING, RUNNING };
+  struct Entry {
+    AsyncWebServerRequest* request;
+    const ArRequestHandlerFunction* deferred;
+    ArDisconnectHandler then;
+    uint32_t client;      // remote IPv4
+    unsigned long since;  // admitted or started
+    uint32_t arrived;     // micros() when admitted, for request latency
+    uint32_t order;       // FIFO position among waiting entries
+    RequestClass cls;
+    uint8_t tag;
+    State state;
+  };
+
+  Entry* find(AsyncWebServerRequest* request);
+  const Entry* find(AsyncWebServerRequest* request) const;
+  RequestClassStats& of(RequestClass cls) { return _classes[static_cast<uint8_t>(cls) - 1]; }
+  const RequestClassStats& of(RequestClass cls) const { return _classes[static_cast<uint8_t>(cls) - 1]; }
+  bool hasRoom(RequestClass cls) const;
+
+  Entry _entries[kMaxEntries];
+  RequestClassStats _classes[kClasses];
+  uint8_t _totalLimit;
+  uint8_t _running;
+  std::atomic<uint8_t> _queued;
+  uint32_t _order;
+  unsigned long _queueTimeout;
+  mutable std::recursive_mutex _lock;
+};
+
+#endif // WIFI_MANAGER_SCHEDULER_H
@@ -0,0 +1,86 @@
+#include "WiFiManagerSerial.h"
+
+static size_t roundUpPow2(size_t n) {
+  size_t p = 64;
+  while (p < n) p <<= 1;
+  return p;
+}
+
+SerialRing::SerialRing(size_t capacity)
+  : _buf(nullptr), _mask(roundUpPow2(capacity) - 1), _head(0), _tail(0), _dropped(0) {
+  _buf = new uint8_t[_mask + 1];
+}
+
+SerialRing::~SerialRing() {
+  delete[] _buf;
+}
+
+size_t SerialRing::size() const {
+  return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire);
+}
+
+size_t SerialRing::write(const uint8_t* data, size_t len) {
+  size_t head = _head.load(std::memory_order_relaxed);
+  size_t space = capacity() - (head - _tail.load(std::memory_order_acquire));
+  size_t n = len < space ? len : space;
+  size_t at = head & _mask;
+  size_t first = n < capacity() - at ? n : capacity() - at;
+  memcpy(_buf + at, data, first);
+  memcpy(_buf, data + first, n - first);
+  _head.store(head + n, std::memory_order_release);
+  if (n < len) countDropped(len - n);
+  return n;
+}
+
+void SerialRing::copyOut(size_t from, uint8_t* out, size_t len) const {
+  size_t at = from & _mask;
+  size_t first = len < capacity() - at ? len : capacity() - at;
+  memcpy(out, _buf + at, first);
+  memcpy(out + first, _buf, len - first);
+}
+
+size_t SerialRing::peek(uint8_t* out, size_t len) const {
+  size_t tail = _tail.load(std::memory_order_relaxed);
+  size_t avail = _head.load(std::memory_order_acquire) - tail;
+  size_t n = len < avail ? len : avail;
+  copyOut(tail, out, n);
+  return n;
+}
+
+void SerialRing::skip(size_t len) {
+  size_t tail = _tail.load(std::memory_order_relaxed);
+  size_t avail = _head.load(std::memory_order_acquire) - tail;
+  _tail.store(tail + (len < avail ? len : avail), std::memory_order_release);
+}
+
+size_t SerialRing::read(uint8_t* out, size_t len) {
+  size_t n = peek(out, len);
+  skip(n);
+  return n;
+}
+
+size_t SerialRing::snapshot(uint8_t* out, size_t len) const {
+  size_t head = _head.load(std::memory_order_acquire);
+  size_t tail = _tail.load(std::memory_order_acquire);
+  size_t n = head - tail < len ? head - tail : len;
+  size_t from = head - n;
+  copyOut(from, out, n);
+  // The producer may only reuse the slot of position p once the consumer has
+  // moved past p, so everything at or after the tail seen now is intact.
+  std::atomic_thread_fence(std::memory_order_acquire);
+  size_t validFrom = _tail.load(std::memory_order_relaxed);
+  if (validFrom <= from) return n;
+  size_t lost = validFrom - from < n ? validFrom - from : n;
+  memmove(out, out + lost, n - lost);
+  return n - lost;
+}
+
+size_t SerialTee::write(const uint8_t* buffer, size_t size) {
+  if (_busy.test_and_set(std::memory_order_acquire)) {
+    _ring.countDropped(size);
+  } else {
+    _ring.write(buffer, size);
+    _busy.clear(std::memory_order_release);
+  }
+  return _out ? _out->write(buffer, size) : size;
+}
@@ -0,0 +1,69 @@
+#ifndef WIFI_MANAGER_SERIAL_H
+#define WIFI_MANAGER_SERIAL_H
+
+#include <Arduino.h>
+#include <atomic>
+
+// Serial monitor plumbing.
+//
+// Log output goes through a SerialTee, which forwards it to the real port and
+// copies it into a SerialRing; WiFiManager::loop() drains the ring into the
+// /serial_ws WebSocket in batched frames. The ring is allocated once and never
+// grows, and a writer never waits: bytes that do not fit are dropped and
+// counted. Slow clients therefore cost log history, not logging latency.
+
+// Single-producer/single-consumer byte ring. Positions are free-running
+// counters; the capacity is rounded up to a power of two so wrapping is a mask.
+class SerialRing {
+public:
+  explicit SerialRing(size_t capacity);
+  ~SerialRing();
+  SerialRing(const SerialRing&) = delete;
+  SerialRing& operator=(const SerialRing&) = delete;
+
+  size_t capacity() const { return _mask + 1; }
+  size_t size() const;
+  uint32_t dropped() const { return _dropped.load(std::memory_order_relaxed); }
+
+  // Producer side. Copies what fits and drops the rest.
+  size_t write(const uint8_t* data, size_t len);
+  void countDropped(size_t len) { _dropped.fetch_add(len, std::memory_order_relaxed); }
+
+  // Consumer side.
+  size_t peek(uint8_t* out, size_t len) const;
+  void skip(size_t len);
+  size_t read(uint8_t* out, size_t len);
+
+  // Copy of the newest bytes (up to len) that is safe to take from any task:
+  // whatever the producer overwrote during the copy is cut off the front.
+  size_t snapshot(uint8_t* out, size_t len) const;
+
+private:
+  uint8_t* _buf;
+  size_t _mask;
+  std::atomic<size_t> _head;  // next write position (producer)
+  std::atomic<size_t> _tail;  // next read position (consumer)
+  std::atomic<uint32_t> _dropped;
+  void copyOut(size_t from, uint8_t* out, size_t len) const;
+};
+
+// Print that forwards to `out` (usually Serial) and copies into a ring.
+// Several tasks log through one tee, so the ring's producer slot is taken with
+// a try-lock: a write that finds another one in progress still reaches `out`
+// but skips the ring (counted as dropped) instead of waiting.
+class SerialTee : public Print {
+public:
+  SerialTee(SerialRing& ring, Print* out) : _ring(ring), _out(out) {}
+
+  using Print::write;
+  size_t write(uint8_t c) override { return write(&c, 1); }
+  size_t write(const uint8_t* buffer, size_t size) override;
+  void setOutput(Print* out) { _out = out; }
+
+private:
+  SerialRing& _ring;
+  Print* _out;
+  std::atomic_flag _busy = ATOMIC_FLAG_INIT;
+};
+
+#endif // WIFI_MANAGER_SERIAL_H
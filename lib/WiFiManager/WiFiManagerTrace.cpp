@@ -0,0 +1,108 @@
+#include "WiFiManagerTrace.h"
+
+#ifdef ENABLE_TRACE
+
+#include <atomic>
+
+static_assert((WM_TRACE_EVENTS & (WM_TRACE_EVENTS - 1)) == 0, "WM_TRACE_EVENTS must be a power of two");
+
+static const std::memory_order kRelaxed = std::memory_order_relaxed;
+
+static TraceEvent sRing[WM_TRACE_EVENTS];
+static std::atomic<uint32_t> sNext(0);
+
+static const char* sTags[WmTrace::kMaxTags] = {
+  "begin.server", "begin.fs", "begin.routes", "begin.listen", "begin.mdns",
+  "dns", "scan", "scan.results", "connect.attempt",
+};
+static std::atomic<uint16_t> sTagCount(kTraceFixedTags);
+
+struct TraceTask {
+  std::atomic<const void*> handle;
+  char name[16];
+};
+static TraceTask sTasks[WmTrace::kMaxTasks];
+static std::atomic<uint8_t> sTaskCount(0);
+
+// ----- Task & Core -----
+#if defined(ESP32)
+static const void* currentTask() { return xTaskGetCurrentTaskHandle(); }
+static void currentTaskName(char* out, size_t len, uint8_t) { strlcpy(out, pcTaskGetName(nullptr), len); }
+static uint8_t currentCore() { return static_cast<uint8_t>(xPortGetCoreID()); }
+#else
+// Host threads: one marker per thread, no cores to speak of.
+static const void* currentTask() {
+  static thread_local char marker;
+  return &marker;
+}
+static void currentTaskName(char* out, size_t len, uint8_t index) { snprintf(out, len, "thread %u", index); }
+static uint8_t currentCore() { return 0; }
+#endif
+
+static uint8_t taskIndex() {
+  const void* self = currentTask();
+  uint8_t n = sTaskCount.load(std::memory_order_acquire);
+  if (n > WmTrace::kMaxTasks) n = WmTrace::kMaxTasks;
+  for (uint8_t i = 0; i < n; i++) {
+    if (sTasks[i].handle.load(std::memory_order_acquire) == self) return i;
+  }
+  uint8_t index = sTaskCount.fetch_add(1, kRelaxed);
+  if (index >= WmTrace::kMaxTasks) return WmTrace::kMaxTasks - 1;  // shares the last track
+  currentTaskName(sTasks[index].name, sizeof(sTasks[index].name), index);
+  sTasks[index].handle.store(self, std::memory_order_release);
+  return index;
+}
+
+// ----- Recording -----
+static void put(uint16_t tag, bool begin, uint32_t at) {
+  uint32_t slot = sNext.fetch_add(1, kRelaxed) & (WM_TRACE_EVENTS - 1);
+  TraceEvent& e = sRing[slot];
+  e.micros = at;
+  e.tag = tag;
+  e.task = taskIndex();
+  e.meta = static_cast<uint8_t>((begin ? kTraceBegin : 0) | currentCore());
+}
+
+void WmTrace::record(uint16_t tag, bool begin) {
+  put(tag, begin, micros());
+}
+
+void WmTrace::span(uint16_t tag, uint32_t startMicros) {
+  uint32_t now = micros();
+  put(tag, true, startMicros);
+  put(tag, false, now);
+}
+
+uint16_t WmTrace::addTag(const char* name) {
+  uint16_t n = sTagCount.load(kRelaxed);
+  for (uint16_t i = kTraceFixedTags; i < n; i++) {
+    if (strcmp(sTags[i], name) == 0) return i;
+  }
+  if (n >= kMaxTags) return kMaxTags - 1;
+  sTags[n] = name;
+  sTagCount.store(n + 1, std::memory_order_release);
+  return n;
+}
+
+const char* WmTrace::tagName(uint16_t tag) {
+  return tag < sTagCount.load(std::memory_order_acquire) ? sTags[tag] : "?";
+}
+
+const char* WmTrace::taskName(uint8_t task) {
+  return task < kMaxTasks && sTasks[task].handle.load(std::memory_order_acquire) ? sTasks[task].name : "?";
+}
+
+// ----- Export -----
+uint32_t WmTrace::snapshot(std::vector<TraceEvent>& out) {
+  uint32_t end = sNext.load(std::memory_order_acquire);
+  uint32_t start = end > WM_TRACE_EVENTS ? end - WM_TRACE_EVENTS : 0;
+  out.resize(end - start);
+  for (uint32_t i = start; i != end; i++) out[i - start] = sRing[i & (WM_TRACE_EVENTS - 1)];
+  return start;
+}
+
+void WmTrace::clear() {
+  sNext.store(0, kRelaxed);
+}
+
+#endif // ENABLE_TRACE
@@ -0,0 +1,103 @@
+#ifndef WIFI_MANAGER_TRACE_H
+#define WIFI_MANAGER_TRACE_H
+
+#include <Arduino.h>
+
+// Hot-path event tracing, compiled in with -DENABLE_TRACE.
+//
+// Spans are begin/end events with a static tag, written into a fixed ring of
+// 8-byte records: microsecond timestamp, tag, task and core. A writer claims a
+// slot with one atomic increment and never blocks or allocates; the oldest
+// events are overwritten. GET /trace exports the ring as Chrome trace JSON
+// (chrome://tracing, ui.perfetto.dev), one track per task. Without
+// ENABLE_TRACE the WM_TRACE_* macros expand to nothing and their arguments
+// are not evaluated.
+
+// Built-in tags. Routes get theirs from WmTrace::addTag() in begin().
+enum TraceTag : uint16_t {
+  kTraceBeginServer,
+  kTraceBeginFilesystem,
+  kTraceBeginRoutes,
+  kTraceBeginListen,
+  kTraceBeginMDNS,
+  kTraceDns,
+  kTraceScan,
+  kTraceScanResults,
+  kTraceConnectAttempt,
+  kTraceFixedTags
+};
+
+#ifdef ENABLE_TRACE
+
+#include <vector>
+
+#ifndef WM_TRACE_EVENTS
+#define WM_TRACE_EVENTS 1024  // ring capacity, a power of two (8 bytes each)
+#endif
+
+struct TraceEvent {
+  uint32_t micros;
+  uint16_t tag;
+  uint8_t task;   // index into WmTrace::taskName()
+  uint8_t meta;   // kTraceBegin | core
+};
+
+static const uint8_t kTraceBegin = 0x80;
+
+namespace WmTrace {
+  static const uint16_t kMaxTags = 64;
+  static const uint8_t kMaxTasks = 16;
+
+  void record(uint16_t tag, bool begin);
+  // A span that started at `startMicros` (same clock as micros()) and ends now.
+  void span(uint16_t tag, uint32_t startMicros);
+  // Registers a tag name (kept by pointer); a full table maps to the last tag.
+  uint16_t addTag(const char* name);
+  const char* tagName(uint16_t tag);
+  const char* taskName(uint8_t task);
+
+  // Copies the ring, oldest first, and returns how many events were
+  // overwritten before it. A slot being written during the copy may come out
+  // stale.
+  uint32_t snapshot(std::vector<TraceEvent>& out);
+  void clear();
+}
+
+class TraceScope {
+public:
+  // Spans shorter than `minMicros` are dropped, so a busy poll (the DNS
+  // responder runs every loop()) does not flush the ring.
+  explicit TraceScope(uint16_t tag, uint32_t minMicros = 0)
+    : _tag(tag), _min(minMicros), _start(micros()) {
+    if (!_min) WmTrace::record(_tag, true);
+  }
+  ~TraceScope() {
+    if (!_min) WmTrace::record(_tag, false);
+    else if (micros() - _start >= _min) WmTrace::span(_tag, _start);
+  }
+
+private:
+  uint16_t _tag;
+  uint32_t _min;
+  uint32_t _start;
+};
+
+#define WM_TRACE_CONCAT_(a, b) a##b
+#define WM_TRACE_CONCAT(a, b) WM_TRACE_CONCAT_(a, b)
+#define WM_TRACE_SCOPE(tag) TraceScope WM_TRACE_CONCAT(_wmTrace, __LINE__)(tag)
+#define WM_TRACE_SCOPE_MIN(tag, minMicros) TraceScope WM_TRACE_CONCAT(_wmTrace, __LINE__)(tag, minMicros)
+#define WM_TRACE_BEGIN(tag) WmTrace::record(tag, true)
+#define WM_TRACE_END(tag) WmTrace::record(tag, false)
+#define WM_TRACE_SPAN(tag, startMicros) WmTrace::span(tag, startMicros)
+
+#else
+
+#define WM_TRACE_SCOPE(tag) do {} while (0)
+#define WM_TRACE_SCOPE_MIN(tag, minMicros) do {} while (0)
+#define WM_TRACE_BEGIN(tag) do {} while (0)
+#define WM_TRACE_END(tag) do {} while (0)
+#define WM_TRACE_SPAN(tag, startMicros) do {} while (0)
+
+#endif // ENABLE_TRACE
+
+#endif // WIFI_MANAGER_TRACE_H
@@ -0,0 +1,44 @@
+#ifndef WIFI_MANAGER_WINDOW_H
+#define WIFI_MANAGER_WINDOW_H
+
+#include <Arduino.h>
+
+// One chunk of a streamed text document. Renderers emit the document (or a
+// resumable piece of it) from its start on every call; the window counts the
+// bytes already sent (`skip`) and drops them, copies the next `maxLen` into
+// the TCP buffer and only counts whatever follows. JsonStreamWriter and
+// MetricsWriter write through one.
+class OutputWindow {
+public:
+  OutputWindow(uint8_t* buf, size_t maxLen, size_t skip) : _buf(buf), _cap(maxLen), _skip(skip) {}
+
+  void write(const char* s, size_t len) {
+    size_t end = _pos + len;
+    if (end > _skip && _written < _cap) {
+      size_t from = _pos < _skip ? _skip - _pos : 0;
+      size_t n = len - from;
+      if (n > _cap - _written) n = _cap - _written;
+      memcpy(_buf + _written, s + from, n);
+      _written += n;
+    }
+    _pos = end;
+  }
+
+  void write(char c) {
+    if (_pos >= _skip && _written < _cap) _buf[_written++] = static_cast<uint8_t>(c);
+    _pos++;
+  }
+
+  size_t written() const { return _written; }  // bytes placed in buf
+  size_t produced() const { return _pos; }     // logical document offset
+  bool full() const { return _written == _cap; }
+
+private:
+  uint8_t* _buf;
+  size_t _cap;
+  size_t _skip;
+  size_t _pos = 0;
+  size_t _written = 0;
+};
+
+#endif // WIFI_MANAGER_WINDOW_H
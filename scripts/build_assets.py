@@ -0,0 +1,328 @@
+"""Portal asset pipeline.
+
+Minifies the files in data/, gzips them and gives the stylesheets and scripts
+that the HTML pages reference content-hashed names (style.<hash8>.css), then
+rewrites the pages to point at those names. The output directory becomes the
+SPIFFS image, so only the .gz variants end up in flash; the firmware serves
+them with Content-Encoding: gzip, a strong ETag taken from the gzip trailer
+and an immutable Cache-Control for the hashed names.
+
+The same streams are also written as a C++ table (portal_assets.h) that
+ENABLE_EMBEDDED_ASSETS builds compile into the firmware, so the portal can be
+served straight from flash without mounting SPIFFS.
+
+PlatformIO runs this as a pre-build script (extra_scripts = pre:...). It can
+also be run by hand to inspect the result and the size report:
+
+    python scripts/build_assets.py [--src data] [--out .pio/build/portal]
+                                   [--header .pio/build/portal_include/portal_assets.h]
+"""
+
+import gzip
+import hashlib
+import io
+import os
+import re
+import shutil
+import struct
+import sys
+
+# SPIFFS_OBJ_NAME_LEN is 32 including the terminator.
+MAX_SPIFFS_PATH = 31
+# Already compressed; gzip would only add a header.
+STORE_AS_IS = {".png", ".jpg", ".jpeg", ".gif", ".webp", ".woff", ".woff2", ".gz"}
+# Referenced from HTML by name and safe to rename.
+FINGERPRINT = {".css", ".js"}
+# Content types for the embedded table; keep in step with the web server's.
+CONTENT_TYPES = {
+    ".html": "text/html", ".htm": "text/html", ".css": "text/css", ".js": "application/javascript",
+    ".json": "application/json", ".ico": "image/x-icon", ".svg": "image/svg+xml", ".txt": "text/plain",
+    ".xml": "text/xml",
+}
+# Effective SoftAP throughput and round trip used for the load-time estimate.
+LINK_KBPS = 1000
+LINK_RTT_MS = 30
+
+
+# ----- Minifiers -----
+# Deliberately conservative: comments and layout whitespace go, line breaks in
+# scripts stay so automatic semicolon insertion is never affected, and string
+# and template literal contents are never touched.
+
+_CSS_TOKENS = re.compile(r'("(?:\\.|[^"\\])*"|\'(?:\\.|[^\'\\])*\')|(/\*.*?\*/)', re.S)
+
+
+def minify_css(text):
+    out = []
+    pos = 0
+    for m in _CSS_TOKENS.finditer(text):
+        out.append(_squeeze_css(text[pos:m.start()]))
+        if m.group(1):
+            out.append(m.group(1))
+        pos = m.end()
+    out.append(_squeeze_css(text[pos:]))
+    return "".join(out).strip()
+
+
+def _squeeze_css(chunk):
+    chunk = re.sub(r"\s+", " ", chunk)
+    chunk = re.sub(r"\s*([{};,>])\s*", r"\1", chunk)
+    return chunk.replace(";}", "}")
+
+
+def minify_js(text):
+    out = []
+    i, n = 0, len(text)
+    last = ""  # last significant character, to tell a regex from a division
+    gap = ""   # whitespace owed before the next token: "", " " or "\n"
+
+    def emit(token):
+        if gap and out:
+            out.append(gap)
+        out.append(token)
+
+    # Only whitespace between tokens is collapsed; strings, template literals
+    # and regexes are copied as they are.
+    while i < n:
+        c = text[i]
+        if c in "\"'`":
+            j = i + 1
+            while j < n and text[j] != c:
+                j += 2 if text[j] == "\\" else 1
+            emit(text[i:j + 1])
+            gap = ""
+            last = c
+            i = j + 1
+        elif text.startswith("//", i):
+            while i < n and text[i] != "\n":
+                i += 1
+        elif text.startswith("/*", i):
+            end = text.find("*/", i + 2)
+            end = n if end < 0 else end + 2
+            gap = "\n" if gap == "\n" or "\n" in text[i:end] else " "
+            i = end
+        elif c.isspace():
+            gap = "\n" if gap == "\n" or c == "\n" else " "
+            i += 1
+        elif c == "/" and (last == "" or last in "(,=:[!&|?{};+-*%<>~^\n"):
+            j = i + 1
+            in_class = False
+            while j < n and text[j] != "\n":
+                if text[j] == "\\":
+                    j += 2
+                    continue
+                if text[j] == "[":
+                    in_class = True
+                elif text[j] == "]":
+                    in_class = False
+                elif text[j] == "/" and not in_class:
+                    break
+                j += 1
+            emit(text[i:j + 1])
+            gap = ""
+            last = "/"
+            i = j + 1
+        else:
+            emit(c)
+            gap = ""
+            last = c
+            i += 1
+    return "".join(out)
+
+
+def minify_html(text):
+    text = re.sub(r"<!--.*?-->", "", text, flags=re.S)
+    lines = (line.strip() for line in text.split("\n"))
+    return "\n".join(line for line in lines if line)
+
+
+MINIFIERS = {".css": minify_css, ".js": minify_js, ".html": minify_html, ".htm": minify_html}
+
+
+# ----- Pipeline -----
+def gzip_bytes(data):
+    buf = io.BytesIO()
+    # mtime=0 and no file name keep the output, and so the ETag, reproducible.
+    with gzip.GzipFile(filename="", mode="wb", fileobj=buf, compresslevel=9, mtime=0) as gz:
+        gz.write(data)
+    return buf.getvalue()
+
+
+def build(src, out):
+    """Builds the image in `out`; returns {name: (raw, minified, stored, output name)}."""
+    if os.path.isdir(out):
+        shutil.rmtree(out)
+    os.makedirs(out)
+
+    assets = {}
+    for name in sorted(os.listdir(src)):
+        path = os.path.join(src, name)
+        if not os.path.isfile(path) or name.startswith("."):
+            continue
+        with open(path, "rb") as f:
+            raw = f.read()
+        ext = os.path.splitext(name)[1].lower()
+        data = raw
+        if ext in MINIFIERS:
+            data = MINIFIERS[ext](raw.decode("utf-8")).encode("utf-8")
+        assets[name] = [raw, data, ext]
+
+    # Pages decide which assets are worth fingerprinting.
+    pages = [n for n, a in assets.items() if a[2] in (".html", ".htm")]
+    renamed = {}
+    for page in pages:
+        html = assets[page][1].decode("utf-8")
+        for ref in re.findall(r'(?:src|href)=["\']([^"\':/?#]+)["\']', html):
+            if ref in assets and assets[ref][2] in FINGERPRINT and ref not in renamed:
+                stem, ext = os.path.splitext(ref)
+                digest = hashlib.sha256(assets[ref][1]).hexdigest()[:8]
+                renamed[ref] = "%s.%s%s" % (stem, digest, ext)
+    for page in pages:
+        html = assets[page][1].decode("utf-8")
+        for old, new in renamed.items():
+            html = re.sub(r'((?:src|href)=["\'])%s(["\'])' % re.escape(old), r"\g<1>%s\g<2>" % new, html)
+        assets[page][1] = html.encode("utf-8")
+
+    report = {}
+    for name, (raw, data, ext) in assets.items():
+        target = renamed.get(name, name)
+        if ext in STORE_AS_IS:
+            stored, written = data, target
+        else:
+            stored, written = gzip_bytes(data), target + ".gz"
+        if len(written) + 1 > MAX_SPIFFS_PATH:
+            raise SystemExit("build_assets: /%s exceeds the SPIFFS name limit" % written)
+        with open(os.path.join(out, written), "wb") as f:
+            f.write(stored)
+        report[name] = (len(raw), len(data), len(stored), written)
+    return report
+
+
+# ----- Embedded table -----
+def gzip_etag(stored):
+    crc, isize = struct.unpack("<II", stored[-8:])
+    return '"%08x-%08x"' % (crc, isize)
+
+
+def render_header(out, report):
+    """C++ source for the embedded asset table, sorted by request path."""
+    entries = []
+    for raw, minified, stored, written in report.values():
+        if not written.endswith(".gz"):
+            continue  # already-compressed types stay on SPIFFS
+        path = "/" + written[:-3]
+        with open(os.path.join(out, written), "rb") as f:
+            entries.append((path.encode("utf-8"), f.read()))
+    entries.sort()
+
+    lines = [
+        "// Generated by scripts/build_assets.py; do not edit.",
+        "#ifndef PORTAL_ASSETS_H",
+        "#define PORTAL_ASSETS_H",
+        "",
+        '#include "WiFiManagerAssets.h"',
+        "",
+        "namespace {",
+    ]
+    for i, (path, data) in enumerate(entries):
+        lines.append("// %s" % path.decode("utf-8"))
+        lines.append("const uint8_t kPortalAsset%d[] PROGMEM = {" % i)
+        for at in range(0, len(data), 20):
+            lines.append("  " + ",".join("0x%02x" % b for b in data[at:at + 20]) + ",")
+        lines.append("};")
+    lines.append("} // namespace")
+    lines.append("")
+    lines.append("constexpr EmbeddedAsset kPortalAssets[] = {")
+    for i, (path, data) in enumerate(entries):
+        name = path.decode("utf-8")
+        ctype = CONTENT_TYPES.get(os.path.splitext(name)[1].lower(), "text/plain")
+        etag = gzip_etag(data).replace('"', '\\"')
+        lines.append('  {"%s", kPortalAsset%d, %d, "%s", "%s"},' % (name, i, len(data), etag, ctype))
+    lines += [
+        "};",
+        "constexpr size_t kPortalAssetCount = sizeof(kPortalAssets) / sizeof(kPortalAssets[0]);",
+        'static_assert(embeddedAssetsSorted(kPortalAssets, kPortalAssetCount), "portal assets must be sorted by path");',
+        "",
+        "#endif // PORTAL_ASSETS_H",
+        "",
+    ]
+    return "\n".join(lines), sum(len(d) for _, d in entries), len(entries)
+
+
+def write_header(out, report, header):
+    text, size, count = render_header(out, report)
+    os.makedirs(os.path.dirname(header), exist_ok=True)
+    # Unchanged assets must not force a rebuild.
+    if not os.path.isfile(header) or open(header, encoding="utf-8").read() != text:
+        with open(header, "w", encoding="utf-8") as f:
+            f.write(text)
+    print("build_assets: embedded table: %d assets, %d bytes of flash -> %s" % (count, size, header))
+
+
+def page_load(report, src, page, use_output):
+    """Bytes and estimated load time of `page` plus the local assets it references."""
+    with open(os.path.join(src, page), "r", encoding="utf-8") as f:
+        html = f.read()
+    refs = [r for r in re.findall(r'(?:src|href)=["\']([^"\':/?#]+)["\']', html) if r in report]
+    refs = sorted(set(refs))
+    col = 2 if use_output else 0
+    first = report[page][col]
+    rest = sum(report[r][col] for r in refs)
+    # The page, then its subresources in one parallel wave.
+    ms = 2 * LINK_RTT_MS + (first + rest) * 8 / LINK_KBPS
+    return first + rest, ms, len(refs) + 1
+
+
+def print_report(report, src):
+    print("build_assets: %-22s %8s %8s %8s" % ("file", "raw", "min", "stored"))
+    for name in sorted(report):
+        raw, minified, stored, written = report[name]
+        print("build_assets: %-22s %8d %8d %8d  -> %s" % (name, raw, minified, stored, written))
+    total = [sum(r[i] for r in report.values()) for i in range(3)]
+    print("build_assets: %-22s %8d %8d %8d" % ("total", total[0], total[1], total[2]))
+    if "index.html" in report:
+        before, before_ms, requests = page_load(report, src, "index.html", False)
+        after, after_ms, _ = page_load(report, src, "index.html", True)
+        print("build_assets: portal load (%d requests, %d kbit/s, %d ms RTT): %d -> %d bytes, ~%d -> ~%d ms;"
+              " repeat visit: 304s only" % (requests, LINK_KBPS, LINK_RTT_MS, before, after, before_ms, after_ms))
+
+
+def main(argv):
+    root = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+    src = os.path.join(root, "data")
+    out = os.path.join(root, ".pio", "build", "portal")
+    header = os.path.join(root, ".pio", "build", "portal_include", "portal_assets.h")
+    args = list(argv)
+    while args:
+        flag = args.pop(0)
+        if flag == "--src":
+            src = args.pop(0)
+        elif flag == "--out":
+            out = args.pop(0)
+        elif flag == "--header":
+            header = args.pop(0)
+        else:
+            raise SystemExit(__doc__)
+    report = build(src, out)
+    print_report(report, src)
+    write_header(out, report, header)
+
+
+try:
+    Import("env")  # noqa: F821 - provided by PlatformIO/SCons
+except NameError:
+    env = None
+
+if env is not None:
+    _src = env.subst("$PROJECT_DATA_DIR")
+    _out = os.path.join(env.subst("$PROJECT_BUILD_DIR"), "portal")
+    _include = os.path.join(env.subst("$PROJECT_BUILD_DIR"), "portal_include")
+    _report = build(_src, _out)
+    print_report(_report, _src)
+    write_header(_out, _report, os.path.join(_include, "portal_assets.h"))
+    # Found by WiFiManagerAssets.cpp when ENABLE_EMBEDDED_ASSETS is set.
+    env.Append(CPPPATH=[_include])
+    # buildfs/uploadfs pack the processed tree instead of data/.
+    env.Replace(PROJECT_DATA_DIR=_out)
+elif __name__ == "__main__":
+    main(sys.argv[1:])
@@ -0,0 +1,501 @@
+"""Portal load generator and latency SLO check.
+
+Drives a running WiFiManager HTTP server (the host build or a device on the
+SoftAP) with concurrent clients the way a crowd of phones on a kiosk portal
+does: /status_json polling, /scan, /update_params posts, static assets and
+long-lived /ws connections. Reports throughput, p50/p99/p99.9 latency and
+error rates per request kind, and the server's heap low-water marks from
+/device_info, then checks them against the given SLOs.
+
+    python scripts/loadgen.py [--host 127.0.0.1] [--port 8080] [--duration 30]
+                              [--concurrency 8] [--ws 4] [--rate 0]
+                              [--mix status_json=60,scan=5,update_params=5,asset=30]
+                              [--slo p99_ms=250] [--slo status_json.p99_ms=100]
+                              [--spawn .pio/build/native/program] [--json report.json]
+
+SLOs are key=value, optionally prefixed with a request kind:
+    p50_ms, p99_ms, p999_ms, max_ms   latency upper bounds
+    error_rate                        failed fraction (transport errors, timeouts, status >= 400)
+    min_rps                           throughput lower bound
+    min_free_heap, min_largest_block  server heap lower bounds in bytes (not per kind)
+
+Exit status: 0 when every SLO holds, 1 when one is breached, 2 when the server
+cannot be reached.
+
+PlatformIO runs this as a post script of env:native, which adds a target that
+builds the host program, starts it on a free port with the processed portal
+and runs the kiosk profile (KIOSK_SLOS) against it:
+
+    pio run -e native -t loadtest      # extra arguments: WM_LOADGEN_ARGS="--duration 60"
+"""
+
+import argparse
+import asyncio
+import base64
+import json
+import os
+import random
+import re
+import shlex
+import socket
+import struct
+import subprocess
+import sys
+import time
+from collections import Counter
+
+DEFAULT_MIX = "status_json=60,scan=5,update_params=5,asset=30"
+# The pio target's gate: a handful of phones polling a portal must never see
+# errors or multi-second stalls, and the heap must keep room for TLS and OTA.
+KIOSK_SLOS = ["error_rate=0.01", "p99_ms=500", "p999_ms=2000", "min_free_heap=100000"]
+LATENCY_KEYS = {"p50_ms": 0.5, "p99_ms": 0.99, "p999_ms": 0.999, "max_ms": 1.0}
+HEAP_KEYS = ("min_free_heap", "min_largest_block")
+
+
+# ----- HTTP & WebSocket -----
+
+class Client:
+    def __init__(self, host, port, timeout, auth):
+        self.host = host
+        self.port = port
+        self.timeout = timeout
+        self.auth = auth
+
+    def head(self, method, path, extra=""):
+        lines = "%s %s HTTP/1.1\r\nHost: %s\r\n" % (method, path, self.host)
+        if self.auth:
+            lines += "Authorization: Basic %s\r\n" % self.auth
+        return lines + extra
+
+    async def request(self, method, path, body=None):
+        """One request on its own connection (the server closes after each); (status, body)."""
+        extra = ""
+        if body is not None:
+            extra = "Content-Type: application/x-www-form-urlencoded\r\nContent-Length: %d\r\n" % len(body)
+        data = (self.head(method, path, extra) + "\r\n").encode() + (body.encode() if body else b"")
+
+        async def exchange():
+            reader, writer = await asyncio.open_connection(self.host, self.port)
+            try:
+                writer.write(data)
+                await writer.drain()
+                raw = await reader.read()
+            finally:
+                writer.close()
+            return raw
+
+        raw = await asyncio.wait_for(exchange(), self.timeout)
+        head, _, payload = raw.partition(b"\r\n\r\n")
+        status = head.split(b" ", 2)
+        if len(status) < 2 or not status[1].isdigit():
+            raise ValueError("malformed response")
+        if b"\r\ntransfer-encoding: chunked" in head.lower():
+            payload = dechunk(payload)
+        return int(status[1]), payload
+
+    async def websocket(self, path):
+        """Opens `path` as a WebSocket; (reader, writer) after the 101."""
+        key = base64.b64encode(os.urandom(16)).decode()
+        extra = ("Upgrade: websocket\r\nConnection: Upgrade\r\nSec-WebSocket-Version: 13\r\n"
+                 "Sec-WebSocket-Key: %s\r\n" % key)
+        reader, writer = await asyncio.wait_for(asyncio.open_connection(self.host, self.port), self.timeout)
+        writer.write((self.head("GET", path, extra) + "\r\n").encode())
+        head = await asyncio.wait_for(reader.readuntil(b"\r\n\r\n"), self.timeout)
+        if not head.startswith(b"HTTP/1.1 101"):
+            writer.close()
+            raise ValueError("no upgrade: %s" % head.split(b"\r\n", 1)[0].decode(errors="replace"))
+        return reader, writer
+
+
+def dechunk(data):
+    out = []
+    pos = 0
+    while True:
+        eol = data.index(b"\r\n", pos)
+        size = int(data[pos:eol].split(b";")[0], 16)
+        if size == 0:
+            return b"".join(out)
+        out.append(data[eol + 2:eol + 2 + size])
+        pos = eol + 4 + size
+
+
+async def read_frame(reader):
+    """(opcode, payload) of the next server frame; server frames are unmasked."""
+    b0, b1 = await reader.readexactly(2)
+    length = b1 & 0x7F
+    if length == 126:
+        length = struct.unpack(">H", await reader.readexactly(2))[0]
+    elif length == 127:
+        length = struct.unpack(">Q", await reader.readexactly(8))[0]
+    return b0 & 0x0F, await reader.readexactly(length)
+
+
+def masked_frame(opcode, payload):
+    mask = os.urandom(4)
+    body = bytes(b ^ mask[i % 4] for i, b in enumerate(payload))
+    return bytes([0x80 | opcode, 0x80 | len(payload)]) + mask + body
+
+
+# ----- Statistics -----
+
+class Stats:
+    def __init__(self):
+        self.latencies = []
+        self.statuses = Counter()
+        self.failures = Counter()  # transport errors and timeouts, by reason
+
+    def ok(self, seconds, status):
+        self.latencies.append(seconds)
+        self.statuses[status] += 1
+
+    def failed(self, reason):
+        self.failures[reason] += 1
+
+    def count(self):
+        return len(self.latencies) + sum(self.failures.values())
+
+    def errors(self):
+        return sum(self.failures.values()) + sum(n for s, n in self.statuses.items() if s >= 400)
+
+    def percentile(self, q):
+        if not self.latencies:
+            return None
+        ordered = sorted(self.latencies)
+        return ordered[min(len(ordered) - 1, max(0, int(q * len(ordered) + 0.999999) - 1))] * 1000.0
+
+    def summary(self, elapsed):
+        n = self.count()
+        out = {"requests": n, "rps": n / elapsed if elapsed else 0.0, "errors": self.errors(),
+               "error_rate": self.errors() / n if n else 0.0,
+               "statuses": {str(k): v for k, v in sorted(self.statuses.items())},
+               "failures": dict(self.failures)}
+        for key, q in LATENCY_KEYS.items():
+            out[key] = self.percentile(q)
+        return out
+
+
+class Pacer:
+    """Spreads requests evenly at `rate` per second over all workers (0 = as fast as possible)."""
+
+    def __init__(self, rate):
+        self.interval = 1.0 / rate if rate > 0 else 0.0
+        self.next = time.monotonic()
+
+    async def wait(self):
+        if not self.interval:
+            return
+        now = time.monotonic()
+        at = max(now, self.next)
+        self.next = at + self.interval
+        if at > now:
+            await asyncio.sleep(at - now)
+
+
+# ----- Workload -----
+
+class Workload:
+    def __init__(self, client, args):
+        self.client = client
+        self.args = args
+        self.stats = {}
+        self.mix = []
+        for item in args.mix.split(","):
+            kind, _, weight = item.partition("=")
+            if kind not in ("status_json", "scan", "update_params", "asset"):
+                raise SystemExit("loadgen: unknown request kind '%s'" % kind)
+            if float(weight or 1) > 0:
+                self.mix.append((kind.strip(), float(weight or 1)))
+        self.assets = list(args.asset)
+        self.form = args.param
+        self.heap = {"start": None, "lowest_free": None, "lowest_block": None, "server": None}
+        self.ws_messages = 0
+        self.stop_at = 0.0
+
+    def stat(self, kind):
+        return self.stats.setdefault(kind, Stats())
+
+    async def discover(self):
+        """Static assets referenced by the portal page and a parameter to post back unchanged."""
+        if not self.assets:
+            status, page = await self.client.request("GET", "/")
+            self.assets = ["/"]
+            if status == 200:
+                refs = re.findall(r'(?:src|href)=["\']([^"\':?#]+)["\']', page.decode(errors="replace"))
+                self.assets += sorted({"/" + r.lstrip("/") for r in refs})
+        if not self.form and any(kind == "update_params" for kind, _ in self.mix):
+            status, body = await self.client.request("GET", "/params_json")
+            params = json.loads(body) if status == 200 else []
+            if not params:
+                raise SystemExit("loadgen: no parameters to post; pass --param id=value or drop update_params")
+            self.form = ["%s=%s" % (params[0]["id"], params[0]["value"])]
+
+    async def one(self, kind):
+        if kind == "asset":
+            method, path, body = "GET", random.choice(self.assets), None
+        elif kind == "update_params":
+            method, path, body = "POST", "/update_params", "&".join(self.form)
+        else:
+            method, path, body = "GET", "/" + kind, None
+        start = time.monotonic()
+        try:
+            status, _ = await self.client.request(method, path, body)
+            self.stat(kind).ok(time.monotonic() - start, status)
+        except asyncio.TimeoutError:
+            self.stat(kind).failed("timeout")
+        except (OSError, ValueError, asyncio.IncompleteReadError) as e:
+            self.stat(kind).failed(type(e).__name__)
+
+    async def http_worker(self, pacer):
+        kinds = [k for k, _ in self.mix]
+        weights = [w for _, w in self.mix]
+        while time.monotonic() < self.stop_at:
+            await pacer.wait()
+            await self.one(random.choices(kinds, weights)[0])
+
+    async def ws_worker(self):
+        """Holds /ws open and reads pushes; a drop counts as an error and reconnects."""
+        stats = self.stat("ws_connect")
+        while time.monotonic() < self.stop_at:
+            start = time.monotonic()
+            try:
+                reader, writer = await self.client.websocket(self.args.ws_path)
+            except asyncio.TimeoutError:
+                stats.failed("timeout")
+                continue
+            except (OSError, ValueError, asyncio.IncompleteReadError) as e:
+                stats.failed(type(e).__name__)
+                await asyncio.sleep(0.1)
+                continue
+            stats.ok(time.monotonic() - start, 101)
+            try:
+                while True:
+                    remaining = self.stop_at - time.monotonic()
+                    if remaining <= 0:
+                        writer.write(masked_frame(0x8, struct.pack(">H", 1000)))
+                        break
+                    try:
+                        opcode, payload = await asyncio.wait_for(read_frame(reader), remaining)
+                    except asyncio.TimeoutError:
+                        continue
+                    if opcode == 0x9:
+                        writer.write(masked_frame(0xA, payload))
+                    elif opcode == 0x8:
+                        stats.failed("closed_by_server")
+                        break
+                    else:
+                        self.ws_messages += 1
+            except (OSError, asyncio.IncompleteReadError):
+                stats.failed("dropped")
+            finally:
+                writer.close()
+
+    async def heap_sample(self):
+        try:
+            status, body = await self.client.request("GET", "/device_info")
+            info = json.loads(body) if status == 200 else {}
+        except (OSError, ValueError, asyncio.TimeoutError, asyncio.IncompleteReadError):
+            return None
+        return info.get("heap")
+
+    async def heap_sampler(self):
+        while time.monotonic() < self.stop_at:
+            heap = await self.heap_sample()
+            if heap:
+                low = self.heap["lowest_free"]
+                self.heap["lowest_free"] = heap["free"] if low is None else min(low, heap["free"])
+                low = self.heap["lowest_block"]
+                block = heap["largest_block"]
+                self.heap["lowest_block"] = block if low is None else min(low, block)
+            await asyncio.sleep(self.args.heap_interval)
+
+    async def run(self):
+        await self.discover()
+        self.heap["start"] = await self.heap_sample()
+        pacer = Pacer(self.args.rate)
+        start = time.monotonic()
+        self.stop_at = start + self.args.duration
+        tasks = [self.http_worker(pacer) for _ in range(self.args.concurrency)]
+        tasks += [self.ws_worker() for _ in range(self.args.ws)]
+        tasks.append(self.heap_sampler())
+        await asyncio.gather(*tasks)
+        elapsed = time.monotonic() - start
+        # min_free and min_largest_block are the server's own low-water marks,
+        # so they also cover the moments between samples.
+        self.heap["server"] = await self.heap_sample()
+        return elapsed
+
+
+# ----- Report & SLOs -----
+
+def build_report(work, elapsed):
+    total = Stats()
+    for kind, s in work.stats.items():
+        if kind == "ws_connect":
+            continue
+        total.latencies += s.latencies
+        total.statuses.update(s.statuses)
+        total.failures.update(s.failures)
+    report = {"duration_s": elapsed, "total": total.summary(elapsed),
+              "kinds": {k: s.summary(elapsed) for k, s in sorted(work.stats.items())},
+              "ws_messages": work.ws_messages, "heap": {}}
+    server = work.heap["server"] or {}
+    start = work.heap["start"] or {}
+    if server or start:
+        report["heap"] = {
+            "free_at_start": start.get("free"),
+            "lowest_free_sampled": work.heap["lowest_free"],
+            "min_free_heap": server.get("min_free"),
+            "min_largest_block": server.get("min_largest_block"),
+        }
+    return report
+
+
+def fmt_ms(value):
+    return "%8.1f" % value if value is not None else "       -"
+
+
+def print_report(report):
+    print("loadgen: %-13s %8s %7s %8s %8s %8s %8s %7s" %
+          ("kind", "requests", "rps", "p50 ms", "p99 ms", "p99.9 ms", "max ms", "errors"))
+    rows = list(report["kinds"].items()) + [("total", report["total"])]
+    for kind, s in rows:
+        print("loadgen: %-13s %8d %7.1f %s %s %s %s %7d" %
+              (kind, s["requests"], s["rps"], fmt_ms(s["p50_ms"]), fmt_ms(s["p99_ms"]), fmt_ms(s["p999_ms"]),
+               fmt_ms(s["max_ms"]), s["errors"]))
+    t = report["total"]
+    statuses = " ".join("%s=%d" % kv for kv in t["statuses"].items())
+    failures = " ".join("%s=%d" % kv for kv in t["failures"].items())
+    print("loadgen: statuses %s%s" % (statuses or "-", ("; failures " + failures) if failures else ""))
+    if "ws_connect" in report["kinds"]:
+        print("loadgen: websocket messages received: %d" % report["ws_messages"])
+    heap = report["heap"]
+    if heap:
+        print("loadgen: heap free %s at start, lowest sampled %s; server min_free %s, min largest block %s" %
+              (heap["free_at_start"], heap["lowest_free_sampled"], heap["min_free_heap"], heap["min_largest_block"]))
+
+
+def check_slos(report, slos):
+    """Prints one line per SLO; True when all hold."""
+    held = True
+    for slo in slos:
+        key, _, limit = slo.partition("=")
+        kind, _, metric = key.rpartition(".")
+        try:
+            limit = float(limit)
+        except ValueError:
+            raise SystemExit("loadgen: bad SLO '%s'" % slo)
+        if metric in HEAP_KEYS:
+            actual = report["heap"].get(metric)
+            ok = actual is not None and actual >= limit
+        else:
+            scope = report["kinds"].get(kind) if kind else report["total"]
+            if metric not in LATENCY_KEYS and metric not in ("error_rate", "min_rps"):
+                raise SystemExit("loadgen: unknown SLO metric '%s'" % metric)
+            if scope is None:
+                actual, ok = None, False
+            elif metric == "min_rps":
+                actual = scope["rps"]
+                ok = actual >= limit
+            else:
+                actual = scope[metric]
+                ok = actual is not None and actual <= limit
+        held &= ok
+        print("loadgen: SLO %-26s %-10s %s" % (slo, "ok" if ok else "BREACHED",
+                                               "%.4g" % actual if actual is not None else "no data"))
+    return held
+
+
+# ----- Server process -----
+
+def free_port(kind):
+    with socket.socket(socket.AF_INET, kind) as s:
+        s.bind(("127.0.0.1", 0))
+        return s.getsockname()[1]
+
+
+def spawn(command, fs_root, log):
+    """Starts the host build on free ports; (process, http port) once it accepts connections."""
+    port = free_port(socket.SOCK_STREAM)
+    env = dict(os.environ, WM_HTTP_PORT=str(port), WM_DNS_PORT=str(free_port(socket.SOCK_DGRAM)))
+    if fs_root:
+        env["WM_FS_ROOT"] = fs_root
+    out = open(log, "w") if log else subprocess.DEVNULL
+    proc = subprocess.Popen(shlex.split(command), env=env, stdout=out, stderr=subprocess.STDOUT)
+    deadline = time.monotonic() + 10
+    while time.monotonic() < deadline and proc.poll() is None:
+        try:
+            socket.create_connection(("127.0.0.1", port), 0.2).close()
+            return proc, port
+        except OSError:
+            time.sleep(0.05)
+    proc.kill()
+    raise SystemExit(2)
+
+
+def main(argv):
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0],
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--host", default="127.0.0.1")
+    parser.add_argument("--port", type=int, default=8080)
+    parser.add_argument("--duration", type=float, default=30, help="seconds of load (default 30)")
+    parser.add_argument("--concurrency", type=int, default=8, help="HTTP clients in flight (default 8)")
+    parser.add_argument("--ws", type=int, default=4, help="WebSocket clients held open (default 4)")
+    parser.add_argument("--ws-path", default="/ws")
+    parser.add_argument("--rate", type=float, default=0, help="cap on HTTP requests/s over all clients")
+    parser.add_argument("--mix", default=DEFAULT_MIX, help="request kinds and weights (default %s)" % DEFAULT_MIX)
+    parser.add_argument("--asset", action="append", default=[], help="static path (default: found from /)")
+    parser.add_argument("--param", action="append", default=[], help="id=value for update_params")
+    parser.add_argument("--timeout", type=float, default=10, help="per-request timeout in s (default 10)")
+    parser.add_argument("--heap-interval", type=float, default=1.0, help="/device_info poll period in s")
+    parser.add_argument("--user", help="portal user (Basic auth)")
+    parser.add_argument("--password", default="")
+    parser.add_argument("--slo", action="append", default=[], help="[kind.]metric=limit, repeatable")
+    parser.add_argument("--json", help="also write the report as JSON to this file")
+    parser.add_argument("--spawn", help="start this host build on a free port and test it")
+    parser.add_argument("--fs-root", help="WM_FS_ROOT for --spawn")
+    parser.add_argument("--server-log", help="output of the --spawn process (default: discarded)")
+    args = parser.parse_args(argv)
+
+    proc = None
+    if args.spawn:
+        proc, args.port = spawn(args.spawn, args.fs_root, args.server_log)
+        args.host = "127.0.0.1"
+    auth = base64.b64encode(("%s:%s" % (args.user, args.password)).encode()).decode() if args.user else None
+    work = Workload(Client(args.host, args.port, args.timeout, auth), args)
+    try:
+        elapsed = asyncio.run(work.run())
+    except OSError as e:
+        print("loadgen: cannot reach %s:%d: %s" % (args.host, args.port, e))
+        return 2
+    finally:
+        if proc:
+            proc.terminate()
+            proc.wait()
+
+    report = build_report(work, elapsed)
+    print_report(report)
+    held = check_slos(report, args.slo)
+    if args.json:
+        with open(args.json, "w") as f:
+            json.dump(dict(report, slos=args.slo, slos_held=held), f, indent=2)
+    return 0 if held else 1
+
+
+try:
+    Import("env")  # noqa: F821 - provided by PlatformIO/SCons
+except NameError:
+    env = None
+
+if env is not None:
+    _script = os.path.join(env.subst("$PROJECT_DIR"), "scripts", "loadgen.py")
+    _portal = os.path.join(env.subst("$PROJECT_BUILD_DIR"), "portal")
+    _slos = " ".join("--slo %s" % s for s in KIOSK_SLOS)
+    env.AddCustomTarget(
+        name="loadtest",
+        dependencies="$BUILD_DIR/${PROGNAME}",
+        actions='"$PYTHONEXE" "%s" --spawn "$BUILD_DIR/${PROGNAME}" --fs-root "%s" %s %s' %
+                (_script, _portal, _slos, os.environ.get("WM_LOADGEN_ARGS", "")),
+        title="Load test",
+        description="Kiosk load profile against the host build; fails on an SLO breach")
+elif __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
@@ -2,12 +2,16 @@
 #include "WiFiManager.h"
 #include <Preferences.h>
 
-// Custom parameters for the WiFi Manager
-WiFiManagerParameter* customMqttServer = nullptr;
-WiFiManagerParameter* customMqttPort = nullptr;
-WiFiManagerParameter* customDeviceName = nullptr;
-WiFiManagerParameter* customThemeColor = nullptr;
-WiFiManagerParameter* customUpdateInterval = nullptr;
+// Custom parameters for the WiFi Manager: the schema stays in flash, the
+// block holds the value buffers (no heap allocation per parameter)
+static constexpr ParamSpec kParamSchema[] = {
+  textParam("mqtt_server", "MQTT Server", 40, "mqtt.example.com"),
+  numberParam("mqtt_port", "MQTT Port", 1, 65535, "1883"),
+  textParam("device_name", "Device Name", 20, "esp32-device"),
+  typedParam("theme_color", "Theme Color", ParameterType::COLOR, 7, "#2196F3"),
+  numberParam("update_interval", "Update Interval (s)", 5, 3600, "30", "", "min='5' max='3600'"),
+};
+static ParamBlock<schemaSize(kParamSchema), schemaValueBytes(kParamSchema)> customParams(kParamSchema);
 
 // Preferences for persistent storage
 Preferences preferences;
@@ -27,37 +31,24 @@ void saveConfigCallback() {
   Serial.println("Configuration saved.");
   
   // Save custom parameters to persistent storage
-  if (customMqttServer && customMqttPort && customDeviceName && customThemeColor && customUpdateInterval) {
-    Serial.println("Saving custom parameters to preferences...");
-    
-    // Open preferences with namespace "modernwifi"
-    preferences.begin("modernwifi", false);
-    
-    // Save all parameters
-    preferences.putString("mqtt_server", customMqttServer->getValue());
-    preferences.putString("mqtt_port", customMqttPort->getValue());
-    preferences.putString("device_name", customDeviceName->getValue());
-    preferences.putString("theme_color", customThemeColor->getValue());
-    preferences.putString("update_interval", customUpdateInterval->getValue());
-    
-    // Close preferences
-    preferences.end();
-    
-    Serial.println("Parameters saved successfully!");
-    
-    // Log the saved values
-    Serial.println("Custom parameters:");
-    Serial.print("MQTT Server: ");
-    Serial.println(customMqttServer->getValue());
-    Serial.print("MQTT Port: ");
-    Serial.println(customMqttPort->getValue());
-    Serial.print("Device Name: ");
-    Serial.println(customDeviceName->getValue());
-    Serial.print("Theme Color: ");
-    Serial.println(customThemeColor->getValue());
-    Serial.print("Update Interval: ");
-    Serial.println(customUpdateInterval->getValue());
+  Serial.println("Saving custom parameters to preferences...");
+  
+  // Open preferences with namespace "modernwifi"
+  preferences.begin("modernwifi", false);
+  
+  // Save all parameters, keyed by id, and log the saved values
+  Serial.println("Custom parameters:");
+  for (size_t i = 0; i < customParams.size(); i++) {
+    preferences.putString(customParams[i]->getID(), customParams[i]->getValue());
+    Serial.print(customParams[i]->getLabel());
+    Serial.print(": ");
+    Serial.println(customParams[i]->getValue());
   }
+  
+  // Close preferences
+  preferences.end();
+  
+  Serial.println("Parameters saved successfully!");
 }
 
 // Callback: Called when the configuration portal times out
@@ -118,28 +109,18 @@ void setup() {
   // Initialize the WiFiManager
   wifiManager.begin();
 
-  // Load saved values from preferences
-  String savedMqttServer = preferences.getString("mqtt_server", "mqtt.example.com");
-  String savedMqttPort = preferences.getString("mqtt_port", "1883");
-  String savedDeviceName = preferences.getString("device_name", "esp32-device");
-  String savedThemeColor = preferences.getString("theme_color", "#2196F3");
-  String savedUpdateInterval = preferences.getString("update_interval", "30");
+  // Load saved values from preferences (schema defaults otherwise); values
+  // outside the schema's limits are ignored
+  for (size_t i = 0; i < customParams.size(); i++) {
+    const ParamSpec& spec = customParams[i]->getSpec();
+    customParams[i]->setValue(preferences.getString(spec.id, spec.defaultValue).c_str());
+  }
   
   // Close preferences in read-only mode
   preferences.end();
 
-  // Add custom parameters with saved values
-  customMqttServer = new WiFiManagerParameter("mqtt_server", "MQTT Server", savedMqttServer.c_str(), 40);
-  customMqttPort = new WiFiManagerParameter("mqtt_port", "MQTT Port", savedMqttPort.c_str(), 6);
-  customDeviceName = new WiFiManagerParameter("device_name", "Device Name", savedDeviceName.c_str(), 20);
-  customThemeColor = new WiFiManagerParameter("theme_color", "Theme Color", savedThemeColor.c_str(), 10, "type='color'");
-  customUpdateInterval = new WiFiManagerParameter("update_interval", "Update Interval (s)", savedUpdateInterval.c_str(), 5, "type='number' min='5' max='3600'");
-  
-  wifiManager.addParameter(customMqttServer);
-  wifiManager.addParameter(customMqttPort);
-  wifiManager.addParameter(customDeviceName);
-  wifiManager.addParameter(customThemeColor);
-  wifiManager.addParameter(customUpdateInterval);
+  // Register the custom parameters with their saved values
+  wifiManager.addParameters(customParams);
 
   // Set a static AP IP if desired
   wifiManager.setAPStaticIPConfig(IPAddress(192,168,4,1), IPAddress(192,168,4,1), IPAddress(255,255,255,0));
@@ -189,30 +170,6 @@ void setup() {
   }
 }
 
-// Clean up WiFiManagerParameter objects to prevent memory leaks
-void cleanupParameters() {
-  if (customMqttServer) {
-    delete customMqttServer;
-    customMqttServer = nullptr;
-  }
-  if (customMqttPort) {
-    delete customMqttPort;
-    customMqttPort = nullptr;
-  }
-  if (customDeviceName) {
-    delete customDeviceName;
-    customDeviceName = nullptr;
-  }
-  if (customThemeColor) {
-    delete customThemeColor;
-    customThemeColor = nullptr;
-  }
-  if (customUpdateInterval) {
-    delete customUpdateInterval;
-    customUpdateInterval = nullptr;
-  }
-}
-
 void loop() {
   // Process incoming HTTP and DNS requests (for the captive portal, JSON API, etc.)
   wifiManager.loop();
@@ -258,8 +215,3 @@ void loop() {
   // Small delay to prevent watchdog issues
   delay(10);
 }
-
-// Call this function when the program ends or during deep sleep
-void onShutdown() {
-  cleanupParameters();
-}
@@ -0,0 +1,66 @@
+#include <Arduino.h>
+#include <NativeSim.h>
+#include "WiFiManager.h"
+
+// Host-native entry point ([env:native]). Runs the full WiFiManager against the
+// simulated radio so handlers can be profiled and load-tested with ordinary
+// Linux tools. Configuration comes from the environment:
+//   WM_HTTP_PORT   HTTP port (default 8080, 0 = ephemeral)
+//   WM_FS_ROOT     directory backing SPIFFS (default ./data)
+//   WM_DNS_PORT    captive DNS port (default 53)
+//   WM_PORTAL_TIMEOUT  config portal timeout in ms (default 1 hour)
+//   WM_SSID/WM_PASS  credentials "stored in NVS" at boot (optional)
+
+WiFiManagerConfig config;
+WiFiManager* wifiManager = nullptr;
+
+static constexpr ParamSpec kParamSchema[] = {
+  textParam("mqtt_server", "MQTT Server", 40, "mqtt.example.com"),
+  numberParam("mqtt_port", "MQTT Port", 1, 65535, "1883"),
+  textParam("device_name", "Device Name", 20, "esp32-device"),
+};
+static ParamBlock<schemaSize(kParamSchema), schemaValueBytes(kParamSchema)> customParams(kParamSchema);
+
+static const char* envOr(const char* name, const char* fallback) {
+  const char* value = getenv(name);
+  return value && *value ? value : fallback;
+}
+
+void setup() {
+  Serial.begin(115200);
+  Serial.println("\n\n--- ModernWifi Starting (native) ---");
+
+  // A small neighbourhood of access points to scan and join.
+  NativeSim::addAccessPoint("HomeNetwork", "password123", 6, -48);
+  NativeSim::addAccessPoint("HomeNetwork", "password123", 11, -71);
+  NativeSim::addAccessPoint("Office-5G", "officepass", 1, -63);
+  NativeSim::addAccessPoint("CoffeeShop", "", 3, -80);
+  NativeSim::addAccessPoint("Neighbour", "secret", 9, -86);
+  if (getenv("WM_SSID")) NativeSim::setStoredCredentials(getenv("WM_SSID"), envOr("WM_PASS", ""));
+
+  WiFi.mode(WIFI_STA);
+  if (getenv("WM_SSID")) WiFi.begin();
+
+  config.connectTimeout = 15000;
+  config.configPortalTimeout = strtoul(envOr("WM_PORTAL_TIMEOUT", "3600000"), nullptr, 10);
+  config.httpPort = static_cast<uint16_t>(atoi(envOr("WM_HTTP_PORT", "8080")));
+  config.autoReconnect = true;
+
+  wifiManager = new WiFiManager(config);
+  wifiManager->setDebugOutput(true, Serial);
+  wifiManager->begin();
+  wifiManager->setAPStaticIPConfig(IPAddress(192, 168, 4, 1), IPAddress(192, 168, 4, 1), IPAddress(255, 255, 255, 0));
+  wifiManager->addParameters(customParams);
+
+  if (wifiManager->autoConnect("modernwifi-native", "modernwifi")) {
+    Serial.print("Connected, IP: ");
+    Serial.println(WiFi.localIP());
+  }
+  Serial.print("HTTP server listening on port ");
+  Serial.println(NativeSim::lastBoundHttpPort());
+}
+
+void loop() {
+  wifiManager->loop();
+  delay(1);
+}
@@ -0,0 +1,271 @@
+#include <Arduino.h>
+#include <unity.h>
+#include <NativeSim.h>
+#include <NativeSimClient.h>
+#include <poll.h>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "WiFiManager.h"
+
+// Admission control for the heavy routes: downloads that are never read hold
+// their transfer places, so the next heavy requests queue, are refused with
+// 503 or 429 and a Retry-After, start in order when a place frees up, or time
+// out in the queue once the server task next runs; refusals are counted in
+// /metrics and light requests are served throughout.
+
+WiFiManagerConfig config;
+WiFiManager* wifiManager = nullptr;
+uint16_t port = 0;
+std::string fsRoot;
+
+// Every address in 127/8 is local: one per simulated client. A slow reader
+// gets a small receive buffer, so an unread download fills it.
+static int openSocket(const char* from, bool slowReader = false) {
+    return NativeSim::openSocket(port, from, slowReader ? 4096 : 0);
+}
+
+// Sends a GET and leaves the reply unread.
+static int start(const std::string& path, const char* from = "127.0.0.2", bool slowReader = false) {
+    int fd = openSocket(from, slowReader);
+    std::string req = "GET " + path + " HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n";
+    send(fd, req.data(), req.size(), 0);
+    return fd;
+}
+
+typedef NativeSim::HttpReply Reply;
+
+// Reads the status line and headers, waiting up to `timeoutMs`; -1 if none came.
+static Reply finish(int fd, int timeoutMs = 2000) {
+    std::string raw;
+    char buf[4096];
+    pollfd p{fd, POLLIN, 0};
+    while (raw.find("\r\n\r\n") == std::string::npos && poll(&p, 1, timeoutMs) > 0) {
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        if (n <= 0) break;
+        raw.append(buf, n);
+    }
+    close(fd);
+    return NativeSim::parseReply(raw);
+}
+
+static bool answered(int fd) {
+    pollfd p{fd, POLLIN, 0};
+    return poll(&p, 1, 100) > 0;
+}
+
+static RequestClassStats transfers() {
+    return wifiManager->getSchedulerStats().classes[static_cast<uint8_t>(RequestClass::TRANSFER) - 1];
+}
+
+// The server thread admits asynchronously; wait until it has.
+static void waitFor(uint8_t running, uint8_t queued) {
+    for (int i = 0; i < 200; i++) {
+        RequestClassStats t = transfers();
+        if (t.running == running && t.queued == queued) return;
+        usleep(10000);
+    }
+    TEST_ASSERT_EQUAL_UINT8(running, transfers().running);
+    TEST_ASSERT_EQUAL_UINT8(queued, transfers().queued);
+}
+
+static std::vector<int> holdTransfers(int count) {
+    std::vector<int> held;
+    for (int i = 0; i < count; i++) {
+        held.push_back(start("/fs/download?path=/big.bin", "127.0.0.2", true));
+        waitFor(i + 1, 0);
+    }
+    return held;
+}
+
+static void drop(std::vector<int>& fds) {
+    for (int fd : fds) close(fd);
+    fds.clear();
+}
+
+void setUp(void) {}
+
+void tearDown(void) {
+    waitFor(0, 0);
+}
+
+void test_classify() {
+    TEST_ASSERT_TRUE(RequestScheduler::classify("/scan") == RequestClass::SCAN);
+    TEST_ASSERT_TRUE(RequestScheduler::classify("/connect") == RequestClass::CONNECT);
+    TEST_ASSERT_TRUE(RequestScheduler::classify("/fs/download") == RequestClass::TRANSFER);
+    TEST_ASSERT_TRUE(RequestScheduler::classify("/restore") == RequestClass::TRANSFER);
+    TEST_ASSERT_TRUE(RequestScheduler::classify("/ota") == RequestClass::OTA);
+    TEST_ASSERT_TRUE(RequestScheduler::classify("/status_json") == RequestClass::LIGHT);
+    TEST_ASSERT_TRUE(RequestScheduler::classify("/scan/extra") == RequestClass::LIGHT);
+}
+
+void test_queued_request_runs_when_a_place_frees() {
+    RequestClassStats before = transfers();
+    std::vector<int> held = holdTransfers(2);
+    int queued = start("/backup");
+    waitFor(2, 1);
+    TEST_ASSERT_FALSE(answered(queued));
+
+    // Light requests go first while the heavy ones are held back.
+    Reply status = finish(start("/status_json", "127.0.0.3"));
+    TEST_ASSERT_EQUAL(200, status.status);
+
+    close(held.back());
+    held.pop_back();
+    Reply backup = finish(queued);
+    TEST_ASSERT_EQUAL(200, backup.status);
+    drop(held);
+    waitFor(0, 0);
+
+    RequestClassStats after = transfers();
+    TEST_ASSERT_EQUAL_UINT32(before.admitted + 3, after.admitted);
+    TEST_ASSERT_EQUAL_UINT32(before.deferred + 1, after.deferred);
+    TEST_ASSERT_TRUE(after.maxQueued >= 1);
+}
+
+void test_full_queue_refuses_with_retry_after() {
+    RequestClassStats before = transfers();
+    std::vector<int> held = holdTransfers(2);
+    std::vector<int> queued;
+    queued.push_back(start("/backup"));
+    queued.push_back(start("/backup"));
+    waitFor(2, 2);
+
+    // A client that already holds a place is throttled, anyone else is busy.
+    Reply again = finish(start("/backup", "127.0.0.2"));
+    TEST_ASSERT_EQUAL(429, again.status);
+    TEST_ASSERT_TRUE(atoi(again.header("Retry-After").c_str()) >= 1);
+    Reply other = finish(start("/fs/download?path=/big.bin", "127.0.0.3"));
+    TEST_ASSERT_EQUAL(503, other.status);
+    TEST_ASSERT_TRUE(atoi(other.header("Retry-After").c_str()) >= 1);
+    TEST_ASSERT_EQUAL(200, finish(start("/device_info", "127.0.0.3")).status);
+
+    drop(held);
+    for (int fd : queued) TEST_ASSERT_EQUAL(200, finish(fd).status);
+    waitFor(0, 0);
+    RequestClassStats after = transfers();
+    TEST_ASSERT_EQUAL_UINT32(before.throttled + 1, after.throttled);
+    TEST_ASSERT_EQUAL_UINT32(before.busy + 1, after.busy);
+}
+
+void test_retry_after_follows_hold_time() {
+    // Hold both places for 4 s of virtual time: the smoothed hold time rises.
+    uint32_t before = transfers().holdMillis;
+    std::vector<int> held = holdTransfers(2);
+    NativeSim::advanceMillis(4000);
+    drop(held);
+    waitFor(0, 0);
+    uint32_t hold = transfers().holdMillis;
+    TEST_ASSERT_TRUE(hold > before + 1000);
+
+    held = holdTransfers(2);
+    std::vector<int> queued;
+    queued.push_back(start("/backup"));
+    queued.push_back(start("/backup"));
+    waitFor(2, 2);
+    // Four ahead plus itself, two at a time.
+    Reply refused = finish(start("/backup", "127.0.0.3"));
+    TEST_ASSERT_EQUAL(503, refused.status);
+    int retryAfter = atoi(refused.header("Retry-After").c_str());
+    TEST_ASSERT_EQUAL((hold * 5 / 2 + 999) / 1000, retryAfter);
+    drop(held);
+    for (int fd : queued) finish(fd);
+
+    char line[80];
+    snprintf(line, sizeof(line), "hold %u ms -> Retry-After %d s", static_cast<unsigned>(hold), retryAfter);
+    TEST_MESSAGE(line);
+}
+
+// A counter from /metrics for one route.
+static uint32_t routeCounter(const char* metric, const char* route) {
+    std::string body;
+    NativeSim::serveInProcess(port, "GET", "/metrics", &body);
+    std::string key = std::string(metric) + "{route=\"" + route + "\"} ";
+    size_t at = body.find(key);
+    return at == std::string::npos ? 0 : strtoul(body.c_str() + at + key.size(), nullptr, 10);
+}
+
+void test_queue_timeout() {
+    RequestClassStats before = transfers();
+    uint32_t errors = routeCounter("wm_http_errors_total", "/backup");
+    std::vector<int> held = holdTransfers(2);
+    int queued = start("/backup");
+    waitFor(2, 1);
+    NativeSim::advanceMillis(config.heavyQueueTimeout + 1);
+    // loop() never answers requests; the next one on the server task does.
+    wifiManager->loop();
+    TEST_ASSERT_FALSE(answered(queued));
+    TEST_ASSERT_EQUAL(200, finish(start("/status_json", "127.0.0.3")).status);
+    Reply expired = finish(queued);
+    TEST_ASSERT_EQUAL(503, expired.status);
+    TEST_ASSERT_EQUAL(before.expired + 1, transfers().expired);
+    // Refusals are counted with the route's errors like any other response.
+    TEST_ASSERT_EQUAL_UINT32(errors + 1, routeCounter("wm_http_errors_total", "/backup"));
+
+    // A finishing transfer starts the oldest waiter and expires the rest.
+    std::vector<int> waiting;
+    waiting.push_back(start("/backup"));
+    waitFor(2, 1);
+    waiting.push_back(start("/backup"));
+    waitFor(2, 2);
+    NativeSim::advanceMillis(config.heavyQueueTimeout + 1);
+    close(held.back());
+    held.pop_back();
+    TEST_ASSERT_EQUAL(200, finish(waiting[0]).status);
+    TEST_ASSERT_EQUAL(503, finish(waiting[1]).status);
+    TEST_ASSERT_EQUAL(before.expired + 2, transfers().expired);
+    drop(held);
+}
+
+void test_metrics_and_device_info() {
+    std::vector<int> held = holdTransfers(1);
+    std::string raw = NativeSim::receiveAll(start("/metrics", "127.0.0.3"));
+    TEST_ASSERT_TRUE(raw.find("wm_http_running{class=\"transfer\"} 1\n") != std::string::npos);
+    TEST_ASSERT_TRUE(raw.find("wm_http_queue_depth{class=\"scan\"} 0\n") != std::string::npos);
+    TEST_ASSERT_TRUE(raw.find("wm_http_rejected_total{class=\"transfer\",code=\"429\"} ") != std::string::npos);
+
+    std::string body;
+    TEST_ASSERT_EQUAL(200, NativeSim::serveInProcess(port, "GET", "/device_info", &body));
+    TEST_ASSERT_TRUE(body.find("\"scheduler\":{\"running\":1,\"limit\":3,") != std::string::npos);
+    TEST_ASSERT_TRUE(body.find("\"transfer\":{\"limit\":2,\"queue_limit\":2,\"running\":1,") != std::string::npos);
+    drop(held);
+}
+
+void test_class_limits() {
+    // No queue for transfers: the next one is refused at once.
+    wifiManager->setRequestClassLimits(RequestClass::TRANSFER, 1, 0);
+    std::vector<int> held = holdTransfers(1);
+    uint32_t requests = routeCounter("wm_http_requests_total", "/backup");
+    TEST_ASSERT_EQUAL(503, finish(start("/backup", "127.0.0.3")).status);
+    TEST_ASSERT_EQUAL_UINT32(requests + 1, routeCounter("wm_http_requests_total", "/backup"));
+    drop(held);
+    wifiManager->setRequestClassLimits(RequestClass::TRANSFER, 2, 2);
+}
+
+int main(int argc, char** argv) {
+    char dir[] = "/tmp/wm-admission-XXXXXX";
+    fsRoot = mkdtemp(dir);
+    std::string big(2 * 1024 * 1024, 'x');
+    std::ofstream(fsRoot + "/big.bin", std::ios::binary) << big;
+    NativeSim::setFilesystemRoot(fsRoot.c_str());
+    NativeSim::setClockMode(NativeSim::ClockMode::Virtual);
+
+    config.httpPort = 0;
+    wifiManager = new WiFiManager(config);
+    wifiManager->setDebugOutput(false);
+    wifiManager->begin();
+    port = NativeSim::lastBoundHttpPort();
+
+    UNITY_BEGIN();
+    RUN_TEST(test_classify);
+    RUN_TEST(test_queued_request_runs_when_a_place_frees);
+    RUN_TEST(test_full_queue_refuses_with_retry_after);
+    RUN_TEST(test_retry_after_follows_hold_time);
+    RUN_TEST(test_queue_timeout);
+    RUN_TEST(test_metrics_and_device_info);
+    RUN_TEST(test_class_limits);
+    int result = UNITY_END();
+    std::string cleanup = "rm -rf " + fsRoot;
+    system(cleanup.c_str());
+    return result;
+}
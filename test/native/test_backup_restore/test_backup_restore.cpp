@@ -0,0 +1,310 @@
+#include <Arduino.h>
+#include <unity.h>
+#include <NativeSim.h>
+#include <NativeSimClient.h>
+#include <string>
+#include <vector>
+#include "WiFiManager.h"
+
+// Binary backup/restore: the codec round-trips through arbitrary chunking,
+// rejects corrupt or truncated input, skips unknown records, reads the JSON
+// form too, a restore over HTTP applies every field or none, and a backup
+// drained slowly still encodes the values from when it was requested.
+
+WiFiManagerConfig sourceConfig;
+WiFiManagerConfig targetConfig;
+WiFiManager* source = nullptr;
+WiFiManager* target = nullptr;
+uint16_t sourcePort = 0;
+uint16_t targetPort = 0;
+WiFiManagerParameter* targetPortParam = nullptr;
+int targetSaves = 0;
+
+static const char* const kParamIds[] = {"mqtt", "port", "topic"};
+static const size_t kBulkParams = 240;
+
+static std::vector<BackupRecord> sampleRecords() {
+    return {
+        {BackupRecord::CREDENTIAL, "HomeNetwork", "password123", 0},
+        {BackupRecord::CREDENTIAL, "Workshop", "", -7},
+        {BackupRecord::PARAMETER, "mqtt", "broker.local", 0},
+        {BackupRecord::PARAMETER, "topic", String(std::string(700, 't').c_str()), 0},
+    };
+}
+
+static std::string encode(const std::vector<BackupRecord>& records, size_t chunk = 64) {
+    BackupEncoder encoder([&records](size_t index, BackupRecord& record) {
+        if (index >= records.size()) return false;
+        record = records[index];
+        return true;
+    });
+    std::string out;
+    uint8_t buf[256];
+    size_t n;
+    while ((n = encoder.read(buf, chunk)) > 0) out.append(reinterpret_cast<char*>(buf), n);
+    return out;
+}
+
+static bool decode(BackupDecoder& decoder, const std::string& data, size_t chunk) {
+    decoder.reset();
+    for (size_t pos = 0; pos < data.size(); pos += chunk) {
+        size_t n = std::min(chunk, data.size() - pos);
+        if (!decoder.write(reinterpret_cast<const uint8_t*>(data.data() + pos), n)) return false;
+    }
+    return decoder.finish();
+}
+
+typedef NativeSim::HttpReply Reply;
+
+static Reply request(uint16_t port, const std::string& req) {
+    return NativeSim::httpRequest(port, req);
+}
+
+static Reply restore(const std::string& body) {
+    return request(targetPort, "POST /restore HTTP/1.1\r\nHost: localhost\r\nContent-Type: application/octet-stream\r\n"
+                               "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body);
+}
+
+static std::string targetJson() {
+    return request(targetPort, "GET /backup HTTP/1.1\r\nHost: localhost\r\n\r\n").body;
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_round_trip_any_chunking() {
+    std::vector<BackupRecord> records = sampleRecords();
+    std::string doc = encode(records, 7);
+    TEST_ASSERT_TRUE(doc.compare(0, 5, "WMBK\x01") == 0);
+    TEST_ASSERT_TRUE(doc == encode(records, 256));
+
+    const size_t chunks[] = {1, 3, 7, 64, doc.size()};
+    for (size_t chunk : chunks) {
+        BackupDecoder decoder;
+        TEST_ASSERT_TRUE_MESSAGE(decode(decoder, doc, chunk), decoder.error());
+        TEST_ASSERT_EQUAL(records.size(), decoder.records().size());
+        for (size_t i = 0; i < records.size(); i++) {
+            const BackupRecord& got = decoder.records()[i];
+            TEST_ASSERT_EQUAL(records[i].type, got.type);
+            TEST_ASSERT_EQUAL_STRING(records[i].key.c_str(), got.key.c_str());
+            TEST_ASSERT_EQUAL_STRING(records[i].value.c_str(), got.value.c_str());
+            TEST_ASSERT_EQUAL(records[i].priority, got.priority);
+        }
+    }
+}
+
+void test_rejects_bad_input() {
+    std::string doc = encode(sampleRecords());
+    BackupDecoder decoder;
+
+    // Any flipped byte ahead of the end record fails the CRC or the framing.
+    for (size_t i = 5; i < doc.size() - 6; i += 37) {
+        std::string bad = doc;
+        bad[i] ^= 0x20;
+        TEST_ASSERT_FALSE(decode(decoder, bad, 16));
+        TEST_ASSERT_EQUAL(0, decoder.records().size());
+    }
+    std::string badCrc = doc;
+    badCrc[doc.size() - 1] ^= 1;
+    TEST_ASSERT_FALSE(decode(decoder, badCrc, 16));
+    TEST_ASSERT_EQUAL_STRING("CRC mismatch", decoder.error());
+
+    TEST_ASSERT_FALSE(decode(decoder, doc.substr(0, doc.size() - 3), 16));
+    TEST_ASSERT_EQUAL_STRING("Truncated backup", decoder.error());
+    TEST_ASSERT_FALSE(decode(decoder, doc + "x", 16));
+    TEST_ASSERT_EQUAL_STRING("Data after end of backup", decoder.error());
+    TEST_ASSERT_FALSE(decode(decoder, "<html></html>", 16));
+    TEST_ASSERT_EQUAL_STRING("Not a backup", decoder.error());
+    TEST_ASSERT_FALSE(decode(decoder, std::string("WMBK\x02", 5), 16));
+    TEST_ASSERT_EQUAL_STRING("Unsupported backup version", decoder.error());
+}
+
+void test_skips_unknown_records() {
+    // A record from a later version between the two known ones, CRC redone.
+    std::string doc = encode({{BackupRecord::PARAMETER, "mqtt", "a", 0}});
+    std::string body = doc.substr(0, doc.size() - 6);
+    body += std::string("\x10\x03xyz", 5);
+    std::string tail = encode({{BackupRecord::PARAMETER, "port", "1", 0}});
+    body += tail.substr(5, tail.size() - 11);
+    uint32_t crc = backupCrc32(0, reinterpret_cast<const uint8_t*>(body.data()), body.size());
+    body += std::string("\xff\x04", 2);
+    for (int i = 0; i < 4; i++) body += static_cast<char>(crc >> (8 * i));
+
+    BackupDecoder decoder;
+    TEST_ASSERT_TRUE_MESSAGE(decode(decoder, body, 5), decoder.error());
+    TEST_ASSERT_EQUAL(2, decoder.records().size());
+    TEST_ASSERT_EQUAL_STRING("port", decoder.records()[1].key.c_str());
+}
+
+void test_decodes_json_form() {
+    // Escapes, members and keys the decoder does not use, any chunking.
+    const std::string doc =
+        " {\"version\":2,\"wifi_credentials\":[{\"ssid\":\"Caf\\u00e9 \\\"5G\\\"\",\"password\":\"p\\/w\",\"priority\":-3,"
+        "\"hidden\":[true,{\"x\":null}]}],\"parameters\":[{\"id\":\"mqtt\",\"label\":\"MQTT\",\"value\":\"\\ud83d\\ude00\","
+        "\"group\":\"Network\"},{\"value\":\"1\",\"id\":\"port\"}]}\n";
+    const size_t chunks[] = {1, 5, doc.size()};
+    for (size_t chunk : chunks) {
+        BackupDecoder decoder;
+        TEST_ASSERT_TRUE_MESSAGE(decode(decoder, doc, chunk), decoder.error());
+        TEST_ASSERT_EQUAL(3, decoder.records().size());
+        const BackupRecord& cred = decoder.records()[0];
+        TEST_ASSERT_EQUAL(BackupRecord::CREDENTIAL, cred.type);
+        TEST_ASSERT_EQUAL_STRING("Caf\xc3\xa9 \"5G\"", cred.key.c_str());
+        TEST_ASSERT_EQUAL_STRING("p/w", cred.value.c_str());
+        TEST_ASSERT_EQUAL(-3, cred.priority);
+        TEST_ASSERT_EQUAL_STRING("\xf0\x9f\x98\x80", decoder.records()[1].value.c_str());
+        TEST_ASSERT_EQUAL_STRING("port", decoder.records()[2].key.c_str());
+    }
+
+    BackupDecoder decoder;
+    TEST_ASSERT_FALSE(decode(decoder, doc.substr(0, doc.size() - 3), 16));
+    TEST_ASSERT_EQUAL_STRING("Truncated backup", decoder.error());
+    TEST_ASSERT_FALSE(decode(decoder, doc + "{}", 16));
+    TEST_ASSERT_EQUAL_STRING("Data after end of backup", decoder.error());
+    TEST_ASSERT_FALSE(decode(decoder, "{\"parameters\":[{\"id\":\"a\",}]}", 16));
+    TEST_ASSERT_EQUAL_STRING("Malformed JSON", decoder.error());
+    TEST_ASSERT_FALSE(decode(decoder, "{\"parameters\":[{\"value\":\"1\"}]}", 16));
+    TEST_ASSERT_EQUAL_STRING("Malformed record", decoder.error());
+    TEST_ASSERT_FALSE(decode(decoder, "{\"wifi_credentials\":[{\"ssid\":\"a\",\"priority\":1.5}]}", 16));
+    TEST_ASSERT_EQUAL_STRING("Malformed record", decoder.error());
+    TEST_ASSERT_EQUAL(0, decoder.records().size());
+}
+
+void test_json_backup_restores_over_http() {
+    Reply backup = request(sourcePort, "GET /backup HTTP/1.1\r\nHost: localhost\r\n\r\n");
+    TEST_ASSERT_EQUAL(200, backup.status);
+    TEST_ASSERT_TRUE(backup.body.find("\"ssid\":\"Workshop\",\"password\":\"tools\",\"priority\":10}") != std::string::npos);
+
+    int saves = targetSaves;
+    Reply applied = request(targetPort, "POST /restore HTTP/1.1\r\nHost: localhost\r\nContent-Type: application/json\r\n"
+                                        "Content-Length: " + std::to_string(backup.body.size()) + "\r\n\r\n" + backup.body);
+    TEST_ASSERT_EQUAL(200, applied.status);
+    TEST_ASSERT_EQUAL_STRING("{\"result\":\"ok\",\"credentials\":2,\"parameters\":3}", applied.body.c_str());
+    TEST_ASSERT_EQUAL(saves + 1, targetSaves);
+    std::string json = targetJson();
+    TEST_ASSERT_TRUE(json.find("\"ssid\":\"Workshop\",\"password\":\"tools\",\"priority\":10}") != std::string::npos);
+    TEST_ASSERT_TRUE(json.find("\"ssid\":\"Stale\"") == std::string::npos);
+}
+
+void test_backup_then_restore_over_http() {
+    Reply backup = request(sourcePort, "GET /backup?format=bin HTTP/1.1\r\nHost: localhost\r\n\r\n");
+    TEST_ASSERT_EQUAL(200, backup.status);
+    TEST_ASSERT_TRUE(backup.head.find("application/octet-stream") != std::string::npos);
+    TEST_ASSERT_TRUE(backup.head.find("attachment") != std::string::npos);
+
+    Reply applied = restore(backup.body);
+    TEST_ASSERT_EQUAL(200, applied.status);
+    TEST_ASSERT_EQUAL_STRING("{\"result\":\"ok\",\"credentials\":2,\"parameters\":3}", applied.body.c_str());
+    TEST_ASSERT_EQUAL(1, targetSaves);
+
+    std::string json = targetJson();
+    TEST_ASSERT_TRUE(json.find("\"ssid\":\"HomeNetwork\",\"password\":\"password123\"") != std::string::npos);
+    TEST_ASSERT_TRUE(json.find("\"ssid\":\"Workshop\"") != std::string::npos);
+    TEST_ASSERT_TRUE(json.find("\"ssid\":\"Stale\"") == std::string::npos);
+    TEST_ASSERT_EQUAL_STRING("8883", targetPortParam->getValue());
+
+    char line[120];
+    snprintf(line, sizeof(line), "binary backup %u B vs JSON backup %u B",
+             static_cast<unsigned>(backup.body.size()),
+             static_cast<unsigned>(request(sourcePort, "GET /backup HTTP/1.1\r\nHost: localhost\r\n\r\n").body.size()));
+    TEST_MESSAGE(line);
+}
+
+void test_restore_is_all_or_nothing() {
+    std::string before = targetJson();
+    int saves = targetSaves;
+
+    // The credential and first parameter are fine; the port value is not.
+    Reply invalid = restore(encode({{BackupRecord::CREDENTIAL, "Other", "secret", 0},
+                                    {BackupRecord::PARAMETER, "mqtt", "other.local", 0},
+                                    {BackupRecord::PARAMETER, "port", "not-a-port", 0}}));
+    TEST_ASSERT_EQUAL(400, invalid.status);
+    TEST_ASSERT_EQUAL_STRING("{\"error\":\"Invalid parameter value\"}", invalid.body.c_str());
+
+    Reply unknown = restore(encode({{BackupRecord::PARAMETER, "nope", "x", 0}}));
+    TEST_ASSERT_EQUAL(400, unknown.status);
+    TEST_ASSERT_EQUAL_STRING("{\"error\":\"Unknown parameter\"}", unknown.body.c_str());
+
+    std::string corrupt = encode({{BackupRecord::PARAMETER, "mqtt", "other.local", 0}});
+    corrupt[10] ^= 1;
+    Reply crc = restore(corrupt);
+    TEST_ASSERT_EQUAL(400, crc.status);
+
+    Reply empty = request(targetPort, "POST /restore HTTP/1.1\r\nHost: localhost\r\nContent-Length: 0\r\n\r\n");
+    TEST_ASSERT_EQUAL(400, empty.status);
+    TEST_ASSERT_EQUAL_STRING("{\"error\":\"Missing backup data\"}", empty.body.c_str());
+
+    TEST_ASSERT_TRUE(before == targetJson());
+    TEST_ASSERT_EQUAL(saves, targetSaves);
+}
+
+void test_binary_backup_is_one_snapshot() {
+    static char ids[kBulkParams][16];
+    std::string before(60, 'b');
+    for (size_t i = 0; i < kBulkParams; i++) {
+        snprintf(ids[i], sizeof(ids[i]), "bulk_%u", static_cast<unsigned>(i));
+        source->addParameter(new WiFiManagerParameter(ids[i], "Bulk", before.c_str(), 64));
+    }
+    int fd = NativeSim::openSocket(sourcePort, nullptr, 2048);
+    std::string req = "GET /backup?format=bin HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    send(fd, req.data(), req.size(), 0);
+    std::string raw;
+    char buf[512];
+    ssize_t n = recv(fd, buf, sizeof(buf), 0);
+    if (n > 0) raw.append(buf, n);
+    // Changed while most of the records are still unsent.
+    std::string after(60, 'a');
+    for (size_t i = 0; i < kBulkParams; i++) source->getParameter(ids[i])->setValue(after.c_str());
+    while ((n = recv(fd, buf, sizeof(buf), 0)) > 0) raw.append(buf, n);
+    close(fd);
+
+    BackupDecoder decoder;
+    TEST_ASSERT_TRUE_MESSAGE(decode(decoder, NativeSim::parseReply(raw).body, 512), decoder.error());
+    TEST_ASSERT_EQUAL(2 + 3 + kBulkParams, decoder.records().size());
+    for (size_t i = 0; i < kBulkParams; i++)
+        TEST_ASSERT_EQUAL_STRING(before.c_str(), decoder.records()[5 + i].value.c_str());
+}
+
+static WiFiManager* createManager(WiFiManagerConfig& config) {
+    config.httpPort = 0;
+    WiFiManager* wm = new WiFiManager(config);
+    wm->setDebugOutput(false);
+    return wm;
+}
+
+int main(int argc, char** argv) {
+    source = createManager(sourceConfig);
+    source->addWiFiCredential("HomeNetwork", "password123");
+    source->addWiFiCredential("Workshop", "tools", 10);
+    source->addParameter(new WiFiManagerParameter("mqtt", "MQTT Server", "broker.local", 40));
+    source->addParameter(new WiFiManagerParameter("port", "Port", "8883", ParameterType::NUMBER));
+    source->addParameter(new WiFiManagerParameter("topic", "Topic", "home/sensors", 64));
+    source->begin();
+    sourcePort = NativeSim::lastBoundHttpPort();
+
+    target = createManager(targetConfig);
+    target->addWiFiCredential("Stale", "old");
+    for (const char* id : kParamIds) {
+        auto* param = new WiFiManagerParameter(id, id, "1883", 64);
+        if (strcmp(id, "port") == 0) {
+            param->setValidation([](const char* value) { return *value && strspn(value, "0123456789") == strlen(value); });
+            targetPortParam = param;
+        }
+        target->addParameter(param);
+    }
+    target->setSaveConfigCallback([]() { targetSaves++; });
+    target->begin();
+    targetPort = NativeSim::lastBoundHttpPort();
+
+    UNITY_BEGIN();
+    RUN_TEST(test_round_trip_any_chunking);
+    RUN_TEST(test_rejects_bad_input);
+    RUN_TEST(test_skips_unknown_records);
+    RUN_TEST(test_decodes_json_form);
+    RUN_TEST(test_backup_then_restore_over_http);
+    RUN_TEST(test_restore_is_all_or_nothing);
+    RUN_TEST(test_json_backup_restores_over_http);
+    RUN_TEST(test_binary_backup_is_one_snapshot);
+    return UNITY_END();
+}
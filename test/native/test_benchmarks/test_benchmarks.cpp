@@ -0,0 +1,305 @@
+#include <Arduino.h>
+#include <unity.h>
+#include <NativeSim.h>
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+#include "WiFiManager.h"
+#include "WiFiManagerBackup.h"
+
+// Micro-benchmarks for the request hot paths: JSON handlers at several sizes,
+// parameter validation per type, HTML rendering, backup serialization and the
+// captive-portal DNS reply and probe redirect.
+// Each case reports ns/op and heap allocations per op and is checked against
+// baseline.txt next to this file:
+//
+//   allocations  may not exceed the baseline by more than half an allocation
+//   time         may not exceed baseline * WM_BENCH_TOLERANCE (default 2.5)
+//
+// Handlers run through NativeSim::serveInProcess(), so the numbers are the
+// handler and response streaming alone, without socket or scheduler time.
+// WM_BENCH_UPDATE=1 rewrites the baseline with this run; WM_BENCH_BASELINE
+// overrides its path (default: relative to the project root).
+
+struct Sample {
+    double nsPerOp;
+    double allocsPerOp;
+};
+
+static const char* kDefaultBaseline = "test/native/test_benchmarks/baseline.txt";
+static const double kMinRunNs = 20e6;     // grow the batch until one takes 20 ms
+static const double kTimingSlackNs = 50;  // timer noise on sub-100 ns cases
+
+std::map<std::string, Sample> baseline;
+std::map<std::string, Sample> results;
+std::string regressions;
+double tolerance = 2.5;
+
+char fsRoot[] = "/tmp/wm-bench-XXXXXX";
+WiFiManagerConfig config;
+WiFiManager* managers[3] = {nullptr, nullptr, nullptr};
+uint16_t ports[3] = {0, 0, 0};
+const size_t kParamCounts[3] = {0, 10, 50};
+
+static double nowNs() {
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void loadBaseline(const char* path) {
+    FILE* f = fopen(path, "r");
+    if (!f) return;
+    char line[160];
+    while (fgets(line, sizeof(line), f)) {
+        char name[96];
+        Sample s;
+        if (line[0] == '#') continue;
+        if (sscanf(line, "%95s %lf %lf", name, &s.nsPerOp, &s.allocsPerOp) == 3) baseline[name] = s;
+    }
+    fclose(f);
+}
+
+static void saveBaseline(const char* path) {
+    FILE* f = fopen(path, "w");
+    if (!f) return;
+    fprintf(f, "# name ns_per_op allocs_per_op (WM_BENCH_UPDATE=1 to regenerate)\n");
+    for (const auto& r : results) fprintf(f, "%s %.1f %.1f\n", r.first.c_str(), r.second.nsPerOp, r.second.allocsPerOp);
+    fclose(f);
+}
+
+// Runs `op` in batches sized to take kMinRunNs; the fastest of three batches
+// gives the time, allocations are counted over the same batch.
+template <typename Op>
+static void bench(const std::string& name, Op op) {
+    for (int i = 0; i < 3; i++) op();  // warm caches and lazily built state
+    uint64_t n = 1;
+    for (;;) {
+        double start = nowNs();
+        for (uint64_t i = 0; i < n; i++) op();
+        if (nowNs() - start >= kMinRunNs || n >= (1ull << 24)) break;
+        n *= 2;
+    }
+    Sample best = {1e300, 0};
+    for (int round = 0; round < 3; round++) {
+        NativeSim::HeapStats before = NativeSim::heapStats();
+        double start = nowNs();
+        for (uint64_t i = 0; i < n; i++) op();
+        double ns = (nowNs() - start) / n;
+        double allocs = static_cast<double>(NativeSim::heapStats().allocations - before.allocations) / n;
+        if (ns < best.nsPerOp) best = Sample{ns, allocs};
+    }
+    results[name] = best;
+
+    char line[200];
+    auto base = baseline.find(name);
+    if (base == baseline.end()) {
+        snprintf(line, sizeof(line), "%-28s %10.1f ns/op %7.1f allocs/op   (no baseline)", name.c_str(), best.nsPerOp,
+                 best.allocsPerOp);
+        TEST_MESSAGE(line);
+        return;
+    }
+    const Sample& b = base->second;
+    snprintf(line, sizeof(line), "%-28s %10.1f ns/op %7.1f allocs/op   baseline %10.1f %7.1f", name.c_str(),
+             best.nsPerOp, best.allocsPerOp, b.nsPerOp, b.allocsPerOp);
+    TEST_MESSAGE(line);
+    if (best.allocsPerOp > b.allocsPerOp + 0.5) {
+        regressions += name + ": allocations " + String(best.allocsPerOp, 1).c_str() + " > " +
+                       String(b.allocsPerOp, 1).c_str() + "; ";
+    }
+    if (best.nsPerOp > b.nsPerOp * tolerance + kTimingSlackNs) {
+        regressions += name + ": " + String(best.nsPerOp, 1).c_str() + " ns > " + String(b.nsPerOp, 1).c_str() +
+                       " ns x " + String(tolerance, 1).c_str() + "; ";
+    }
+}
+
+static void serve(uint16_t port, const char* target) {
+    std::string body;
+    int code = NativeSim::serveInProcess(port, "GET", target, &body);
+    if (code != 200 || body.empty()) TEST_FAIL_MESSAGE(target);
+}
+
+static void checkRegressions() {
+    std::string found;
+    found.swap(regressions);
+    if (!found.empty()) TEST_FAIL_MESSAGE(found.c_str());
+}
+
+static void addParams(WiFiManager* manager, size_t count) {
+    static const ParameterType kTypes[] = {ParameterType::TEXT, ParameterType::NUMBER, ParameterType::TOGGLE,
+                                           ParameterType::EMAIL, ParameterType::URL};
+    static const char* kValues[] = {"some-value-1234", "1883", "true", "ops@example.com", "http://broker.local"};
+    static char ids[64][16];
+    for (size_t i = 0; i < count; i++) {
+        snprintf(ids[i], sizeof(ids[i]), "param_%02u", static_cast<unsigned>(i));
+        manager->addParameter(new WiFiManagerParameter(ids[i], "Benchmark Parameter", kValues[i % 5], kTypes[i % 5]));
+    }
+}
+
+static void scanWith(size_t networks) {
+    NativeSim::clearAccessPoints();
+    for (size_t i = 0; i < networks; i++) {
+        char ssid[24];
+        snprintf(ssid, sizeof(ssid), "Network-%02u", static_cast<unsigned>(i));
+        NativeSim::addAccessPoint(ssid, "password123", 1 + i % 13, -40 - static_cast<int32_t>(i));
+    }
+    TEST_ASSERT_TRUE(managers[0]->startScan());
+    while (managers[0]->isScanInProgress()) delay(10);
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_json_handlers() {
+    for (int i = 0; i < 3; i++) {
+        std::string suffix = "/" + std::to_string(kParamCounts[i]) + "_params";
+        bench("status_json" + suffix, [i] { serve(ports[i], "/status_json"); });
+        bench("params_json" + suffix, [i] { serve(ports[i], "/params_json"); });
+    }
+    const size_t networks[2] = {5, 30};
+    for (size_t count : networks) {
+        scanWith(count);
+        bench("scan/" + std::to_string(count) + "_networks", [] { serve(ports[0], "/scan"); });
+    }
+    checkRegressions();
+}
+
+void test_validation_per_type() {
+    struct Case {
+        const char* name;
+        ParameterType type;
+        const char* value;
+    };
+    static const Case kCases[] = {
+        {"TEXT", ParameterType::TEXT, "living room"},
+        {"PASSWORD", ParameterType::PASSWORD, "s3cret-pass"},
+        {"NUMBER", ParameterType::NUMBER, "-1234.5"},
+        {"TOGGLE", ParameterType::TOGGLE, "false"},
+        {"SLIDER", ParameterType::SLIDER, "75"},
+        {"SELECT", ParameterType::SELECT, "b"},
+        {"EMAIL", ParameterType::EMAIL, "ops@example.com"},
+        {"URL", ParameterType::URL, "https://broker.example.com:8883"},
+        {"SEARCH", ParameterType::SEARCH, "sensor"},
+        {"TEL", ParameterType::TEL, "+1 (555) 010-0199"},
+        {"DATE", ParameterType::DATE, "2026-10-17"},
+        {"TIME", ParameterType::TIME, "12:30"},
+        {"DATETIME_LOCAL", ParameterType::DATETIME_LOCAL, "2026-10-17T12:30"},
+        {"MONTH", ParameterType::MONTH, "2026-10"},
+        {"WEEK", ParameterType::WEEK, "2026-W42"},
+        {"COLOR", ParameterType::COLOR, "#12ab9f"},
+        {"FILE", ParameterType::FILE, "firmware.bin"},
+        {"HIDDEN", ParameterType::HIDDEN, "token"},
+        {"TEXTAREA", ParameterType::TEXTAREA, "line one\nline two"},
+    };
+    for (const Case& c : kCases) {
+        WiFiManagerParameter param("bench", "Bench", "", c.type, c.type == ParameterType::SELECT ? "<option>b</option>" : "");
+        TEST_ASSERT_TRUE_MESSAGE(param.accepts(c.value), c.name);
+        bench(std::string("accepts/") + c.name, [&param, &c] {
+            if (!param.accepts(c.value)) TEST_FAIL_MESSAGE(c.name);
+        });
+    }
+    checkRegressions();
+}
+
+void test_html_rendering() {
+    WiFiManagerParameter text("mqtt", "MQTT Server", "broker.local", ParameterType::TEXT, "required", "Network");
+    WiFiManagerParameter select("mode", "Mode", "b", ParameterType::SELECT,
+                                "<option value='a'>A</option><option value='b'>B</option>");
+    WiFiManagerParameter slider("level", "Level", "40", ParameterType::SLIDER, "min='0' max='100'");
+    bench("getHTML/TEXT", [&text] { TEST_ASSERT_TRUE(text.getHTML().length() > 0); });
+    bench("getHTML/SELECT", [&select] { TEST_ASSERT_TRUE(select.getHTML().length() > 0); });
+    bench("getHTML/SLIDER", [&slider] { TEST_ASSERT_TRUE(slider.getHTML().length() > 0); });
+
+    // No index.html on the filesystem: "/" is the built-in page.
+    for (int i = 1; i < 3; i++) {
+        std::string suffix = "/" + std::to_string(kParamCounts[i]) + "_params";
+        bench("root_page_cached" + suffix, [i] { serve(ports[i], "/"); });
+        // A value change invalidates the cached page, so every request renders it.
+        WiFiManagerParameter* first = managers[i]->getParameters()[0];
+        bool flip = false;
+        bench("root_page_cold" + suffix, [i, first, &flip] {
+            first->setValue((flip = !flip) ? "value-a" : "value-b");
+            serve(ports[i], "/");
+        });
+    }
+    checkRegressions();
+}
+
+void test_backup_serialization() {
+    std::vector<BackupRecord> records;
+    for (int i = 0; i < 5; i++) {
+        records.push_back(BackupRecord{BackupRecord::CREDENTIAL, String("Network-") + i, "password123", i});
+    }
+    for (WiFiManagerParameter* param : managers[2]->getParameters()) {
+        records.push_back(BackupRecord{BackupRecord::PARAMETER, param->getID(), param->getValue(), 0});
+    }
+    bench("backup_encode/55_records", [&records] {
+        BackupEncoder encoder([&records](size_t index, BackupRecord& record) {
+            if (index >= records.size()) return false;
+            record = records[index];
+            return true;
+        });
+        uint8_t buf[512];
+        size_t total = 0;
+        size_t n;
+        while ((n = encoder.read(buf, sizeof(buf))) > 0) total += n;
+        if (total == 0) TEST_FAIL_MESSAGE("empty backup");
+    });
+    bench("backup_json/50_params", [] { serve(ports[2], "/backup"); });
+    checkRegressions();
+}
+
+void test_captive_portal() {
+    CaptiveDNS dns;
+    TEST_ASSERT_TRUE(dns.begin(IPAddress(192, 168, 4, 1), 0));
+    // A query for connectivitycheck.gstatic.com A, as Android sends it.
+    const uint8_t query[] = {0x12, 0x34, 0x01, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+                             17, 'c', 'o', 'n', 'n', 'e', 'c', 't', 'i', 'v', 'i', 't', 'y', 'c', 'h', 'e', 'c', 'k',
+                             7, 'g', 's', 't', 'a', 't', 'i', 'c', 3, 'c', 'o', 'm', 0, 0x00, 0x01, 0x00, 0x01};
+    bench("dns_answer/a_query", [&dns, &query] {
+        uint8_t reply[CaptiveDNS::kMaxPacket];
+        if (dns.answer(query, sizeof(query), reply) != sizeof(query) + 16) TEST_FAIL_MESSAGE("no answer");
+    });
+    dns.end();
+    bench("probe_redirect", [] {
+        if (NativeSim::serveInProcess(ports[0], "GET", "/generate_204") != 302) TEST_FAIL_MESSAGE("/generate_204");
+    });
+    checkRegressions();
+}
+
+int main(int argc, char** argv) {
+    const char* path = getenv("WM_BENCH_BASELINE");
+    if (!path) path = kDefaultBaseline;
+    const char* tol = getenv("WM_BENCH_TOLERANCE");
+    if (tol) tolerance = atof(tol);
+    bool update = getenv("WM_BENCH_UPDATE") && atoi(getenv("WM_BENCH_UPDATE"));
+    if (!update) loadBaseline(path);
+
+    if (!mkdtemp(fsRoot)) return 1;
+    NativeSim::setFilesystemRoot(fsRoot);  // empty: no index.html
+    NativeSim::setClockMode(NativeSim::ClockMode::Virtual);  // scan cache never goes stale mid-run
+    NativeSim::setRadioTiming(NativeSim::RadioTiming{1, 13, 1, 1, 1});
+    NativeSim::setFlashTiming(NativeSim::FlashTiming{0, 0});
+    config.httpPort = 0;
+    config.requestArenas = 2;
+    for (int i = 0; i < 3; i++) {
+        managers[i] = new WiFiManager(config);
+        managers[i]->setDebugOutput(false);
+        addParams(managers[i], kParamCounts[i]);
+        managers[i]->begin();
+        ports[i] = NativeSim::lastBoundHttpPort();
+    }
+
+    UNITY_BEGIN();
+    RUN_TEST(test_json_handlers);
+    RUN_TEST(test_validation_per_type);
+    RUN_TEST(test_html_rendering);
+    RUN_TEST(test_backup_serialization);
+    RUN_TEST(test_captive_portal);
+    int result = UNITY_END();
+    if (update) saveBaseline(path);
+    for (WiFiManager* manager : managers) delete manager;
+    std::string cleanup = std::string("rm -rf ") + fsRoot;
+    system(cleanup.c_str());
+    return result;
+}
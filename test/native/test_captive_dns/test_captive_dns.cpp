@@ -0,0 +1,231 @@
+#include <Arduino.h>
+#include <unity.h>
+#include <NativeSim.h>
+#include <NativeSimClient.h>
+#include <arpa/inet.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "WiFiManager.h"
+
+// Captive DNS and OS connectivity probes: replies built by CaptiveDNS, a
+// burst of queries answered while nothing calls loop(), and the probe URLs
+// redirected to the portal.
+
+WiFiManagerConfig config;
+WiFiManager* wifiManager = nullptr;
+uint16_t httpPort = 0;
+uint16_t dnsPort = 0;
+
+static std::string query(uint16_t id, const char* name, uint16_t qtype, bool edns = false) {
+    std::string q;
+    q += static_cast<char>(id >> 8);
+    q += static_cast<char>(id);
+    q += std::string("\x01\x00\x00\x01\x00\x00\x00\x00\x00", 9);  // RD, one question
+    q += static_cast<char>(edns ? 1 : 0);
+    const char* label = name;
+    while (*label) {
+        const char* dot = strchr(label, '.');
+        size_t len = dot ? static_cast<size_t>(dot - label) : strlen(label);
+        q += static_cast<char>(len);
+        q.append(label, len);
+        label += len + (dot ? 1 : 0);
+    }
+    q += '\0';
+    q += static_cast<char>(qtype >> 8);
+    q += static_cast<char>(qtype);
+    q += std::string("\x00\x01", 2);
+    if (edns) q += std::string("\x00\x00\x29\x10\x00\x00\x00\x00\x00\x00\x00", 11);  // OPT, 4096 bytes
+    return q;
+}
+
+static size_t answer(CaptiveDNS& dns, const std::string& q, uint8_t* reply) {
+    return dns.answer(reinterpret_cast<const uint8_t*>(q.data()), q.size(), reply);
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_a_query_resolves_to_portal() {
+    CaptiveDNS dns;
+    TEST_ASSERT_TRUE(dns.begin(IPAddress(192, 168, 4, 1), 0, 300));
+    uint8_t reply[CaptiveDNS::kMaxPacket];
+    std::string q = query(0xBEEF, "connectivitycheck.gstatic.com", 1);
+    size_t len = answer(dns, q, reply);
+    TEST_ASSERT_EQUAL(q.size() + 16, len);
+    TEST_ASSERT_EQUAL_HEX8(0xBE, reply[0]);
+    TEST_ASSERT_EQUAL_HEX8(0xEF, reply[1]);
+    TEST_ASSERT_EQUAL_HEX8(0x85, reply[2]);  // response, authoritative, RD
+    TEST_ASSERT_EQUAL_HEX8(0x80, reply[3]);  // RA, NOERROR
+    TEST_ASSERT_EQUAL(1, reply[5]);
+    TEST_ASSERT_EQUAL(1, reply[7]);
+    TEST_ASSERT_EQUAL_MEMORY(q.data() + 12, reply + 12, q.size() - 12);
+    const uint8_t record[] = {0xC0, 0x0C, 0, 1, 0, 1, 0, 0, 0x01, 0x2C, 0, 4, 192, 168, 4, 1};
+    TEST_ASSERT_EQUAL_MEMORY(record, reply + q.size(), sizeof(record));
+    dns.end();
+}
+
+void test_other_queries() {
+    CaptiveDNS dns;
+    TEST_ASSERT_TRUE(dns.begin(IPAddress(192, 168, 4, 1), 0));
+    uint8_t reply[CaptiveDNS::kMaxPacket];
+
+    // AAAA: empty NOERROR, so the client asks for A.
+    std::string aaaa = query(1, "captive.apple.com", 28);
+    TEST_ASSERT_EQUAL(aaaa.size(), answer(dns, aaaa, reply));
+    TEST_ASSERT_EQUAL(0, reply[7]);
+    TEST_ASSERT_EQUAL(0, reply[3] & 0x0F);
+
+    // EDNS: the OPT record is not echoed.
+    std::string edns = query(2, "www.msftconnecttest.com", 1, true);
+    TEST_ASSERT_EQUAL(edns.size() - 11 + 16, answer(dns, edns, reply));
+    TEST_ASSERT_EQUAL(0, reply[11]);
+
+    // Dropped: truncated, a response, two questions, a compressed name.
+    TEST_ASSERT_EQUAL(0, answer(dns, aaaa.substr(0, 20), reply));
+    std::string response = aaaa;
+    response[2] |= 0x80;
+    TEST_ASSERT_EQUAL(0, answer(dns, response, reply));
+    std::string twice = aaaa;
+    twice[5] = 2;
+    TEST_ASSERT_EQUAL(0, answer(dns, twice, reply));
+    std::string pointer = aaaa;
+    pointer[12] = static_cast<char>(0xC0);
+    TEST_ASSERT_EQUAL(0, answer(dns, pointer, reply));
+
+    CaptiveDNSStats s = dns.stats();
+    TEST_ASSERT_EQUAL_UINT32(1, s.answers);
+    TEST_ASSERT_EQUAL_UINT32(4, s.dropped);
+    dns.end();
+}
+
+void test_burst_answered_without_loop() {
+    // Nothing calls wifiManager->loop() in this test.
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(dnsPort);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+
+    CaptiveDNSStats before = wifiManager->getDNSStats();
+    const int kBurst = 64;
+    const char* names[] = {"connectivitycheck.gstatic.com", "captive.apple.com", "www.msftconnecttest.com",
+                           "detectportal.firefox.com"};
+    std::vector<std::chrono::steady_clock::time_point> sent(kBurst);
+    std::vector<double> latencyMicros;
+    for (int i = 0; i < kBurst; i++) {
+        std::string q = query(static_cast<uint16_t>(i), names[i % 4], 1);
+        sent[i] = std::chrono::steady_clock::now();
+        send(fd, q.data(), q.size(), 0);
+    }
+    const uint8_t portal[] = {192, 168, 4, 1};
+    uint8_t reply[CaptiveDNS::kMaxPacket];
+    pollfd p{fd, POLLIN, 0};
+    while (static_cast<int>(latencyMicros.size()) < kBurst && poll(&p, 1, 1000) > 0) {
+        ssize_t n = recv(fd, reply, sizeof(reply), 0);
+        if (n < 28) break;
+        uint16_t id = (reply[0] << 8) | reply[1];
+        TEST_ASSERT_TRUE(id < kBurst);
+        TEST_ASSERT_EQUAL_MEMORY(portal, reply + n - 4, 4);
+        latencyMicros.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - sent[id]).count());
+    }
+    close(fd);
+    TEST_ASSERT_EQUAL(kBurst, latencyMicros.size());
+    CaptiveDNSStats after = wifiManager->getDNSStats();
+    TEST_ASSERT_EQUAL_UINT32(before.queries + kBurst, after.queries);
+    TEST_ASSERT_EQUAL_UINT32(before.answers + kBurst, after.answers);
+
+    std::sort(latencyMicros.begin(), latencyMicros.end());
+    char line[120];
+    snprintf(line, sizeof(line), "burst of %d queries, no loop(): p50 %.0f us, max %.0f us", kBurst,
+             latencyMicros[kBurst / 2], latencyMicros.back());
+    TEST_MESSAGE(line);
+}
+
+static std::string fetchHead(const char* method, const char* path, const char* host, uint16_t port = 0) {
+    std::string req = std::string(method) + " " + path + " HTTP/1.1\r\nHost: " + host + "\r\nConnection: close\r\n\r\n";
+    return NativeSim::parseReply(NativeSim::exchange(port ? port : httpPort, req)).head;
+}
+
+void test_probes_redirect_to_portal() {
+    const char* probes[][2] = {
+        {"/generate_204", "connectivitycheck.gstatic.com"},
+        {"/hotspot-detect.html", "captive.apple.com"},
+        {"/library/test/success.html", "www.apple.com"},
+        {"/connecttest.txt", "www.msftconnecttest.com"},
+        {"/ncsi.txt", "www.msftncsi.com"},
+        {"/canonical.html", "detectportal.firefox.com"},
+    };
+    for (const auto& probe : probes) {
+        std::string head = fetchHead("GET", probe[0], probe[1]);
+        TEST_ASSERT_EQUAL_STRING_MESSAGE("HTTP/1.1 302", head.substr(0, 12).c_str(), probe[0]);
+        TEST_ASSERT_TRUE_MESSAGE(head.find("\r\nLocation: http://192.168.4.1/\r\n") != std::string::npos, probe[0]);
+        TEST_ASSERT_TRUE(head.find("\r\nCache-Control: no-store\r\n") != std::string::npos);
+    }
+    TEST_ASSERT_EQUAL_STRING("HTTP/1.1 302", fetchHead("HEAD", "/gen_204", "clients3.google.com").substr(0, 12).c_str());
+    // Other unknown paths still end in handleNotFound().
+    TEST_ASSERT_EQUAL(404, NativeSim::serveInProcess(httpPort, "GET", "/generate_205"));
+
+    // A probe costs one small response; time it in-process.
+    const int kRounds = 2000;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kRounds; i++) NativeSim::serveInProcess(httpPort, "GET", "/generate_204");
+    double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / kRounds;
+    char line[80];
+    snprintf(line, sizeof(line), "probe redirect: %.2f us per request in-process", us);
+    TEST_MESSAGE(line);
+}
+
+void test_redirect_names_the_port() {
+    // A free port to run a second portal on.
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+    socklen_t len = sizeof(addr);
+    getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len);
+    close(fd);
+    uint16_t port = ntohs(addr.sin_port);
+
+    WiFiManagerConfig other = config;
+    other.httpPort = port;
+    WiFiManager portal(other);
+    portal.setDebugOutput(false);
+    portal.begin();
+    portal.startConfigPortal("WM-Port");
+    std::string head = fetchHead("GET", "/generate_204", "connectivitycheck.gstatic.com", port);
+    std::string location = "\r\nLocation: http://192.168.4.1:" + std::to_string(port) + "/\r\n";
+    TEST_ASSERT_TRUE_MESSAGE(head.find(location) != std::string::npos, head.c_str());
+}
+
+int main(int argc, char** argv) {
+    setenv("WM_DNS_PORT", "0", 1);
+    NativeSim::setClockMode(NativeSim::ClockMode::Virtual);
+
+    config.httpPort = 0;
+    config.configPortalTimeout = 1000;
+    wifiManager = new WiFiManager(config);
+    wifiManager->setDebugOutput(false);
+    wifiManager->begin();
+    httpPort = NativeSim::lastBoundHttpPort();
+    // Times out on the virtual clock and leaves the AP and its DNS up.
+    wifiManager->startConfigPortal("WM-Test");
+    dnsPort = NativeSim::lastBoundUdpPort();
+
+    UNITY_BEGIN();
+    RUN_TEST(test_a_query_resolves_to_portal);
+    RUN_TEST(test_other_queries);
+    RUN_TEST(test_burst_answered_without_loop);
+    RUN_TEST(test_probes_redirect_to_portal);
+    RUN_TEST(test_redirect_names_the_port);
+    return UNITY_END();
+}
@@ -0,0 +1,144 @@
+#include <Arduino.h>
+#include <unity.h>
+#include <NativeSim.h>
+#include <NativeSimClient.h>
+#include <string>
+#include "WiFiManager.h"
+#include "WiFiManagerAssets.h"
+
+// Portal assets compiled into the firmware: table ordering and lookup,
+// serving straight from the table without SPIFFS, and time spent in begin()
+// with and without the mount (simulated flash timing on the virtual clock).
+
+// gzip -9 of "body{color:red}", "<html><body>embedded</body></html>" and
+// "{\"brand\":\"x\"}"; ETags are CRC-32 and ISIZE from the trailers.
+static const uint8_t kCss[] PROGMEM = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x4b, 0xca, 0x4f, 0xa9, 0xac, 0x4e, 0xce, 0xcf,
+    0xc9, 0x2f, 0xb2, 0x2a, 0x4a, 0x4d, 0xa9, 0x05, 0x00, 0xbd, 0xa4, 0x4c, 0x03, 0x0f, 0x00, 0x00, 0x00};
+static const uint8_t kHtml[] PROGMEM = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0xb3, 0xc9, 0x28, 0xc9, 0xcd, 0xb1,
+    0xb3, 0x49, 0xca, 0x4f, 0xa9, 0xb4, 0x4b, 0xcd, 0x4d, 0x4a, 0x4d, 0x49, 0x49, 0x4d, 0xb1, 0xd1,
+    0x07, 0x73, 0x6d, 0xf4, 0xc1, 0x72, 0x00, 0x83, 0xf9, 0x04, 0xe7, 0x22, 0x00, 0x00, 0x00};
+static const uint8_t kJson[] PROGMEM = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0xab, 0x56, 0x4a, 0x2a, 0x4a, 0xcc, 0x4b,
+    0x51, 0xb2, 0x52, 0xaa, 0x50, 0xaa, 0x05, 0x00, 0xe0, 0xe4, 0xed, 0xd5, 0x0d, 0x00, 0x00, 0x00};
+
+constexpr EmbeddedAsset kTable[] = {
+    {"/branding.json", kJson, sizeof(kJson), "\"d5ede4e0-0000000d\"", "application/json"},
+    {"/index.html", kHtml, sizeof(kHtml), "\"e704f983-00000022\"", "text/html"},
+    {"/style.1ce633e8.css", kCss, sizeof(kCss), "\"034ca4bd-0000000f\"", "text/css"},
+};
+constexpr size_t kTableSize = sizeof(kTable) / sizeof(kTable[0]);
+static_assert(embeddedAssetsSorted(kTable, kTableSize), "test table must be sorted");
+
+constexpr EmbeddedAsset kUnsorted[] = {
+    {"/index.html", kHtml, sizeof(kHtml), "", "text/html"},
+    {"/branding.json", kJson, sizeof(kJson), "", "application/json"},
+};
+static_assert(!embeddedAssetsSorted(kUnsorted, 2), "out-of-order tables are rejected");
+
+WiFiManagerConfig config;
+WiFiManager* wifiManager = nullptr;
+uint16_t port = 0;
+char fsRoot[] = "/tmp/wm-embedded-XXXXXX";
+
+typedef NativeSim::HttpReply Reply;
+
+static Reply get(const char* path, const std::string& extraHeaders = "") {
+    return NativeSim::httpGet(port, path, extraHeaders);
+}
+
+// Time spent in begin(), i.e. from power-up to the portal being served.
+static unsigned long timedBegin(bool mount, const char* root) {
+    NativeSim::setFilesystemRoot(root);
+    WiFiManagerConfig c = config;
+    c.mountFilesystem = mount;
+    WiFiManager wm(c);
+    wm.setDebugOutput(false);
+    wm.setEmbeddedAssets(kTable, kTableSize);
+    unsigned long start = millis();
+    wm.begin();
+    unsigned long elapsed = millis() - start;
+    TEST_ASSERT_EQUAL(mount, wm.isFilesystemMounted());
+    return elapsed;
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_lookup_uses_full_path() {
+    for (size_t i = 0; i < kTableSize; i++) {
+        TEST_ASSERT_EQUAL_PTR(&kTable[i], findEmbeddedAsset(kTable, kTableSize, kTable[i].path));
+    }
+    TEST_ASSERT_NULL(findEmbeddedAsset(kTable, kTableSize, "/"));
+    TEST_ASSERT_NULL(findEmbeddedAsset(kTable, kTableSize, "/index.htm"));
+    TEST_ASSERT_NULL(findEmbeddedAsset(kTable, kTableSize, "/index.html.gz"));
+    TEST_ASSERT_NULL(findEmbeddedAsset(kTable, kTableSize, "/zzz"));
+    TEST_ASSERT_NULL(findEmbeddedAsset(kTable, 0, "/index.html"));
+}
+
+void test_startup_with_and_without_mount() {
+    char blank[sizeof(fsRoot) + 8];
+    snprintf(blank, sizeof(blank), "%s/blank", fsRoot);
+    unsigned long mounted = timedBegin(true, fsRoot);
+    unsigned long formatted = timedBegin(true, blank);
+    unsigned long skipped = timedBegin(false, fsRoot);
+
+    char line[128];
+    snprintf(line, sizeof(line), "begin(): SPIFFS mount %lu ms, blank partition %lu ms, embedded only %lu ms",
+             mounted, formatted, skipped);
+    TEST_MESSAGE(line);
+
+    const NativeSim::FlashTiming t = NativeSim::flashTiming();
+    TEST_ASSERT_GREATER_OR_EQUAL(t.mountMs, mounted);
+    TEST_ASSERT_GREATER_OR_EQUAL(t.formatMs + 2 * t.mountMs, formatted);
+    TEST_ASSERT_LESS_THAN(t.mountMs, skipped);
+    NativeSim::setFilesystemRoot(fsRoot);
+}
+
+void test_served_from_table_without_filesystem() {
+    Reply r = get("/style.1ce633e8.css");
+    TEST_ASSERT_EQUAL(200, r.status);
+    TEST_ASSERT_EQUAL_STRING("gzip", r.header("Content-Encoding").c_str());
+    TEST_ASSERT_EQUAL_STRING("text/css", r.header("Content-Type").c_str());
+    TEST_ASSERT_EQUAL_STRING("\"034ca4bd-0000000f\"", r.header("ETag").c_str());
+    TEST_ASSERT_EQUAL_STRING("public, max-age=31536000, immutable", r.header("Cache-Control").c_str());
+    TEST_ASSERT_TRUE(r.body == std::string(reinterpret_cast<const char*>(kCss), sizeof(kCss)));
+
+    Reply root = get("/");
+    TEST_ASSERT_EQUAL(200, root.status);
+    TEST_ASSERT_EQUAL_STRING("text/html", root.header("Content-Type").c_str());
+    TEST_ASSERT_EQUAL_STRING("no-cache", root.header("Cache-Control").c_str());
+    TEST_ASSERT_EQUAL(sizeof(kHtml), root.body.size());
+}
+
+void test_revalidation_and_misses() {
+    Reply again = get("/index.html", "If-None-Match: \"e704f983-00000022\"\r\n");
+    TEST_ASSERT_EQUAL(304, again.status);
+    TEST_ASSERT_EQUAL(0, again.body.size());
+    TEST_ASSERT_EQUAL(404, get("/missing.js").status);
+    // Explorer endpoints report the unmounted filesystem instead of an empty one.
+    TEST_ASSERT_EQUAL(503, get("/fs/list").status);
+}
+
+int main(int argc, char** argv) {
+    if (!mkdtemp(fsRoot)) return 1;
+    NativeSim::setClockMode(NativeSim::ClockMode::Virtual);
+    config.httpPort = 0;
+
+    UNITY_BEGIN();
+    RUN_TEST(test_lookup_uses_full_path);
+    RUN_TEST(test_startup_with_and_without_mount);
+
+    WiFiManagerConfig served = config;
+    served.mountFilesystem = false;
+    wifiManager = new WiFiManager(served);
+    wifiManager->setDebugOutput(false);
+    wifiManager->setEmbeddedAssets(kTable, kTableSize);
+    wifiManager->begin();
+    port = NativeSim::lastBoundHttpPort();
+    RUN_TEST(test_served_from_table_without_filesystem);
+    RUN_TEST(test_revalidation_and_misses);
+    return UNITY_END();
+}
@@ -0,0 +1,154 @@
+#include <Arduino.h>
+#include <unity.h>
+#include <NativeSim.h>
+#include <Preferences.h>
+#include <string>
+#include "WiFiManager.h"
+
+// Fast-reconnect cache on the virtual clock. Each "boot" is a fresh
+// WiFiManager; the station keeps its NVS credentials and the cache survives
+// in the simulated NVS, as it would across deep sleep or a reset. The cache
+// holds no passphrase, and the cached lease is handed back to DHCP once the
+// link is up.
+
+WiFiManagerConfig config;
+
+static unsigned long normalMs = 0;
+static IPAddress firstLease;
+
+static WiFiManager* boot() {
+    // Power-up: the radio is down but the driver still has its stored config.
+    WiFi.disconnect();
+    WiFi.mode(WIFI_OFF);
+    WiFiManager* wm = new WiFiManager(config);
+    wm->setDebugOutput(false);
+    wm->begin();
+    return wm;
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_first_boot_takes_normal_path_and_caches() {
+    NativeSim::setStoredCredentials("HomeNetwork", "password123");
+    uint32_t writes = NativeSim::nvsWriteCount();
+    WiFiManager* wm = boot();
+    TEST_ASSERT_TRUE(wm->autoConnect("test-ap"));
+    TEST_ASSERT_TRUE(wm->getLastConnectPath() == ConnectPath::NORMAL);
+    normalMs = wm->getTimeToConnected(ConnectPath::NORMAL);
+    firstLease = WiFi.localIP();
+    TEST_ASSERT_GREATER_THAN(0, normalMs);
+    TEST_ASSERT_EQUAL(0, wm->getTimeToConnected(ConnectPath::FAST));
+    TEST_ASSERT_EQUAL(writes + 1, NativeSim::nvsWriteCount());
+    delete wm;
+}
+
+void test_second_boot_uses_fast_path() {
+    uint32_t writes = NativeSim::nvsWriteCount();
+    WiFiManager* wm = boot();
+    // Not associated yet: the passphrase has to come from the saved config.
+    TEST_ASSERT_EQUAL_STRING("", WiFi.SSID().c_str());
+    TEST_ASSERT_TRUE(wm->autoConnect("test-ap"));
+    unsigned long fastMs = wm->getTimeToConnected(ConnectPath::FAST);
+
+    char line[96];
+    snprintf(line, sizeof(line), "time-to-connected: normal %lu ms, fast %lu ms", normalMs, fastMs);
+    TEST_MESSAGE(line);
+
+    TEST_ASSERT_TRUE(wm->getLastConnectPath() == ConnectPath::FAST);
+    TEST_ASSERT_EQUAL(6, WiFi.channel());
+    TEST_ASSERT_EQUAL_UINT32(static_cast<uint32_t>(firstLease), static_cast<uint32_t>(WiFi.localIP()));
+    // One channel dwell and association; no probe sweep, no DHCP.
+    const NativeSim::RadioTiming t = NativeSim::radioTiming();
+    TEST_ASSERT_LESS_OR_EQUAL(t.channelDwellMs + t.associateMs + 20, fastMs);
+    TEST_ASSERT_LESS_THAN(normalMs / 3, fastMs);
+    // DHCP takes over once the link is up and renews the same lease.
+    NativeSim::advanceMillis(t.dhcpMs);
+    wm->loop();
+    TEST_ASSERT_EQUAL_UINT32(static_cast<uint32_t>(firstLease), static_cast<uint32_t>(WiFi.localIP()));
+    // Same AP, same lease: nothing is rewritten.
+    TEST_ASSERT_EQUAL(writes, NativeSim::nvsWriteCount());
+
+    // The cached address is no longer configured: a reconnect asks DHCP again.
+    WiFi.disconnect();
+    unsigned long start = millis();
+    WiFi.reconnect();
+    while (WiFi.status() != WL_CONNECTED && millis() - start < 10000) delay(10);
+    TEST_ASSERT_EQUAL(WL_CONNECTED, WiFi.status());
+    TEST_ASSERT_GREATER_OR_EQUAL(t.dhcpMs, millis() - start);
+    delete wm;
+}
+
+void test_record_holds_no_passphrase() {
+    Preferences prefs;
+    prefs.begin("wm_fast", true);
+    std::string record(prefs.getBytesLength("last"), '\0');
+    prefs.getBytes("last", &record[0], record.size());
+    prefs.end();
+    TEST_ASSERT_GREATER_THAN(0, record.size());
+    TEST_ASSERT_TRUE(record.find("password123") == std::string::npos);
+
+    // A record in the old layout, passphrase included, is dropped unread.
+    std::string old(160, '\0');
+    old[0] = 1;
+    old.replace(4, 11, "HomeNetwork");
+    old.replace(37, 11, "password123");
+    prefs.begin("wm_fast", false);
+    prefs.putBytes("last", old.data(), old.size());
+    prefs.end();
+    WiFiManager* wm = boot();
+    TEST_ASSERT_TRUE(wm->autoConnect("test-ap"));
+    TEST_ASSERT_TRUE(wm->getLastConnectPath() == ConnectPath::NORMAL);
+    prefs.begin("wm_fast", true);
+    TEST_ASSERT_EQUAL(record.size(), prefs.getBytesLength("last"));
+    prefs.end();
+    delete wm;
+}
+
+void test_fast_path_falls_back_when_network_is_gone() {
+    // The cached network disappears; another stored network is in range.
+    NativeSim::clearAccessPoints();
+    NativeSim::addAccessPoint("Workshop", "tools", 9, -60);
+    WiFiManager* wm = boot();
+    wm->addWiFiCredential("Workshop", "tools");
+    TEST_ASSERT_TRUE(wm->autoConnect("test-ap"));
+    TEST_ASSERT_TRUE(wm->getLastConnectPath() == ConnectPath::NORMAL);
+    TEST_ASSERT_EQUAL_STRING("Workshop", WiFi.SSID().c_str());
+    TEST_ASSERT_EQUAL(0, wm->getTimeToConnected(ConnectPath::FAST));
+    delete wm;
+
+    // The cache now points at the new network.
+    wm = boot();
+    TEST_ASSERT_TRUE(wm->autoConnect("test-ap"));
+    TEST_ASSERT_TRUE(wm->getLastConnectPath() == ConnectPath::FAST);
+    TEST_ASSERT_EQUAL(9, WiFi.channel());
+    delete wm;
+}
+
+void test_reset_clears_cache() {
+    WiFiManager* wm = boot();
+    wm->resetSettings();
+    delete wm;
+    NativeSim::setStoredCredentials("Workshop", "tools");
+    wm = boot();
+    TEST_ASSERT_TRUE(wm->autoConnect("test-ap"));
+    TEST_ASSERT_TRUE(wm->getLastConnectPath() == ConnectPath::NORMAL);
+    delete wm;
+}
+
+int main(int argc, char** argv) {
+    NativeSim::setClockMode(NativeSim::ClockMode::Virtual);
+    NativeSim::addAccessPoint("HomeNetwork", "password123", 6, -48);
+    NativeSim::addAccessPoint("Guest", "guestpass", 1, -80);
+    config.httpPort = 0;
+    config.configPortalTimeout = 1000;
+
+    UNITY_BEGIN();
+    RUN_TEST(test_first_boot_takes_normal_path_and_caches);
+    RUN_TEST(test_second_boot_uses_fast_path);
+    RUN_TEST(test_record_holds_no_passphrase);
+    RUN_TEST(test_fast_path_falls_back_when_network_is_gone);
+    RUN_TEST(test_reset_clears_cache);
+    return UNITY_END();
+}
@@ -0,0 +1,158 @@
+#include <Arduino.h>
+#include <unity.h>
+#include <NativeSim.h>
+#include <NativeSimClient.h>
+#include <fstream>
+#include <string>
+#include "WiFiManager.h"
+
+// /fs/list over a few hundred files: pages by offset/limit/prefix, the
+// directory is walked once and then served from the index, and uploads and
+// deletes keep that index current (virtual clock, simulated SPIFFS costs).
+
+WiFiManagerConfig config;
+WiFiManager* wifiManager = nullptr;
+uint16_t port = 0;
+std::string fsRoot;
+
+static const int kLogs = 300;
+static const int kCaptures = 40;
+
+typedef NativeSim::HttpReply Reply;
+
+static Reply request(const std::string& req) { return NativeSim::httpRequest(port, req); }
+
+static Reply list(const std::string& query) {
+    return request("GET /fs/list" + query + " HTTP/1.1\r\nHost: localhost\r\n\r\n");
+}
+
+static size_t count(const std::string& haystack, const std::string& needle) {
+    size_t n = 0;
+    for (size_t pos = haystack.find(needle); pos != std::string::npos; pos = haystack.find(needle, pos + 1)) n++;
+    return n;
+}
+
+static std::string logName(int i) {
+    char name[32];
+    snprintf(name, sizeof(name), "log-%03d.txt", i);
+    return name;
+}
+
+void setUp(void) { NativeSim::resetFlashStats(); }
+
+void tearDown(void) {}
+
+void test_pages_walk_once() {
+    uint64_t t0 = NativeSim::nowMicros();
+    Reply first = list("");
+    uint64_t walkUs = NativeSim::nowMicros() - t0;
+    NativeSim::FlashStats walk = NativeSim::flashStats();
+    TEST_ASSERT_EQUAL(200, first.status);
+    TEST_ASSERT_TRUE(first.body.find("\"total\":" + std::to_string(kLogs + kCaptures)) != std::string::npos);
+    TEST_ASSERT_EQUAL(50, count(first.body, "\"name\":"));
+    TEST_ASSERT_GREATER_OR_EQUAL(kLogs + kCaptures, walk.opens);
+
+    // Every log, in name order, over six more pages; none touches flash.
+    NativeSim::resetFlashStats();
+    t0 = NativeSim::nowMicros();
+    std::string all;
+    for (int offset = 0; offset < kLogs; offset += 50) {
+        Reply page = list("?prefix=log-&limit=50&offset=" + std::to_string(offset));
+        TEST_ASSERT_EQUAL(200, page.status);
+        TEST_ASSERT_TRUE(page.body.find("\"total\":" + std::to_string(kLogs)) != std::string::npos);
+        all += page.body;
+    }
+    uint64_t pagesUs = NativeSim::nowMicros() - t0;
+    TEST_ASSERT_EQUAL(0, NativeSim::flashStats().opens);
+    TEST_ASSERT_EQUAL(kLogs, count(all, "\"name\":\"log-"));
+    size_t last = 0;
+    for (int i = 0; i < kLogs; i++) {
+        size_t pos = all.find("\"name\":\"" + logName(i) + "\"");
+        TEST_ASSERT_TRUE(pos != std::string::npos && pos >= last);
+        last = pos;
+    }
+
+    char line[160];
+    snprintf(line, sizeof(line), "%d files: first listing walks %u opens (%.0f ms flash), the next 6 pages none (%.1f ms)",
+             kLogs + kCaptures, static_cast<unsigned>(walk.opens), walkUs / 1000.0, pagesUs / 1000.0);
+    TEST_MESSAGE(line);
+}
+
+void test_limits_prefix_and_heap() {
+    Reply tail = list("?prefix=/capture-&offset=35");
+    TEST_ASSERT_TRUE(tail.body.find("\"total\":" + std::to_string(kCaptures)) != std::string::npos);
+    TEST_ASSERT_EQUAL(kCaptures - 35, count(tail.body, "\"name\":\"capture-"));
+
+    Reply past = list("?offset=100000");
+    TEST_ASSERT_EQUAL(200, past.status);
+    TEST_ASSERT_TRUE(past.body.find("\"files\":[]") != std::string::npos);
+
+    Reply none = list("?prefix=nothing");
+    TEST_ASSERT_TRUE(none.body.find("\"total\":0") != std::string::npos);
+
+    // The largest page streams: it needs no more heap than a one-entry page
+    // beyond what the client side of this test buffers.
+    NativeSim::resetHeapPeak();
+    size_t liveBefore = NativeSim::heapStats().liveBytes;
+    Reply small = list("?limit=1");
+    size_t smallPeak = NativeSim::heapStats().peakLiveBytes - liveBefore;
+    NativeSim::resetHeapPeak();
+    liveBefore = NativeSim::heapStats().liveBytes;
+    Reply big = list("?limit=100000");
+    size_t bigPeak = NativeSim::heapStats().peakLiveBytes - liveBefore;
+    TEST_ASSERT_EQUAL(1, count(small.body, "\"name\":"));
+    TEST_ASSERT_TRUE(big.body.find("\"limit\":200") != std::string::npos);
+    TEST_ASSERT_EQUAL(200, count(big.body, "\"name\":"));
+    char line[120];
+    snprintf(line, sizeof(line), "peak heap growth: 1-entry page %u B, 200-entry page (%u B body) %u B",
+             static_cast<unsigned>(smallPeak), static_cast<unsigned>(big.body.size()), static_cast<unsigned>(bigPeak));
+    TEST_MESSAGE(line);
+    // The test's own recv buffers hold the body up to three times over.
+    TEST_ASSERT_LESS_THAN(smallPeak + 3 * big.body.size() + 4096, bigPeak);
+}
+
+void test_upload_and_delete_update_index() {
+    const std::string boundary = "----listBoundary";
+    std::string body = "--" + boundary +
+                       "\r\nContent-Disposition: form-data; name=\"file\"; filename=\"capture-new.bin\"\r\n\r\n" +
+                       std::string(5000, 'c') + "\r\n--" + boundary + "--\r\n";
+    Reply up = request("POST /fs/upload HTTP/1.1\r\nHost: localhost\r\nContent-Type: multipart/form-data; boundary=" +
+                       boundary + "\r\nContent-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body);
+    TEST_ASSERT_EQUAL(200, up.status);
+
+    Reply after = list("?prefix=capture-new");
+    TEST_ASSERT_TRUE(after.body.find("\"name\":\"capture-new.bin\",\"size\":5000") != std::string::npos);
+
+    Reply del = request("DELETE /fs/delete?path=/log-007.txt HTTP/1.1\r\nHost: localhost\r\n\r\n");
+    TEST_ASSERT_EQUAL(200, del.status);
+    Reply logs = list("?prefix=log-&limit=10");
+    TEST_ASSERT_TRUE(logs.body.find("\"total\":" + std::to_string(kLogs - 1)) != std::string::npos);
+    TEST_ASSERT_TRUE(logs.body.find(logName(7)) == std::string::npos);
+
+    // Only the upload's temp file and rename touched the directory.
+    TEST_ASSERT_EQUAL(2, NativeSim::flashStats().opens);
+}
+
+int main(int argc, char** argv) {
+    char dir[] = "/tmp/wm-fs-list-XXXXXX";
+    fsRoot = mkdtemp(dir);
+    for (int i = 0; i < kLogs; i++) std::ofstream(fsRoot + "/" + logName(i)) << "entry " << i << "\n";
+    for (int i = 0; i < kCaptures; i++) std::ofstream(fsRoot + "/capture-" + std::to_string(1000 + i) + ".bin") << i;
+    NativeSim::setFilesystemRoot(fsRoot.c_str());
+    NativeSim::setClockMode(NativeSim::ClockMode::Virtual);
+
+    config.httpPort = 0;
+    wifiManager = new WiFiManager(config);
+    wifiManager->setDebugOutput(false);
+    wifiManager->begin();
+    port = NativeSim::lastBoundHttpPort();
+
+    UNITY_BEGIN();
+    RUN_TEST(test_pages_walk_once);
+    RUN_TEST(test_limits_prefix_and_heap);
+    RUN_TEST(test_upload_and_delete_update_index);
+    int result = UNITY_END();
+    std::string cleanup = "rm -rf " + fsRoot;
+    system(cleanup.c_str());
+    return result;
+}
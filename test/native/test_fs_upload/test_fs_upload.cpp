@@ -0,0 +1,191 @@
+#include <Arduino.h>
+#include <unity.h>
+#include <NativeSim.h>
+#include <NativeSimClient.h>
+#include <SPIFFS.h>
+#include <dirent.h>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include "WiFiManager.h"
+
+// File explorer uploads: a 500 KB asset through POST /fs/upload against the
+// former open/append/close per chunk, on the simulated SPIFFS cost model
+// (virtual clock, so the flash time is the modelled one), plus temp-file
+// replacement, aborted uploads and multi-file requests.
+
+WiFiManagerConfig config;
+WiFiManager* wifiManager = nullptr;
+uint16_t port = 0;
+std::string fsRoot;
+std::string asset;  // 500 KB
+
+static const size_t kChunk = 1460;  // what the upload callback gets per call
+
+static std::string readFile(const std::string& spiffsPath) {
+    std::ifstream in(fsRoot + spiffsPath, std::ios::binary);
+    std::stringstream ss;
+    ss << in.rdbuf();
+    return ss.str();
+}
+
+static void writeFile(const std::string& spiffsPath, const std::string& data) {
+    std::ofstream out(fsRoot + spiffsPath, std::ios::binary);
+    out << data;
+}
+
+static size_t tempFiles() {
+    size_t n = 0;
+    DIR* d = opendir(fsRoot.c_str());
+    while (struct dirent* e = readdir(d)) {
+        if (strncmp(e->d_name, ".upload", 7) == 0) n++;
+    }
+    closedir(d);
+    return n;
+}
+
+static const char kBoundary[] = "----fsBoundary3kTq9";
+
+static std::string part(const std::string& filename, const std::string& data) {
+    return std::string("--") + kBoundary + "\r\nContent-Disposition: form-data; name=\"file\"; filename=\"" + filename +
+           "\"\r\nContent-Type: application/octet-stream\r\n\r\n" + data + "\r\n";
+}
+
+static std::string multipart(const std::string& parts) { return parts + "--" + kBoundary + "--\r\n"; }
+
+static std::string requestHead(size_t contentLength) {
+    return std::string("POST /fs/upload HTTP/1.1\r\nHost: localhost\r\nContent-Type: multipart/form-data; boundary=") +
+           kBoundary + "\r\nContent-Length: " + std::to_string(contentLength) + "\r\n\r\n";
+}
+
+typedef NativeSim::HttpReply Reply;
+
+static Reply post(const std::string& body) {
+    int fd = NativeSim::openSocket(port);
+    std::string head = requestHead(body.size());
+    send(fd, head.data(), head.size(), 0);
+    for (size_t sent = 0; sent < body.size();) {
+        ssize_t n = send(fd, body.data() + sent, std::min<size_t>(65536, body.size() - sent), 0);
+        if (n <= 0) break;
+        sent += n;
+    }
+    return NativeSim::parseReply(NativeSim::receiveAll(fd));
+}
+
+void setUp(void) { NativeSim::resetFlashStats(); }
+
+void tearDown(void) {}
+
+void test_upload_throughput_against_per_chunk_append() {
+    // Former handler: remove, then open/append/close for every chunk.
+    uint64_t t0 = NativeSim::nowMicros();
+    SPIFFS.remove("/legacy.bin");
+    for (size_t i = 0; i < asset.size(); i += kChunk) {
+        File file = SPIFFS.open("/legacy.bin", FILE_APPEND);
+        file.write(reinterpret_cast<const uint8_t*>(asset.data()) + i, std::min(kChunk, asset.size() - i));
+        file.close();
+    }
+    uint64_t legacyUs = NativeSim::nowMicros() - t0;
+    NativeSim::FlashStats legacy = NativeSim::flashStats();
+    TEST_ASSERT_TRUE(readFile("/legacy.bin") == asset);
+
+    const std::string body = multipart(part("asset.bin", asset));
+    NativeSim::resetFlashStats();
+    NativeSim::resetHeapPeak();
+    size_t liveBefore = NativeSim::heapStats().liveBytes;
+    auto wall0 = std::chrono::steady_clock::now();
+    t0 = NativeSim::nowMicros();
+    Reply r = post(body);
+    uint64_t streamedUs = NativeSim::nowMicros() - t0;
+    double wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - wall0).count();
+    size_t peakGrowth = NativeSim::heapStats().peakLiveBytes - liveBefore;
+    NativeSim::FlashStats streamed = NativeSim::flashStats();
+
+    TEST_ASSERT_EQUAL(200, r.status);
+    TEST_ASSERT_TRUE(r.body.find("\"files\":1") != std::string::npos);
+    TEST_ASSERT_TRUE(r.body.find("\"bytes\":" + std::to_string(asset.size())) != std::string::npos);
+    TEST_ASSERT_TRUE(readFile("/asset.bin") == asset);
+    TEST_ASSERT_EQUAL(0, tempFiles());
+
+    char line[200];
+    snprintf(line, sizeof(line),
+             "per-chunk append: %u opens, %u writes, %.0f ms flash (%.0f KB/s)",
+             static_cast<unsigned>(legacy.opens), static_cast<unsigned>(legacy.writes), legacyUs / 1000.0,
+             asset.size() / 1024.0 / (legacyUs / 1e6));
+    TEST_MESSAGE(line);
+    snprintf(line, sizeof(line),
+             "POST /fs/upload:  %u opens, %u writes, %.0f ms flash (%.0f KB/s), %.1f ms wall, peak heap growth %u B",
+             static_cast<unsigned>(streamed.opens), static_cast<unsigned>(streamed.writes), streamedUs / 1000.0,
+             asset.size() / 1024.0 / (streamedUs / 1e6), wallMs, static_cast<unsigned>(peakGrowth));
+    TEST_MESSAGE(line);
+
+    // Temp file create plus rename; sector-sized writes only.
+    TEST_ASSERT_EQUAL(2, streamed.opens);
+    TEST_ASSERT_EQUAL((asset.size() + FsUpload::kWriteSize - 1) / FsUpload::kWriteSize, streamed.writes);
+    TEST_ASSERT_LESS_THAN(legacyUs / 5, streamedUs);
+    TEST_ASSERT_LESS_THAN(64 * 1024, peakGrowth);
+}
+
+void test_aborted_upload_keeps_previous_version() {
+    writeFile("/page.html", "previous");
+    std::string body = multipart(part("page.html", asset));
+    int fd = NativeSim::openSocket(port);
+    std::string req = requestHead(body.size()) + body.substr(0, body.size() / 2);
+    send(fd, req.data(), req.size(), 0);
+    usleep(100000);
+    close(fd);
+    for (int i = 0; i < 100 && tempFiles(); i++) usleep(10000);
+
+    TEST_ASSERT_EQUAL_STRING("previous", readFile("/page.html").c_str());
+    TEST_ASSERT_EQUAL(0, tempFiles());
+
+    // The slot was released: the next upload replaces the file.
+    Reply r = post(multipart(part("page.html", "<html>new</html>")));
+    TEST_ASSERT_EQUAL(200, r.status);
+    TEST_ASSERT_EQUAL_STRING("<html>new</html>", readFile("/page.html").c_str());
+}
+
+void test_multiple_files_and_bad_requests() {
+    Reply r = post(multipart(part("a.txt", "alpha") + part("b.txt", std::string(10000, 'b'))));
+    TEST_ASSERT_EQUAL(200, r.status);
+    TEST_ASSERT_TRUE(r.body.find("\"files\":2") != std::string::npos);
+    TEST_ASSERT_EQUAL_STRING("alpha", readFile("/a.txt").c_str());
+    TEST_ASSERT_TRUE(readFile("/b.txt") == std::string(10000, 'b'));
+
+    Reply empty = post(multipart(part("empty.txt", "")));
+    TEST_ASSERT_EQUAL(200, empty.status);
+    TEST_ASSERT_TRUE(SPIFFS.exists("/empty.txt"));
+
+    Reply badName = post(multipart(part("../escape.txt", "x")));
+    TEST_ASSERT_EQUAL(400, badName.status);
+    TEST_ASSERT_TRUE(badName.body.find("Invalid filename") != std::string::npos);
+
+    Reply none = post(multipart(""));
+    TEST_ASSERT_EQUAL(400, none.status);
+    TEST_ASSERT_EQUAL(0, tempFiles());
+}
+
+int main(int argc, char** argv) {
+    char dir[] = "/tmp/wm-fs-upload-XXXXXX";
+    fsRoot = mkdtemp(dir);
+    NativeSim::setFilesystemRoot(fsRoot.c_str());
+    NativeSim::setClockMode(NativeSim::ClockMode::Virtual);
+    asset.resize(500 * 1024);
+    for (size_t i = 0; i < asset.size(); i++) asset[i] = static_cast<char>((i * 131) ^ (i >> 9));
+
+    config.httpPort = 0;
+    wifiManager = new WiFiManager(config);
+    wifiManager->setDebugOutput(false);
+    wifiManager->begin();
+    port = NativeSim::lastBoundHttpPort();
+
+    UNITY_BEGIN();
+    RUN_TEST(test_upload_throughput_against_per_chunk_append);
+    RUN_TEST(test_aborted_upload_keeps_previous_version);
+    RUN_TEST(test_multiple_files_and_bad_requests);
+    int result = UNITY_END();
+    std::string cleanup = "rm -rf " + fsRoot;
+    system(cleanup.c_str());
+    return result;
+}
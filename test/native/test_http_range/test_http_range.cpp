@@ -0,0 +1,206 @@
+#include <Arduino.h>
+#include <unity.h>
+#include <NativeSim.h>
+#include <NativeSimClient.h>
+#include <fstream>
+#include <string>
+#include "WiFiManager.h"
+#include "WiFiManagerAssets.h"
+
+// Range requests on files served from SPIFFS: the Range parser, a download
+// that drops halfway and resumes with If-Range, multipart/byteranges, the
+// 416/200 fallbacks, and that a range is read by seeking rather than from
+// the start of the file.
+
+WiFiManagerConfig config;
+WiFiManager* wifiManager = nullptr;
+uint16_t port = 0;
+std::string fsRoot;
+std::string capture;  // 200 KB data file
+
+typedef NativeSim::HttpReply Reply;
+
+// With `maxBody` the link drops after that much of the body.
+static Reply get(const std::string& path, const std::string& headers = "", size_t maxBody = std::string::npos) {
+    std::string req = "GET " + path + " HTTP/1.1\r\nHost: localhost\r\n" + headers + "\r\n";
+    Reply reply = NativeSim::parseReply(NativeSim::exchange(port, req, maxBody));
+    if (reply.body.size() > maxBody) reply.body.resize(maxBody);
+    return reply;
+}
+
+void setUp(void) { NativeSim::resetFlashStats(); }
+
+void tearDown(void) {}
+
+void test_parse_byte_ranges() {
+    ByteRange r[kMaxByteRanges];
+    TEST_ASSERT_EQUAL(1, parseByteRanges("bytes=0-99", 1000, r, kMaxByteRanges));
+    TEST_ASSERT_EQUAL(0, r[0].first);
+    TEST_ASSERT_EQUAL(99, r[0].last);
+    TEST_ASSERT_EQUAL(1, parseByteRanges("bytes=900-", 1000, r, kMaxByteRanges));
+    TEST_ASSERT_EQUAL(999, r[0].last);
+    TEST_ASSERT_EQUAL(1, parseByteRanges("bytes=-100", 1000, r, kMaxByteRanges));
+    TEST_ASSERT_EQUAL(900, r[0].first);
+    TEST_ASSERT_EQUAL(1, parseByteRanges("bytes=-5000", 1000, r, kMaxByteRanges));
+    TEST_ASSERT_EQUAL(0, r[0].first);
+    TEST_ASSERT_EQUAL(1, parseByteRanges("bytes=990-2000", 1000, r, kMaxByteRanges));
+    TEST_ASSERT_EQUAL(999, r[0].last);
+    TEST_ASSERT_EQUAL(2, parseByteRanges("bytes=0-0, 5000-6000 ,-1", 1000, r, kMaxByteRanges));
+    TEST_ASSERT_EQUAL(999, r[1].first);
+
+    // Unsatisfiable: 416.
+    TEST_ASSERT_EQUAL(0, parseByteRanges("bytes=1000-", 1000, r, kMaxByteRanges));
+    TEST_ASSERT_EQUAL(0, parseByteRanges("bytes=-0", 1000, r, kMaxByteRanges));
+    TEST_ASSERT_EQUAL(0, parseByteRanges("bytes=0-", 0, r, kMaxByteRanges));
+    // Ignored: whole file.
+    TEST_ASSERT_EQUAL(-1, parseByteRanges("items=0-1", 1000, r, kMaxByteRanges));
+    TEST_ASSERT_EQUAL(-1, parseByteRanges("bytes=5-1", 1000, r, kMaxByteRanges));
+    TEST_ASSERT_EQUAL(-1, parseByteRanges("bytes=a-b", 1000, r, kMaxByteRanges));
+    TEST_ASSERT_EQUAL(-1, parseByteRanges("bytes=0-1,", 1000, r, kMaxByteRanges));
+    TEST_ASSERT_EQUAL(-1, parseByteRanges("bytes=99999999999999999999999-", 1000, r, kMaxByteRanges));
+    TEST_ASSERT_EQUAL(-1, parseByteRanges("bytes=0-0,1-1,2-2,3-3,4-4,5-5,6-6,7-7,8-8", 1000, r, kMaxByteRanges));
+}
+
+void test_resume_interrupted_download() {
+    Reply first = get("/fs/download?path=/capture.bin", "", 80000);
+    TEST_ASSERT_EQUAL(200, first.status);
+    TEST_ASSERT_EQUAL_STRING("bytes", first.header("Accept-Ranges").c_str());
+    std::string etag = first.header("ETag");
+    TEST_ASSERT_TRUE(etag.size() > 2);
+    TEST_ASSERT_EQUAL(80000, first.body.size());
+
+    NativeSim::resetFlashStats();
+    Reply rest = get("/fs/download?path=/capture.bin",
+                     "Range: bytes=" + std::to_string(first.body.size()) + "-\r\nIf-Range: " + etag + "\r\n");
+    TEST_ASSERT_EQUAL(206, rest.status);
+    TEST_ASSERT_EQUAL_STRING(("bytes 80000-" + std::to_string(capture.size() - 1) + "/" + std::to_string(capture.size())).c_str(),
+                             rest.header("Content-Range").c_str());
+    TEST_ASSERT_EQUAL_STRING(std::to_string(capture.size() - 80000).c_str(), rest.header("Content-Length").c_str());
+    TEST_ASSERT_TRUE(rest.header("Content-Disposition").find("attachment") != std::string::npos);
+    TEST_ASSERT_TRUE(first.body + rest.body == capture);
+    // Seeked past what the client already has.
+    TEST_ASSERT_EQUAL(capture.size() - 80000, NativeSim::flashStats().bytesRead);
+
+    // The tail of a large file costs only the tail.
+    NativeSim::resetFlashStats();
+    Reply tail = get("/fs/download?path=/capture.bin", "Range: bytes=-1024\r\n");
+    TEST_ASSERT_EQUAL(206, tail.status);
+    TEST_ASSERT_TRUE(tail.body == capture.substr(capture.size() - 1024));
+    TEST_ASSERT_EQUAL(1024, NativeSim::flashStats().bytesRead);
+
+    char line[120];
+    snprintf(line, sizeof(line), "resume after %u of %u bytes: %u bytes re-sent",
+             static_cast<unsigned>(first.body.size()), static_cast<unsigned>(capture.size()),
+             static_cast<unsigned>(rest.body.size()));
+    TEST_MESSAGE(line);
+}
+
+void test_multipart_byteranges() {
+    Reply r = get("/fs/download?path=/capture.bin", "Range: bytes=0-9, 100000-100099, -5\r\n");
+    TEST_ASSERT_EQUAL(206, r.status);
+    std::string type = r.header("Content-Type");
+    TEST_ASSERT_TRUE(type.compare(0, 30, "multipart/byteranges; boundary") == 0);
+    std::string boundary = "--" + type.substr(type.find('=') + 1);
+    TEST_ASSERT_EQUAL_STRING(std::to_string(r.body.size()).c_str(), r.header("Content-Length").c_str());
+
+    const size_t firsts[] = {0, 100000, capture.size() - 5};
+    const size_t lens[] = {10, 100, 5};
+    size_t pos = 0;
+    for (int i = 0; i < 3; i++) {
+        pos = r.body.find(boundary, pos);
+        TEST_ASSERT_TRUE(pos != std::string::npos);
+        std::string range = "Content-Range: bytes " + std::to_string(firsts[i]) + "-" +
+                            std::to_string(firsts[i] + lens[i] - 1) + "/" + std::to_string(capture.size());
+        size_t at = r.body.find(range, pos);
+        TEST_ASSERT_TRUE(at != std::string::npos);
+        size_t data = r.body.find("\r\n\r\n", at) + 4;
+        TEST_ASSERT_TRUE(r.body.compare(data, lens[i], capture, firsts[i], lens[i]) == 0);
+        pos = data + lens[i];
+    }
+    TEST_ASSERT_EQUAL_STRING(("\r\n" + boundary + "--\r\n").c_str(), r.body.substr(pos).c_str());
+}
+
+void test_validators_and_fallbacks() {
+    Reply full = get("/fs/download?path=/capture.bin");
+    std::string etag = full.header("ETag");
+
+    Reply stale = get("/fs/download?path=/capture.bin", "Range: bytes=10-\r\nIf-Range: \"0-0\"\r\n");
+    TEST_ASSERT_EQUAL(200, stale.status);
+    TEST_ASSERT_EQUAL(capture.size(), stale.body.size());
+
+    Reply dated = get("/fs/download?path=/capture.bin", "Range: bytes=10-\r\nIf-Range: Wed, 21 Oct 2015 07:28:00 GMT\r\n");
+    TEST_ASSERT_EQUAL(200, dated.status);
+
+    Reply past = get("/fs/download?path=/capture.bin", "Range: bytes=999999-\r\n");
+    TEST_ASSERT_EQUAL(416, past.status);
+    TEST_ASSERT_EQUAL_STRING(("bytes */" + std::to_string(capture.size())).c_str(), past.header("Content-Range").c_str());
+
+    Reply bad = get("/fs/download?path=/capture.bin", "Range: bytes=oops\r\n");
+    TEST_ASSERT_EQUAL(200, bad.status);
+
+    Reply cached = get("/fs/download?path=/capture.bin", "If-None-Match: " + etag + "\r\n");
+    TEST_ASSERT_EQUAL(304, cached.status);
+
+    // A rewritten file gets a new ETag, so an old If-Range no longer matches.
+    std::ofstream(fsRoot + "/capture.bin", std::ios::binary | std::ios::app) << "more";
+    Reply changed = get("/fs/download?path=/capture.bin", "Range: bytes=10-19\r\nIf-Range: " + etag + "\r\n");
+    TEST_ASSERT_EQUAL(200, changed.status);
+    TEST_ASSERT_TRUE(changed.header("ETag") != etag);
+    std::ofstream(fsRoot + "/capture.bin", std::ios::binary) << capture;
+
+    Reply missing = get("/fs/download?path=/nope.bin", "Range: bytes=0-1\r\n");
+    TEST_ASSERT_EQUAL(404, missing.status);
+}
+
+void test_static_files() {
+    Reply plain = get("/log.txt", "Range: bytes=6-10\r\n");
+    TEST_ASSERT_EQUAL(206, plain.status);
+    TEST_ASSERT_EQUAL_STRING("text/plain", plain.header("Content-Type").c_str());
+    TEST_ASSERT_EQUAL_STRING("line2", plain.body.c_str());
+    TEST_ASSERT_TRUE(plain.header("ETag").size() > 2);
+
+    // Gzip assets: ranges over the stored (compressed) bytes.
+    Reply whole = get("/app.js");
+    Reply gz = get("/app.js", "Range: bytes=0-1\r\n");
+    TEST_ASSERT_EQUAL(206, gz.status);
+    TEST_ASSERT_EQUAL_STRING("gzip", gz.header("Content-Encoding").c_str());
+    TEST_ASSERT_EQUAL_STRING(whole.header("ETag").c_str(), gz.header("ETag").c_str());
+    TEST_ASSERT_EQUAL_STRING("\x1f\x8b", gz.body.c_str());
+    // Several ranges would be a multipart body under Content-Encoding: 200 instead.
+    Reply multi = get("/app.js", "Range: bytes=0-1, 4-5\r\n");
+    TEST_ASSERT_EQUAL(200, multi.status);
+    TEST_ASSERT_EQUAL_STRING("gzip", multi.header("Content-Encoding").c_str());
+    TEST_ASSERT_TRUE(multi.body == whole.body);
+}
+
+int main(int argc, char** argv) {
+    char dir[] = "/tmp/wm-range-XXXXXX";
+    fsRoot = mkdtemp(dir);
+    capture.resize(200 * 1024);
+    for (size_t i = 0; i < capture.size(); i++) capture[i] = static_cast<char>((i * 7919) >> 3);
+    std::ofstream(fsRoot + "/capture.bin", std::ios::binary) << capture;
+    std::ofstream(fsRoot + "/log.txt") << "line1\nline2\nline3\n";
+    // Smallest valid gzip member of "x": header, deflate block, CRC-32, ISIZE.
+    const unsigned char gz[] = {0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0xab, 0x00, 0x00,
+                                0x83, 0x16, 0xdc, 0x8c, 0x01, 0x00, 0x00, 0x00};
+    std::ofstream(fsRoot + "/app.js.gz", std::ios::binary).write(reinterpret_cast<const char*>(gz), sizeof(gz));
+    NativeSim::setFilesystemRoot(fsRoot.c_str());
+    NativeSim::setClockMode(NativeSim::ClockMode::Virtual);
+
+    config.httpPort = 0;
+    wifiManager = new WiFiManager(config);
+    wifiManager->setDebugOutput(false);
+    wifiManager->begin();
+    port = NativeSim::lastBoundHttpPort();
+
+    UNITY_BEGIN();
+    RUN_TEST(test_parse_byte_ranges);
+    RUN_TEST(test_resume_interrupted_download);
+    RUN_TEST(test_multipart_byteranges);
+    RUN_TEST(test_validators_and_fallbacks);
+    RUN_TEST(test_static_files);
+    int result = UNITY_END();
+    std::string cleanup = "rm -rf " + fsRoot;
+    system(cleanup.c_str());
+    return result;
+}
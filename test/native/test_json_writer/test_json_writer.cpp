@@ -0,0 +1,264 @@
+#include <Arduino.h>
+#include <unity.h>
+#include <NativeSim.h>
+#include <NativeSimClient.h>
+#include <string>
+#include "WiFiManager.h"
+#include "WiFiManagerJson.h"
+
+// Streaming JSON writer: correctness of the emitted document, chunk-boundary
+// independence, piece-wise resumption through JsonCursor, and a
+// bytes-allocated-per-request benchmark against the String-concatenation
+// handlers it replaced.
+
+WiFiManagerConfig config;
+WiFiManager* wifiManager = nullptr;
+AsyncWebServer* legacyServer = nullptr;
+uint16_t managerPort = 0;
+uint16_t legacyPort = 0;
+
+static std::string render(const JsonRenderer& fn) {
+    std::string out(measureJson(fn), '\0');
+    JsonStreamWriter json(reinterpret_cast<uint8_t*>(&out[0]), out.size());
+    fn(json);
+    return out;
+}
+
+static void sampleDocument(JsonStreamWriter& json) {
+    json.beginObject();
+    json.field("name", "say \"hi\"\\\n");
+    json.field("count", 42);
+    json.field("negative", -7L);
+    json.field("ok", true);
+    json.key("ip");
+    json.valueIP(IPAddress(192, 168, 4, 1));
+    json.key("empty");
+    json.beginArray();
+    json.endArray();
+    json.key("items");
+    json.beginArray();
+    for (int i = 0; i < 3; i++) {
+        json.beginObject();
+        json.field("i", i);
+        json.endObject();
+    }
+    json.value("tail");
+    json.endArray();
+    json.key("none");
+    json.valueNull();
+    json.endObject();
+}
+
+// Reference implementation of the pre-streaming /status_json handler.
+static String legacyStatusJSON(const std::vector<WiFiManagerParameter*>& params) {
+    String json = "{";
+    json += "\"status\":\"" + String("Connected") + "\",";
+    json += "\"ip\":\"" + WiFi.localIP().toString() + "\",";
+    json += "\"lastResult\":" + String(3) + ",";
+    json += "\"ssid\":\"" + (WiFi.SSID().length() ? WiFi.SSID() : String("")) + "\",";
+    json += "\"rssi\":" + String(WiFi.status() == WL_CONNECTED ? WiFi.RSSI() : 0) + ",";
+    json += "\"params\":[";
+    for (size_t i = 0; i < params.size(); i++) {
+        json += "{";
+        json += "\"id\":\"" + String(params[i]->getID()) + "\",";
+        json += "\"label\":\"" + String(params[i]->getLabel()) + "\",";
+        json += "\"value\":\"" + String(params[i]->getValue()) + "\"";
+        json += ",\"group\":\"" + String(params[i]->getGroup()) + "\"";
+        json += "}";
+        if (i < params.size()-1) json += ",";
+    }
+    json += "]";
+    json += "}";
+    return json;
+}
+
+struct AllocSample {
+    uint64_t allocations;
+    uint64_t bytes;
+    size_t responseBytes;
+};
+
+static AllocSample measure(uint16_t port, const char* path) {
+    const int rounds = 20;
+    size_t responseBytes = 0;
+    NativeSim::httpGetDiscard(port, path, &responseBytes);  // warm-up
+    delay(20);
+    NativeSim::HeapStats before = NativeSim::heapStats();
+    for (int i = 0; i < rounds; i++) {
+        TEST_ASSERT_EQUAL(200, NativeSim::httpGetDiscard(port, path, &responseBytes));
+    }
+    delay(20);
+    NativeSim::HeapStats after = NativeSim::heapStats();
+    AllocSample s;
+    s.allocations = (after.allocations - before.allocations) / rounds;
+    s.bytes = (after.bytesAllocated - before.bytesAllocated) / rounds;
+    s.responseBytes = responseBytes;
+    return s;
+}
+
+static void addParams(size_t total) {
+    static char ids[600][16];
+    size_t have = wifiManager->getParameters().size();
+    for (size_t i = have; i < total; i++) {
+        snprintf(ids[i], sizeof(ids[i]), "param_%03u", static_cast<unsigned>(i));
+        wifiManager->addParameter(new WiFiManagerParameter(ids[i], "Benchmark Parameter", "some-value-1234", 40));
+    }
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_writer_emits_valid_structure() {
+    TEST_ASSERT_EQUAL_STRING(
+        "{\"name\":\"say \\\"hi\\\"\\\\\\n\",\"count\":42,\"negative\":-7,\"ok\":true,"
+        "\"ip\":\"192.168.4.1\",\"empty\":[],\"items\":[{\"i\":0},{\"i\":1},{\"i\":2},\"tail\"],\"none\":null}",
+        render(sampleDocument).c_str());
+}
+
+void test_writer_escapes_control_characters() {
+    std::string out = render([](JsonStreamWriter& json) { json.value("a\x01" "b\tc"); });
+    TEST_ASSERT_EQUAL_STRING("\"a\\u0001b\\tc\"", out.c_str());
+}
+
+void test_chunked_output_matches_single_pass() {
+    std::string whole = render(sampleDocument);
+    for (size_t window = 1; window <= whole.size() + 1; window++) {
+        std::string joined;
+        uint8_t buf[256];
+        for (;;) {
+            JsonStreamWriter json(buf, window, joined.size());
+            sampleDocument(json);
+            if (json.written() == 0) break;
+            joined.append(reinterpret_cast<char*>(buf), json.written());
+        }
+        TEST_ASSERT_EQUAL_STRING(whole.c_str(), joined.c_str());
+    }
+}
+
+// sampleDocument() in pieces: up to "items":[, three rows, the rest.
+static bool samplePiece(JsonStreamWriter& json, size_t piece) {
+    if (piece == 0) {
+        json.beginObject();
+        json.field("name", "say \"hi\"\\\n");
+        json.field("count", 42);
+        json.field("negative", -7L);
+        json.field("ok", true);
+        json.key("ip");
+        json.valueIP(IPAddress(192, 168, 4, 1));
+        json.key("empty");
+        json.beginArray();
+        json.endArray();
+        json.key("items");
+        json.beginArray();
+    } else if (piece <= 3) {
+        json.beginObject();
+        json.field("i", static_cast<int>(piece - 1));
+        json.endObject();
+    } else if (piece == 4) {
+        json.value("tail");
+        json.endArray();
+        json.key("none");
+        json.valueNull();
+        json.endObject();
+    } else {
+        return false;
+    }
+    return true;
+}
+
+void test_cursor_resumes_in_pieces() {
+    std::string whole = render(sampleDocument);
+    for (size_t window = 1; window <= whole.size() + 1; window++) {
+        JsonCursor cursor;
+        size_t renders = 0;
+        size_t chunks = 0;
+        auto counted = [&renders](JsonStreamWriter& json, size_t piece) {
+            renders++;
+            return samplePiece(json, piece);
+        };
+        std::string joined;
+        uint8_t buf[256];
+        for (;;) {
+            size_t n = cursor.fill(buf, window, joined.size(), counted);
+            if (n == 0) break;
+            joined.append(reinterpret_cast<char*>(buf), n);
+            chunks++;
+        }
+        TEST_ASSERT_EQUAL_STRING(whole.c_str(), joined.c_str());
+        // Each chunk renders the piece it resumes plus the ones it completes.
+        TEST_ASSERT_LESS_OR_EQUAL(chunks + 5 + 1, renders);
+    }
+}
+
+void test_writer_does_not_allocate() {
+    uint8_t buf[64];
+    NativeSim::HeapStats before = NativeSim::heapStats();
+    for (size_t skip = 0; skip < 200; skip += 64) {
+        JsonStreamWriter json(buf, sizeof(buf), skip);
+        sampleDocument(json);
+    }
+    NativeSim::HeapStats after = NativeSim::heapStats();
+    TEST_ASSERT_EQUAL(0, after.allocations - before.allocations);
+}
+
+void test_status_json_allocations_independent_of_param_count() {
+    char line[160];
+    AllocSample streamed[2];
+    AllocSample legacy[2];
+    const size_t counts[2] = {10, 100};
+    for (int i = 0; i < 2; i++) {
+        addParams(counts[i]);
+        streamed[i] = measure(managerPort, "/status_json");
+        legacy[i] = measure(legacyPort, "/status_json");
+        snprintf(line, sizeof(line), "params=%3u  legacy: %4llu allocs %7llu B   streamed: %3llu allocs %6llu B  (%u B response)",
+                 static_cast<unsigned>(counts[i]),
+                 static_cast<unsigned long long>(legacy[i].allocations), static_cast<unsigned long long>(legacy[i].bytes),
+                 static_cast<unsigned long long>(streamed[i].allocations), static_cast<unsigned long long>(streamed[i].bytes),
+                 static_cast<unsigned>(streamed[i].responseBytes));
+        TEST_MESSAGE(line);
+    }
+    // Per-request allocations are fixed overhead (request, response, filler).
+    TEST_ASSERT_EQUAL(streamed[0].allocations, streamed[1].allocations);
+    TEST_ASSERT_LESS_THAN(legacy[1].allocations, streamed[1].allocations);
+    TEST_ASSERT_LESS_THAN(legacy[1].bytes, streamed[1].bytes);
+}
+
+void test_params_json_is_streamed() {
+    AllocSample a = measure(managerPort, "/params_json");
+    addParams(wifiManager->getParameters().size() + 50);
+    AllocSample b = measure(managerPort, "/params_json");
+    TEST_ASSERT_GREATER_THAN(a.responseBytes, b.responseBytes);
+    TEST_ASSERT_EQUAL(a.allocations, b.allocations);
+}
+
+int main(int argc, char** argv) {
+    NativeSim::addAccessPoint("HomeNetwork", "password123", 6, -48);
+    NativeSim::setRadioTiming(NativeSim::RadioTiming{1, 13, 1, 1, 1});
+    WiFi.mode(WIFI_STA);
+    WiFi.begin("HomeNetwork", "password123");
+    while (WiFi.status() != WL_CONNECTED) delay(1);
+
+    config.httpPort = 0;
+    wifiManager = new WiFiManager(config);
+    wifiManager->setDebugOutput(false);
+    wifiManager->begin();
+    managerPort = NativeSim::lastBoundHttpPort();
+
+    legacyServer = new AsyncWebServer(0);
+    legacyServer->on("/status_json", HTTP_GET, [](AsyncWebServerRequest* request) {
+        request->send(200, "application/json", legacyStatusJSON(wifiManager->getParameters()));
+    });
+    legacyServer->begin();
+    legacyPort = NativeSim::lastBoundHttpPort();
+
+    UNITY_BEGIN();
+    RUN_TEST(test_writer_emits_valid_structure);
+    RUN_TEST(test_writer_escapes_control_characters);
+    RUN_TEST(test_chunked_output_matches_single_pass);
+    RUN_TEST(test_cursor_resumes_in_pieces);
+    RUN_TEST(test_writer_does_not_allocate);
+    RUN_TEST(test_status_json_allocations_independent_of_param_count);
+    RUN_TEST(test_params_json_is_streamed);
+    return UNITY_END();
+}
@@ -0,0 +1,189 @@
+#include <Arduino.h>
+#include <unity.h>
+#include <NativeSim.h>
+#include <NativeSimClient.h>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include "WiFiManager.h"
+
+// GET /metrics: per-route counters and latency histograms in Prometheus text
+// format, bytes charged against what clients actually received, upload
+// latency measured from the first chunk, and the cost of recording (also from
+// several threads at once, which must not lose increments).
+
+WiFiManagerConfig config;
+WiFiManager* wifiManager = nullptr;
+uint16_t port = 0;
+std::string fsRoot;
+
+// Value of one sample line, e.g. value(text, "wm_http_requests_total{route=\"/scan\"}").
+static double value(const std::string& text, const std::string& series) {
+    size_t at = text.find("\n" + series + " ");
+    if (at == std::string::npos) return -1;
+    return atof(text.c_str() + at + series.size() + 2);
+}
+
+static std::string metrics() { return NativeSim::httpGet(port, "/metrics").body; }
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_exposition() {
+    std::string before = metrics();
+    double statusBefore = value(before, "wm_http_requests_total{route=\"/status_json\"}");
+    TEST_ASSERT_EQUAL_FLOAT(0, statusBefore);
+    for (int i = 0; i < 5; i++) NativeSim::httpGet(port, "/status_json");
+    NativeSim::httpGet(port, "/fs/download?path=/missing.bin");
+    NativeSim::httpGet(port, "/fs/download");
+
+    NativeSim::HttpReply reply = NativeSim::httpGet(port, "/metrics");
+    TEST_ASSERT_EQUAL_STRING("text/plain; version=0.0.4; charset=utf-8", reply.header("Content-Type").c_str());
+    std::string text = reply.body;
+    TEST_ASSERT_TRUE(text.find("# TYPE wm_http_requests_total counter\n") == 0 ||
+                     text.find("# HELP wm_http_requests_total ") == 0);
+    TEST_ASSERT_TRUE(text.find("# TYPE wm_http_request_duration_seconds histogram\n") != std::string::npos);
+    TEST_ASSERT_EQUAL_FLOAT(5, value(text, "wm_http_requests_total{route=\"/status_json\"}"));
+    TEST_ASSERT_EQUAL_FLOAT(0, value(text, "wm_http_errors_total{route=\"/status_json\"}"));
+    TEST_ASSERT_EQUAL_FLOAT(2, value(text, "wm_http_requests_total{route=\"/fs/download\"}"));
+    TEST_ASSERT_EQUAL_FLOAT(2, value(text, "wm_http_errors_total{route=\"/fs/download\"}"));
+    TEST_ASSERT_EQUAL_FLOAT(1, value(text, "wm_http_requests_total{route=\"/metrics\"}"));
+
+    // Buckets are cumulative and end in +Inf == _count.
+    double last = 0;
+    const char* bounds[] = {"0.0005", "0.001", "0.0025", "0.005", "0.01", "0.025", "0.05",
+                            "0.1", "0.25", "0.5", "1", "2.5", "5", "+Inf"};
+    for (const char* le : bounds) {
+        double n = value(text, std::string("wm_http_request_duration_seconds_bucket{route=\"/status_json\",le=\"") + le + "\"}");
+        TEST_ASSERT_TRUE(n >= last);
+        last = n;
+    }
+    TEST_ASSERT_EQUAL_FLOAT(5, last);
+    TEST_ASSERT_EQUAL_FLOAT(5, value(text, "wm_http_request_duration_seconds_count{route=\"/status_json\"}"));
+    TEST_ASSERT_TRUE(value(text, "wm_http_request_duration_seconds_sum{route=\"/status_json\"}") >= 0);
+
+    TEST_ASSERT_TRUE(value(text, "wm_heap_free_bytes") > 0);
+    TEST_ASSERT_TRUE(value(text, "wm_heap_largest_free_block_bytes") > 0);
+    TEST_ASSERT_EQUAL_FLOAT(0, value(text, "wm_websocket_clients"));
+    TEST_ASSERT_TRUE(value(text, "wm_softap_stations") >= 0);
+    TEST_ASSERT_TRUE(value(text, "wm_uptime_seconds") >= 0);
+
+    // The scan gauge appears once a scan has completed.
+    TEST_ASSERT_EQUAL_FLOAT(-1, value(text, "wm_wifi_scan_duration_seconds"));
+    TEST_ASSERT_TRUE(wifiManager->startScan());
+    while (wifiManager->isScanInProgress()) delay(10);
+    text = metrics();
+    double scan = value(text, "wm_wifi_scan_duration_seconds");
+    char line[64];
+    snprintf(line, sizeof(line), "simulated scan: %.3f s", scan);
+    TEST_MESSAGE(line);
+    TEST_ASSERT_TRUE(scan >= 0);
+}
+
+void test_bytes_match_what_clients_received() {
+    // The last one is a 400 with a JSON error body.
+    const char* paths[] = {"/params_json", "/status_json", "/fs/download?path=/asset.bin", "/fs/download"};
+    const char* routes[] = {"/params_json", "/status_json", "/fs/download", "/fs/download"};
+    for (size_t i = 0; i < 4; i++) {
+        std::string series = std::string("wm_http_response_bytes_total{route=\"") + routes[i] + "\"}";
+        double before = value(metrics(), series);
+        size_t received = 0;
+        for (int n = 0; n < 4; n++) received += NativeSim::httpGet(port, paths[i]).body.size();
+        double after = value(metrics(), series);
+        TEST_ASSERT_EQUAL_FLOAT(static_cast<double>(received), after - before);
+    }
+}
+
+void test_upload_latency_starts_at_first_chunk() {
+    static const char kBoundary[] = "----metricsBoundary";
+    std::string data(64 * 1024, 'm');
+    std::string form = std::string("--") + kBoundary +
+                       "\r\nContent-Disposition: form-data; name=\"file\"; filename=\"up.bin\"\r\n"
+                       "Content-Type: application/octet-stream\r\n\r\n" + data + "\r\n--" + kBoundary + "--\r\n";
+    std::string head = std::string("POST /fs/upload HTTP/1.1\r\nHost: localhost\r\nContent-Type: multipart/form-data; boundary=") +
+                       kBoundary + "\r\nContent-Length: " + std::to_string(form.size()) + "\r\n\r\n";
+
+    // Half the body, a 300 ms pause, then the rest: the pause is part of the request.
+    int fd = NativeSim::openSocket(port);
+    send(fd, head.data(), head.size(), 0);
+    send(fd, form.data(), form.size() / 2, 0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    send(fd, form.data() + form.size() / 2, form.size() - form.size() / 2, 0);
+    TEST_ASSERT_EQUAL(200, NativeSim::parseReply(NativeSim::receiveAll(fd)).status);
+
+    std::string text = metrics();
+    double sum = value(text, "wm_http_request_duration_seconds_sum{route=\"/fs/upload\"}");
+    char line[96];
+    snprintf(line, sizeof(line), "/fs/upload with a 300 ms stall: %.3f s recorded", sum);
+    TEST_MESSAGE(line);
+    TEST_ASSERT_TRUE(sum >= 0.3);
+    TEST_ASSERT_EQUAL_FLOAT(0, value(text, "wm_http_request_duration_seconds_bucket{route=\"/fs/upload\",le=\"0.25\"}"));
+    TEST_ASSERT_EQUAL_FLOAT(1, value(text, "wm_http_request_duration_seconds_bucket{route=\"/fs/upload\",le=\"+Inf\"}"));
+}
+
+void test_recording_cost_and_concurrency() {
+    static HttpMetrics m;
+    uint8_t route = m.addRoute("/bench");
+    const uint32_t kOps = 1000000;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < kOps; i++) m.record(route, i & 0xFFFFF, 200, 100);
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / kOps;
+    char line[96];
+    snprintf(line, sizeof(line), "record(): %.1f ns per request", ns);
+    TEST_MESSAGE(line);
+    TEST_ASSERT_LESS_THAN(1000, static_cast<int>(ns));
+
+    // Four writers and a scraper: no increment is lost, nothing blocks.
+    uint8_t shared = m.addRoute("/shared");
+    const uint32_t kPerThread = 200000;
+    std::vector<std::thread> writers;
+    for (int t = 0; t < 4; t++) {
+        writers.emplace_back([&m, shared, t] {
+            for (uint32_t i = 0; i < kPerThread; i++) m.record(shared, 700, (i % 10 == 0) ? 500 : 200, 3);
+        });
+    }
+    std::vector<HttpMetrics::RouteSnapshot> snap;
+    for (int i = 0; i < 100; i++) m.snapshot(snap);
+    for (auto& w : writers) w.join();
+    m.snapshot(snap);
+    TEST_ASSERT_EQUAL_UINT32(4 * kPerThread, snap[shared].requests);
+    TEST_ASSERT_EQUAL_UINT32(4 * kPerThread / 10, snap[shared].errors);
+    TEST_ASSERT_EQUAL_UINT32(4 * kPerThread * 3, snap[shared].bytes);
+    TEST_ASSERT_EQUAL_UINT32(4 * kPerThread, snap[shared].buckets[1]);  // 700 us: (0.5 ms, 1 ms]
+    TEST_ASSERT_EQUAL(route, m.addRoute("/bench"));
+
+    // 5000 s of handler time: past what 32 bits of microseconds hold.
+    uint8_t slow = m.addRoute("/slow");
+    for (int i = 0; i < 5000; i++) m.record(slow, 1000000, 200, 0);
+    m.snapshot(snap);
+    TEST_ASSERT_TRUE(snap[slow].sumMicros == 5000000000ULL);
+}
+
+int main(int argc, char** argv) {
+    char dir[] = "/tmp/wm-metrics-XXXXXX";
+    fsRoot = mkdtemp(dir);
+    NativeSim::setFilesystemRoot(fsRoot.c_str());
+    std::string asset(20000, 'a');
+    FILE* f = fopen((fsRoot + "/asset.bin").c_str(), "wb");
+    fwrite(asset.data(), 1, asset.size(), f);
+    fclose(f);
+
+    config.httpPort = 0;
+    wifiManager = new WiFiManager(config);
+    wifiManager->setDebugOutput(false);
+    wifiManager->begin();
+    port = NativeSim::lastBoundHttpPort();
+
+    UNITY_BEGIN();
+    RUN_TEST(test_exposition);
+    RUN_TEST(test_bytes_match_what_clients_received);
+    RUN_TEST(test_upload_latency_starts_at_first_chunk);
+    RUN_TEST(test_recording_cost_and_concurrency);
+    int result = UNITY_END();
+    delete wifiManager;
+    std::string cleanup = "rm -rf " + fsRoot;
+    system(cleanup.c_str());
+    return result;
+}
@@ -0,0 +1,151 @@
+#include <Arduino.h>
+#include <unity.h>
+#include <NativeSim.h>
+#include "WiFiManager.h"
+
+// Multi-credential selection on the virtual clock: one scan, RSSI/priority
+// ranking and BSSID/channel pinning, against the sequential per-credential
+// loop autoConnect used before. Times are simulated milliseconds, so the
+// numbers are identical on every run.
+
+WiFiManagerConfig config;
+
+// Two stored networks are out of range; the reachable ones are listed in the
+// order a user would typically have added them (weakest first).
+static const char* const kCredentials[][2] = {
+    {"Cabin", "cabinpass"},
+    {"Office", "officepass"},
+    {"Guest", "guestpass"},
+    {"HomeNetwork", "password123"},
+    {"Workshop", "tools"},
+};
+static const size_t kCredentialCount = sizeof(kCredentials) / sizeof(kCredentials[0]);
+
+static unsigned long legacyMs = 0;
+
+// The pre-ranking autoConnect loop: every credential in turn, each polled for
+// the full connectTimeout.
+static bool legacyAutoConnect() {
+    WiFi.mode(WIFI_STA);
+    for (size_t i = 0; i < kCredentialCount; i++) {
+        WiFi.begin(kCredentials[i][0], kCredentials[i][1]);
+        unsigned long startTime = millis();
+        while (WiFi.status() != WL_CONNECTED && (millis() - startTime) < config.connectTimeout) {
+            delay(500);
+        }
+        if (WiFi.status() == WL_CONNECTED) return true;
+    }
+    return false;
+}
+
+static WiFiManager* makeManager() {
+    WiFiManager* wm = new WiFiManager(config);
+    wm->setDebugOutput(false);
+    wm->begin();
+    return wm;
+}
+
+void setUp(void) {
+    // Forget the previous association so autoConnect does not start from it.
+    WiFi.disconnect(false, true);
+}
+
+void tearDown(void) {}
+
+void test_legacy_sequential_baseline() {
+    unsigned long start = millis();
+    TEST_ASSERT_TRUE(legacyAutoConnect());
+    legacyMs = millis() - start;
+    // First reachable entry in list order wins, however weak it is.
+    TEST_ASSERT_EQUAL_STRING("Guest", WiFi.SSID().c_str());
+    TEST_ASSERT_GREATER_OR_EQUAL(2 * config.connectTimeout, legacyMs);
+}
+
+void test_ranked_autoconnect_picks_strongest_bssid() {
+    WiFiManager* wm = makeManager();
+    for (size_t i = 0; i < kCredentialCount; i++) wm->addWiFiCredential(kCredentials[i][0], kCredentials[i][1]);
+    unsigned long start = millis();
+    TEST_ASSERT_TRUE(wm->autoConnect("test-ap"));
+    unsigned long rankedMs = millis() - start;
+
+    char line[128];
+    snprintf(line, sizeof(line), "time-to-connected: sequential %lu ms, ranked %lu ms (%lu ms in connect state machine)",
+             legacyMs, rankedMs, wm->getConnectDuration());
+    TEST_MESSAGE(line);
+
+    TEST_ASSERT_EQUAL_STRING("HomeNetwork", WiFi.SSID().c_str());
+    TEST_ASSERT_EQUAL(6, WiFi.channel());
+    TEST_ASSERT_EQUAL(-48, WiFi.RSSI());
+    TEST_ASSERT_TRUE(wm->getConnectState() == ConnectState::CONNECTED);
+    // One full scan plus a single pinned association.
+    const NativeSim::RadioTiming t = NativeSim::radioTiming();
+    unsigned long budget = t.channels * t.channelDwellMs + t.channelDwellMs + t.associateMs + t.dhcpMs + 100;
+    TEST_ASSERT_LESS_OR_EQUAL(budget, rankedMs);
+    TEST_ASSERT_LESS_THAN(legacyMs / 5, rankedMs);
+    delete wm;
+}
+
+void test_priority_beats_signal() {
+    WiFiManager* wm = makeManager();
+    wm->addWiFiCredential("HomeNetwork", "password123");
+    wm->addWiFiCredential("Workshop", "tools", 10);
+    TEST_ASSERT_TRUE(wm->autoConnect("test-ap"));
+    TEST_ASSERT_EQUAL_STRING("Workshop", WiFi.SSID().c_str());
+    TEST_ASSERT_EQUAL(9, WiFi.channel());
+    delete wm;
+}
+
+void test_rejected_candidate_falls_through_without_timeout() {
+    WiFiManager* wm = makeManager();
+    wm->addWiFiCredential("HomeNetwork", "wrong-password");
+    wm->addWiFiCredential("Workshop", "tools");
+    unsigned long start = millis();
+    TEST_ASSERT_TRUE(wm->autoConnect("test-ap"));
+    unsigned long elapsed = millis() - start;
+    TEST_ASSERT_EQUAL_STRING("Workshop", WiFi.SSID().c_str());
+    // The auth failure ends the first attempt long before connectTimeout.
+    TEST_ASSERT_LESS_THAN(config.connectTimeout, elapsed);
+    delete wm;
+}
+
+void test_web_connect_reuses_fresh_scan() {
+    WiFiManager* wm = makeManager();
+    wm->addWiFiCredential("HomeNetwork", "password123");
+    wm->addWiFiCredential("Guest", "guestpass");
+    TEST_ASSERT_TRUE(wm->autoConnect("test-ap"));
+    WiFi.disconnect(false, true);
+
+    // The cache from autoConnect is still fresh: the request is pinned and
+    // only pays for one channel dwell instead of walking up to channel 6.
+    TEST_ASSERT_TRUE(wm->beginConnect("HomeNetwork", "password123"));
+    unsigned long start = millis();
+    while (wm->getConnectState() == ConnectState::CONNECTING) {
+        wm->loop();
+        delay(10);
+    }
+    unsigned long elapsed = millis() - start;
+    const NativeSim::RadioTiming t = NativeSim::radioTiming();
+    TEST_ASSERT_TRUE(wm->getConnectState() == ConnectState::CONNECTED);
+    TEST_ASSERT_LESS_OR_EQUAL(t.channelDwellMs + t.associateMs + t.dhcpMs + 20, elapsed);
+    delete wm;
+}
+
+int main(int argc, char** argv) {
+    NativeSim::setClockMode(NativeSim::ClockMode::Virtual);
+    NativeSim::addAccessPoint("Guest", "guestpass", 1, -80);
+    NativeSim::addAccessPoint("HomeNetwork", "password123", 6, -48);
+    NativeSim::addAccessPoint("HomeNetwork", "password123", 11, -71);
+    NativeSim::addAccessPoint("Workshop", "tools", 9, -60);
+    config.httpPort = 0;
+    config.connectTimeout = 10000;
+    config.configPortalTimeout = 1000;
+    config.fastReconnect = false;  // measure ranking alone; see test_fast_reconnect
+
+    UNITY_BEGIN();
+    RUN_TEST(test_legacy_sequential_baseline);
+    RUN_TEST(test_ranked_autoconnect_picks_strongest_bssid);
+    RUN_TEST(test_priority_beats_signal);
+    RUN_TEST(test_rejected_candidate_falls_through_without_timeout);
+    RUN_TEST(test_web_connect_reuses_fresh_scan);
+    return UNITY_END();
+}
@@ -0,0 +1,271 @@
+#include <Arduino.h>
+#include <unity.h>
+#include <NativeSim.h>
+#include <NativeSimClient.h>
+#include <Update.h>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "WiFiManager.h"
+#include "WiFiManagerOta.h"
+
+// Streaming OTA: SHA-256 against the FIPS vectors, throughput of the engine
+// (hash + Update sink) on a multi-MB image, and /ota end to end — multipart
+// and raw uploads, digest mismatch, progress on /ws and bounded heap.
+
+WiFiManagerConfig config;
+WiFiManager* wifiManager = nullptr;
+uint16_t port = 0;
+std::string image;      // 4 MB firmware with the ESP image magic byte
+std::string imageSha;   // its SHA-256, hex
+
+static std::string hexDigest(const std::string& data, size_t chunk = 0) {
+    Sha256 sha;
+    if (!chunk) chunk = data.size() ? data.size() : 1;
+    for (size_t i = 0; i < data.size(); i += chunk) {
+        sha.update(reinterpret_cast<const uint8_t*>(data.data()) + i, std::min(chunk, data.size() - i));
+    }
+    uint8_t digest[Sha256::kDigestSize];
+    char hex[2 * Sha256::kDigestSize + 1];
+    sha.finish(digest);
+    Sha256::toHex(digest, hex);
+    return hex;
+}
+
+static std::string readFile(const char* path) {
+    std::ifstream in(path, std::ios::binary);
+    std::stringstream ss;
+    ss << in.rdbuf();
+    return ss.str();
+}
+
+static double mbPerSecond(size_t bytes, std::chrono::steady_clock::duration d) {
+    double s = std::chrono::duration<double>(d).count();
+    return s > 0 ? bytes / s / (1024.0 * 1024.0) : 0;
+}
+
+typedef NativeSim::HttpReply Reply;
+
+static Reply post(const std::string& head, const std::string& body) {
+    int fd = NativeSim::openSocket(port);
+    std::string req = head + "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n";
+    send(fd, req.data(), req.size(), 0);
+    for (size_t sent = 0; sent < body.size();) {
+        ssize_t n = send(fd, body.data() + sent, std::min<size_t>(65536, body.size() - sent), 0);
+        if (n <= 0) break;
+        sent += n;
+    }
+    return NativeSim::parseReply(NativeSim::receiveAll(fd));
+}
+
+static const char kBoundary[] = "----otaBoundary7MA4YWxk";
+
+static std::string multipartBody(const std::string& firmware) {
+    return std::string("--") + kBoundary +
+           "\r\nContent-Disposition: form-data; name=\"firmware\"; filename=\"fw.bin\"\r\n"
+           "Content-Type: application/octet-stream\r\n\r\n" +
+           firmware + "\r\n--" + kBoundary + "--\r\n";
+}
+
+static Reply postMultipartBody(const std::string& body, const std::string& digestHeader) {
+    std::string head = std::string("POST /ota HTTP/1.1\r\nHost: localhost\r\nContent-Type: multipart/form-data; boundary=") +
+                       kBoundary + "\r\n" + digestHeader;
+    return post(head, body);
+}
+
+static Reply postMultipart(const std::string& firmware, const std::string& digestHeader) {
+    return postMultipartBody(multipartBody(firmware), digestHeader);
+}
+
+// /ws listener collecting the {"type":"ota"} messages.
+struct WsClient {
+    int fd = -1;
+    std::string raw;
+    void open() {
+        fd = NativeSim::openWebSocket(port, "/ws");
+        TEST_ASSERT_TRUE(fd >= 0);
+    }
+    std::vector<std::string> otaMessages() {
+        std::vector<std::string> out;
+        char buf[4096];
+        for (int idle = 0; idle < 100; idle += 5) {
+            ssize_t n = recv(fd, buf, sizeof(buf), MSG_DONTWAIT);
+            if (n > 0) {
+                raw.append(buf, n);
+                idle = 0;
+            } else {
+                usleep(5000);
+            }
+        }
+        std::vector<std::string> messages;
+        NativeSim::takeTextFrames(raw, messages);
+        for (const std::string& msg : messages)
+            if (msg.find("\"type\":\"ota\"") != std::string::npos) out.push_back(msg);
+        return out;
+    }
+    void close() { ::close(fd); }
+};
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_sha256_known_answers() {
+    TEST_ASSERT_EQUAL_STRING("e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855", hexDigest("").c_str());
+    TEST_ASSERT_EQUAL_STRING("ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad", hexDigest("abc").c_str());
+    const std::string twoBlocks = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+    TEST_ASSERT_EQUAL_STRING("248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1",
+                             hexDigest(twoBlocks).c_str());
+    // Odd chunk sizes exercise the partial-block path.
+    const std::string million(1000000, 'a');
+    TEST_ASSERT_EQUAL_STRING("cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0",
+                             hexDigest(million, 997).c_str());
+    TEST_ASSERT_EQUAL_STRING(hexDigest(image).c_str(), hexDigest(image, 1460).c_str());
+
+    uint8_t parsed[Sha256::kDigestSize];
+    TEST_ASSERT_TRUE(Sha256::fromHex("BA7816BF8F01CFEA414140DE5DAE2223B00361A396177A9CB410FF61F20015AD", parsed));
+    TEST_ASSERT_EQUAL_HEX8(0xba, parsed[0]);
+    TEST_ASSERT_FALSE(Sha256::fromHex("ba7816bf", parsed));
+    TEST_ASSERT_FALSE(Sha256::fromHex("zz7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad", parsed));
+}
+
+void test_engine_throughput() {
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(image.data());
+    const size_t chunk = 1460;  // one TCP segment, as the upload callback delivers it
+
+    auto t0 = std::chrono::steady_clock::now();
+    {
+        Sha256 sha;
+        for (size_t i = 0; i < image.size(); i += chunk) sha.update(data + i, std::min(chunk, image.size() - i));
+        uint8_t digest[Sha256::kDigestSize];
+        sha.finish(digest);
+    }
+    auto hashOnly = std::chrono::steady_clock::now() - t0;
+
+    OtaUpdate ota;
+    t0 = std::chrono::steady_clock::now();
+    TEST_ASSERT_TRUE(ota.begin(UPDATE_SIZE_UNKNOWN, imageSha.c_str()));
+    for (size_t i = 0; i < image.size(); i += chunk) {
+        TEST_ASSERT_TRUE(ota.write(data + i, std::min(chunk, image.size() - i)));
+    }
+    TEST_ASSERT_TRUE(ota.end());
+    auto engine = std::chrono::steady_clock::now() - t0;
+
+    char line[160];
+    snprintf(line, sizeof(line), "%u KB image in %u B chunks: SHA-256 %.1f MB/s, hash + Update sink %.1f MB/s",
+             static_cast<unsigned>(image.size() / 1024), static_cast<unsigned>(chunk),
+             mbPerSecond(image.size(), hashOnly), mbPerSecond(image.size(), engine));
+    TEST_MESSAGE(line);
+    TEST_ASSERT_EQUAL_STRING(imageSha.c_str(), ota.digest());
+    TEST_ASSERT_EQUAL(image.size(), ota.written());
+    TEST_ASSERT_TRUE(readFile(NativeSim::otaImagePath()) == image);
+}
+
+void test_upload_streams_to_flash() {
+    unlink(NativeSim::otaImagePath());
+    WsClient ws;
+    ws.open();
+    ws.otaMessages();
+
+    // Built up front so only the server side is measured.
+    const std::string body = multipartBody(image);
+    const std::string digestHeader = "X-SHA256: " + imageSha + "\r\n";
+    NativeSim::resetHeapPeak();
+    size_t liveBefore = NativeSim::heapStats().liveBytes;
+    auto t0 = std::chrono::steady_clock::now();
+    Reply r = postMultipartBody(body, digestHeader);
+    auto elapsed = std::chrono::steady_clock::now() - t0;
+    size_t peakGrowth = NativeSim::heapStats().peakLiveBytes - liveBefore;
+
+    TEST_ASSERT_EQUAL(200, r.status);
+    TEST_ASSERT_TRUE(r.body.find("\"result\":\"ok\"") != std::string::npos);
+    TEST_ASSERT_TRUE(r.body.find("\"sha256\":\"" + imageSha + "\"") != std::string::npos);
+    TEST_ASSERT_TRUE(r.body.find("\"bytes\":" + std::to_string(image.size())) != std::string::npos);
+    TEST_ASSERT_TRUE(r.body.find("\"reboot\":false") != std::string::npos);
+    TEST_ASSERT_TRUE(readFile(NativeSim::otaImagePath()) == image);
+
+    std::vector<std::string> progress = ws.otaMessages();
+    ws.close();
+    TEST_ASSERT_GREATER_OR_EQUAL(2, progress.size());
+    TEST_ASSERT_TRUE(progress.front().find("\"state\":\"writing\"") != std::string::npos);
+    TEST_ASSERT_TRUE(progress.back().find("\"state\":\"done\"") != std::string::npos);
+    TEST_ASSERT_TRUE(progress.back().find(imageSha) != std::string::npos);
+
+    char line[160];
+    snprintf(line, sizeof(line), "POST /ota %u KB: %.1f MB/s end to end, %u progress messages, peak heap growth %u B",
+             static_cast<unsigned>(image.size() / 1024), mbPerSecond(image.size(), elapsed),
+             static_cast<unsigned>(progress.size()), static_cast<unsigned>(peakGrowth));
+    TEST_MESSAGE(line);
+    // The image is never held in RAM.
+    TEST_ASSERT_LESS_THAN(64 * 1024, peakGrowth);
+}
+
+void test_digest_mismatch_keeps_running_image() {
+    std::string before = readFile(NativeSim::otaImagePath());
+    std::string tampered = image;
+    tampered[tampered.size() / 2] ^= 0x01;
+    Reply r = postMultipart(tampered, "X-SHA256: " + imageSha + "\r\n");
+    TEST_ASSERT_EQUAL(400, r.status);
+    TEST_ASSERT_TRUE(r.body.find("SHA-256 mismatch") != std::string::npos);
+    TEST_ASSERT_TRUE(readFile(NativeSim::otaImagePath()) == before);
+
+    Reply bad = postMultipart(image, "X-SHA256: not-a-digest\r\n");
+    TEST_ASSERT_EQUAL(400, bad.status);
+    TEST_ASSERT_TRUE(bad.body.find("Invalid SHA-256 digest") != std::string::npos);
+}
+
+void test_raw_body_and_flash_errors() {
+    // Raw body with the size known up front; the digest is optional.
+    std::string small = image.substr(0, 300000);
+    Reply r = post("POST /ota HTTP/1.1\r\nHost: localhost\r\nContent-Type: application/octet-stream\r\n", small);
+    TEST_ASSERT_EQUAL(200, r.status);
+    TEST_ASSERT_TRUE(r.body.find(hexDigest(small)) != std::string::npos);
+    TEST_ASSERT_TRUE(readFile(NativeSim::otaImagePath()) == small);
+
+    std::string notFirmware(8192, '\0');
+    Reply magic = post("POST /ota HTTP/1.1\r\nHost: localhost\r\nContent-Type: application/octet-stream\r\n",
+                       notFirmware);
+    TEST_ASSERT_EQUAL(500, magic.status);
+    TEST_ASSERT_TRUE(magic.body.find("Wrong Magic Byte") != std::string::npos);
+
+    std::string huge(NativeSim::otaPartitionSize() + 4096, '\xE9');
+    Reply space = postMultipart(huge, "");
+    TEST_ASSERT_EQUAL(500, space.status);
+    TEST_ASSERT_TRUE(readFile(NativeSim::otaImagePath()) == small);
+
+    Reply empty = post("POST /ota HTTP/1.1\r\nHost: localhost\r\n", "");
+    TEST_ASSERT_EQUAL(400, empty.status);
+}
+
+int main(int argc, char** argv) {
+    NativeSim::setFlashTiming(NativeSim::FlashTiming{0, 0});
+    NativeSim::setOtaPartitionSize(6 * 1024 * 1024);
+    image.resize(4 * 1024 * 1024);
+    uint32_t x = 2463534242u;
+    for (char& c : image) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        c = static_cast<char>(x);
+    }
+    image[0] = static_cast<char>(ESP_IMAGE_HEADER_MAGIC);
+    imageSha = hexDigest(image);
+
+    config.httpPort = 0;
+    config.rebootAfterOTA = false;
+    wifiManager = new WiFiManager(config);
+    wifiManager->setDebugOutput(false);
+    wifiManager->begin();
+    port = NativeSim::lastBoundHttpPort();
+
+    UNITY_BEGIN();
+    RUN_TEST(test_sha256_known_answers);
+    RUN_TEST(test_engine_throughput);
+    RUN_TEST(test_upload_streams_to_flash);
+    RUN_TEST(test_digest_mismatch_keeps_running_image);
+    RUN_TEST(test_raw_body_and_flash_errors);
+    unlink(NativeSim::otaImagePath());
+    return UNITY_END();
+}
@@ -0,0 +1,194 @@
+#include <Arduino.h>
+#include <unity.h>
+#include <NativeSim.h>
+#include <NativeSimClient.h>
+#include <chrono>
+#include <string>
+#include "WiFiManager.h"
+
+// Parameter registry: id lookups, duplicate rejection, POST /update_params
+// at 10, 100 and 500 parameters against the former per-parameter
+// hasParam/getParam scan, served side by side, and /params_json staying one
+// consistent document while values change under a slow reader.
+
+WiFiManagerConfig config;
+WiFiManager* wifiManager = nullptr;
+AsyncWebServer* legacyServer = nullptr;
+uint16_t managerPort = 0;
+uint16_t legacyPort = 0;
+
+static const size_t kMaxParams = 500;
+
+// Reference implementation of handleUpdateParams before the registry.
+static void legacyUpdateParams(AsyncWebServerRequest* request) {
+    std::vector<WiFiManagerParameter*> params = wifiManager->getParameters();
+    bool updated = false;
+    for (size_t i = 0; i < params.size(); i++) {
+        if (request->hasParam(params[i]->getID(), true)) {
+            String newValue = request->getParam(params[i]->getID(), true)->value();
+            params[i]->setValue(newValue.c_str());
+            updated = true;
+        }
+    }
+    if (updated)
+        request->send(200, "application/json", "{\"result\":\"Custom fields updated\"}");
+    else
+        request->send(400, "application/json", "{\"error\":\"No parameters updated\"}");
+}
+
+static int post(uint16_t port, const std::string& form) {
+    std::string req = "POST /update_params HTTP/1.1\r\nHost: localhost\r\n"
+                      "Content-Type: application/x-www-form-urlencoded\r\nContent-Length: " +
+                      std::to_string(form.size()) + "\r\n\r\n" + form;
+    return NativeSim::httpRequest(port, req).status;
+}
+
+static const char* paramId(size_t i) {
+    static char ids[kMaxParams][24];
+    snprintf(ids[i], sizeof(ids[i]), "device_setting_%03u", static_cast<unsigned>(i));
+    return ids[i];
+}
+
+static void addParams(size_t total) {
+    for (size_t i = wifiManager->getParameters().size(); i < total; i++) {
+        TEST_ASSERT_TRUE(wifiManager->addParameter(new WiFiManagerParameter(paramId(i), "Setting", "initial", 40)));
+    }
+}
+
+// Every parameter submitted, as the portal form does.
+static std::string fullForm(size_t count, int round) {
+    std::string form;
+    for (size_t i = 0; i < count; i++) {
+        if (i) form += '&';
+        form += std::string(paramId(i)) + "=value-" + std::to_string(round) + "-" + std::to_string(i);
+    }
+    return form;
+}
+
+struct Sample {
+    double usPerRequest;
+    uint64_t allocations;
+};
+
+static Sample measure(uint16_t port, size_t count) {
+    const int rounds = count >= 500 ? 10 : 40;
+    std::vector<std::string> forms;
+    for (int r = 0; r < rounds; r++) forms.push_back(fullForm(count, r));
+    TEST_ASSERT_EQUAL(200, post(port, fullForm(count, -1)));  // warm-up
+    delay(20);
+    NativeSim::HeapStats before = NativeSim::heapStats();
+    auto t0 = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; r++) TEST_ASSERT_EQUAL(200, post(port, forms[r]));
+    auto elapsed = std::chrono::steady_clock::now() - t0;
+    delay(20);
+    NativeSim::HeapStats after = NativeSim::heapStats();
+    TEST_ASSERT_EQUAL_STRING(("value-" + std::to_string(rounds - 1) + "-" + std::to_string(count - 1)).c_str(),
+                             wifiManager->getParameter(paramId(count - 1))->getValue());
+    return Sample{std::chrono::duration<double, std::micro>(elapsed).count() / rounds,
+                  (after.allocations - before.allocations) / rounds};
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_lookup_and_duplicates() {
+    ParamRegistry registry;
+    static char ids[300][12];
+    for (int i = 0; i < 300; i++) {
+        snprintf(ids[i], sizeof(ids[i]), "p%d", i);
+        TEST_ASSERT_TRUE(registry.add(new WiFiManagerParameter(ids[i], "P", "", 8)));
+    }
+    for (int i = 0; i < 300; i++) TEST_ASSERT_EQUAL_STRING(ids[i], registry.find(String(ids[i]))->getID());
+    TEST_ASSERT_NULL(registry.find(String("p300")));
+    TEST_ASSERT_NULL(registry.find("p1", 1));  // "p" is a prefix of every id, not an id
+    TEST_ASSERT_EQUAL_STRING("p1", registry.find("p10", 2)->getID());
+    // Registration order is kept for rendering.
+    TEST_ASSERT_EQUAL_STRING("p0", registry[0]->getID());
+    TEST_ASSERT_EQUAL_STRING("p299", registry[299]->getID());
+
+    WiFiManagerParameter duplicate("p42", "Again", "", 8);
+    TEST_ASSERT_FALSE(registry.add(&duplicate));
+    TEST_ASSERT_FALSE(registry.add(nullptr));
+    TEST_ASSERT_EQUAL(300, registry.size());
+    for (auto* param : registry) delete param;
+}
+
+void test_update_ignores_unknown_fields() {
+    addParams(3);
+    TEST_ASSERT_EQUAL(200, post(managerPort, "ssid=x&device_setting_001=changed&csrf=1"));
+    TEST_ASSERT_EQUAL_STRING("changed", wifiManager->getParameter("device_setting_001")->getValue());
+    TEST_ASSERT_EQUAL_STRING("initial", wifiManager->getParameter("device_setting_002")->getValue());
+    TEST_ASSERT_EQUAL(400, post(managerPort, "ssid=x&other=y"));
+    TEST_ASSERT_NULL(wifiManager->getParameter("ssid"));
+    WiFiManagerParameter duplicate("device_setting_000", "Again", "", 8);
+    TEST_ASSERT_FALSE(wifiManager->addParameter(&duplicate));
+    TEST_ASSERT_EQUAL(3, wifiManager->getParameters().size());
+}
+
+void test_update_scales_with_fields() {
+    char line[160];
+    const size_t counts[] = {10, 100, 500};
+    Sample indexed[3];
+    Sample legacy[3];
+    for (int i = 0; i < 3; i++) {
+        addParams(counts[i]);
+        legacy[i] = measure(legacyPort, counts[i]);
+        indexed[i] = measure(managerPort, counts[i]);
+        snprintf(line, sizeof(line), "params=%3u  legacy: %8.1f us %6llu allocs   indexed: %7.1f us %5llu allocs",
+                 static_cast<unsigned>(counts[i]), legacy[i].usPerRequest,
+                 static_cast<unsigned long long>(legacy[i].allocations), indexed[i].usPerRequest,
+                 static_cast<unsigned long long>(indexed[i].allocations));
+        TEST_MESSAGE(line);
+    }
+    // The scan grows with params x fields; the registry with fields only.
+    TEST_ASSERT_LESS_THAN(legacy[2].usPerRequest / 3, indexed[2].usPerRequest);
+    TEST_ASSERT_LESS_OR_EQUAL(legacy[2].allocations, indexed[2].allocations);
+}
+
+void test_params_json_is_one_snapshot() {
+    addParams(kMaxParams);
+    for (size_t i = 0; i < kMaxParams; i++) wifiManager->getParameter(paramId(i))->setValue("before");
+    int fd = NativeSim::openSocket(managerPort, nullptr, 2048);
+    std::string req = "GET /params_json HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    send(fd, req.data(), req.size(), 0);
+    std::string raw;
+    char buf[512];
+    ssize_t n = recv(fd, buf, sizeof(buf), 0);
+    if (n > 0) raw.append(buf, n);
+    // Longer values, changed while most of the document is still unsent.
+    for (size_t i = 0; i < kMaxParams; i++)
+        wifiManager->getParameter(paramId(i))->setValue("after-a-much-longer-value");
+    while ((n = recv(fd, buf, sizeof(buf), 0)) > 0) raw.append(buf, n);
+    close(fd);
+
+    std::string body = NativeSim::parseReply(raw).body;
+    size_t rows = 0;
+    for (size_t pos = 0; (pos = body.find("{\"id\":\"device_setting_", pos)) != std::string::npos; pos++) rows++;
+    TEST_ASSERT_EQUAL(kMaxParams, rows);
+    TEST_ASSERT_EQUAL('[', body.front());
+    TEST_ASSERT_EQUAL_STRING("}]", body.substr(body.size() - 2).c_str());
+    TEST_ASSERT_TRUE(body.find("after-") == std::string::npos);
+    std::string last = std::string("{\"id\":\"") + paramId(kMaxParams - 1) + "\",\"label\":\"Setting\",\"value\":\"before\"";
+    TEST_ASSERT_TRUE(body.find(last) != std::string::npos);
+}
+
+int main(int argc, char** argv) {
+    config.httpPort = 0;
+    wifiManager = new WiFiManager(config);
+    wifiManager->setDebugOutput(false);
+    wifiManager->begin();
+    managerPort = NativeSim::lastBoundHttpPort();
+
+    legacyServer = new AsyncWebServer(0);
+    legacyServer->on("/update_params", HTTP_POST, legacyUpdateParams);
+    legacyServer->begin();
+    legacyPort = NativeSim::lastBoundHttpPort();
+
+    UNITY_BEGIN();
+    RUN_TEST(test_lookup_and_duplicates);
+    RUN_TEST(test_update_ignores_unknown_fields);
+    RUN_TEST(test_update_scales_with_fields);
+    RUN_TEST(test_params_json_is_one_snapshot);
+    return UNITY_END();
+}
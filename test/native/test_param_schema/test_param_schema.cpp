@@ -0,0 +1,145 @@
+#include <Arduino.h>
+#include <unity.h>
+#include <NativeSim.h>
+#include <NativeSimClient.h>
+#include <string>
+#include "WiFiManager.h"
+
+// Compile-time parameter schema: limits enforced from the flash table, values
+// served and updated through the portal like any other parameter, and the
+// RAM of a 120-field configuration against the same fields built at runtime.
+
+#define FIELD(g, i) textParam("field_" #g #i, "Field " #g "." #i, 32, "default-value", "Group " #g)
+#define GROUP(g) FIELD(g, 0), FIELD(g, 1), FIELD(g, 2), FIELD(g, 3), FIELD(g, 4), \
+                 FIELD(g, 5), FIELD(g, 6), FIELD(g, 7), FIELD(g, 8), FIELD(g, 9)
+
+static constexpr ParamSpec kSchema[] = {
+    numberParam("mqtt_port", "MQTT Port", 1, 65535, "1883", "MQTT"),
+    toggleParam("mqtt_tls", "Use TLS", true, "MQTT"),
+    typedParam("accent", "Accent", ParameterType::COLOR, 7, "#2196F3"),
+    GROUP(0), GROUP(1), GROUP(2), GROUP(3), GROUP(4), GROUP(5),
+    GROUP(6), GROUP(7), GROUP(8), GROUP(9), GROUP(10), GROUP(11),
+};
+static const size_t kFields = schemaSize(kSchema);
+
+// Sized by the compiler; no code runs to lay out the table.
+static_assert(schemaSize(kSchema) == 123, "schema size");
+static_assert(schemaValueBytes(kSchema) == 12 + 6 + 8 + 120 * 33, "value bytes");
+
+static ParamBlock<schemaSize(kSchema), schemaValueBytes(kSchema)> params(kSchema);
+
+WiFiManagerConfig config;
+WiFiManager* wifiManager = nullptr;
+uint16_t port = 0;
+bool added = false;
+
+static std::string request(const std::string& req) {
+    return NativeSim::exchange(port, req);
+}
+
+static std::string postParams(const std::string& form) {
+    return request("POST /update_params HTTP/1.1\r\nHost: localhost\r\nContent-Type: application/x-www-form-urlencoded\r\n"
+                   "Content-Length: " + std::to_string(form.size()) + "\r\n\r\n" + form);
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_schema_limits() {
+    WiFiManagerParameter* mqttPort = params[0];
+    TEST_ASSERT_TRUE(mqttPort->isSchemaBacked());
+    TEST_ASSERT_EQUAL_STRING("1883", mqttPort->getValue());
+    TEST_ASSERT_EQUAL_STRING("MQTT", mqttPort->getGroup());
+    TEST_ASSERT_TRUE(mqttPort->accepts("65535"));
+    TEST_ASSERT_FALSE(mqttPort->accepts("0"));
+    TEST_ASSERT_FALSE(mqttPort->accepts("70000"));
+    TEST_ASSERT_FALSE(mqttPort->accepts("12a"));
+    TEST_ASSERT_FALSE(mqttPort->accepts(""));
+
+    TEST_ASSERT_EQUAL_STRING("true", params[1]->getValue());
+    TEST_ASSERT_FALSE(params[1]->accepts("yes"));
+    TEST_ASSERT_FALSE(params[2]->accepts("#12345678"));
+
+    // Values never outgrow their buffer.
+    WiFiManagerParameter* field = params[3];
+    std::string longest(32, 'x');
+    field->setValue(longest.c_str());
+    TEST_ASSERT_EQUAL_STRING(longest.c_str(), field->getValue());
+    field->setValue((longest + "y").c_str());
+    TEST_ASSERT_EQUAL_STRING(longest.c_str(), field->getValue());
+    TEST_ASSERT_EQUAL_STRING("default-value", params[4]->getValue());
+
+    // A validator or attributes set at runtime override the table.
+    field->setValidation([](const char* value) { return value[0] == 'v'; });
+    TEST_ASSERT_FALSE(field->accepts("x"));
+    TEST_ASSERT_TRUE(field->accepts("valid"));
+    field->setCustomAttributes("required");
+    TEST_ASSERT_EQUAL_STRING("required", field->getCustomAttributes());
+    TEST_ASSERT_EQUAL_STRING("field_00", field->getID());
+}
+
+void test_served_through_portal() {
+    TEST_ASSERT_TRUE(added);
+    TEST_ASSERT_EQUAL(kFields, wifiManager->getParameters().size());
+    std::string reply = postParams("mqtt_port=8883&field_57=from-portal&mqtt_tls=maybe");
+    TEST_ASSERT_TRUE(reply.find("200 OK") != std::string::npos);
+    TEST_ASSERT_EQUAL_STRING("8883", wifiManager->getParameter("mqtt_port")->getValue());
+    TEST_ASSERT_EQUAL_STRING("from-portal", wifiManager->getParameter("field_57")->getValue());
+    TEST_ASSERT_EQUAL_STRING("true", wifiManager->getParameter("mqtt_tls")->getValue());
+
+    postParams("mqtt_port=99999");
+    TEST_ASSERT_EQUAL_STRING("8883", wifiManager->getParameter("mqtt_port")->getValue());
+
+    std::string json = request("GET /params_json HTTP/1.1\r\nHost: localhost\r\n\r\n");
+    TEST_ASSERT_TRUE(json.find("{\"id\":\"field_57\",\"label\":\"Field 5.7\",\"value\":\"from-portal\"") != std::string::npos);
+    TEST_ASSERT_TRUE(json.find("\"group\":\"Group 11\"") != std::string::npos);
+}
+
+void test_ram_against_runtime_parameters() {
+    // The same fields, built the way a sketch did before schemas existed.
+    NativeSim::HeapStats before = NativeSim::heapStats();
+    std::vector<WiFiManagerParameter*> runtime;
+    for (const ParamSpec& spec : kSchema) {
+        runtime.push_back(spec.type == ParameterType::TEXT
+            ? new WiFiManagerParameter(spec.id, spec.label, spec.defaultValue, spec.length, "", 1, spec.group)
+            : new WiFiManagerParameter(spec.id, spec.label, spec.defaultValue, spec.type, spec.attributes, spec.group));
+    }
+    NativeSim::HeapStats after = NativeSim::heapStats();
+    size_t runtimeBytes = after.liveBytes - before.liveBytes;
+    uint64_t runtimeAllocs = after.allocations - before.allocations;
+    for (auto* param : runtime) delete param;
+
+    // The schema block lives in .bss and allocated nothing when it was built.
+    size_t schemaBytes = sizeof(params);
+    char line[200];
+    snprintf(line, sizeof(line),
+             "%u fields: runtime-built %u B heap in %llu allocations; schema %u B static (%u B values), 0 B heap",
+             static_cast<unsigned>(kFields), static_cast<unsigned>(runtimeBytes),
+             static_cast<unsigned long long>(runtimeAllocs), static_cast<unsigned>(schemaBytes),
+             static_cast<unsigned>(schemaValueBytes(kSchema)));
+    TEST_MESSAGE(line);
+    snprintf(line, sizeof(line), "per parameter: %u B object for schema, %u B object + %u B owned strings at runtime",
+             static_cast<unsigned>(sizeof(WiFiManagerParameter)), static_cast<unsigned>(sizeof(WiFiManagerParameter)),
+             static_cast<unsigned>((runtimeBytes - kFields * sizeof(WiFiManagerParameter)) / kFields));
+    TEST_MESSAGE(line);
+    TEST_ASSERT_LESS_THAN(runtimeBytes / 2, schemaBytes);
+    TEST_ASSERT_GREATER_OR_EQUAL(3 * kFields, runtimeAllocs);
+}
+
+int main(int argc, char** argv) {
+    config.httpPort = 0;
+    wifiManager = new WiFiManager(config);
+    wifiManager->setDebugOutput(false);
+    added = wifiManager->addParameters(params);
+    wifiManager->begin();
+    port = NativeSim::lastBoundHttpPort();
+
+    UNITY_BEGIN();
+    RUN_TEST(test_schema_limits);
+    RUN_TEST(test_served_through_portal);
+    RUN_TEST(test_ram_against_runtime_parameters);
+    int result = UNITY_END();
+    delete wifiManager;  // must leave the block's parameters alone
+    return result;
+}
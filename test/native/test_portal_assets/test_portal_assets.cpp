@@ -0,0 +1,134 @@
+#include <Arduino.h>
+#include <unity.h>
+#include <NativeSim.h>
+#include <NativeSimClient.h>
+#include <string>
+#include "WiFiManager.h"
+#include "WiFiManagerAssets.h"
+
+// Serving of the pipeline output (scripts/build_assets.py): .gz variants with
+// Content-Encoding, strong ETags from the gzip trailer, immutable caching for
+// content-hashed names and 304 on revalidation.
+
+WiFiManagerConfig config;
+WiFiManager* wifiManager = nullptr;
+uint16_t port = 0;
+char fsRoot[] = "/tmp/wm-assets-XXXXXX";
+
+static uint32_t crc32(const uint8_t* data, size_t len) {
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (int k = 0; k < 8; k++) crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+    }
+    return ~crc;
+}
+
+// A gzip member with one stored deflate block, enough for the server side.
+static std::string gzipStored(const std::string& content) {
+    std::string out("\x1f\x8b\x08\x00\x00\x00\x00\x00\x02\xff", 10);
+    uint16_t len = static_cast<uint16_t>(content.size());
+    out += '\x01';
+    out += static_cast<char>(len & 0xFF);
+    out += static_cast<char>(len >> 8);
+    out += static_cast<char>(~len & 0xFF);
+    out += static_cast<char>((~len >> 8) & 0xFF);
+    out += content;
+    uint32_t crc = crc32(reinterpret_cast<const uint8_t*>(content.data()), content.size());
+    uint32_t size = static_cast<uint32_t>(content.size());
+    for (int i = 0; i < 4; i++) out += static_cast<char>((crc >> (8 * i)) & 0xFF);
+    for (int i = 0; i < 4; i++) out += static_cast<char>((size >> (8 * i)) & 0xFF);
+    return out;
+}
+
+static void writeFile(const char* name, const std::string& data) {
+    std::string path = std::string(fsRoot) + "/" + name;
+    FILE* f = fopen(path.c_str(), "wb");
+    fwrite(data.data(), 1, data.size(), f);
+    fclose(f);
+}
+
+typedef NativeSim::HttpReply Reply;
+
+static Reply get(const char* path, const std::string& extraHeaders = "") {
+    return NativeSim::httpGet(port, path, extraHeaders);
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_fingerprint_detection() {
+    TEST_ASSERT_TRUE(isFingerprintedAsset("/style.1ce633e8.css"));
+    TEST_ASSERT_TRUE(isFingerprintedAsset("/script.2013e97c.js"));
+    TEST_ASSERT_FALSE(isFingerprintedAsset("/style.css"));
+    TEST_ASSERT_FALSE(isFingerprintedAsset("/index.html"));
+    TEST_ASSERT_FALSE(isFingerprintedAsset("/style.1CE633E8.css"));
+    TEST_ASSERT_FALSE(isFingerprintedAsset("/a.1ce633e.css"));
+}
+
+void test_hashed_asset_is_gzip_immutable_with_etag() {
+    std::string gz = gzipStored("body{color:red}");
+    writeFile("style.1ce633e8.css.gz", gz);
+    Reply r = get("/style.1ce633e8.css");
+    TEST_ASSERT_EQUAL(200, r.status);
+    TEST_ASSERT_EQUAL_STRING("gzip", r.header("Content-Encoding").c_str());
+    TEST_ASSERT_EQUAL_STRING("text/css", r.header("Content-Type").c_str());
+    TEST_ASSERT_EQUAL_STRING("public, max-age=31536000, immutable", r.header("Cache-Control").c_str());
+    char expected[24];
+    snprintf(expected, sizeof(expected), "\"%08x-%08x\"", crc32(reinterpret_cast<const uint8_t*>("body{color:red}"), 15), 15u);
+    TEST_ASSERT_EQUAL_STRING(expected, r.header("ETag").c_str());
+    TEST_ASSERT_TRUE(r.body == gz);
+}
+
+void test_revalidation_answers_304_without_body() {
+    Reply first = get("/style.1ce633e8.css");
+    std::string etag = first.header("ETag");
+    Reply again = get("/style.1ce633e8.css", "If-None-Match: " + etag + "\r\n");
+    TEST_ASSERT_EQUAL(304, again.status);
+    TEST_ASSERT_EQUAL_STRING(etag.c_str(), again.header("ETag").c_str());
+    TEST_ASSERT_EQUAL(0, again.body.size());
+
+    Reply stale = get("/style.1ce633e8.css", "If-None-Match: \"00000000-00000000\"\r\n");
+    TEST_ASSERT_EQUAL(200, stale.status);
+}
+
+void test_root_page_served_from_gzip_and_revalidated() {
+    writeFile("index.html.gz", gzipStored("<html><body>portal</body></html>"));
+    Reply r = get("/");
+    TEST_ASSERT_EQUAL(200, r.status);
+    TEST_ASSERT_EQUAL_STRING("gzip", r.header("Content-Encoding").c_str());
+    TEST_ASSERT_EQUAL_STRING("text/html", r.header("Content-Type").c_str());
+    TEST_ASSERT_EQUAL_STRING("no-cache", r.header("Cache-Control").c_str());
+    Reply again = get("/", "If-None-Match: " + r.header("ETag") + "\r\n");
+    TEST_ASSERT_EQUAL(304, again.status);
+}
+
+void test_plain_file_still_served() {
+    writeFile("notes.txt", "hello");
+    Reply r = get("/notes.txt");
+    TEST_ASSERT_EQUAL(200, r.status);
+    TEST_ASSERT_EQUAL_STRING("", r.header("Content-Encoding").c_str());
+    // No content hash to go by: size and mtime.
+    TEST_ASSERT_EQUAL_STRING("\"5-", r.header("ETag").substr(0, 3).c_str());
+    TEST_ASSERT_EQUAL_STRING("hello", r.body.c_str());
+    TEST_ASSERT_EQUAL(404, get("/missing.js").status);
+}
+
+int main(int argc, char** argv) {
+    if (!mkdtemp(fsRoot)) return 1;
+    NativeSim::setFilesystemRoot(fsRoot);
+    config.httpPort = 0;
+    wifiManager = new WiFiManager(config);
+    wifiManager->setDebugOutput(false);
+    wifiManager->begin();
+    port = NativeSim::lastBoundHttpPort();
+
+    UNITY_BEGIN();
+    RUN_TEST(test_fingerprint_detection);
+    RUN_TEST(test_hashed_asset_is_gzip_immutable_with_etag);
+    RUN_TEST(test_revalidation_answers_304_without_body);
+    RUN_TEST(test_root_page_served_from_gzip_and_revalidated);
+    RUN_TEST(test_plain_file_still_served);
+    return UNITY_END();
+}
@@ -0,0 +1,155 @@
+#include <Arduino.h>
+#include <unity.h>
+#include <NativeSim.h>
+#include <NativeSimClient.h>
+#include <string>
+#include "WiFiManager.h"
+
+// Per-request arenas: pool accounting (exhaustion, heap fallback, high water,
+// destructors on release), and the heap traffic of the JSON handlers with
+// arenas leased against the same handlers without.
+
+WiFiManagerConfig config;
+WiFiManager* pooled = nullptr;
+WiFiManager* plain = nullptr;
+uint16_t pooledPort = 0;
+uint16_t plainPort = 0;
+
+// Heap allocations made while serving `rounds` requests for `path`.
+static uint64_t allocationsFor(uint16_t port, const char* path, int rounds) {
+    NativeSim::httpGetDiscard(port, path);  // warm caches
+    delay(5);
+    NativeSim::HeapStats before = NativeSim::heapStats();
+    for (int i = 0; i < rounds; i++) {
+        TEST_ASSERT_EQUAL(200, NativeSim::httpGetDiscard(port, path));
+        delay(5);  // let the server finish tearing the request down
+    }
+    return (NativeSim::heapStats().allocations - before.allocations) / rounds;
+}
+
+struct Tracked {
+    static int live;
+    char payload[40];
+    Tracked() { live++; }
+    ~Tracked() { live--; }
+};
+int Tracked::live = 0;
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_pool_accounting() {
+    ArenaPool pool;
+    TEST_ASSERT_FALSE(pool.enabled());
+    pool.begin(2, 256);
+    TEST_ASSERT_TRUE(pool.enabled());
+
+    RequestArena* a = pool.acquire();
+    RequestArena* b = pool.acquire();
+    TEST_ASSERT_NOT_NULL(a);
+    TEST_ASSERT_NOT_NULL(b);
+    TEST_ASSERT_TRUE(a != b);
+    TEST_ASSERT_EQUAL(256, a->capacity());
+
+    // Every arena busy: the third request still gets one, from the heap.
+    RequestArena* c = pool.acquire();
+    TEST_ASSERT_NOT_NULL(c);
+    TEST_ASSERT_NOT_NULL(c->make<Tracked>());
+    pool.release(c);
+    TEST_ASSERT_EQUAL(0, Tracked::live);
+
+    // Objects run their destructors on release; what does not fit spills to the heap.
+    TEST_ASSERT_NOT_NULL(a->make<Tracked>());
+    TEST_ASSERT_NOT_NULL(a->make<Tracked>());
+    TEST_ASSERT_NOT_NULL(a->allocate(100));
+    size_t used = a->used();
+    TEST_ASSERT_NOT_NULL(a->allocate(512));
+    TEST_ASSERT_EQUAL(used, a->used());
+    TEST_ASSERT_EQUAL(2, Tracked::live);
+
+    ArenaStats stats = pool.stats();
+    TEST_ASSERT_EQUAL(2, stats.leases);
+    TEST_ASSERT_EQUAL(2, stats.inUse);
+    TEST_ASSERT_EQUAL(1, stats.exhausted);
+    TEST_ASSERT_EQUAL(3, stats.fallbacks);  // the transient arena's object and its cleanup, then the 512 bytes
+    TEST_ASSERT_GREATER_OR_EQUAL(512 + sizeof(Tracked), stats.fallbackBytes);
+
+    pool.release(a);
+    pool.release(b);
+    TEST_ASSERT_EQUAL(0, Tracked::live);
+    stats = pool.stats();
+    TEST_ASSERT_EQUAL(0, stats.inUse);
+    TEST_ASSERT_EQUAL(used, stats.highWater);
+
+    // A released arena is reset and handed out again.
+    RequestArena* again = pool.acquire();
+    TEST_ASSERT_TRUE(again == a || again == b);
+    TEST_ASSERT_EQUAL(0, again->used());
+    pool.release(again);
+}
+
+void test_handlers_allocate_less() {
+    const char* paths[] = {"/status_json", "/scan", "/params_json", "/device_info"};
+    for (const char* path : paths) {
+        uint64_t withArena = allocationsFor(pooledPort, path, 20);
+        uint64_t without = allocationsFor(plainPort, path, 20);
+        char line[120];
+        snprintf(line, sizeof(line), "%s: %llu heap allocations per request with arenas, %llu without", path,
+                 static_cast<unsigned long long>(withArena), static_cast<unsigned long long>(without));
+        TEST_MESSAGE(line);
+        TEST_ASSERT_LESS_THAN(without, withArena);
+    }
+    ArenaStats stats = pooled->getArenaStats();
+    TEST_ASSERT_GREATER_OR_EQUAL(84, stats.leases);
+    TEST_ASSERT_EQUAL(0, stats.inUse);
+    TEST_ASSERT_EQUAL(0, stats.exhausted);
+    TEST_ASSERT_EQUAL(0, stats.fallbacks);
+    TEST_ASSERT_GREATER_THAN(0, stats.highWater);
+    TEST_ASSERT_LESS_OR_EQUAL(config.requestArenaSize, stats.highWater);
+    TEST_ASSERT_EQUAL(0, plain->getArenaStats().leases);
+}
+
+void test_device_info_telemetry() {
+    for (int i = 0; i < 3; i++) {
+        NativeSim::advanceMillis(config.heapSampleInterval);
+        pooled->loop();
+    }
+    HeapTelemetry heap = pooled->getHeapTelemetry();
+    TEST_ASSERT_GREATER_OR_EQUAL(3, heap.samples);
+    TEST_ASSERT_GREATER_THAN(0, heap.largestBlock);
+    TEST_ASSERT_LESS_OR_EQUAL(heap.largestBlock, heap.minLargestBlock);
+
+    std::string info = NativeSim::httpGet(pooledPort, "/device_info").body;
+    TEST_ASSERT_TRUE(info.find("\"heap\":{\"free\":") != std::string::npos);
+    TEST_ASSERT_TRUE(info.find("\"largest_block_history\":[") != std::string::npos);
+    TEST_ASSERT_TRUE(info.find("\"arenas\":{\"count\":4,\"size\":") != std::string::npos);
+    TEST_ASSERT_TRUE(info.find("\"exhausted\":0,\"fallbacks\":0") != std::string::npos);
+    TEST_ASSERT_TRUE(NativeSim::httpGet(plainPort, "/device_info").body.find("\"arenas\":{\"count\":0") != std::string::npos);
+}
+
+int main(int argc, char** argv) {
+    NativeSim::setClockMode(NativeSim::ClockMode::Virtual);
+    config.httpPort = 0;
+    config.requestArenas = 4;
+    pooled = new WiFiManager(config);
+    pooled->setDebugOutput(false);
+    pooled->begin();
+    pooledPort = NativeSim::lastBoundHttpPort();
+
+    WiFiManagerConfig plainConfig;
+    plainConfig.httpPort = 0;
+    plain = new WiFiManager(plainConfig);
+    plain->setDebugOutput(false);
+    plain->begin();
+    plainPort = NativeSim::lastBoundHttpPort();
+
+    UNITY_BEGIN();
+    RUN_TEST(test_pool_accounting);
+    RUN_TEST(test_handlers_allocate_less);
+    RUN_TEST(test_device_info_telemetry);
+    int result = UNITY_END();
+    delete plain;
+    delete pooled;
+    return result;
+}
@@ -0,0 +1,197 @@
+#include <Arduino.h>
+#include <unity.h>
+#include <NativeSim.h>
+#include <NativeSimClient.h>
+#include <string>
+#include "WiFiManager.h"
+
+// Fallback root page (no index.html on the filesystem): output identical to
+// the per-request String renderer it replaced, invalidation on every content
+// change, and allocations per request once the page is cached.
+
+WiFiManagerConfig config;
+WiFiManager* wifiManager = nullptr;
+AsyncWebServer* legacyServer = nullptr;
+uint16_t managerPort = 0;
+uint16_t legacyPort = 0;
+char fsRoot[] = "/tmp/wm-rootpage-XXXXXX";
+static const char* kHead = "<link rel='icon' href='data:,'>";
+
+// Reference implementation of the pre-caching fallback in handleRoot.
+static String legacyRootPage(const std::vector<WiFiManagerParameter*>& params, const String& status) {
+    static const char* const types[] = {"text", "password", "number", "checkbox", "range", "select", "email", "text",
+                                        "text", "text", "date", "time", "datetime-local", "text", "text", "color"};
+    String page = "<html><head>";
+    page += kHead;
+    page += "<meta charset='utf-8'><meta name='viewport' content='width=device-width, initial-scale=1.0'>";
+    page += "<title>WiFi Manager</title>";
+    page += "<style>body{font-family:Arial,sans-serif;padding:20px;color:#333} .container{max-width:800px;margin:auto;padding:20px;background:#f9f9f9;border-radius:5px} .btn{padding:8px 16px;background:#0066cc;color:white;border:none;border-radius:4px;cursor:pointer} input,select,textarea{width:100%;padding:8px;margin:5px 0;border:1px solid #ddd;border-radius:4px;}</style>";
+    page += "</head><body><div class='container'>";
+    page += "<h1>WiFi Manager</h1>";
+    page += "<p>Status: " + status + "</p>";
+    page += "<h2>Available Networks</h2>";
+    page += "<button class='btn' onclick='scanNetworks()'>Scan Networks</button>";
+    page += "<div id='networks'></div>";
+    page += "<h2>Connect to Network</h2>";
+    page += "<form id='wifi-form'><label for='ssid'>SSID:</label><input type='text' id='ssid' name='ssid' required>";
+    page += "<label for='password'>Password:</label><input type='password' id='password' name='password'>";
+    page += "<button type='submit' class='btn'>Connect</button></form>";
+    if (params.size() > 0) {
+        page += "<h2>Custom Fields</h2>";
+        page += "<form id='custom-form'>";
+        for (auto param : params) {
+            page += "<label for='" + String(param->getID()) + "'>" + String(param->getLabel());
+            if (strlen(param->getGroup()) > 0) { page += " (" + String(param->getGroup()) + ")"; }
+            page += ":</label>";
+            page += "<input type='" + String(types[static_cast<int>(param->getType())]) + "' id='" + String(param->getID()) +
+                    "' name='" + String(param->getID()) + "' value='" + String(param->getValue()) + "' " +
+                    String(param->getCustomAttributes()) + ">";
+        }
+        page += "<button type='submit' class='btn'>Save Custom Fields</button>";
+        page += "</form>";
+    }
+    page += "<hr><h2>Advanced Tools</h2>";
+    page += "<a href='/ota'>OTA Update</a> | ";
+    page += "<a href='/fs/list'>File Explorer</a> | ";
+    page += "<a href='/backup'>Backup Config</a> | ";
+    page += "<a href='/device_info'>Device Info</a>";
+    page += " | <a href='/terminal'>Terminal</a>";
+    page += "</div>";
+    page += "<script>";
+    page += "function scanNetworks(retry){ document.getElementById('networks').innerHTML='Scanning...';";
+    page += "fetch(retry?'/scan':'/scan?refresh=1').then(r=>r.json()).then(data=>{ if(data.scanning&&(retry||0)<15){ setTimeout(()=>scanNetworks((retry||0)+1),1000); return; } let html='<ul>'; data.networks.forEach(n=>{ html+='<li><a href=\"#\" onclick=\"document.getElementById(\\'ssid\\').value=\\''+n.ssid+'\\'\">'+n.ssid+' ('+n.rssi+'dBm)</a></li>'; }); html+='</ul>'; document.getElementById('networks').innerHTML=html; }); }";
+    page += "document.getElementById('wifi-form').onsubmit=function(e){ e.preventDefault(); let formData=new FormData(e.target);";
+    page += "fetch('/connect',{method:'POST',body:formData}).then(r=>r.json()).then(data=>{ if(data.error){ alert(data.error); return; } waitConnect(0); }).catch(err=>{ alert('Connection failed'); }); };";
+    page += "function waitConnect(n){ fetch('/status_json').then(r=>r.json()).then(s=>{ if(s.connect.state=='connecting'&&n<60){ setTimeout(()=>waitConnect(n+1),1000); return; } alert(s.connect.state=='connected'?'Connected!':'Connection failed'); }); }";
+    page += "if(document.getElementById('custom-form')){ document.getElementById('custom-form').onsubmit=function(e){ e.preventDefault();";
+    page += "let formData=new FormData(e.target); fetch('/update_params',{method:'POST',body:formData}).then(r=>r.json()).then(data=>{ alert(data.result || 'Updated'); }).catch(err=>{ alert('Update failed'); }); }; }";
+    page += "</script></body></html>";
+    return page;
+}
+
+static std::string page(uint16_t port = managerPort) {
+    NativeSim::HttpReply reply = NativeSim::httpGet(port, "/");
+    TEST_ASSERT_EQUAL(200, reply.status);
+    return reply.body;
+}
+
+struct AllocSample {
+    uint64_t allocations;
+    uint64_t bytes;
+};
+
+static AllocSample measure(uint16_t port) {
+    const int rounds = 20;
+    NativeSim::httpGetDiscard(port, "/");  // warm-up; builds the cache
+    delay(20);
+    NativeSim::HeapStats before = NativeSim::heapStats();
+    for (int i = 0; i < rounds; i++) TEST_ASSERT_EQUAL(200, NativeSim::httpGetDiscard(port, "/"));
+    delay(20);
+    NativeSim::HeapStats after = NativeSim::heapStats();
+    return AllocSample{(after.allocations - before.allocations) / rounds, (after.bytesAllocated - before.bytesAllocated) / rounds};
+}
+
+static void addParams(size_t total) {
+    static char ids[200][16];
+    size_t have = wifiManager->getParameters().size();
+    for (size_t i = have; i < total; i++) {
+        snprintf(ids[i], sizeof(ids[i]), "param_%03u", static_cast<unsigned>(i));
+        wifiManager->addParameter(new WiFiManagerParameter(ids[i], "Benchmark Parameter", "some-value-1234", 40));
+    }
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_matches_legacy_renderer() {
+    auto* mqtt = new WiFiManagerParameter("mqtt", "MQTT Server", "broker.local", ParameterType::URL, "required", "Network");
+    wifiManager->addParameter(mqtt);
+    wifiManager->addParameter(new WiFiManagerParameter("port", "Port", "1883", ParameterType::NUMBER));
+    wifiManager->addParameter(new WiFiManagerParameter("led", "LED", "true", ParameterType::TOGGLE));
+    std::string legacy = page(legacyPort);
+    TEST_ASSERT_EQUAL_STRING(legacy.c_str(), page().c_str());
+    // A second request is served from the cache and is byte-identical.
+    TEST_ASSERT_EQUAL_STRING(legacy.c_str(), page().c_str());
+}
+
+void test_invalidated_by_each_content_change() {
+    WiFiManagerParameter* port = wifiManager->getParameters()[1];
+    port->setValue("8883");
+    TEST_ASSERT_TRUE(page().find("value='8883'") != std::string::npos);
+
+    // Rejected and unchanged values do not invalidate anything.
+    uint32_t revision = WiFiManagerParameter::revision();
+    port->setValue("not-a-number");
+    port->setValue("8883");
+    TEST_ASSERT_EQUAL(revision, WiFiManagerParameter::revision());
+
+    wifiManager->addParameter(new WiFiManagerParameter("late", "Added Later", "x", 8));
+    TEST_ASSERT_TRUE(page().find("id='late'") != std::string::npos);
+
+    wifiManager->setCustomHeadElement("<meta name='x-build' content='42'>");
+    std::string body = page();
+    TEST_ASSERT_TRUE(body.find("content='42'") != std::string::npos);
+    TEST_ASSERT_TRUE(body.find(kHead) == std::string::npos);
+
+    wifiManager->setCustomBodyFooter("<footer>acme</footer>");
+    TEST_ASSERT_TRUE(page().find("</div><footer>acme</footer><script>") != std::string::npos);
+}
+
+void test_status_slot_is_live() {
+    TEST_ASSERT_TRUE(page().find("Status: Disconnected</p>") != std::string::npos);
+    WiFi.begin("HomeNetwork", "password123");
+    while (WiFi.status() != WL_CONNECTED) delay(1);
+    TEST_ASSERT_TRUE(page().find("Status: Connected</p>") != std::string::npos);
+    WiFi.disconnect();
+}
+
+void test_allocations_independent_of_param_count() {
+    char line[160];
+    AllocSample cached[2];
+    AllocSample legacy[2];
+    const size_t counts[2] = {10, 100};
+    for (int i = 0; i < 2; i++) {
+        addParams(counts[i]);
+        cached[i] = measure(managerPort);
+        legacy[i] = measure(legacyPort);
+        snprintf(line, sizeof(line), "params=%3u  legacy: %5llu allocs %8llu B   cached: %3llu allocs %6llu B",
+                 static_cast<unsigned>(counts[i]),
+                 static_cast<unsigned long long>(legacy[i].allocations), static_cast<unsigned long long>(legacy[i].bytes),
+                 static_cast<unsigned long long>(cached[i].allocations), static_cast<unsigned long long>(cached[i].bytes));
+        TEST_MESSAGE(line);
+    }
+    TEST_ASSERT_EQUAL(cached[0].allocations, cached[1].allocations);
+    TEST_ASSERT_LESS_THAN(legacy[0].allocations, cached[0].allocations);
+    TEST_ASSERT_LESS_THAN(legacy[1].bytes / 10, cached[1].bytes);
+}
+
+int main(int argc, char** argv) {
+    if (!mkdtemp(fsRoot)) return 1;
+    NativeSim::setFilesystemRoot(fsRoot);  // empty: no index.html
+    NativeSim::addAccessPoint("HomeNetwork", "password123", 6, -48);
+    NativeSim::setRadioTiming(NativeSim::RadioTiming{1, 13, 1, 1, 1});
+    NativeSim::setFlashTiming(NativeSim::FlashTiming{0, 0});
+    WiFi.mode(WIFI_STA);
+
+    config.httpPort = 0;
+    wifiManager = new WiFiManager(config);
+    wifiManager->setDebugOutput(false);
+    wifiManager->setCustomHeadElement(kHead);
+    wifiManager->begin();
+    managerPort = NativeSim::lastBoundHttpPort();
+
+    legacyServer = new AsyncWebServer(0);
+    legacyServer->on("/", HTTP_GET, [](AsyncWebServerRequest* request) {
+        request->send(200, "text/html", legacyRootPage(wifiManager->getParameters(), wifiManager->getConnectionStatus()));
+    });
+    legacyServer->begin();
+    legacyPort = NativeSim::lastBoundHttpPort();
+
+    UNITY_BEGIN();
+    RUN_TEST(test_matches_legacy_renderer);
+    RUN_TEST(test_invalidated_by_each_content_change);
+    RUN_TEST(test_status_slot_is_live);
+    RUN_TEST(test_allocations_independent_of_param_count);
+    return UNITY_END();
+}
@@ -0,0 +1,223 @@
+#include <Arduino.h>
+#include <unity.h>
+#include <NativeSim.h>
+#include <NativeSimClient.h>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include "WiFiManager.h"
+#include "WiFiManagerSerial.h"
+
+// Serial monitor: SPSC ring correctness under a concurrent producer, batched
+// streaming to /serial_ws, and bounded memory / non-blocking logging when a
+// client stops reading.
+
+WiFiManagerConfig config;
+WiFiManager* wifiManager = nullptr;
+uint16_t port = 0;
+
+class NullPrint : public Print {
+public:
+    size_t write(uint8_t) override { return 1; }
+    size_t write(const uint8_t*, size_t size) override { return size; }
+};
+NullPrint nullPort;
+
+// Reads server frames until `until` appears in the joined text or the
+// deadline passes, calling loop() in between. Returns the frame count.
+static int readFrames(int fd, std::string& text, const char* until, unsigned long timeoutMs = 3000) {
+    std::string raw;
+    std::vector<std::string> messages;
+    unsigned long start = millis();
+    while (text.find(until) == std::string::npos && millis() - start < timeoutMs) {
+        wifiManager->loop();
+        char buf[4096];
+        ssize_t n = recv(fd, buf, sizeof(buf), MSG_DONTWAIT);
+        if (n > 0) raw.append(buf, n);
+        else delay(5);
+        size_t first = messages.size();
+        NativeSim::takeTextFrames(raw, messages);
+        for (size_t i = first; i < messages.size(); i++) text += messages[i];
+    }
+    return static_cast<int>(messages.size());
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_ring_wraps_and_drops_excess() {
+    SerialRing ring(100);
+    TEST_ASSERT_EQUAL(128, ring.capacity());
+    uint8_t in[256];
+    for (int i = 0; i < 256; i++) in[i] = static_cast<uint8_t>(i);
+    uint8_t out[256];
+    TEST_ASSERT_EQUAL(100, ring.write(in, 100));
+    TEST_ASSERT_EQUAL(60, ring.read(out, 60));
+    TEST_ASSERT_EQUAL(80, ring.write(in + 100, 80));  // wraps
+    TEST_ASSERT_EQUAL(8, ring.write(in + 180, 20));
+    TEST_ASSERT_EQUAL(12, ring.dropped());
+    TEST_ASSERT_EQUAL(128, ring.size());
+
+    // The snapshot sees the pending bytes without consuming them.
+    TEST_ASSERT_EQUAL(128, ring.snapshot(out, sizeof(out)));
+    TEST_ASSERT_EQUAL_MEMORY(in + 60, out, 128);
+    TEST_ASSERT_EQUAL(16, ring.snapshot(out, 16));
+    TEST_ASSERT_EQUAL_MEMORY(in + 172, out, 16);
+    TEST_ASSERT_EQUAL(128, ring.read(out, sizeof(out)));
+    TEST_ASSERT_EQUAL_MEMORY(in + 60, out, 128);
+    TEST_ASSERT_EQUAL(0, ring.size());
+}
+
+void test_ring_preserves_order_under_concurrent_producer() {
+    SerialRing ring(1024);
+    const size_t total = 4 * 1024 * 1024;
+    std::thread producer([&ring, total] {
+        uint8_t chunk[97];
+        size_t sent = 0;
+        while (sent < total) {
+            size_t len = 1 + sent % sizeof(chunk);
+            if (len > total - sent) len = total - sent;
+            for (size_t i = 0; i < len; i++) chunk[i] = static_cast<uint8_t>((sent + i) % 251);
+            size_t done = 0;
+            while (done < len) {
+                // Retry instead of dropping so every byte can be checked.
+                size_t space = ring.capacity() - ring.size();
+                size_t n = ring.write(chunk + done, std::min(len - done, space));
+                done += n;
+                if (!n) std::this_thread::yield();
+            }
+            sent += len;
+        }
+    });
+    size_t received = 0;
+    bool ordered = true;
+    uint8_t buf[300];
+    while (received < total) {
+        size_t n = ring.read(buf, sizeof(buf));
+        for (size_t i = 0; i < n; i++) ordered &= buf[i] == static_cast<uint8_t>((received + i) % 251);
+        received += n;
+        if (!n) std::this_thread::yield();
+    }
+    producer.join();
+    TEST_ASSERT_TRUE(ordered);
+    TEST_ASSERT_EQUAL(0, ring.dropped());
+}
+
+void test_tee_forwards_and_copies() {
+    class Capture : public Print {
+    public:
+        std::string text;
+        size_t write(uint8_t c) override {
+            text += static_cast<char>(c);
+            return 1;
+        }
+    } port;
+    SerialRing ring(64);
+    SerialTee tee(ring, &port);
+    TEST_ASSERT_EQUAL(5, tee.println("abc"));
+    tee.print('!');
+    TEST_ASSERT_EQUAL_STRING("abc\r\n!", port.text.c_str());
+    char out[16] = {0};
+    TEST_ASSERT_EQUAL(6, ring.read(reinterpret_cast<uint8_t*>(out), sizeof(out)));
+    TEST_ASSERT_EQUAL_STRING("abc\r\n!", out);
+
+    // Without a downstream port the tee still feeds the ring.
+    tee.setOutput(nullptr);
+    TEST_ASSERT_EQUAL(3, tee.print("xyz"));
+    TEST_ASSERT_EQUAL(3, ring.size());
+}
+
+void test_streams_to_websocket_in_batches() {
+    int ws = NativeSim::openWebSocket(port, "/serial_ws");
+    TEST_ASSERT_TRUE(ws >= 0);
+    std::string text;
+    Print& out = wifiManager->getSerialMonitorOutput();
+    out.println("hello from the sketch");
+    readFrames(ws, text, "hello from the sketch");
+    TEST_ASSERT_TRUE(text.find("hello from the sketch\r\n") != std::string::npos);
+
+    // 200 lines logged back to back leave in a handful of frames.
+    text.clear();
+    for (int i = 0; i < 200; i++) out.printf("line %03d\n", i);
+    int frames = readFrames(ws, text, "line 199\n");
+    char line[96];
+    snprintf(line, sizeof(line), "200 log lines (%u bytes) -> %d frames", static_cast<unsigned>(text.size()), frames);
+    TEST_MESSAGE(line);
+    TEST_ASSERT_TRUE(text.find("line 000\n") != std::string::npos);
+    TEST_ASSERT_TRUE(text.find("line 199\n") != std::string::npos);
+    TEST_ASSERT_LESS_THAN(20, frames);
+    close(ws);
+}
+
+void test_stalled_client_never_blocks_logging() {
+    // Never reads: its socket and queue fill up while the logger keeps going.
+    int stalled = NativeSim::openWebSocket(port, "/serial_ws", 4096);
+    TEST_ASSERT_TRUE(stalled >= 0);
+    Print& out = wifiManager->getSerialMonitorOutput();
+    char payload[128];
+    memset(payload, 'x', sizeof(payload) - 1);
+    payload[sizeof(payload) - 1] = '\0';
+
+    NativeSim::resetHeapPeak();
+    size_t liveBefore = NativeSim::heapStats().liveBytes;
+    uint32_t droppedBefore = wifiManager->getSerialMonitorDropped();
+    auto slowest = std::chrono::nanoseconds(0);
+    const int lines = 40000;  // ~5 MB
+    for (int i = 0; i < lines; i++) {
+        auto t0 = std::chrono::steady_clock::now();
+        out.println(payload);
+        auto t = std::chrono::steady_clock::now() - t0;
+        if (t > slowest) slowest = t;
+        if (i % 64 == 0) wifiManager->loop();
+    }
+    size_t peakGrowth = NativeSim::heapStats().peakLiveBytes - liveBefore;
+    uint32_t dropped = wifiManager->getSerialMonitorDropped() - droppedBefore;
+
+    char line[160];
+    snprintf(line, sizeof(line), "stalled client: %d lines, slowest println %lld us, %u bytes dropped, peak heap growth %u B",
+             lines, static_cast<long long>(std::chrono::duration_cast<std::chrono::microseconds>(slowest).count()),
+             static_cast<unsigned>(dropped), static_cast<unsigned>(peakGrowth));
+    TEST_MESSAGE(line);
+    TEST_ASSERT_GREATER_THAN(0, dropped);
+    TEST_ASSERT_LESS_THAN(256 * 1024, peakGrowth);
+    close(stalled);
+}
+
+void test_backlog_kept_for_polling_clients() {
+    // Let the server notice the closed sockets.
+    for (int i = 0; i < 20; i++) {
+        wifiManager->loop();
+        delay(10);
+    }
+    wifiManager->getSerialMonitorOutput().println("backlog marker");
+    for (int i = 0; i < 5; i++) wifiManager->loop();
+    String buffered = wifiManager->getSerialMonitorBuffer();
+    TEST_ASSERT_TRUE(buffered.indexOf("backlog marker") >= 0);
+    TEST_ASSERT_LESS_OR_EQUAL(config.serialMonitorBufferSize, buffered.length());
+
+    NativeSim::HttpReply reply = NativeSim::httpGet(port, "/serial_data");
+    TEST_ASSERT_EQUAL(200, reply.status);
+    TEST_ASSERT_TRUE(reply.body.find("backlog marker") != std::string::npos);
+}
+
+int main(int argc, char** argv) {
+    NativeSim::setFlashTiming(NativeSim::FlashTiming{0, 0});
+    config.httpPort = 0;
+    config.enableSerialMonitor = true;
+    config.serialMonitorBufferSize = 8192;
+    wifiManager = new WiFiManager(config);
+    wifiManager->setDebugOutput(true, nullPort);
+    wifiManager->begin();
+    port = NativeSim::lastBoundHttpPort();
+
+    UNITY_BEGIN();
+    RUN_TEST(test_ring_wraps_and_drops_excess);
+    RUN_TEST(test_ring_preserves_order_under_concurrent_producer);
+    RUN_TEST(test_tee_forwards_and_copies);
+    RUN_TEST(test_streams_to_websocket_in_batches);
+    RUN_TEST(test_stalled_client_never_blocks_logging);
+    RUN_TEST(test_backlog_kept_for_polling_clients);
+    return UNITY_END();
+}
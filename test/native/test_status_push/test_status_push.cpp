@@ -0,0 +1,194 @@
+#include <Arduino.h>
+#include <unity.h>
+#include <NativeSim.h>
+#include <NativeSimClient.h>
+#include <string>
+#include <vector>
+#include "WiFiManager.h"
+
+// Status push on /ws: a new client gets the full state once, after that only
+// changed fields are sent, and an idle portal sends nothing. Compared with the
+// UI's former 10 s /status_json polling (virtual clock, real sockets).
+
+WiFiManagerConfig config;
+WiFiManager* wifiManager = nullptr;
+WiFiManagerParameter* mqttHost = nullptr;
+WiFiManagerParameter* mqttPort = nullptr;
+uint16_t port = 0;
+
+struct WsClient {
+    int fd = -1;
+    std::string raw;
+    size_t bytes = 0;  // wire bytes received after the handshake
+
+    void open() {
+        fd = NativeSim::openWebSocket(port, "/ws");
+        TEST_ASSERT_TRUE(fd >= 0);
+    }
+
+    // Text messages that arrived within `waitMs` of real time.
+    std::vector<std::string> messages(int waitMs = 100) {
+        std::vector<std::string> out;
+        char buf[4096];
+        for (int idle = 0; idle < waitMs; idle += 5) {
+            ssize_t n = recv(fd, buf, sizeof(buf), MSG_DONTWAIT);
+            if (n > 0) {
+                raw.append(buf, n);
+                bytes += n;
+                idle = 0;
+            } else {
+                usleep(5000);
+            }
+        }
+        NativeSim::takeTextFrames(raw, out);
+        return out;
+    }
+
+    void close() { ::close(fd); }
+};
+
+static bool has(const std::string& msg, const char* text) { return msg.find(text) != std::string::npos; }
+
+// Runs loop() for `ms` of virtual time.
+static void runFor(unsigned long ms) {
+    unsigned long start = millis();
+    while (millis() - start < ms) {
+        wifiManager->loop();
+        delay(50);
+    }
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_snapshot_then_silence_when_idle() {
+    WsClient ws;
+    ws.open();
+    std::vector<std::string> first = ws.messages();
+    TEST_ASSERT_EQUAL(1, first.size());
+    const std::string& snap = first[0];
+    TEST_ASSERT_TRUE(has(snap, "\"type\":\"status\""));
+    TEST_ASSERT_TRUE(has(snap, "\"status\":"));
+    TEST_ASSERT_TRUE(has(snap, "\"ip\":"));
+    TEST_ASSERT_TRUE(has(snap, "\"connect\":{\"state\":\"idle\"}"));
+    TEST_ASSERT_TRUE(has(snap, "{\"id\":\"mqtt_host\",\"value\":\"broker.local\"}"));
+    TEST_ASSERT_TRUE(has(snap, "{\"id\":\"mqtt_port\",\"value\":\"1883\"}"));
+
+    // Nothing changes for a minute: nothing is sent.
+    runFor(2000);
+    ws.messages();
+    size_t before = ws.bytes;
+    runFor(60000);
+    TEST_ASSERT_EQUAL(0, ws.messages().size());
+    TEST_ASSERT_EQUAL(before, ws.bytes);
+    ws.close();
+}
+
+void test_connect_pushes_changed_fields_only() {
+    WsClient ws;
+    ws.open();
+    ws.messages();
+    runFor(1500);
+    ws.messages();
+
+    TEST_ASSERT_TRUE(wifiManager->beginConnect("Home", "secret"));
+    while (wifiManager->getConnectState() == ConnectState::CONNECTING) {
+        wifiManager->loop();
+        delay(10);
+    }
+    TEST_ASSERT_TRUE(wifiManager->getConnectState() == ConnectState::CONNECTED);
+    runFor(1500);
+
+    std::string delta;
+    for (const std::string& m : ws.messages()) {
+        if (has(m, "\"type\":\"status\"")) delta += m;  // merged, as the UI does
+    }
+    TEST_ASSERT_TRUE(has(delta, "\"status\":\"Connected\""));
+    TEST_ASSERT_TRUE(has(delta, "\"ssid\":\"Home\""));
+    TEST_ASSERT_TRUE(has(delta, "\"rssi\":-60"));
+    TEST_ASSERT_FALSE(has(delta, "\"params\""));
+
+    // RSSI jitter below the step is not worth a message...
+    NativeSim::setAccessPointRssi("Home", -61);
+    runFor(3000);
+    TEST_ASSERT_EQUAL(0, ws.messages().size());
+    // ...a real change is, and carries nothing else.
+    NativeSim::setAccessPointRssi("Home", -67);
+    runFor(1500);
+    std::vector<std::string> rssi = ws.messages();
+    TEST_ASSERT_EQUAL(1, rssi.size());
+    TEST_ASSERT_EQUAL_STRING("{\"type\":\"status\",\"rssi\":-67}", rssi[0].c_str());
+    ws.close();
+}
+
+void test_parameter_change_sends_that_parameter() {
+    WsClient ws;
+    ws.open();
+    ws.messages();
+    runFor(1500);
+    ws.messages();
+
+    mqttPort->setValue("8883");
+    mqttHost->setCustomAttributes("maxlength=\"64\"");  // not a value change
+    runFor(1500);
+    std::vector<std::string> msgs = ws.messages();
+    TEST_ASSERT_EQUAL(1, msgs.size());
+    TEST_ASSERT_EQUAL_STRING("{\"type\":\"status\",\"params\":[{\"id\":\"mqtt_port\",\"value\":\"8883\"}]}",
+                             msgs[0].c_str());
+
+    mqttHost->setCustomAttributes("");
+    runFor(1500);
+    TEST_ASSERT_EQUAL(0, ws.messages().size());
+    ws.close();
+}
+
+void test_traffic_against_polling() {
+    // One /status_json poll as the UI used to issue it every 10 s.
+    const char req[] = "GET /status_json HTTP/1.1\r\nHost: localhost\r\nAccept: */*\r\n\r\n";
+    size_t reply = NativeSim::exchange(port, req).size();
+    TEST_ASSERT_GREATER_THAN(0, reply);
+
+    // The same minute on /ws with one RSSI change in it.
+    WsClient ws;
+    ws.open();
+    ws.messages();
+    size_t snapshot = ws.bytes;
+    runFor(30000);
+    NativeSim::setAccessPointRssi("Home", -55);
+    runFor(30000);
+    ws.messages();
+    size_t pushed = ws.bytes - snapshot;
+    ws.close();
+
+    size_t polled = 6 * (sizeof(req) - 1 + reply);
+    char line[160];
+    snprintf(line, sizeof(line), "per tab per minute: polling %u B in 6 requests, /ws %u B (+%u B snapshot on open)",
+             static_cast<unsigned>(polled), static_cast<unsigned>(pushed), static_cast<unsigned>(snapshot));
+    TEST_MESSAGE(line);
+    TEST_ASSERT_GREATER_THAN(0, pushed);
+    TEST_ASSERT_LESS_THAN(polled / 10, pushed);
+}
+
+int main(int argc, char** argv) {
+    NativeSim::setClockMode(NativeSim::ClockMode::Virtual);
+    NativeSim::setFlashTiming(NativeSim::FlashTiming{0, 0});
+    NativeSim::addAccessPoint("Home", "secret", 6, -60);
+    config.httpPort = 0;
+    config.fastReconnect = false;
+    wifiManager = new WiFiManager(config);
+    wifiManager->setDebugOutput(false);
+    mqttHost = new WiFiManagerParameter("mqtt_host", "MQTT host", "broker.local", 40);
+    mqttPort = new WiFiManagerParameter("mqtt_port", "MQTT port", "1883", 6);
+    wifiManager->addParameter(mqttHost);
+    wifiManager->addParameter(mqttPort);
+    wifiManager->begin();
+    port = NativeSim::lastBoundHttpPort();
+
+    UNITY_BEGIN();
+    RUN_TEST(test_snapshot_then_silence_when_idle);
+    RUN_TEST(test_connect_pushes_changed_fields_only);
+    RUN_TEST(test_parameter_change_sends_that_parameter);
+    RUN_TEST(test_traffic_against_polling);
+    return UNITY_END();
+}
@@ -0,0 +1,176 @@
+#include <Arduino.h>
+#include <unity.h>
+#include <NativeSim.h>
+#include <NativeSimClient.h>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include "WiFiManager.h"
+
+// Event tracer on the virtual clock: begin() phases, handler spans on the
+// server thread, scan and connect-attempt spans with their modelled radio
+// time, ring wrap-around, the /trace export and the cost of one event.
+
+WiFiManagerConfig config;
+WiFiManager* wifiManager = nullptr;
+uint16_t port = 0;
+
+static std::string get(const char* path) {
+    return NativeSim::exchange(port, std::string("GET ") + path + " HTTP/1.1\r\nHost: localhost\r\n\r\n");
+}
+
+struct Span {
+    uint8_t task;
+    uint32_t start;
+    uint32_t end;
+};
+
+// Completed spans named `name`, matched begin to end per task.
+static std::vector<Span> spans(const char* name) {
+    std::vector<TraceEvent> events;
+    WmTrace::snapshot(events);
+    std::vector<Span> out;
+    std::vector<Span> open;
+    for (const TraceEvent& e : events) {
+        if (strcmp(WmTrace::tagName(e.tag), name) != 0) continue;
+        if (e.meta & kTraceBegin) {
+            open.push_back(Span{e.task, e.micros, 0});
+            continue;
+        }
+        for (size_t i = open.size(); i-- > 0;) {
+            if (open[i].task != e.task) continue;
+            open[i].end = e.micros;
+            out.push_back(open[i]);
+            open.erase(open.begin() + i);
+            break;
+        }
+    }
+    return out;
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_begin_phases_and_handlers() {
+    const char* phases[] = {"begin.server", "begin.fs", "begin.routes", "begin.listen"};
+    uint8_t mainTask = 0xFF;
+    uint32_t last = 0;
+    for (const char* phase : phases) {
+        std::vector<Span> s = spans(phase);
+        TEST_ASSERT_EQUAL(1, s.size());
+        TEST_ASSERT_TRUE(s[0].start >= last);
+        TEST_ASSERT_TRUE(s[0].end >= s[0].start);
+        last = s[0].end;
+        if (mainTask == 0xFF) mainTask = s[0].task;
+        TEST_ASSERT_EQUAL(mainTask, s[0].task);
+    }
+    TEST_ASSERT_EQUAL_STRING("thread 0", WmTrace::taskName(mainTask));
+
+    for (int i = 0; i < 3; i++) get("/params_json");
+    get("/no-such-page");
+    std::vector<Span> handlers = spans("/params_json");
+    TEST_ASSERT_EQUAL(3, handlers.size());
+    TEST_ASSERT_TRUE(handlers[0].task != mainTask);  // the web server's own task
+    TEST_ASSERT_EQUAL(1, spans("other").size());
+}
+
+void test_scan_and_connect_spans() {
+    TEST_ASSERT_TRUE(wifiManager->startScan());
+    while (wifiManager->isScanInProgress()) delay(10);
+    std::vector<Span> scan = spans("scan");
+    TEST_ASSERT_EQUAL(1, scan.size());
+    NativeSim::RadioTiming radio = NativeSim::radioTiming();
+    uint32_t sweep = radio.channelDwellMs * radio.channels * 1000;
+    TEST_ASSERT_UINT32_WITHIN(20000, sweep, scan[0].end - scan[0].start);
+    TEST_ASSERT_EQUAL(1, spans("scan.results").size());
+
+    NativeSim::setStoredCredentials("HomeNetwork", "password123");
+    TEST_ASSERT_TRUE(wifiManager->autoConnect("test-ap"));
+    std::vector<Span> attempts = spans("connect.attempt");
+    TEST_ASSERT_GREATER_OR_EQUAL(1, attempts.size());
+    uint32_t took = attempts.back().end - attempts.back().start;
+    char line[96];
+    snprintf(line, sizeof(line), "scan %u ms, connect attempt %u ms", static_cast<unsigned>((scan[0].end - scan[0].start) / 1000),
+             static_cast<unsigned>(took / 1000));
+    TEST_MESSAGE(line);
+    TEST_ASSERT_GREATER_OR_EQUAL((radio.associateMs + radio.dhcpMs) * 1000 - 20000, took);
+}
+
+void test_chrome_trace_export() {
+    std::string raw = get("/trace");
+    std::string json = raw.substr(raw.find("\r\n\r\n") + 4);
+    TEST_ASSERT_TRUE(raw.find("application/json") != std::string::npos);
+    TEST_ASSERT_TRUE(json.find("{\"traceEvents\":[") != std::string::npos);
+    TEST_ASSERT_TRUE(json.find("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"thread 0\"}}") !=
+                     std::string::npos);
+    TEST_ASSERT_TRUE(json.find("{\"name\":\"begin.server\",\"cat\":\"wm\",\"ph\":\"B\",\"ts\":0,\"pid\":1,\"tid\":0,"
+                               "\"args\":{\"core\":0}}") != std::string::npos);
+    TEST_ASSERT_TRUE(json.find("\"name\":\"/params_json\",\"cat\":\"wm\",\"ph\":\"E\"") != std::string::npos);
+    TEST_ASSERT_TRUE(json.find("\"displayTimeUnit\":\"ms\",\"otherData\":{\"dropped\":0,\"capacity\":1024}}") !=
+                     std::string::npos);
+}
+
+void test_ring_wraps_and_event_cost() {
+    uint16_t tag = WmTrace::addTag("bench");
+    TEST_ASSERT_EQUAL(tag, WmTrace::addTag("bench"));
+    WmTrace::clear();
+    const uint32_t kSpans = 200000;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < kSpans; i++) {
+        WM_TRACE_SCOPE(tag);
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / (2 * kSpans);
+    char line[64];
+    snprintf(line, sizeof(line), "%.1f ns per event", ns);
+    TEST_MESSAGE(line);
+
+    std::vector<TraceEvent> events;
+    uint32_t dropped = WmTrace::snapshot(events);
+    TEST_ASSERT_EQUAL(WM_TRACE_EVENTS, events.size());
+    TEST_ASSERT_EQUAL_UINT32(2 * kSpans - WM_TRACE_EVENTS, dropped);
+    TEST_ASSERT_TRUE(events[0].meta & kTraceBegin);
+    TEST_ASSERT_FALSE(events[WM_TRACE_EVENTS - 1].meta & kTraceBegin);
+
+    // Several writers at once: every slot holds a whole event from one of them.
+    WmTrace::clear();
+    std::vector<std::thread> writers;
+    for (int t = 0; t < 4; t++) {
+        writers.emplace_back([tag] {
+            for (int i = 0; i < 100; i++) {
+                WM_TRACE_SCOPE(tag);
+            }
+        });
+    }
+    for (auto& w : writers) w.join();
+    dropped = WmTrace::snapshot(events);
+    TEST_ASSERT_EQUAL(800, events.size());
+    TEST_ASSERT_EQUAL(0, dropped);
+    uint32_t begins = 0;
+    for (const TraceEvent& e : events) {
+        TEST_ASSERT_EQUAL(tag, e.tag);
+        if (e.meta & kTraceBegin) begins++;
+    }
+    TEST_ASSERT_EQUAL(400, begins);
+}
+
+int main(int argc, char** argv) {
+    NativeSim::setClockMode(NativeSim::ClockMode::Virtual);
+    NativeSim::addAccessPoint("HomeNetwork", "password123", 6, -48);
+    config.httpPort = 0;
+    config.configPortalTimeout = 1000;
+    wifiManager = new WiFiManager(config);
+    wifiManager->setDebugOutput(false);
+    wifiManager->begin();
+    port = NativeSim::lastBoundHttpPort();
+
+    UNITY_BEGIN();
+    RUN_TEST(test_begin_phases_and_handlers);
+    RUN_TEST(test_scan_and_connect_spans);
+    RUN_TEST(test_chrome_trace_export);
+    RUN_TEST(test_ring_wraps_and_event_cost);
+    int result = UNITY_END();
+    delete wifiManager;
+    return result;
+}